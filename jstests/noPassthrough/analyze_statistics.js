@@ -0,0 +1,100 @@
+/**
+ * Tests that statistics gathered by the 'analyze' command are saved to system.statistics, prune
+ * candidate plans which are estimated to do far more work than the cheapest one, and cause cached
+ * plans which are estimated to be poor for a query's parameters to be replanned.
+ */
+(function() {
+    "use strict";
+
+    load("jstests/libs/analyze_plan.js");
+    load("jstests/libs/check_log.js");
+
+    let conn = MongoRunner.runMongod();
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    let testDB = conn.getDB("test");
+    let coll = testDB.analyze_statistics;
+    coll.drop();
+
+    // 'a' is 0 in nine documents out of ten, while 'b' is spread evenly over 1000 values.
+    const nDocs = 20000;
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocs; ++i) {
+        bulk.insert({a: (i % 10 === 0) ? i : 0, b: i % 1000});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.createIndex({a: 1}));
+    assert.commandWorked(coll.createIndex({b: 1}));
+
+    function getRejectedPlans(query) {
+        const explain = coll.find(query).explain();
+        assert(isIxscan(testDB, explain.queryPlanner.winningPlan), tojson(explain));
+        return explain.queryPlanner.rejectedPlans;
+    }
+
+    // Without statistics, both indexes are raced.
+    assert.eq(1, getRejectedPlans({a: 0, b: 5}).length);
+
+    // Invalid arguments are rejected.
+    assert.commandFailedWithCode(testDB.runCommand({analyze: "missing"}),
+                                 ErrorCodes.NamespaceNotFound);
+    assert.commandFailed(testDB.runCommand({analyze: coll.getName(), sampleSize: 0}));
+    assert.commandFailed(testDB.runCommand({analyze: coll.getName(), fields: "a"}));
+
+    let res = assert.commandWorked(
+        testDB.runCommand({analyze: coll.getName(), sampleSize: nDocs, fields: ["c"]}));
+    assert.eq(nDocs, res.numRecords, tojson(res));
+    assert.eq(["_id", "a", "b", "c"], res.fields.map(field => field.path).sort(), tojson(res));
+
+    const statsDoc = testDB.system.statistics.findOne({_id: coll.getName()});
+    assert.neq(null, statsDoc);
+    assert.eq(nDocs, statsDoc.numRecords, tojson(statsDoc));
+
+    // The plan over 'a' is estimated to examine 0.9 of the collection against 0.001 for the plan
+    // over 'b', so it is not raced. Both are kept when neither is obviously worse.
+    function assertPruned() {
+        const explain = coll.find({a: 0, b: 5}).explain();
+        assert.eq(0, explain.queryPlanner.rejectedPlans.length, tojson(explain));
+        assert.eq({b: 1}, getPlanStage(explain.queryPlanner.winningPlan, "IXSCAN").keyPattern);
+    }
+    assertPruned();
+    assert.eq(1, getRejectedPlans({a: 10, b: 5}).length);
+    assert.eq(nDocs * 0.9 / 1000, coll.find({a: 0, b: 5}).itcount());
+
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryPlannerStatsPruneRatio: 0}));
+    assert.eq(1, getRejectedPlans({a: 0, b: 5}).length);
+
+    // Cache the plan over 'a' for a query on a rare value of 'a'. Both plans have to be raced for
+    // it to be cached, so this is done while pruning is disabled.
+    const shape = {query: {a: 10, b: {$lte: 999}}, sort: {}, projection: {}};
+    assert.eq(1, coll.find({a: 10, b: {$lte: 999}}).itcount());
+    assert.eq(1, coll.find({a: 10, b: {$lte: 999}}).itcount());
+    let entry = assert.commandWorked(coll.runCommand("planCacheListPlans", shape));
+    assert(entry.isActive, tojson(entry));
+    assert.eq({a: 1}, entry.plans[0].reason.stats.inputStage.keyPattern, tojson(entry));
+
+    // For a common value of 'a', the statistics show the cached plan to be poor before it runs.
+    // The cached plan is only evicted on those grounds if replanning would prune it.
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryPlannerStatsPruneRatio: 10}));
+    assert.commandWorked(testDB.setLogLevel(1, "query"));
+    assert.eq(nDocs * 0.9 / 1000, coll.find({a: 0, b: {$lte: 0}}).itcount());
+    checkLog.contains(conn, "Collection statistics estimate that the cached plan examines");
+    assert.commandWorked(testDB.setLogLevel(0, "query"));
+
+    // Statistics are not loaded on startup, but can be reloaded from system.statistics.
+    MongoRunner.stopMongod(conn);
+    conn = MongoRunner.runMongod({restart: conn, cleanData: false});
+    assert.neq(null, conn, "mongod was unable to restart");
+    testDB = conn.getDB("test");
+    coll = testDB.analyze_statistics;
+    assert.eq(1, getRejectedPlans({a: 0, b: 5}).length);
+    assert.commandWorked(testDB.runCommand({analyze: coll.getName(), reload: true}));
+    assertPruned();
+
+    assert.commandFailedWithCode(testDB.runCommand({analyze: "other", reload: true}),
+                                 ErrorCodes.NoSuchKey);
+
+    MongoRunner.stopMongod(conn);
+})();
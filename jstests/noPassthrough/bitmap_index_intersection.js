@@ -0,0 +1,67 @@
+/**
+ * Tests that with internalQueryPlannerEnableBitmapIntersection enabled, $and and $or predicates
+ * over several single-field indexes are answered by intersecting and unioning RecordId bitmaps.
+ */
+(function() {
+    "use strict";
+
+    load("jstests/libs/analyze_plan.js");
+
+    const conn = MongoRunner.runMongod({
+        setParameter: {
+            internalQueryPlannerEnableBitmapIntersection: true,
+            internalQueryForceIntersectionPlans: true
+        }
+    });
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.bitmap_index_intersection;
+    coll.drop();
+
+    const nDocs = 20000;
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocs; ++i) {
+        bulk.insert({_id: i, a: i % 7, b: i % 11, c: i % 13, d: i});
+    }
+    assert.writeOK(bulk.execute());
+    for (let field of ["a", "b", "c", "d"]) {
+        assert.commandWorked(coll.createIndex({[field]: 1}));
+    }
+
+    function assertSameResults(query) {
+        const expected = coll.find(query).hint({$natural: 1}).sort({_id: 1}).toArray();
+        const actual = coll.find(query).sort({_id: 1}).toArray();
+        assert.eq(expected, actual, tojson(query));
+    }
+
+    // Range predicates over three indexes are intersected in a bitmap.
+    const andQuery = {a: {$lte: 1}, b: {$gte: 9}, c: {$lt: 3}};
+    let explain = coll.find(andQuery).explain("executionStats");
+    let bitmap = getPlanStage(explain.executionStats.executionStages, "AND_BITMAP");
+    assert.neq(null, bitmap, tojson(explain));
+    assert.gt(bitmap.containers, 0, tojson(bitmap));
+    assert.gt(bitmap.memUsage, 0, tojson(bitmap));
+    assert.gte(bitmap.bitmapAfterChild_0, bitmap.bitmapAfterChild_1, tojson(bitmap));
+    assertSameResults(andQuery);
+    assertSameResults({a: 3, b: {$gt: 4}, d: {$gte: 100, $lt: 5000}});
+    assertSameResults({a: {$gt: 100}, b: {$gt: 1}});
+
+    // An $or inside an $and is unioned in a bitmap.
+    const orQuery = {d: {$gte: 0}, $or: [{a: {$lte: 1}}, {b: {$gt: 9}}, {c: 12}]};
+    assertSameResults(orQuery);
+    assertSameResults({$or: [{a: 2}, {d: {$lt: 100}}]});
+
+    // The bitmap stage fails once it outgrows its memory limit, leaving other plans to answer the
+    // query.
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryBitmapMergeMaxMemoryBytes: 1}));
+    coll.getPlanCache().clear();
+    assertSameResults(andQuery);
+    explain = coll.find(andQuery).explain("executionStats");
+    assert.eq(null,
+              getPlanStage(explain.executionStats.executionStages, "AND_BITMAP"),
+              tojson(explain));
+
+    MongoRunner.stopMongod(conn);
+})();
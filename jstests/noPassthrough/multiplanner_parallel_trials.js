@@ -0,0 +1,120 @@
+/**
+ * Tests that with internalQueryMultiPlannerParallelTrials enabled, the candidate plans of a query
+ * are ranked and their results returned just as when the trial periods run on a single thread.
+ */
+(function() {
+    "use strict";
+
+    load("jstests/libs/analyze_plan.js");
+
+    const conn = MongoRunner.runMongod({
+        setParameter:
+            {internalQueryMultiPlannerParallelTrials: true, internalQueryMultiPlannerTrialThreads: 4}
+    });
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.multiplanner_parallel_trials;
+    coll.drop();
+
+    const nDocs = 5000;
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocs; ++i) {
+        bulk.insert({a: i % 10, b: i % 1000, c: i, s: "x".repeat(i % 7)});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.createIndex({a: 1}));
+    assert.commandWorked(coll.createIndex({b: 1}));
+    assert.commandWorked(coll.createIndex({a: 1, c: 1}));
+
+    function assertSameResults(query, sort) {
+        const expected = coll.find(query).hint({$natural: 1}).sort(sort).toArray();
+        coll.getPlanCache().clear();
+        const actual = coll.find(query).sort(sort).toArray();
+        assert.eq(expected, actual, tojson(query));
+    }
+
+    // The most selective index wins the trial period.
+    coll.getPlanCache().clear();
+    let explain = coll.find({a: 3, b: 13}).explain("allPlansExecution");
+    assert.gte(explain.executionStats.allPlansExecution.length, 2, tojson(explain));
+    let ixscan = getPlanStage(explain.queryPlanner.winningPlan, "IXSCAN");
+    assert.eq({b: 1}, ixscan.keyPattern, tojson(explain));
+    assert.eq(5, explain.executionStats.nReturned, tojson(explain));
+
+    assertSameResults({a: 3, b: 13}, {c: 1});
+    assertSameResults({a: {$gte: 8}, b: {$lt: 100}}, {c: 1});
+    assertSameResults({a: 4, c: {$gt: 2000}}, {c: -1});
+    assertSameResults({a: 1, b: 1, s: "x"}, {c: 1});
+    assertSameResults({a: 11, b: 11}, {c: 1});
+
+    // Covered and sorted plans return their results through the caller's working set too.
+    coll.getPlanCache().clear();
+    assert.eq(coll.find({a: 2, c: {$lt: 100}}, {_id: 0, a: 1, c: 1}).sort({c: 1}).toArray(),
+              coll.find({a: 2, c: {$lt: 100}}, {_id: 0, a: 1, c: 1})
+                  .hint({$natural: 1})
+                  .sort({c: 1})
+                  .toArray());
+
+    // Batches larger than the trial period are continued by the winning plan.
+    coll.getPlanCache().clear();
+    assert.eq(nDocs / 10, coll.find({a: 5, b: {$gte: 0}}).batchSize(7).itcount());
+
+    // Updates and deletes plan the same way.
+    assert.writeOK(coll.update({a: 6, b: 6}, {$set: {updated: true}}, {multi: true}));
+    assert.eq(5, coll.find({updated: true}).itcount());
+    assert.writeOK(coll.remove({a: 7, b: {$lt: 500}}));
+    assert.eq(0, coll.find({a: 7, b: {$lt: 500}}).hint({$natural: 1}).itcount());
+
+    MongoRunner.stopMongod(conn);
+
+    // With more candidates than trial threads, some trials only start once a plan has hit EOF.
+    // Each of them is still worked before the plans are ranked.
+    const singleThreadConn = MongoRunner.runMongod({
+        setParameter:
+            {internalQueryMultiPlannerParallelTrials: true, internalQueryMultiPlannerTrialThreads: 1}
+    });
+    assert.neq(null, singleThreadConn, "mongod was unable to start up");
+
+    const emptyColl = singleThreadConn.getDB("test").multiplanner_parallel_trials_eof;
+    emptyColl.drop();
+    assert.commandWorked(emptyColl.createIndex({a: 1}));
+    assert.commandWorked(emptyColl.createIndex({b: 1}));
+    assert.commandWorked(emptyColl.createIndex({a: 1, c: 1}));
+    assert.commandWorked(emptyColl.createIndex({b: 1, c: 1}));
+    assert.eq(0, emptyColl.find({a: 1, b: 1}).itcount());
+
+    assert.writeOK(emptyColl.insert({a: 1, b: 2, c: 3}));
+    emptyColl.getPlanCache().clear();
+    assert.eq(0, emptyColl.find({a: 100, b: 2}).itcount());
+    emptyColl.getPlanCache().clear();
+    assert.eq(1, emptyColl.find({a: 1, b: 2}).itcount());
+
+    // A candidate which waited for the thread is worked as many times as the plan which ended the
+    // trial period, so the plans are ranked on the same amount of work.
+    const rankedColl = singleThreadConn.getDB("test").multiplanner_parallel_trials_ranked;
+    rankedColl.drop();
+    const rankedBulk = rankedColl.initializeUnorderedBulkOp();
+    for (let i = 0; i < 200; ++i) {
+        rankedBulk.insert({a: i, b: i % 2, c: i});
+    }
+    assert.writeOK(rankedBulk.execute());
+    assert.commandWorked(rankedColl.createIndex({a: 1}));
+    assert.commandWorked(rankedColl.createIndex({b: 1}));
+    assert.commandWorked(rankedColl.createIndex({b: 1, c: 1}));
+
+    const rankedExplain = rankedColl.find({a: 5, b: 1}).explain("allPlansExecution");
+    const allPlans = rankedExplain.executionStats.allPlansExecution;
+    assert.eq(3, allPlans.length, tojson(rankedExplain));
+    const eofWorks = allPlans.filter(plan => plan.executionStages.isEOF)
+                         .map(plan => plan.executionStages.works);
+    assert.gt(eofWorks.length, 0, tojson(rankedExplain));
+    for (let plan of allPlans) {
+        assert.gte(plan.executionStages.works, Math.min(...eofWorks), tojson(rankedExplain));
+    }
+    assert.eq({a: 1},
+              getPlanStage(rankedExplain.queryPlanner.winningPlan, "IXSCAN").keyPattern,
+              tojson(rankedExplain));
+
+    MongoRunner.stopMongod(singleThreadConn);
+})();
@@ -0,0 +1,96 @@
+/**
+ * Tests that an aggregation whose collection scan is split into RecordId ranges by the
+ * internalQueryParallelCollectionScanThreads knob produces the same results as a single-threaded
+ * scan.
+ * @tags: [requires_wiredtiger]
+ */
+(function() {
+    "use strict";
+
+    load("jstests/libs/check_log.js");
+
+    const conn = MongoRunner.runMongod({});
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.parallel_collection_scan;
+    coll.drop();
+
+    const nDocs = 20000;
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocs; ++i) {
+        const doc = {a: i % 997, b: i % 13, c: i, s: "str" + (i % 31)};
+        if (i % 101 === 0) {
+            delete doc.a;
+        }
+        bulk.insert(doc);
+    }
+    assert.writeOK(bulk.execute());
+
+    // Leave holes in the collection, so that some of the sampled split points no longer exist.
+    assert.writeOK(coll.remove({c: {$mod: [7, 3]}}));
+
+    // An index on 'b' makes queries on it ineligible for the rewrite.
+    assert.commandWorked(coll.createIndex({b: 1}));
+
+    function runPipeline(pipeline, options) {
+        return coll.aggregate(pipeline, Object.assign({cursor: {batchSize: 10}}, options))
+            .toArray()
+            .sort((x, y) => bsonWoCompare(x, y));
+    }
+
+    const pipelines = [
+        [{$group: {_id: "$a", total: {$sum: "$c"}, count: {$sum: 1}, max: {$max: "$c"}}}],
+        [
+          {$match: {c: {$gt: 100}, s: {$ne: "str3"}}},
+          {$project: {a: 1, b: 1, c: 1}},
+          {$group: {_id: {a: "$a", b: "$b"}, avg: {$avg: "$c"}, cs: {$addToSet: "$b"}}},
+          {$sort: {"_id.a": 1, "_id.b": 1}}
+        ],
+        [{$unwind: {path: "$s"}}, {$group: {_id: null, count: {$sum: 1}, min: {$min: "$c"}}}],
+        [{$group: {_id: "$s", cs: {$addToSet: "$b"}}}, {$project: {n: {$size: "$cs"}}}],
+        // Not eligible for the rewrite, but must still work with the knob set.
+        [{$match: {b: 3}}, {$group: {_id: "$a", count: {$sum: 1}}}],
+        [{$sort: {c: 1}}, {$group: {_id: "$b", first: {$first: "$c"}}}],
+    ];
+
+    const expected = pipelines.map((pipeline) => runPipeline(pipeline));
+
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, logComponentVerbosity: {query: {verbosity: 1}}}));
+    assert.commandWorked(testDB.adminCommand(
+        {setParameter: 1, internalQueryParallelCollectionScanMinRecords: 1000}));
+
+    for (let nThreads of [2, 4, 7]) {
+        assert.commandWorked(testDB.adminCommand(
+            {setParameter: 1, internalQueryParallelCollectionScanThreads: nThreads}));
+
+        pipelines.forEach((pipeline, idx) => {
+            assert.eq(expected[idx], runPipeline(pipeline), tojson(pipeline));
+        });
+
+        // Spilling in the workers and in the merging $group must work as well.
+        assert.eq(expected[0], runPipeline(pipelines[0], {allowDiskUse: true}));
+    }
+
+    checkLog.contains(conn, "splitting the collection scan of " + coll.getFullName());
+
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryParallelCollectionScanThreads: 4}));
+
+    // A worker failure is reported to the client.
+    const divideByZero = [{$group: {_id: "$a", x: {$sum: {$divide: ["$c", "$b"]}}}}];
+    assert.commandFailedWithCode(
+        testDB.runCommand({aggregate: coll.getName(), pipeline: divideByZero, cursor: {}}), 16608);
+
+    // A cursor which is killed before it is exhausted stops its workers.
+    const res = assert.commandWorked(testDB.runCommand(
+        {aggregate: coll.getName(), pipeline: [{$group: {_id: "$c"}}], cursor: {batchSize: 1}}));
+    assert.commandWorked(
+        testDB.runCommand({killCursors: coll.getName(), cursors: [res.cursor.id]}));
+
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryParallelCollectionScanThreads: 0}));
+
+    MongoRunner.stopMongod(conn);
+}());
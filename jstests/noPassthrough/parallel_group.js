@@ -0,0 +1,81 @@
+/**
+ * Tests that a $group which is split across several threads by the
+ * internalQueryParallelGroupConsumers knob produces the same results as a single-threaded $group.
+ */
+(function() {
+    "use strict";
+
+    const conn = MongoRunner.runMongod({});
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.parallel_group;
+    coll.drop();
+
+    const nDocs = 20000;
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocs; ++i) {
+        const doc = {a: i % 997, b: i % 13, c: i, s: "str" + (i % 31)};
+        // Exercise documents with a missing or null group key.
+        if (i % 101 === 0) {
+            delete doc.a;
+        } else if (i % 103 === 0) {
+            doc.a = null;
+        }
+        bulk.insert(doc);
+    }
+    assert.writeOK(bulk.execute());
+
+    function runPipeline(pipeline, options) {
+        return coll.aggregate(pipeline, Object.assign({cursor: {batchSize: 10}}, options))
+            .toArray()
+            .sort((x, y) => bsonWoCompare(x, y));
+    }
+
+    const pipelines = [
+        [{$group: {_id: "$a", total: {$sum: "$c"}, count: {$sum: 1}, max: {$max: "$c"}}}],
+        [
+          {$match: {b: {$gt: 2}}},
+          {$project: {a: 1, b: 1, c: 1}},
+          {$group: {_id: {a: "$a", b: "$b"}, avg: {$avg: "$c"}}},
+          {$sort: {"_id.a": 1, "_id.b": 1}}
+        ],
+        [{$group: {_id: "$s", cs: {$addToSet: "$b"}}}, {$project: {n: {$size: "$cs"}}}],
+        // Not eligible for the rewrite, but must still work with the knob set.
+        [{$group: {_id: "$a.x", count: {$sum: 1}}}],
+        [{$group: {_id: null, count: {$sum: 1}}}],
+    ];
+
+    const expected = pipelines.map((pipeline) => runPipeline(pipeline));
+
+    for (let nConsumers of [2, 4, 7]) {
+        assert.commandWorked(testDB.adminCommand(
+            {setParameter: 1, internalQueryParallelGroupConsumers: nConsumers}));
+
+        pipelines.forEach((pipeline, idx) => {
+            assert.eq(expected[idx], runPipeline(pipeline), tojson(pipeline));
+        });
+
+        // Spilling in the consumers must work as well.
+        assert.eq(expected[0], runPipeline(pipelines[0], {allowDiskUse: true}));
+    }
+
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryParallelGroupConsumers: 4}));
+
+    // A consumer failure is reported to the client.
+    const divideByZero = [{$group: {_id: "$a", x: {$sum: {$divide: ["$c", "$b"]}}}}];
+    assert.commandFailedWithCode(
+        testDB.runCommand({aggregate: coll.getName(), pipeline: divideByZero, cursor: {}}), 16608);
+
+    // A cursor which is killed before it is exhausted stops its consumer threads.
+    const res = assert.commandWorked(testDB.runCommand(
+        {aggregate: coll.getName(), pipeline: [{$group: {_id: "$c"}}], cursor: {batchSize: 1}}));
+    assert.commandWorked(
+        testDB.runCommand({killCursors: coll.getName(), cursors: [res.cursor.id]}));
+
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryParallelGroupConsumers: 0}));
+
+    MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,56 @@
+/**
+ * Tests that with internalQueryPlannerGenerateSkipScans enabled, a predicate over the trailing
+ * field of a compound index can use that index by seeking between the distinct values of its
+ * unconstrained leading field.
+ */
+(function() {
+    "use strict";
+
+    load("jstests/libs/analyze_plan.js");
+
+    const conn = MongoRunner.runMongod({setParameter: "internalQueryPlannerGenerateSkipScans=1"});
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.skip_scan;
+    coll.drop();
+
+    const nTenants = 5;
+    const nStatuses = 10;
+    const nDocs = 20000;
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocs; ++i) {
+        bulk.insert({tenant: i % nTenants, status: "s" + (i % nStatuses), c: i});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.createIndex({tenant: 1, status: 1}));
+
+    function assertSameResults(query) {
+        const expected = coll.find(query).hint({$natural: 1}).sort({c: 1}).toArray();
+        const actual = coll.find(query).sort({c: 1}).toArray();
+        assert.eq(expected, actual, tojson(query));
+    }
+
+    // A predicate over 'status' alone only needs to examine the matching keys under each tenant.
+    let explain = coll.find({status: "s3"}).explain("executionStats");
+    assert(isIxscan(testDB, explain.queryPlanner.winningPlan), tojson(explain));
+    let ixscan = getPlanStage(explain.executionStats.executionStages, "IXSCAN");
+    assert.eq(nDocs / nStatuses, explain.executionStats.nReturned, tojson(explain));
+    assert.lt(ixscan.keysExamined, 2 * nDocs / nStatuses, tojson(ixscan));
+    assert.gte(ixscan.seeks, nTenants, tojson(ixscan));
+    assertSameResults({status: "s3"});
+
+    // Range predicates and predicates over fields outside the index are applied too.
+    assertSameResults({status: {$gte: "s2", $lt: "s5"}});
+    assertSameResults({status: {$in: ["s1", "s8"]}, c: {$mod: [3, 0]}});
+    assertSameResults({status: "missing"});
+
+    // Disabling the knob falls back to a collection scan.
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryPlannerGenerateSkipScans: false}));
+    coll.getPlanCache().clear();
+    explain = coll.find({status: "s3"}).explain("executionStats");
+    assert(isCollscan(testDB, explain.queryPlanner.winningPlan), tojson(explain));
+
+    MongoRunner.stopMongod(conn);
+})();
@@ -0,0 +1,34 @@
+/**
+ * Tests that the WiredTiger session cache is split into the configured number of partitions, and
+ * that serverStatus reports how long session checkouts take.
+ * @tags: [requires_wiredtiger]
+ */
+(function() {
+    "use strict";
+
+    const conn = MongoRunner.runMongod({setParameter: "wiredTigerSessionCachePartitions=3"});
+    assert.neq(null, conn, "mongod was unable to start up");
+
+    const testDB = conn.getDB("test");
+    const coll = testDB.wt_session_cache_partitions;
+    for (let i = 0; i < 100; ++i) {
+        assert.writeOK(coll.insert({_id: i}));
+    }
+    assert.eq(100, coll.find().itcount());
+
+    const stats = assert.commandWorked(testDB.serverStatus()).wiredTiger.sessionCache;
+    assert.eq(3, stats.partitions, tojson(stats));
+    assert.gt(stats.sessionsCreated, 0, tojson(stats));
+    assert.gte(stats.checkoutLatency.ops, 100, tojson(stats));
+    assert.gt(stats.checkoutLatency.histogram.length, 0, tojson(stats));
+
+    let histogramCount = 0;
+    stats.checkoutLatency.histogram.forEach(bucket => histogramCount += bucket.count);
+    assert.eq(stats.checkoutLatency.ops, histogramCount, tojson(stats));
+
+    // The partition count is only configurable at startup.
+    assert.commandFailed(
+        testDB.adminCommand({setParameter: 1, wiredTigerSessionCachePartitions: 4}));
+
+    MongoRunner.stopMongod(conn);
+})();
@@ -0,0 +1,76 @@
+/**
+ * Tests that with initialSyncCollectionClonerMaxRanges above 1, initial sync clones a large
+ * collection over several concurrent _id ranges, reports them in replSetGetStatus, and copies
+ * every document, including those whose _id values are of different types.
+ */
+
+(function() {
+    "use strict";
+    load("jstests/libs/check_log.js");
+
+    const replSet = new ReplSetTest({name: "initial_sync_parallel_ranges", nodes: 1});
+    replSet.startSet();
+    replSet.initiate();
+    const primary = replSet.getPrimary();
+
+    const coll = primary.getDB("test").coll;
+    const nDocs = 4000;
+    const bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < nDocs; ++i) {
+        bulk.insert({_id: i, x: i});
+    }
+    for (let i = 0; i < 100; ++i) {
+        bulk.insert({_id: "s" + i, x: i});
+        bulk.insert({_id: {k: i}, x: i});
+    }
+    assert.writeOK(bulk.execute());
+    const expectedCount = coll.find().itcount();
+
+    // A capped collection is always cloned with a single query.
+    const testDB = primary.getDB("test");
+    assert.commandWorked(testDB.createCollection("capped", {capped: true, size: 1 << 20}));
+    for (let i = 0; i < 100; ++i) {
+        assert.writeOK(testDB.capped.insert({_id: i}));
+    }
+
+    const secondary = replSet.add({
+        setParameter: {
+            initialSyncCollectionClonerMaxRanges: 4,
+            initialSyncCollectionClonerMinDocumentsPerRange: 100,
+            collectionClonerBatchSize: 50,
+        }
+    });
+    secondary.setSlaveOk();
+    assert.commandWorked(secondary.adminCommand(
+        {configureFailPoint: "initialSyncHangBeforeFinish", mode: "alwaysOn"}));
+    replSet.reInitiate();
+
+    checkLog.contains(secondary, "initial sync - initialSyncHangBeforeFinish fail point enabled");
+
+    const res = assert.commandWorked(secondary.adminCommand({replSetGetStatus: 1, initialSync: 1}));
+    const collStats = res.initialSyncStatus.databases.test["test.coll"];
+    assert.eq(expectedCount, collStats.documentsCopied, tojson(collStats));
+    assert(collStats.ranges, tojson(collStats));
+    assert.gt(collStats.ranges.length, 1, tojson(collStats));
+    assert.lte(collStats.ranges.length, 4, tojson(collStats));
+    assert(!collStats.ranges[0].hasOwnProperty("min"), tojson(collStats));
+    assert(!collStats.ranges[collStats.ranges.length - 1].hasOwnProperty("max"), tojson(collStats));
+    let fetched = 0;
+    collStats.ranges.forEach(range => {
+        assert(range.done, tojson(collStats));
+        fetched += range.documentsFetched;
+    });
+    assert.eq(expectedCount, fetched, tojson(collStats));
+    assert(!res.initialSyncStatus.databases.test["test.capped"].ranges, tojson(res));
+
+    assert.commandWorked(
+        secondary.adminCommand({configureFailPoint: "initialSyncHangBeforeFinish", mode: "off"}));
+    replSet.awaitSecondaryNodes(60 * 1000);
+    replSet.awaitReplication();
+
+    const secondaryColl = secondary.getDB("test").coll;
+    assert.eq(expectedCount, secondaryColl.find().itcount());
+    assert.eq(coll.find().sort({_id: 1}).toArray(), secondaryColl.find().sort({_id: 1}).toArray());
+    replSet.checkReplicatedDataHashes();
+    replSet.stopSet();
+})();
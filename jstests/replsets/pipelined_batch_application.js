@@ -0,0 +1,61 @@
+/**
+ * Tests that with replApplierPipelineBatches enabled, a secondary working through a backlog of
+ * batches prepares each batch while the previous one is being applied, and ends up with the same
+ * data and oplog as the primary.
+ */
+(function() {
+    "use strict";
+
+    const rst = new ReplSetTest({
+        nodes: [
+            {},
+            {
+              rsConfig: {priority: 0},
+              setParameter: {replApplierPipelineBatches: true, replBatchLimitOperations: 50}
+            }
+        ]
+    });
+    rst.startSet();
+    rst.initiate();
+
+    const primary = rst.getPrimary();
+    const secondary = rst.getSecondary();
+    const coll = primary.getDB("test").pipelined_batch_application;
+    assert.writeOK(coll.insert({_id: -1}));
+    rst.awaitReplication();
+
+    // Pause application on the secondary so that a backlog of batches builds up.
+    assert.commandWorked(
+        secondary.adminCommand({configureFailPoint: "rsSyncApplyStop", mode: "alwaysOn"}));
+
+    const nDocs = 2000;
+    for (let i = 0; i < nDocs; i += 100) {
+        const bulk = coll.initializeUnorderedBulkOp();
+        for (let j = i; j < i + 100; ++j) {
+            bulk.insert({_id: j, x: 0});
+        }
+        assert.writeOK(bulk.execute({w: 1}));
+        assert.writeOK(coll.update({_id: {$gte: i - 50, $lt: i + 50}},
+                                   {$inc: {x: 1}},
+                                   {multi: true, writeConcern: {w: 1}}));
+    }
+    // A command in the middle of the backlog is applied on its own.
+    assert.commandWorked(coll.createIndex({x: 1}));
+    assert.writeOK(coll.remove({_id: {$lt: 100}}, {writeConcern: {w: 1}}));
+
+    const before = assert.commandWorked(secondary.adminCommand({serverStatus: 1}));
+    assert.commandWorked(
+        secondary.adminCommand({configureFailPoint: "rsSyncApplyStop", mode: "off"}));
+    rst.awaitReplication();
+
+    const after = assert.commandWorked(secondary.adminCommand({serverStatus: 1}));
+    const pipelined = after.metrics.repl.apply.pipelinedBatches -
+        before.metrics.repl.apply.pipelinedBatches;
+    assert.gt(pipelined, 0, tojson(after.metrics.repl.apply));
+
+    const secondaryColl = secondary.getDB("test").pipelined_batch_application;
+    assert.eq(coll.find().sort({_id: 1}).toArray(), secondaryColl.find().sort({_id: 1}).toArray());
+    rst.checkOplogs();
+    rst.checkReplicatedDataHashes();
+    rst.stopSet();
+})();
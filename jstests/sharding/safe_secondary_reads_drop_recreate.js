@@ -81,6 +81,7 @@
             },
             behavior: "versioned"
         },
+        analyze: {skip: "primary only"},
         appendOplogNote: {skip: "primary only"},
         applyOps: {skip: "primary only"},
         authSchemaUpgrade: {skip: "primary only"},
@@ -82,6 +82,7 @@
             },
             behavior: "versioned"
         },
+        analyze: {skip: "primary only"},
         appendOplogNote: {skip: "primary only"},
         applyOps: {skip: "primary only"},
         authenticate: {skip: "does not return user data"},
@@ -30,6 +30,7 @@
 
 #include "mongo/base/shim.h"
 #include "mongo/db/collection_index_usage_tracker.h"
+#include "mongo/db/query/collection_statistics.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/update_index_data.h"
@@ -54,6 +55,10 @@ public:
 
         virtual QuerySettings* getQuerySettings() const = 0;
 
+        virtual std::shared_ptr<const CollectionStatistics> getCollectionStatistics() const = 0;
+
+        virtual void setCollectionStatistics(std::shared_ptr<const CollectionStatistics> stats) = 0;
+
         virtual const UpdateIndexData& getIndexKeys(OperationContext* opCtx) const = 0;
 
         virtual CollectionIndexUsageMap getIndexUsageStats() const = 0;
@@ -103,6 +108,22 @@ public:
         return this->_impl().getQuerySettings();
     }
 
+    /**
+     * Returns the statistics most recently gathered for this collection by the 'analyze' command,
+     * or nullptr if there are none.
+     */
+    inline std::shared_ptr<const CollectionStatistics> getCollectionStatistics() const {
+        return this->_impl().getCollectionStatistics();
+    }
+
+    /**
+     * Replaces the statistics used to plan queries over this collection, and clears the plan
+     * cache so that cached plans are chosen again in their light.
+     */
+    inline void setCollectionStatistics(std::shared_ptr<const CollectionStatistics> stats) {
+        return this->_impl().setCollectionStatistics(std::move(stats));
+    }
+
     /* get set of index keys for this namespace.  handy to quickly check if a given
        field is indexed (Note it might be a secondary component of a compound index.)
     */
@@ -191,6 +191,21 @@ QuerySettings* CollectionInfoCacheImpl::getQuerySettings() const {
     return _querySettings.get();
 }
 
+std::shared_ptr<const CollectionStatistics> CollectionInfoCacheImpl::getCollectionStatistics()
+    const {
+    stdx::lock_guard<stdx::mutex> lk(_statsMutex);
+    return _collectionStats;
+}
+
+void CollectionInfoCacheImpl::setCollectionStatistics(
+    std::shared_ptr<const CollectionStatistics> stats) {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_statsMutex);
+        _collectionStats = std::move(stats);
+    }
+    clearQueryCache();
+}
+
 void CollectionInfoCacheImpl::updatePlanCacheIndexEntries(OperationContext* opCtx) {
     std::vector<IndexEntry> indexEntries;
 
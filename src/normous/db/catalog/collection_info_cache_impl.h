@@ -35,6 +35,7 @@
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/update_index_data.h"
+#include "mongo/stdx/mutex.h"
 
 namespace mongo {
 
@@ -62,6 +63,16 @@ public:
      */
     QuerySettings* getQuerySettings() const;
 
+    /**
+     * Get the statistics gathered for this collection by the 'analyze' command, if any.
+     */
+    std::shared_ptr<const CollectionStatistics> getCollectionStatistics() const;
+
+    /**
+     * Install new statistics for this collection. Clears the plan cache.
+     */
+    void setCollectionStatistics(std::shared_ptr<const CollectionStatistics> stats);
+
     /* get set of index keys for this namespace.  handy to quickly check if a given
        field is indexed (Note it might be a secondary component of a compound index.)
     */
@@ -132,6 +143,11 @@ private:
     // Includes index filters.
     std::unique_ptr<QuerySettings> _querySettings;
 
+    // Statistics gathered by the 'analyze' command. Queries read these under an intent lock while
+    // the command installs new ones, so access is guarded by '_statsMutex'.
+    mutable stdx::mutex _statsMutex;
+    std::shared_ptr<const CollectionStatistics> _collectionStats;
+
     // Tracks index usage statistics for this collection.
     CollectionIndexUsageTracker _indexUsageTracker;
 
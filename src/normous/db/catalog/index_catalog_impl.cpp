@@ -1221,18 +1221,31 @@ Status IndexCatalogImpl::_indexFilteredRecords(OperationContext* opCtx,
     InsertDeleteOptions options;
     prepareInsertDeleteOptions(opCtx, index->descriptor(), &options);
 
-    for (auto bsonRecord : bsonRecords) {
-        int64_t inserted;
-        invariant(bsonRecord.id != RecordId());
+    // Records are handed to the access method in batches so that key generation and insertion
+    // can be amortized across documents. All keys in a batch are written at one timestamp, so a
+    // batch ends wherever the record timestamp changes.
+    std::vector<BSONObj> batchObjs;
+    std::vector<RecordId> batchLocs;
+    auto it = bsonRecords.begin();
+    while (it != bsonRecords.end()) {
+        const Timestamp ts = it->ts;
+        batchObjs.clear();
+        batchLocs.clear();
+        for (; it != bsonRecords.end() && it->ts == ts; ++it) {
+            invariant(it->id != RecordId());
+            batchObjs.push_back(*it->docPtr);
+            batchLocs.push_back(it->id);
+        }
 
-        if (!bsonRecord.ts.isNull()) {
-            Status status = opCtx->recoveryUnit()->setTimestamp(bsonRecord.ts);
+        if (!ts.isNull()) {
+            Status status = opCtx->recoveryUnit()->setTimestamp(ts);
             if (!status.isOK())
                 return status;
         }
 
-        Status status = index->accessMethod()->insert(
-            opCtx, *bsonRecord.docPtr, bsonRecord.id, options, &inserted);
+        int64_t inserted;
+        Status status =
+            index->accessMethod()->insertBatch(opCtx, batchObjs, batchLocs, options, &inserted);
         if (!status.isOK())
             return status;
 
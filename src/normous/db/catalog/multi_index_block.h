@@ -87,6 +87,17 @@ public:
      */
     virtual void ignoreUniqueConstraint() = 0;
 
+    /**
+     * Call this before init() to have insert() hand the documents to key generation threads,
+     * which generate their keys while the caller goes on inserting. All of the keys have been
+     * generated by the time doneInserting() returns. This has no effect on background builds, or
+     * unless the internalIndexBuildStreamInserts server parameter is enabled.
+     *
+     * If this is called, insert() or doneInserting() may return the key generation error of a
+     * document passed to an earlier insert().
+     */
+    virtual void streamInserts() = 0;
+
     /**
      * Removes pre-existing indexes from 'specs'. If this isn't done, init() may fail with
      * IndexAlreadyExists.
@@ -32,6 +32,9 @@
 
 #include "mongo/db/catalog/multi_index_block_impl.h"
 
+#include <algorithm>
+#include <memory>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/base/init.h"
 #include "mongo/db/audit.h"
@@ -49,12 +52,15 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/stdx/future.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/util/destructor_guard.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
+#include "mongo/util/producer_consumer_queue.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/quick_exit.h"
 #include "mongo/util/scopeguard.h"
@@ -95,6 +101,47 @@ public:
 
 } exportedMaxIndexBuildMemoryUsageParameter;
 
+// Whether foreground builds of more than one index generate their keys on separate threads, fed by
+// the collection scan.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildPipelineKeyGeneration, bool, false);
+
+// The most key generation threads a single index build starts. With more indexes than threads, each
+// thread generates the keys for several indexes.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildPipelineMaxThreads, int, 4)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "internalIndexBuildPipelineMaxThreads must be between 1 and 64");
+        }
+        return Status::OK();
+    });
+
+// Whether index builds that were asked to stream their inserts, such as those of the collections
+// cloned by initial sync, generate the keys of the inserted documents on separate threads. Unlike
+// internalIndexBuildPipelineKeyGeneration, this applies to builds of a single index.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildStreamInserts, bool, false);
+
+// The number of documents the collection scan hands to the key generation threads at a time.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildPipelineBatchSize, int, 1000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 100000) {
+            return Status(ErrorCodes::BadValue,
+                          "internalIndexBuildPipelineBatchSize must be between 1 and 100000");
+        }
+        return Status::OK();
+    });
+
+// The number of batches that may be waiting for each key generation thread before the collection
+// scan blocks.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildPipelineQueueDepth, int, 4)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 1024) {
+            return Status(ErrorCodes::BadValue,
+                          "internalIndexBuildPipelineQueueDepth must be between 1 and 1024");
+        }
+        return Status::OK();
+    });
+
 
 /**
  * On rollback sets MultiIndexBlockImpl::_needToCleanup to true.
@@ -130,15 +177,203 @@ private:
     MultiIndexBlockImpl* const _indexer;
 };
 
+/**
+ * Generates the keys for the indexes being built on up to 'maxThreads' threads, each of which owns
+ * a share of the indexes. The collection scan adds documents, which are gathered into batches and
+ * handed to every thread over a bounded queue; each thread inserts the keys for its indexes into
+ * their BulkBuilders.
+ *
+ * Batches are shared by all of the queues, so at most 'queueDepth' + 2 of them are alive at once:
+ * those waiting on the slowest thread, the one it is working on, and the one being gathered. A
+ * batch is handed off early once its documents reach that share of 'maxQueuedBytes'.
+ *
+ * The worker threads never touch the OperationContext, so the scanning thread remains its only
+ * user. If the pipeline is destroyed before finish() is called, the workers are stopped and joined.
+ */
+class MultiIndexBlockImpl::KeyGenerationPipeline {
+    MONGO_DISALLOW_COPYING(KeyGenerationPipeline);
+
+public:
+    KeyGenerationPipeline(std::vector<IndexToBuild>* indexes,
+                          size_t maxThreads,
+                          size_t batchSize,
+                          size_t queueDepth,
+                          size_t maxQueuedBytes)
+        : _batchSize(batchSize),
+          _maxBatchBytes(std::max(maxQueuedBytes / (queueDepth + 2), size_t(1))) {
+        _batch.reserve(_batchSize);
+
+        const size_t numThreads = std::min(maxThreads, indexes->size());
+        std::vector<std::vector<IndexToBuild*>> indexesPerThread(numThreads);
+        for (size_t i = 0; i < indexes->size(); ++i) {
+            invariant((*indexes)[i].bulk);
+            indexesPerThread[i % numThreads].push_back(&(*indexes)[i]);
+        }
+
+        for (auto&& threadIndexes : indexesPerThread) {
+            _queues.push_back(stdx::make_unique<BatchQueue>(queueDepth));
+            _workers.push_back(stdx::async(stdx::launch::async,
+                                           &KeyGenerationPipeline::_runWorker,
+                                           std::move(threadIndexes),
+                                           _queues.back().get()));
+        }
+    }
+
+    /**
+     * Returns the number of threads generating keys.
+     */
+    size_t numThreads() const {
+        return _workers.size();
+    }
+
+    ~KeyGenerationPipeline() {
+        if (!_finished) {
+            DESTRUCTOR_GUARD(_abort(););
+        }
+    }
+
+    /**
+     * Queues 'doc' to be indexed at 'loc'. Returns the error of a failed worker, in which case the
+     * pipeline has been shut down and must not be used again.
+     */
+    Status add(const BSONObj& doc, const RecordId& loc) {
+        invariant(!_finished);
+        _batch.emplace_back(doc.getOwned(), loc);
+        _batchBytes += doc.objsize();
+        if (_batch.size() < _batchSize && _batchBytes < _maxBatchBytes) {
+            return Status::OK();
+        }
+        return _flush();
+    }
+
+    /**
+     * Hands off any partial batch and waits for every worker to drain its queue. Returns the first
+     * error encountered by a worker.
+     */
+    Status finish() {
+        Status status = _flush();
+        if (!status.isOK()) {
+            return status;
+        }
+
+        for (auto&& queue : _queues) {
+            queue->closeProducerEnd();
+        }
+        return _join();
+    }
+
+private:
+    using Batch = std::vector<std::pair<BSONObj, RecordId>>;
+    using BatchQueue = ProducerConsumerQueue<std::shared_ptr<const Batch>>;
+
+    static Status _runWorker(std::vector<IndexToBuild*> indexes, BatchQueue* queue) {
+        try {
+            while (true) {
+                auto batch = queue->pop();
+                for (auto&& entry : *batch) {
+                    for (auto&& index : indexes) {
+                        if (index->filterExpression &&
+                            !index->filterExpression->matchesBSON(entry.first)) {
+                            continue;
+                        }
+
+                        // The BulkBuilder doesn't use the OperationContext, which can't be shared
+                        // with the scanning thread.
+                        Status status =
+                            index->bulk->insert(nullptr, entry.first, entry.second, index->options);
+                        if (!status.isOK()) {
+                            queue->closeConsumerEnd();
+                            return status;
+                        }
+                    }
+                }
+            }
+        } catch (const ExceptionFor<ErrorCodes::ProducerConsumerQueueEndClosed>&) {
+            // The producer closed the queue and every batch has been consumed, or the pipeline
+            // is being aborted.
+            return Status::OK();
+        } catch (const DBException& ex) {
+            queue->closeConsumerEnd();
+            return ex.toStatus();
+        }
+    }
+
+    Status _flush() {
+        if (_batch.empty()) {
+            return Status::OK();
+        }
+
+        auto batch = std::make_shared<const Batch>(std::move(_batch));
+        _batch.clear();
+        _batch.reserve(_batchSize);
+        _batchBytes = 0;
+
+        try {
+            for (auto&& queue : _queues) {
+                auto queuedBatch = batch;
+                queue->push(std::move(queuedBatch));
+            }
+        } catch (const ExceptionFor<ErrorCodes::ProducerConsumerQueueEndClosed>&) {
+            // A worker failed and closed its queue; report its error.
+            _abort();
+            for (auto&& status : _statuses) {
+                if (!status.isOK()) {
+                    return status;
+                }
+            }
+            MONGO_UNREACHABLE;
+        }
+        return Status::OK();
+    }
+
+    void _abort() {
+        for (auto&& queue : _queues) {
+            queue->closeConsumerEnd();
+        }
+        _join().ignore();
+    }
+
+    Status _join() {
+        _finished = true;
+        for (auto&& worker : _workers) {
+            _statuses.push_back(worker.get());
+        }
+        _workers.clear();
+
+        for (auto&& status : _statuses) {
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+        return Status::OK();
+    }
+
+    const size_t _batchSize;
+    const size_t _maxBatchBytes;
+    Batch _batch;
+    size_t _batchBytes = 0;
+
+    std::vector<std::unique_ptr<BatchQueue>> _queues;
+    std::vector<stdx::future<Status>> _workers;
+    std::vector<Status> _statuses;
+    bool _finished = false;
+};
+
 MultiIndexBlockImpl::MultiIndexBlockImpl(OperationContext* opCtx, Collection* collection)
     : _collection(collection),
       _opCtx(opCtx),
       _buildInBackground(false),
       _allowInterruption(false),
       _ignoreUnique(false),
+      _streamInserts(false),
+      _pipelineKeyGeneration(false),
+      _pipelineMaxQueuedBytes(0),
       _needToCleanup(true) {}
 
 MultiIndexBlockImpl::~MultiIndexBlockImpl() {
+    // Stop the key generation threads before the BulkBuilders they insert into go away.
+    _insertPipeline.reset();
+
     if (!_needToCleanup && !_indexes.empty()) {
         _collection->infoCache()->clearQueryCache();
     }
@@ -230,10 +465,15 @@ StatusWith<std::vector<BSONObj>> MultiIndexBlockImpl::init(const std::vector<BSO
     std::vector<BSONObj> indexInfoObjs;
     indexInfoObjs.reserve(indexSpecs.size());
     std::size_t eachIndexBuildMaxMemoryUsageBytes = 0;
+    _pipelineKeyGeneration = _shouldPipelineKeyGeneration(indexSpecs.size());
     if (!indexSpecs.empty()) {
+        // The batches queued for the key generation threads get a share of the memory limit of
+        // their own, as the BulkBuilders don't see them.
+        const std::size_t shares = indexSpecs.size() + (_pipelineKeyGeneration ? 1 : 0);
         eachIndexBuildMaxMemoryUsageBytes =
             static_cast<std::size_t>(maxIndexBuildMemoryUsageMegabytes.load()) * 1024 * 1024 /
-            indexSpecs.size();
+            shares;
+        _pipelineMaxQueuedBytes = _pipelineKeyGeneration ? eachIndexBuildMaxMemoryUsageBytes : 0;
     }
 
     for (size_t i = 0; i < indexSpecs.size(); i++) {
@@ -357,6 +597,13 @@ Status MultiIndexBlockImpl::insertAllDocumentsInCollection() {
     auto exec =
         InternalPlanner::collectionScan(_opCtx, _collection->ns().ns(), _collection, yieldPolicy);
 
+    std::unique_ptr<KeyGenerationPipeline> pipeline;
+    if (_pipelineKeyGeneration) {
+        pipeline = _makeKeyGenerationPipeline();
+        LOG(1) << "generating the keys of " << _indexes.size() << " indexes on "
+               << pipeline->numThreads() << " threads";
+    }
+
     Snapshotted<BSONObj> objToIndex;
     RecordId loc;
     PlanExecutor::ExecState state;
@@ -389,19 +636,27 @@ Status MultiIndexBlockImpl::insertAllDocumentsInCollection() {
 
             failPointHangDuringBuild(&hangBeforeIndexBuildOf, "before", objToIndex.value());
 
-            WriteUnitOfWork wunit(_opCtx);
-            Status ret = insert(objToIndex.value(), loc);
-            if (_buildInBackground)
-                exec->saveState();
-            if (!ret.isOK()) {
-                // Fail the index build hard.
-                return ret;
-            }
-            wunit.commit();
-            if (_buildInBackground) {
-                auto restoreStatus = exec->restoreState();  // Handles any WCEs internally.
-                if (!restoreStatus.isOK()) {
-                    return restoreStatus;
+            if (pipeline) {
+                Status ret = pipeline->add(objToIndex.value(), loc);
+                if (!ret.isOK()) {
+                    // Fail the index build hard.
+                    return ret;
+                }
+            } else {
+                WriteUnitOfWork wunit(_opCtx);
+                Status ret = insert(objToIndex.value(), loc);
+                if (_buildInBackground)
+                    exec->saveState();
+                if (!ret.isOK()) {
+                    // Fail the index build hard.
+                    return ret;
+                }
+                wunit.commit();
+                if (_buildInBackground) {
+                    auto restoreStatus = exec->restoreState();  // Handles any WCEs internally.
+                    if (!restoreStatus.isOK()) {
+                        return restoreStatus;
+                    }
                 }
             }
 
@@ -453,6 +708,12 @@ Status MultiIndexBlockImpl::insertAllDocumentsInCollection() {
         }
     }
 
+    if (pipeline) {
+        Status ret = pipeline->finish();
+        if (!ret.isOK())
+            return ret;
+    }
+
     progress->finished();
 
     Status ret = doneInserting();
@@ -464,7 +725,52 @@ Status MultiIndexBlockImpl::insertAllDocumentsInCollection() {
     return Status::OK();
 }
 
+bool MultiIndexBlockImpl::_shouldPipelineKeyGeneration(size_t numIndexes) const {
+    // Background builds insert into the indexes directly and yield between documents, so only
+    // foreground builds, which have a BulkBuilder for every index, are pipelined.
+    if (_buildInBackground || numIndexes == 0) {
+        return false;
+    }
+
+    // Streamed inserts have the record store insert and the caller's own work to overlap with key
+    // generation, so even a single index is worth a thread of its own there.
+    if (_streamInserts) {
+        return internalIndexBuildStreamInserts.load();
+    }
+    return internalIndexBuildPipelineKeyGeneration.load() && numIndexes >= 2;
+}
+
+std::unique_ptr<MultiIndexBlockImpl::KeyGenerationPipeline>
+MultiIndexBlockImpl::_makeKeyGenerationPipeline() {
+    invariant(_pipelineKeyGeneration);
+    return stdx::make_unique<KeyGenerationPipeline>(
+        &_indexes,
+        static_cast<size_t>(internalIndexBuildPipelineMaxThreads.load()),
+        static_cast<size_t>(internalIndexBuildPipelineBatchSize.load()),
+        static_cast<size_t>(internalIndexBuildPipelineQueueDepth.load()),
+        _pipelineMaxQueuedBytes);
+}
+
 Status MultiIndexBlockImpl::insert(const BSONObj& doc, const RecordId& loc) {
+    if (_streamInserts) {
+        if (!_insertPipeline && _pipelineKeyGeneration) {
+            _insertPipeline = _makeKeyGenerationPipeline();
+            LOG(1) << "streaming inserted documents to " << _insertPipeline->numThreads()
+                   << " key generation threads";
+        }
+        if (!_insertPipeline) {
+            _streamInserts = false;
+        } else {
+            Status status = _insertPipeline->add(doc, loc);
+            if (!status.isOK()) {
+                // The pipeline has been shut down, so any further documents are indexed here.
+                _insertPipeline.reset();
+                _streamInserts = false;
+            }
+            return status;
+        }
+    }
+
     for (size_t i = 0; i < _indexes.size(); i++) {
         if (_indexes[i].filterExpression && !_indexes[i].filterExpression->matchesBSON(doc)) {
             continue;
@@ -486,6 +792,14 @@ Status MultiIndexBlockImpl::insert(const BSONObj& doc, const RecordId& loc) {
 
 Status MultiIndexBlockImpl::doneInserting(std::set<RecordId>* dupsOut) {
     invariant(!_opCtx->lockState()->inAWriteUnitOfWork());
+    if (_insertPipeline) {
+        Status status = _insertPipeline->finish();
+        _insertPipeline.reset();
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+
     for (size_t i = 0; i < _indexes.size(); i++) {
         if (_indexes[i].bulk == NULL)
             continue;
@@ -505,6 +819,7 @@ Status MultiIndexBlockImpl::doneInserting(std::set<RecordId>* dupsOut) {
 }
 
 void MultiIndexBlockImpl::abortWithoutCleanup() {
+    _insertPipeline.reset();
     _indexes.clear();
     _needToCleanup = false;
 }
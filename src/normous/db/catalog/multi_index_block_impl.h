@@ -101,6 +101,15 @@ public:
         _ignoreUnique = true;
     }
 
+    /**
+     * Call this before init() to have insert() hand the documents to a KeyGenerationPipeline
+     * rather than generating their keys on the calling thread, if the
+     * internalIndexBuildStreamInserts server parameter allows it.
+     */
+    void streamInserts() override {
+        _streamInserts = true;
+    }
+
     /**
      * Removes pre-existing indexes from 'specs'. If this isn't done, init() may fail with
      * IndexAlreadyExists.
@@ -189,6 +198,15 @@ public:
 private:
     class SetNeedToCleanupOnRollback;
     class CleanupIndexesVectorOnRollback;
+    class KeyGenerationPipeline;
+
+    /**
+     * Returns true if the documents being indexed should be handed to a KeyGenerationPipeline
+     * rather than having the keys for all 'numIndexes' indexes generated on the calling thread.
+     */
+    bool _shouldPipelineKeyGeneration(size_t numIndexes) const;
+
+    std::unique_ptr<KeyGenerationPipeline> _makeKeyGenerationPipeline();
 
     struct IndexToBuild {
         std::unique_ptr<IndexCatalog::IndexBuildBlockInterface> block;
@@ -202,6 +220,9 @@ private:
 
     std::vector<IndexToBuild> _indexes;
 
+    // Generates the keys of the documents passed to insert() when streamInserts() was called.
+    std::unique_ptr<KeyGenerationPipeline> _insertPipeline;
+
     std::unique_ptr<BackgroundOperation> _backgroundOperation;
 
     // Pointers not owned here and must outlive 'this'
@@ -211,6 +232,11 @@ private:
     bool _buildInBackground;
     bool _allowInterruption;
     bool _ignoreUnique;
+    bool _streamInserts;
+
+    // Decided by init(), along with the share of the memory limit left to the queued batches.
+    bool _pipelineKeyGeneration;
+    std::size_t _pipelineMaxQueuedBytes;
 
     bool _needToCleanup;
 };
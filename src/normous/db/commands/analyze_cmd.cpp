@@ -0,0 +1,373 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kCommand
+
+#include "mongo/platform/basic.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/query/collection_statistics.h"
+#include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+const long long kDefaultSampleSize = 10000;
+const long long kMaxSampleSize = 1000 * 1000;
+const long long kMaxBuckets = 1000;
+
+/**
+ * Returns the field paths to gather statistics for: those named by the command, followed by the
+ * fields of every btree index on the collection.
+ */
+std::vector<std::string> getFieldsToAnalyze(OperationContext* opCtx,
+                                            Collection* collection,
+                                            const BSONObj& cmdObj) {
+    std::vector<std::string> paths;
+    const auto addPath = [&paths](std::string path) {
+        if (std::find(paths.begin(), paths.end(), path) == paths.end()) {
+            paths.push_back(std::move(path));
+        }
+    };
+
+    if (BSONElement fields = cmdObj["fields"]) {
+        uassert(50975, "'fields' must be an array of field paths", fields.type() == Array);
+        for (auto&& field : fields.Obj()) {
+            uassert(50976,
+                    "'fields' must be an array of field paths",
+                    field.type() == String && !field.valueStringData().empty());
+            addPath(field.str());
+        }
+    }
+
+    IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+    while (ii.more()) {
+        const IndexDescriptor* desc = ii.next();
+        if (IndexNames::findPluginName(desc->keyPattern()) != IndexNames::BTREE) {
+            continue;
+        }
+        for (auto&& field : desc->keyPattern()) {
+            addPath(field.fieldName());
+        }
+    }
+    return paths;
+}
+
+long long parsePositiveLong(const BSONObj& cmdObj,
+                            StringData fieldName,
+                            long long defaultValue,
+                            long long maxValue) {
+    BSONElement elt = cmdObj[fieldName];
+    if (!elt) {
+        return defaultValue;
+    }
+    uassert(50977,
+            str::stream() << "'" << fieldName << "' must be a number between 1 and " << maxValue,
+            elt.isNumber() && elt.safeNumberLong() >= 1 && elt.safeNumberLong() <= maxValue);
+    return elt.safeNumberLong();
+}
+
+/**
+ * Creates the database's statistics collection, unless it exists already.
+ */
+void createStatisticsCollection(OperationContext* opCtx, const NamespaceString& statsNss) {
+    writeConflictRetry(opCtx, "analyze", statsNss.ns(), [&] {
+        {
+            AutoGetCollection autoColl(opCtx, statsNss, MODE_IX);
+            if (autoColl.getCollection()) {
+                return;
+            }
+        }
+
+        // Creating a collection needs the database exclusively, which is why this is only done
+        // when the collection is missing.
+        AutoGetOrCreateDb autoDb(opCtx, statsNss.db(), MODE_X);
+        uassert(ErrorCodes::NotMaster,
+                str::stream() << "Not primary while creating " << statsNss.ns(),
+                repl::ReplicationCoordinator::get(opCtx)->canAcceptWritesFor(opCtx, statsNss));
+
+        Database* db = autoDb.getDb();
+        if (db->getCollection(opCtx, statsNss)) {
+            return;
+        }
+
+        WriteUnitOfWork wuow(opCtx);
+        invariant(db->createCollection(opCtx, statsNss.ns()));
+        wuow.commit();
+    });
+}
+
+/**
+ * Upserts 'statsDoc' into the database's statistics collection, creating the collection if
+ * necessary, and installs 'stats' in the analyzed collection's info cache.
+ */
+void saveStatistics(OperationContext* opCtx,
+                    const NamespaceString& nss,
+                    const BSONObj& statsDoc,
+                    std::shared_ptr<const CollectionStatistics> stats) {
+    const NamespaceString statsNss(nss.db(), CollectionStatistics::kStatisticsCollectionName);
+    createStatisticsCollection(opCtx, statsNss);
+
+    writeConflictRetry(opCtx, "analyze", statsNss.ns(), [&] {
+        // Only the statistics collection is locked exclusively, so that concurrent runs of
+        // analyze on the same collection do not both insert its document.
+        AutoGetCollection autoStatsColl(opCtx, statsNss, MODE_IX, MODE_X);
+        uassert(ErrorCodes::NotMaster,
+                str::stream() << "Not primary while saving statistics to " << statsNss.ns(),
+                repl::ReplicationCoordinator::get(opCtx)->canAcceptWritesFor(opCtx, statsNss));
+
+        Collection* statsCollection = autoStatsColl.getCollection();
+        uassert(ErrorCodes::NamespaceNotFound,
+                str::stream() << statsNss.ns() << " was dropped while saving statistics",
+                statsCollection);
+
+        Lock::CollectionLock collLock(opCtx->lockState(), nss.ns(), MODE_IS);
+        Collection* collection = autoStatsColl.getDb()->getCollection(opCtx, nss);
+        uassert(ErrorCodes::NamespaceNotFound,
+                str::stream() << "collection " << nss.ns() << " was dropped while analyzing it",
+                collection);
+
+        WriteUnitOfWork wuow(opCtx);
+        const BSONObj idQuery = BSON("_id" << nss.coll());
+        const bool requireIndex = false;
+        RecordId id = Helpers::findOne(opCtx, statsCollection, idQuery, requireIndex);
+
+        Snapshotted<BSONObj> oldDoc;
+        if (!id.isValid() || !statsCollection->findDoc(opCtx, id, &oldDoc)) {
+            uassertStatusOK(statsCollection->insertDocument(
+                opCtx, InsertStatement(statsDoc), &CurOp::get(opCtx)->debug()));
+        } else {
+            CollectionUpdateArgs args;
+            args.update = statsDoc;
+            args.criteria = idQuery;
+            args.fromMigrate = false;
+
+            const bool assumeIndexesAreAffected = true;
+            statsCollection->updateDocument(opCtx,
+                                            id,
+                                            oldDoc,
+                                            statsDoc,
+                                            assumeIndexesAreAffected,
+                                            &CurOp::get(opCtx)->debug(),
+                                            &args);
+        }
+        wuow.commit();
+
+        collection->infoCache()->setCollectionStatistics(stats);
+    });
+}
+
+/**
+ * Reads the statistics last saved for 'nss' and installs them in the collection's info cache.
+ */
+void reloadStatistics(OperationContext* opCtx, const NamespaceString& nss) {
+    const NamespaceString statsNss(nss.db(), CollectionStatistics::kStatisticsCollectionName);
+
+    BSONObj statsDoc;
+    {
+        AutoGetCollectionForReadCommand ctx(opCtx, statsNss);
+        Collection* statsCollection = ctx.getCollection();
+        const bool found = statsCollection &&
+            Helpers::findById(
+                opCtx, ctx.getDb(), statsNss.ns(), BSON("_id" << nss.coll()), statsDoc);
+        uassert(ErrorCodes::NoSuchKey,
+                str::stream() << "no statistics have been saved for " << nss.ns(),
+                found);
+    }
+
+    auto stats = uassertStatusOK(CollectionStatistics::parse(statsDoc));
+
+    AutoGetCollection autoColl(opCtx, nss, MODE_IX);
+    uassert(ErrorCodes::NamespaceNotFound,
+            str::stream() << "collection " << nss.ns() << " does not exist",
+            autoColl.getCollection());
+    autoColl.getCollection()->infoCache()->setCollectionStatistics(
+        std::make_shared<CollectionStatistics>(std::move(stats)));
+}
+
+/**
+ * { analyze: <collection>, [fields: [<path>, ...]], [sampleSize: <n>], [buckets: <n>],
+ *   [reload: <bool>] }
+ *
+ * Samples the collection and builds a histogram and distinct-count estimate for every field of
+ * its btree indexes, along with any other fields named in 'fields'. The statistics are saved in
+ * the database's system.statistics collection and used by the query planner to discard
+ * candidate plans which are estimated to do far more work than the cheapest one, and to replan
+ * cached plans which are estimated to be poor for a query's parameters.
+ *
+ * Statistics are only installed on the node which gathers or reloads them. With 'reload', the
+ * saved statistics are installed without sampling the collection again, for instance after a
+ * restart.
+ */
+class AnalyzeCmd : public BasicCommand {
+public:
+    AnalyzeCmd() : BasicCommand("analyze") {}
+
+    bool supportsWriteConcern(const BSONObj& cmd) const override {
+        return true;
+    }
+
+    AllowedOnSecondary secondaryAllowed(ServiceContext*) const override {
+        return AllowedOnSecondary::kNever;
+    }
+
+    bool adminOnly() const override {
+        return false;
+    }
+
+    std::string help() const override {
+        return "gather statistics used to plan queries over a collection\n"
+               "{ analyze: <collection>, [fields: [<path>, ...]], [sampleSize: <n>],\n"
+               "  [buckets: <n>], [reload: <bool>] }";
+    }
+
+    void addRequiredPrivileges(const std::string& dbname,
+                               const BSONObj& cmdObj,
+                               std::vector<Privilege>* out) const override {
+        ActionSet actions;
+        actions.addAction(ActionType::find);
+        actions.addAction(ActionType::planCacheWrite);
+        out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+    }
+
+    bool run(OperationContext* opCtx,
+             const std::string& dbname,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        const NamespaceString nss(CommandHelpers::parseNsCollectionRequired(dbname, cmdObj));
+        uassert(ErrorCodes::InvalidNamespace,
+                str::stream() << "cannot analyze " << nss.ns(),
+                nss.isNormal() && !nss.isSystem());
+
+        if (cmdObj["reload"].trueValue()) {
+            reloadStatistics(opCtx, nss);
+            return true;
+        }
+
+        const long long sampleSize =
+            parsePositiveLong(cmdObj, "sampleSize", kDefaultSampleSize, kMaxSampleSize);
+        const long long numBuckets =
+            parsePositiveLong(cmdObj, "buckets", FieldStatistics::kDefaultNumBuckets, kMaxBuckets);
+
+        std::shared_ptr<CollectionStatistics> stats;
+        {
+            AutoGetCollectionForReadCommand ctx(
+                opCtx, nss, AutoGetCollection::ViewMode::kViewsPermitted);
+            uassert(ErrorCodes::CommandNotSupportedOnView, "can't analyze a view", !ctx.getView());
+
+            Collection* collection = ctx.getCollection();
+            uassert(ErrorCodes::NamespaceNotFound,
+                    str::stream() << "collection " << nss.ns() << " does not exist",
+                    collection);
+
+            const std::vector<std::string> paths =
+                getFieldsToAnalyze(opCtx, collection, cmdObj);
+            std::vector<FieldStatistics::Builder> builders;
+            for (auto&& path : paths) {
+                builders.emplace_back(path);
+            }
+
+            // Collections no larger than the sample are read in full. Otherwise documents are
+            // drawn at random, if the storage engine supports it, which may return a document
+            // more than once.
+            const long long numRecords = collection->numRecords(opCtx);
+            std::unique_ptr<RecordCursor> cursor;
+            if (numRecords > sampleSize) {
+                cursor = collection->getRecordStore()->getRandomCursor(opCtx);
+            }
+            if (!cursor) {
+                cursor = collection->getCursor(opCtx);
+            }
+
+            long long numSampled = 0;
+            while (numSampled < sampleSize) {
+                auto record = cursor->next();
+                if (!record) {
+                    break;
+                }
+                if (++numSampled % 128 == 0) {
+                    opCtx->checkForInterrupt();
+                }
+
+                const BSONObj doc = record->data.releaseToBson();
+                for (auto&& builder : builders) {
+                    builder.addDocument(doc);
+                }
+            }
+
+            stats = std::make_shared<CollectionStatistics>(numRecords);
+            for (size_t i = 0; i < builders.size(); ++i) {
+                stats->setField(paths[i], builders[i].done(numRecords, numBuckets));
+            }
+        }
+
+        const BSONObj statsDoc = stats->toBSON(nss.coll());
+        uassert(ErrorCodes::BSONObjectTooLarge,
+                "statistics are too large to save; analyze fewer fields or use fewer buckets",
+                statsDoc.objsize() <= BSONObjMaxUserSize);
+        saveStatistics(opCtx, nss, statsDoc, stats);
+
+        log() << "analyze " << nss.ns() << ": gathered statistics for " << stats->getFields().size()
+              << " fields";
+
+        result.append("numRecords", stats->getNumRecords());
+        BSONArrayBuilder fields(result.subarrayStart("fields"));
+        for (auto&& field : stats->getFields()) {
+            BSONObjBuilder fieldBob(fields.subobjStart());
+            fieldBob.append("path", field.first);
+            fieldBob.append("numSampled", field.second.getNumSampled());
+            fieldBob.append("numDistinct", field.second.getNumDistinct());
+            fieldBob.append("numBuckets", static_cast<long long>(field.second.numBuckets()));
+            fieldBob.append("hasArrays", field.second.hasArrays());
+        }
+        fields.doneFast();
+        return true;
+    }
+} analyzeCmd;
+
+}  // namespace
+}  // namespace mongo
@@ -331,7 +331,7 @@ boost::intrusive_ptr<ExpressionContext> makeExpressionContext(
                               MongoProcessInterface::create(opCtx),
                               uassertStatusOK(resolveInvolvedNamespaces(opCtx, request)),
                               uuid);
-    expCtx->tempDir = storageGlobalParams.dbpath + "/_tmp";
+    expCtx->tempDir = storageGlobalParams.getSpillDirectory();
     auto txnParticipant = TransactionParticipant::get(opCtx);
     expCtx->inMultiDocumentTransaction =
         txnParticipant && txnParticipant->inMultiDocumentTransaction();
@@ -0,0 +1,175 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/bitmap_merge.h"
+
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+using std::unique_ptr;
+using stdx::make_unique;
+
+// static
+const char* BitmapMergeStage::kIntersectionStageType = "AND_BITMAP";
+const char* BitmapMergeStage::kUnionStageType = "OR_BITMAP";
+
+BitmapMergeStage::BitmapMergeStage(OperationContext* opCtx, WorkingSet* ws, MergeType mergeType)
+    : BitmapMergeStage(opCtx,
+                       ws,
+                       mergeType,
+                       static_cast<size_t>(internalQueryBitmapMergeMaxMemoryBytes.load())) {}
+
+BitmapMergeStage::BitmapMergeStage(OperationContext* opCtx,
+                                   WorkingSet* ws,
+                                   MergeType mergeType,
+                                   size_t maxMemUsage)
+    : PlanStage(mergeType == MergeType::kIntersection ? kIntersectionStageType : kUnionStageType,
+                opCtx),
+      _ws(ws),
+      _mergeType(mergeType),
+      _maxMemUsage(maxMemUsage) {}
+
+void BitmapMergeStage::addChild(PlanStage* child) {
+    _children.emplace_back(child);
+}
+
+bool BitmapMergeStage::isEOF() {
+    return !_readingChildren && !_output.more();
+}
+
+PlanStage::StageState BitmapMergeStage::doWork(WorkingSetID* out) {
+    if (isEOF()) {
+        return PlanStage::IS_EOF;
+    }
+
+    if (_readingChildren) {
+        return readChild(out);
+    }
+
+    // Only the RecordId is known, which is why the planner puts a fetch of the entire predicate
+    // above this stage.
+    WorkingSetID id = _ws->allocate();
+    WorkingSetMember* member = _ws->get(id);
+    member->recordId = _output.next();
+    _ws->transitionToRecordIdAndIdx(id);
+
+    *out = id;
+    return PlanStage::ADVANCED;
+}
+
+PlanStage::StageState BitmapMergeStage::readChild(WorkingSetID* out) {
+    WorkingSetID id = WorkingSet::INVALID_ID;
+    StageState childStatus = _children[_currentChild]->work(&id);
+
+    if (PlanStage::ADVANCED == childStatus) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // The child must give us a WorkingSetMember with a record id, since we merge index keys
+        // based on the record id. The planner ensures that the child stage can never produce an WSM
+        // with no record id.
+        invariant(member->hasRecordId());
+        const RecordId recordId = member->recordId;
+        _ws->free(id);
+
+        if (_mergeType == MergeType::kUnion || 0 == _currentChild) {
+            _bitmap.add(recordId);
+        } else if (_bitmap.contains(recordId)) {
+            _childBitmap.add(recordId);
+        }
+
+        if (getMemUsage() > _maxMemUsage) {
+            mongoutils::str::stream ss;
+            ss << "bitmap " << (_mergeType == MergeType::kIntersection ? "AND" : "OR")
+               << " stage buffered data usage of " << getMemUsage()
+               << " bytes exceeds internal limit of " << _maxMemUsage << " bytes";
+            Status status(ErrorCodes::Overflow, ss);
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+            return PlanStage::FAILURE;
+        }
+
+        return PlanStage::NEED_TIME;
+    } else if (PlanStage::IS_EOF == childStatus) {
+        if (_mergeType == MergeType::kIntersection && _currentChild > 0) {
+            _bitmap.swap(_childBitmap);
+            _childBitmap.clear();
+        }
+        _specificStats.bitmapAfterChild.push_back(_bitmap.cardinality());
+        ++_currentChild;
+
+        // Once an intersection is empty, the remaining children cannot add anything to it.
+        if (_currentChild == _children.size() ||
+            (_mergeType == MergeType::kIntersection && _bitmap.empty())) {
+            _readingChildren = false;
+            _output = _bitmap.begin();
+            _specificStats.containers = _bitmap.numContainers();
+            _specificStats.bitsetContainers = _bitmap.numBitsetContainers();
+        }
+
+        return PlanStage::NEED_TIME;
+    } else if (PlanStage::FAILURE == childStatus || PlanStage::DEAD == childStatus) {
+        // The stage which produces a failure is responsible for allocating a working set member
+        // with error details.
+        invariant(WorkingSet::INVALID_ID != id);
+        *out = id;
+        return childStatus;
+    } else {
+        if (PlanStage::NEED_YIELD == childStatus) {
+            *out = id;
+        }
+
+        return childStatus;
+    }
+}
+
+unique_ptr<PlanStageStats> BitmapMergeStage::getStats() {
+    _commonStats.isEOF = isEOF();
+
+    _specificStats.memLimit = _maxMemUsage;
+    _specificStats.memUsage = getMemUsage();
+
+    unique_ptr<PlanStageStats> ret = make_unique<PlanStageStats>(_commonStats, stageType());
+    ret->specific = make_unique<BitmapMergeStats>(_specificStats);
+    for (size_t i = 0; i < _children.size(); ++i) {
+        ret->children.emplace_back(_children[i]->getStats());
+    }
+
+    return ret;
+}
+
+const SpecificStats* BitmapMergeStage::getSpecificStats() const {
+    return &_specificStats;
+}
+
+}  // namespace mongo
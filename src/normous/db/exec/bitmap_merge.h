@@ -0,0 +1,112 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/record_id_bitmap.h"
+
+namespace mongo {
+
+/**
+ * Reads all of the RecordIds produced by its N children into a RecordIdBitmap and outputs their
+ * intersection or their union, in ascending order of RecordId. The bitmap takes a fraction of the
+ * memory of the hash table of an AndHashStage, and unions need no hash set to deduplicate.
+ *
+ * Only RecordIds are output, so a fetch above this stage must evaluate the entire predicate.
+ *
+ * Preconditions: Valid RecordId. More than one child.
+ */
+class BitmapMergeStage final : public PlanStage {
+public:
+    enum class MergeType {
+        kIntersection,
+        kUnion,
+    };
+
+    BitmapMergeStage(OperationContext* opCtx, WorkingSet* ws, MergeType mergeType);
+
+    /**
+     * For testing only. Allows tests to set memory usage threshold.
+     */
+    BitmapMergeStage(OperationContext* opCtx,
+                     WorkingSet* ws,
+                     MergeType mergeType,
+                     size_t maxMemUsage);
+
+    void addChild(PlanStage* child);
+
+    StageState doWork(WorkingSetID* out) final;
+    bool isEOF() final;
+
+    StageType stageType() const final {
+        return _mergeType == MergeType::kIntersection ? STAGE_AND_BITMAP : STAGE_OR_BITMAP;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+    static const char* kIntersectionStageType;
+    static const char* kUnionStageType;
+
+private:
+    StageState readChild(WorkingSetID* out);
+
+    size_t getMemUsage() const {
+        return _bitmap.getMemUsage() + _childBitmap.getMemUsage();
+    }
+
+    // Not owned by us.
+    WorkingSet* _ws;
+
+    const MergeType _mergeType;
+
+    // The RecordIds produced by every child read so far for an intersection, or by any child
+    // read so far for a union.
+    RecordIdBitmap _bitmap;
+
+    // For an intersection, those RecordIds of the child being read which are also in '_bitmap'.
+    RecordIdBitmap _childBitmap;
+
+    // Which child are we currently reading?
+    size_t _currentChild = 0;
+
+    // True until every child which can contribute to the result has been read.
+    bool _readingChildren = true;
+
+    // Our position in '_bitmap' once we are returning results.
+    RecordIdBitmap::Iterator _output;
+
+    // Upper limit for the memory usage of the bitmaps.
+    size_t _maxMemUsage;
+
+    BitmapMergeStats _specificStats;
+};
+
+}  // namespace mongo
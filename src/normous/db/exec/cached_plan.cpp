@@ -37,6 +37,7 @@
 #include "mongo/db/exec/multi_plan.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/collection_statistics.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
@@ -60,13 +61,17 @@ CachedPlanStage::CachedPlanStage(OperationContext* opCtx,
                                  CanonicalQuery* cq,
                                  const QueryPlannerParams& params,
                                  size_t decisionWorks,
-                                 PlanStage* root)
+                                 PlanStage* root,
+                                 boost::optional<double> estimatedScanFraction,
+                                 boost::optional<double> cheapestEstimatedScanFraction)
     : PlanStage(kStageType, opCtx),
       _collection(collection),
       _ws(ws),
       _canonicalQuery(cq),
       _plannerParams(params),
-      _decisionWorks(decisionWorks) {
+      _decisionWorks(decisionWorks),
+      _estimatedScanFraction(estimatedScanFraction),
+      _cheapestEstimatedScanFraction(cheapestEstimatedScanFraction) {
     invariant(_collection);
     _children.emplace_back(root);
 }
@@ -77,6 +82,17 @@ Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     // make sense.
     ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
 
+    if (shouldReplanFromStatistics()) {
+        LOG(1) << "Collection statistics estimate that the cached plan examines "
+               << *_estimatedScanFraction
+               << " of the collection, far more than the cheapest alternative. Evicting cache "
+               << "entry and replanning query: " << redact(_canonicalQuery->toStringShort())
+               << " plan summary before replan: " << Explain::getPlanSummary(child().get());
+
+        const bool shouldCache = true;
+        return replan(yieldPolicy, shouldCache);
+    }
+
     // If we work this many times during the trial period, then we will replan the
     // query from scratch.
     size_t maxWorksBeforeReplan =
@@ -168,6 +184,29 @@ Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     return replan(yieldPolicy, shouldCache);
 }
 
+bool CachedPlanStage::shouldReplanFromStatistics() const {
+    // This mirrors pruneSolutionsByEstimatedCost() in the query planner, so that a plan is only
+    // evicted if replanning would prune it. Otherwise the same plan could win the trial period
+    // again, be cached again, and be evicted again by the next query of this shape.
+    const auto& stats = _plannerParams.collectionStats;
+    const double pruneRatio = internalQueryPlannerStatsPruneRatio.load();
+    const QueryRequest& qr = _canonicalQuery->getQueryRequest();
+    if (!stats || !_estimatedScanFraction || !_cheapestEstimatedScanFraction || pruneRatio == 0.0 ||
+        !qr.getSort().isEmpty() || qr.getLimit() || qr.getNToReturn() || qr.isTailable()) {
+        return false;
+    }
+
+    // A plan which would finish within the budget of a trial period anyway is not pruned.
+    const double trialWorks = internalQueryPlanEvaluationWorks.load();
+    if (*_estimatedScanFraction * stats->getNumRecords() <= trialWorks) {
+        return false;
+    }
+
+    // The cheapest candidate was estimated when the plan was cached, so that this check does not
+    // have to enumerate the candidate plans on every use of the cache entry.
+    return *_estimatedScanFraction > pruneRatio * *_cheapestEstimatedScanFraction;
+}
+
 Status CachedPlanStage::tryYield(PlanYieldPolicy* yieldPolicy) {
     // These are the conditions which can cause us to yield:
     //   1) The yield policy's timer elapsed, or
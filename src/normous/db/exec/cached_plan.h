@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 #include <queue>
 
@@ -58,7 +59,9 @@ public:
                     CanonicalQuery* cq,
                     const QueryPlannerParams& params,
                     size_t decisionWorks,
-                    PlanStage* root);
+                    PlanStage* root,
+                    boost::optional<double> estimatedScanFraction = boost::none,
+                    boost::optional<double> cheapestEstimatedScanFraction = boost::none);
 
     bool isEOF() final;
 
@@ -104,6 +107,15 @@ private:
      */
     Status replan(PlanYieldPolicy* yieldPolicy, bool shouldCache);
 
+    /**
+     * Returns true if the collection statistics estimate that, for this query's parameters, the
+     * cached plan examines more than internalQueryPlannerStatsPruneRatio times as many keys and
+     * documents as the cheapest candidate did when the plan was cached, and could not finish
+     * within a trial period. The planner would then prune the cached plan, so it is not worth a
+     * trial period either.
+     */
+    bool shouldReplanFromStatistics() const;
+
     /**
      * May yield during the cached plan stage's trial period or replanning phases.
      *
@@ -128,6 +140,14 @@ private:
     // cached.
     size_t _decisionWorks;
 
+    // The fraction of the collection the cached plan is estimated to examine, when the collection
+    // has statistics which can estimate it.
+    boost::optional<double> _estimatedScanFraction;
+
+    // The smallest fraction of the collection which any candidate plan was estimated to examine
+    // when the plan was cached.
+    boost::optional<double> _cheapestEstimatedScanFraction;
+
     // If we fall back to re-planning the query, and there is just one resulting query solution,
     // that solution is owned here.
     std::unique_ptr<QuerySolution> _replannedQs;
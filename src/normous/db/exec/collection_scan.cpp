@@ -38,6 +38,7 @@
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/optime.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/fail_point_service.h"
@@ -67,6 +68,12 @@ CollectionScan::CollectionScan(OperationContext* opCtx,
     _specificStats.direction = params.direction;
     _specificStats.maxTs = params.maxTs;
     invariant(!_params.shouldTrackLatestOplogTimestamp || _params.collection->ns().isOplog());
+    invariant((_params.minRecord.isNull() && _params.maxRecord.isNull()) ||
+              (_params.direction == CollectionScanParams::FORWARD && !_params.tailable));
+
+    if (_filter && internalQueryEnableCompiledFilters.load()) {
+        _compiledFilter = stdx::make_unique<CompiledMatchExpression>(_filter);
+    }
 
     if (params.maxTs) {
         _endConditionBSON = BSON("$gte" << *(params.maxTs));
@@ -137,6 +144,15 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
                 }
             }
 
+            if (!_params.minRecord.isNull() && !_cursor->seekAtOrAfter(_params.minRecord)) {
+                Status status(ErrorCodes::IllegalOperation,
+                              str::stream() << "CollectionScan could not position its cursor at "
+                                            << "the start of its range: "
+                                            << _params.minRecord);
+                *out = WorkingSetCommon::allocateStatusMember(_workingSet, status);
+                return PlanStage::FAILURE;
+            }
+
             return PlanStage::NEED_TIME;
         }
 
@@ -166,6 +182,11 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
+    if (!_params.maxRecord.isNull() && record->id >= _params.maxRecord) {
+        _commonStats.isEOF = true;
+        return PlanStage::IS_EOF;
+    }
+
     _lastSeenId = record->id;
     if (_params.shouldTrackLatestOplogTimestamp) {
         auto status = setLatestOplogEntryTimestamp(*record);
@@ -202,9 +223,10 @@ PlanStage::StageState CollectionScan::returnIfMatches(WorkingSetMember* member,
                                                       WorkingSetID* out) {
     ++_specificStats.docsTested;
 
-    if (Filter::passes(member, _filter)) {
+    if (Filter::passes(member, _filter, _compiledFilter.get())) {
         if (_params.stopApplyingFilterAfterFirstMatch) {
             _filter = nullptr;
+            _compiledFilter.reset();
         }
         *out = memberID;
         return PlanStage::ADVANCED;
@@ -48,6 +48,12 @@ struct CollectionScanParams {
     // The RecordId to which we should seek to as the first document of the scan.
     RecordId start;
 
+    // If not null, a forward scan over the records with ids in the range [minRecord, maxRecord).
+    // Unlike 'start', 'minRecord' need not be the id of an existing record. Only supported by
+    // storage engines whose cursors implement SeekableRecordCursor::seekAtOrAfter().
+    RecordId minRecord;
+    RecordId maxRecord;
+
     // If present, the collection scan will stop and return EOF the first time it sees a document
     // that does not pass the filter and has 'ts' greater than 'maxTs'.
     boost::optional<Timestamp> maxTs;
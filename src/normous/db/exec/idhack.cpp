@@ -148,8 +148,8 @@ PlanStage::StageState IDHackStage::advance(WorkingSetID id,
 
     if (_addKeyMetadata) {
         BSONObj ownedKeyObj = member->obj.value()["_id"].wrap().getOwned();
-        member->addComputed(
-            new IndexKeyComputedData(IndexKeyComputedData::rehydrateKey(_key, ownedKeyObj)));
+        member->emplaceComputed<IndexKeyComputedData>(
+            IndexKeyComputedData::rehydrateKey(_key, ownedKeyObj));
     }
 
     _done = true;
@@ -212,8 +212,8 @@ PlanStage::StageState IndexScan::doWork(WorkingSetID* out) {
     _workingSet->transitionToRecordIdAndIdx(id);
 
     if (_params.addKeyMetadata) {
-        member->addComputed(
-            new IndexKeyComputedData(IndexKeyComputedData::rehydrateKey(_keyPattern, kv->key)));
+        member->emplaceComputed<IndexKeyComputedData>(
+            IndexKeyComputedData::rehydrateKey(_keyPattern, kv->key));
     }
 
     *out = id;
@@ -39,13 +39,20 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
+#include "mongo/db/concurrency/locker_noop.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/repl/read_concern_args.h"
+#include "mongo/db/service_context.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -57,6 +64,147 @@ using std::unique_ptr;
 using std::vector;
 using stdx::make_unique;
 
+namespace {
+
+/**
+ * Returns the pool which runs the trial periods of all the MultiPlanStages in the process. It is
+ * created on first use and never destroyed.
+ */
+ThreadPool* getTrialThreadPool() {
+    static ThreadPool* pool = [] {
+        ThreadPool::Options options;
+        options.poolName = "multi-planner trial pool";
+        options.threadNamePrefix = "planTrial-";
+        options.minThreads = 0;
+        options.maxThreads = internalQueryMultiPlannerTrialThreads;
+        options.onCreateThread = [](const std::string& name) { Client::initThread(name); };
+        auto pool = new ThreadPool(options);
+        pool->startup();
+        return pool;
+    }();
+    return pool;
+}
+
+/**
+ * Returns true if the trial periods of the plans for 'opCtx' may run on other operation
+ * contexts. Those read from the latest data under storage snapshots of their own, which only
+ * plain reads at local read concern can tolerate.
+ */
+bool canRunTrialsInParallel(OperationContext* opCtx) {
+    if (!internalQueryMultiPlannerParallelTrials.load() ||
+        opCtx->lockState()->inAWriteUnitOfWork() ||
+        opCtx->recoveryUnit()->getTimestampReadSource() != RecoveryUnit::ReadSource::kUnset) {
+        return false;
+    }
+
+    const auto& readConcernArgs = repl::ReadConcernArgs::get(opCtx);
+    return readConcernArgs.isEmpty() ||
+        readConcernArgs.getLevel() == repl::ReadConcernLevel::kLocalReadConcern;
+}
+
+/**
+ * The state shared by the threads which run the trial periods of one MultiPlanStage.
+ */
+struct ParallelTrials {
+    ParallelTrials(size_t numCandidates, size_t numWorks)
+        : workBudget(numWorks),
+          statuses(numCandidates, Status::OK()),
+          failureIds(numCandidates, WorkingSet::INVALID_ID) {}
+
+    /**
+     * Ends the trial period once every candidate has been worked 'works' times, unless it was
+     * already due to end sooner.
+     */
+    void endAfter(size_t works) {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        if (works < workBudget.load()) {
+            workBudget.store(works);
+        }
+    }
+
+    stdx::mutex mutex;
+    stdx::condition_variable trialDone;
+    size_t activeTrials = 0;
+
+    // The number of times each candidate is worked. Once any plan hits EOF or returns enough
+    // results, this drops to the number of works that plan took, so that every candidate is
+    // ranked on the same amount of work however long it waited for a pool thread. It drops to 0
+    // once the operation is interrupted.
+    AtomicWord<size_t> workBudget;
+
+    // Why each failed candidate failed, either as an error or as the status member it returned.
+    std::vector<Status> statuses;
+    std::vector<WorkingSetID> failureIds;
+};
+
+/**
+ * Runs the trial period of 'candidate' on the calling pool thread. The tree must have been saved
+ * and detached from its operation context, and is returned in the same condition.
+ */
+void runTrial(CandidatePlan* candidate,
+              size_t candidateIdx,
+              size_t numResults,
+              ParallelTrials* trials) {
+    auto opCtx = cc().makeOperationContext();
+
+    // The operation which started the trial holds the locks the plan needs and waits for it to
+    // finish, so the trial must neither acquire nor release any locks of its own.
+    opCtx->swapLockState(stdx::make_unique<LockerNoop>());
+
+    PlanStage* root = candidate->root;
+    root->reattachToOperationContext(opCtx.get());
+
+    Status status = Status::OK();
+    try {
+        root->restoreState();
+
+        // A candidate which only gets a thread after another plan ended the trial period is still
+        // worked as many times as that plan was, as it would have been had they run side by side.
+        for (size_t ix = 0; ix < trials->workBudget.load(); ++ix) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = root->work(&id);
+
+            if (PlanStage::ADVANCED == state) {
+                candidate->ws->get(id)->makeObjOwnedIfNeeded();
+                candidate->results.push(id);
+                if (candidate->results.size() >= numResults) {
+                    trials->endAfter(ix + 1);
+                }
+            } else if (PlanStage::IS_EOF == state) {
+                trials->endAfter(ix + 1);
+                break;
+            } else if (PlanStage::NEED_YIELD == state) {
+                // There are no locks to give up, but a newer snapshot may resolve the conflict.
+                WorkingSetCommon::prepareForSnapshotChange(candidate->ws);
+                root->saveState();
+                opCtx->recoveryUnit()->abandonSnapshot();
+                root->restoreState();
+            } else if (PlanStage::NEED_TIME != state) {
+                candidate->failed = true;
+                if (PlanStage::FAILURE == state) {
+                    trials->failureIds[candidateIdx] = id;
+                }
+                break;
+            }
+        }
+
+        WorkingSetCommon::prepareForSnapshotChange(candidate->ws);
+        root->saveState();
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+        candidate->failed = true;
+    }
+
+    root->detachFromOperationContext();
+
+    stdx::lock_guard<stdx::mutex> lk(trials->mutex);
+    trials->statuses[candidateIdx] = status;
+    --trials->activeTrials;
+    trials->trialDone.notify_all();
+}
+
+}  // namespace
+
 // static
 const char* MultiPlanStage::kStageType = "MULTI_PLAN";
 
@@ -83,6 +231,21 @@ void MultiPlanStage::addPlan(std::unique_ptr<QuerySolution> solution,
     _children.emplace_back(root);
 }
 
+WorkingSet* MultiPlanStage::getCandidateWorkingSet(WorkingSet* sharedWs) {
+    // Whether the trials run concurrently is decided once, for all of the candidates.
+    if (_candidates.empty()) {
+        _sharedWs = canRunTrialsInParallel(getOpCtx()) ? sharedWs : nullptr;
+    }
+
+    if (!_sharedWs) {
+        return sharedWs;
+    }
+
+    invariant(_sharedWs == sharedWs);
+    _candidateWorkingSets.push_back(stdx::make_unique<WorkingSet>());
+    return _candidateWorkingSets.back().get();
+}
+
 bool MultiPlanStage::isEOF() {
     if (_failure) {
         return true;
@@ -109,7 +272,7 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
 
     // Look for an already produced result that provides the data the caller wants.
     if (!bestPlan.results.empty()) {
-        *out = bestPlan.results.front();
+        *out = toSharedWorkingSet(_bestPlanIdx, bestPlan.results.front());
         bestPlan.results.pop();
         return PlanStage::ADVANCED;
     }
@@ -117,6 +280,7 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
     // best plan had no (or has no more) cached results
 
     StageState state = bestPlan.root->work(out);
+    *out = toSharedWorkingSet(_bestPlanIdx, *out);
 
     if (PlanStage::FAILURE == state && hasBackupPlan()) {
         LOG(5) << "Best plan errored out switching to backup";
@@ -133,7 +297,9 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
         _bestPlanIdx = _backupPlanIdx;
         _backupPlanIdx = kNoSuchPlan;
 
-        return _candidates[_bestPlanIdx].root->work(out);
+        state = _candidates[_bestPlanIdx].root->work(out);
+        *out = toSharedWorkingSet(_bestPlanIdx, *out);
+        return state;
     }
 
     if (hasBackupPlan() && PlanStage::ADVANCED == state) {
@@ -144,6 +310,20 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
     return state;
 }
 
+WorkingSetID MultiPlanStage::toSharedWorkingSet(size_t candidateIdx, WorkingSetID id) {
+    if (!_sharedWs || WorkingSet::INVALID_ID == id) {
+        return id;
+    }
+    return _sharedWs->transferMember(_candidates[candidateIdx].ws, id);
+}
+
+void MultiPlanStage::doSaveState() {
+    // The caller only prepares its own WorkingSet for the snapshot to change.
+    for (auto&& ws : _candidateWorkingSets) {
+        WorkingSetCommon::prepareForSnapshotChange(ws.get());
+    }
+}
+
 Status MultiPlanStage::tryYield(PlanYieldPolicy* yieldPolicy) {
     // These are the conditions which can cause us to yield:
     //   1) The yield policy's timer elapsed, or
@@ -205,12 +385,19 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     size_t numWorks = getTrialPeriodWorks(getOpCtx(), _collection);
     size_t numResults = getTrialPeriodNumToReturn(*_query);
 
-    // Work the plans, stopping when a plan hits EOF or returns some
-    // fixed number of results.
-    for (size_t ix = 0; ix < numWorks; ++ix) {
-        bool moreToDo = workAllPlans(numResults, yieldPolicy);
-        if (!moreToDo) {
-            break;
+    if (_sharedWs) {
+        Status status = runTrialsInParallel(numWorks, numResults);
+        if (!status.isOK()) {
+            return status;
+        }
+    } else {
+        // Work the plans, stopping when a plan hits EOF or returns some
+        // fixed number of results.
+        for (size_t ix = 0; ix < numWorks; ++ix) {
+            bool moreToDo = workAllPlans(numResults, yieldPolicy);
+            if (!moreToDo) {
+                break;
+            }
         }
     }
 
@@ -324,7 +511,9 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
                 ->set(*_query,
                       solutions,
                       std::move(ranking),
-                      getOpCtx()->getServiceContext()->getPreciseClockSource()->now())
+                      getOpCtx()->getServiceContext()->getPreciseClockSource()->now(),
+                      boost::none,
+                      _collection->infoCache()->getCollectionStatistics().get())
                 .transitional_ignore();
         }
     }
@@ -332,6 +521,90 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     return Status::OK();
 }
 
+Status MultiPlanStage::runTrialsInParallel(size_t numWorks, size_t numResults) {
+    OperationContext* opCtx = getOpCtx();
+    ParallelTrials trials(_candidates.size(), numWorks);
+
+    // Each tree is handed to a pool thread, which works it on an operation context and under a
+    // storage snapshot of its own.
+    for (auto&& candidate : _candidates) {
+        WorkingSetCommon::prepareForSnapshotChange(candidate.ws);
+        candidate.root->saveState();
+        candidate.root->detachFromOperationContext();
+    }
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(trials.mutex);
+        trials.activeTrials = _candidates.size();
+    }
+
+    for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+        CandidatePlan* candidate = &_candidates[ix];
+        Status scheduleStatus = getTrialThreadPool()->schedule([=, &trials] {
+            runTrial(candidate, ix, numResults, &trials);
+        });
+        if (!scheduleStatus.isOK()) {
+            candidate->failed = true;
+            stdx::lock_guard<stdx::mutex> lk(trials.mutex);
+            trials.statuses[ix] = scheduleStatus;
+            --trials.activeTrials;
+        }
+    }
+
+    Status interruptStatus = Status::OK();
+    {
+        stdx::unique_lock<stdx::mutex> lk(trials.mutex);
+        try {
+            opCtx->waitForConditionOrInterrupt(
+                trials.trialDone, lk, [&] { return trials.activeTrials == 0; });
+        } catch (const DBException& ex) {
+            // The trees and 'trials' are in use until every trial has noticed that it must stop.
+            interruptStatus = ex.toStatus();
+            trials.workBudget.store(0);
+            trials.trialDone.wait(lk, [&] { return trials.activeTrials == 0; });
+        }
+    }
+
+    // The trials may have seen newer data than the snapshot this operation had open.
+    opCtx->recoveryUnit()->abandonSnapshot();
+    for (auto&& candidate : _candidates) {
+        candidate.root->reattachToOperationContext(opCtx);
+        candidate.root->restoreState();
+    }
+
+    if (!interruptStatus.isOK()) {
+        _failure = true;
+        _statusMemberId = WorkingSetCommon::allocateStatusMember(_sharedWs, interruptStatus);
+        return interruptStatus;
+    }
+
+    Status lastFailure = Status::OK();
+    for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+        if (!_candidates[ix].failed) {
+            continue;
+        }
+
+        ++_failureCount;
+        if (!trials.statuses[ix].isOK()) {
+            lastFailure = trials.statuses[ix];
+        } else if (WorkingSet::INVALID_ID != trials.failureIds[ix]) {
+            lastFailure =
+                WorkingSetCommon::getMemberStatus(*_candidates[ix].ws->get(trials.failureIds[ix]));
+        }
+    }
+
+    if (_failureCount == _candidates.size()) {
+        if (lastFailure.isOK()) {
+            lastFailure = Status(ErrorCodes::InternalError, "all candidate plans died");
+        }
+        _failure = true;
+        _statusMemberId = WorkingSetCommon::allocateStatusMember(_sharedWs, lastFailure);
+        return lastFailure;
+    }
+
+    return Status::OK();
+}
+
 bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy) {
     bool doneWorking = false;
 
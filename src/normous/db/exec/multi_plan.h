@@ -88,6 +88,8 @@ public:
         return STAGE_MULTI_PLAN;
     }
 
+    void doSaveState() final;
+
     std::unique_ptr<PlanStageStats> getStats() final;
 
 
@@ -98,6 +100,14 @@ public:
      */
     void addPlan(std::unique_ptr<QuerySolution> solution, PlanStage* root, WorkingSet* sharedWs);
 
+    /**
+     * Returns the WorkingSet that the next candidate plan passed to addPlan() should be built
+     * over. This is 'sharedWs' unless the trial periods are to run concurrently, in which case
+     * every candidate gets a WorkingSet of its own, owned by this stage, and the results of the
+     * winning plan are moved into 'sharedWs' as they are returned.
+     */
+    WorkingSet* getCandidateWorkingSet(WorkingSet* sharedWs);
+
     /**
      * Runs all plans added by addPlan, ranks them, and picks a best.
      * All further calls to work(...) will return results from the best plan.
@@ -166,6 +176,21 @@ private:
      */
     bool workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy);
 
+    /**
+     * Runs the trial period of every candidate on a thread of its own, stopping all of them as
+     * soon as any plan hits EOF or returns 'numResults' results. The caller's locks are held
+     * throughout, so there is no yielding.
+     *
+     * Returns a non-OK status if the operation was interrupted or if all of the plans failed.
+     */
+    Status runTrialsInParallel(size_t numWorks, size_t numResults);
+
+    /**
+     * Returns 'id', a member of the WorkingSet of candidate 'candidateIdx', as a member of the
+     * WorkingSet that the caller reads results from.
+     */
+    WorkingSetID toSharedWorkingSet(size_t candidateIdx, WorkingSetID id);
+
     /**
      * Checks whether we need to perform either a timing-based yield or a yield for a document
      * fetch. If so, then uses 'yieldPolicy' to actually perform the yield.
@@ -220,6 +245,11 @@ private:
     // returned by ::work()
     WorkingSetID _statusMemberId;
 
+    // The WorkingSet that the caller reads results from, if the trial periods run concurrently.
+    // The candidates then work over the WorkingSets in '_candidateWorkingSets' instead.
+    WorkingSet* _sharedWs = nullptr;
+    std::vector<std::unique_ptr<WorkingSet>> _candidateWorkingSets;
+
     // Stats
     MultiPlanStats _specificStats;
 };
@@ -158,6 +158,28 @@ struct AndHashStats : public SpecificStats {
     size_t memLimit = 0u;
 };
 
+struct BitmapMergeStats : public SpecificStats {
+    BitmapMergeStats() = default;
+
+    SpecificStats* clone() const final {
+        return new BitmapMergeStats(*this);
+    }
+
+    // How many RecordIds are in the bitmap after each child? For an intersection, the bitmap
+    // after child 'i' holds the RecordIds produced by every one of children 0 through 'i'.
+    std::vector<size_t> bitmapAfterChild;
+
+    // How many containers does the final bitmap consist of, and how many of them are bitsets?
+    size_t containers = 0u;
+    size_t bitsetContainers = 0u;
+
+    // What's our current memory usage?
+    size_t memUsage = 0u;
+
+    // What's our memory limit?
+    size_t memLimit = 0u;
+};
+
 struct AndSortedStats : public SpecificStats {
     AndSortedStats() = default;
 
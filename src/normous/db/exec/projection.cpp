@@ -71,12 +71,16 @@ ProjectionStage::ProjectionStage(OperationContext* opCtx,
         invariant(_projObj.isOwned());
         invariant(!_projObj.isEmpty());
 
-        // Figure out what fields are in the projection.
-        getSimpleInclusionFields(_projObj, &_includedFields);
+        // Compile the projection for the objects we get from our child.
+        _simpleExec.emplace(_projObj);
 
         // If we're pulling data out of one index we can pre-compute the indices of the fields
         // in the key that we pull data from and avoid looking up the field name each time.
         if (ProjectionStageParams::COVERED_ONE_INDEX == params.projImpl) {
+            // Figure out what fields are in the projection.
+            invariant(_simpleExec->isInclusion());
+            getSimpleInclusionFields(_projObj, &_includedFields);
+
             // Sanity-check.
             _coveredKeyObj = params.coveredKeyObj;
             invariant(_coveredKeyObj.isOwned());
@@ -126,22 +130,6 @@ void ProjectionStage::getSimpleInclusionFields(const BSONObj& projObj, FieldSet*
     }
 }
 
-// static
-void ProjectionStage::transformSimpleInclusion(const BSONObj& in,
-                                               const FieldSet& includedFields,
-                                               BSONObjBuilder& bob) {
-    // Look at every field in the source document and see if we're including it.
-    BSONObjIterator inputIt(in);
-    while (inputIt.more()) {
-        BSONElement elt = inputIt.next();
-        auto fieldIt = includedFields.find(elt.fieldNameStringData());
-        if (includedFields.end() != fieldIt) {
-            // If so, add it to the builder.
-            bob.append(elt);
-        }
-    }
-}
-
 Status ProjectionStage::transform(WorkingSetMember* member) {
     // The default no-fast-path case.
     if (ProjectionStageParams::NO_FAST_PATH == _projImpl) {
@@ -156,7 +144,7 @@ Status ProjectionStage::transform(WorkingSetMember* member) {
         invariant(member->hasObj());
 
         // Apply the SIMPLE_DOC projection.
-        transformSimpleInclusion(member->obj.value(), _includedFields, bob);
+        _simpleExec->transform(member->obj.value(), &bob);
     } else {
         invariant(ProjectionStageParams::COVERED_ONE_INDEX == _projImpl);
         // We're pulling data out of the key.
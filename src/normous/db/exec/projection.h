@@ -29,8 +29,11 @@
 #pragma once
 
 
+#include <boost/optional.hpp>
+
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/projection_exec.h"
+#include "mongo/db/exec/simple_projection_exec.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
@@ -47,7 +50,8 @@ struct ProjectionStageParams {
         // The projection is simple inclusion and is totally covered by one index.
         COVERED_ONE_INDEX,
 
-        // The projection is simple inclusion and we expect an object.
+        // The projection is simple inclusion or exclusion of top-level fields and we expect an
+        // object.
         SIMPLE_DOC
     };
 
@@ -100,16 +104,6 @@ public:
      */
     static void getSimpleInclusionFields(const BSONObj& projObj, FieldSet* includedFields);
 
-    /**
-     * Applies a simple inclusion projection to 'in', including
-     * only the fields specified by 'includedFields'.
-     *
-     * The resulting document is constructed using 'bob'.
-     */
-    static void transformSimpleInclusion(const BSONObj& in,
-                                         const FieldSet& includedFields,
-                                         BSONObjBuilder& bob);
-
     static const char* kStageType;
 
 private:
@@ -129,13 +123,17 @@ private:
     // Used by all projection implementations.
     BSONObj _projObj;
 
-    // Data used for both SIMPLE_DOC and COVERED_ONE_INDEX paths.
-    // Has the field names present in the simple projection.
-    FieldSet _includedFields;
+    // Used for the SIMPLE_DOC path, and by the COVERED_ONE_INDEX path when the child provides
+    // an object.
+    boost::optional<SimpleProjectionExec> _simpleExec;
 
     //
     // Used for the COVERED_ONE_INDEX path.
     //
+
+    // Has the field names present in the simple projection.
+    FieldSet _includedFields;
+
     BSONObj _coveredKeyObj;
 
     // Field names can be empty in 2.4 and before so we can't use them as a sentinel value.
@@ -0,0 +1,214 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/record_id_bitmap.h"
+
+#include <algorithm>
+
+#include "mongo/platform/bits.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+// The cost of a node of the container map, on top of the container itself.
+const size_t kContainerNodeOverheadBytes = 4 * sizeof(void*);
+
+int64_t highBits(const RecordId& id) {
+    return id.repr() >> 16;
+}
+
+uint16_t lowBits(const RecordId& id) {
+    return static_cast<uint16_t>(id.repr() & 0xFFFF);
+}
+
+}  // namespace
+
+constexpr size_t RecordIdBitmap::kMaxArrayContainerSize;
+constexpr size_t RecordIdBitmap::Container::kNumWords;
+
+//
+// RecordIdBitmap::Container
+//
+
+bool RecordIdBitmap::Container::add(uint16_t low) {
+    if (isBitset()) {
+        uint64_t& word = _bits[low / 64];
+        const uint64_t bit = 1ULL << (low % 64);
+        if (word & bit) {
+            return false;
+        }
+        word |= bit;
+        return true;
+    }
+
+    if (_array.empty() || _array.back() < low) {
+        _array.push_back(low);
+    } else {
+        auto it = std::lower_bound(_array.begin(), _array.end(), low);
+        if (*it == low) {
+            return false;
+        }
+        _array.insert(it, low);
+    }
+
+    if (_array.size() > kMaxArrayContainerSize) {
+        convertToBitset();
+    }
+    return true;
+}
+
+bool RecordIdBitmap::Container::contains(uint16_t low) const {
+    if (isBitset()) {
+        return _bits[low / 64] & (1ULL << (low % 64));
+    }
+    return std::binary_search(_array.begin(), _array.end(), low);
+}
+
+bool RecordIdBitmap::Container::next(uint32_t from, uint16_t* low) const {
+    if (from > UINT16_MAX) {
+        return false;
+    }
+
+    if (!isBitset()) {
+        auto it = std::lower_bound(_array.begin(), _array.end(), static_cast<uint16_t>(from));
+        if (it == _array.end()) {
+            return false;
+        }
+        *low = *it;
+        return true;
+    }
+
+    size_t wordIdx = from / 64;
+    uint64_t word = _bits[wordIdx] & (~0ULL << (from % 64));
+    while (!word) {
+        if (++wordIdx == kNumWords) {
+            return false;
+        }
+        word = _bits[wordIdx];
+    }
+    *low = static_cast<uint16_t>(wordIdx * 64 + countTrailingZeros64(word));
+    return true;
+}
+
+size_t RecordIdBitmap::Container::getMemUsage() const {
+    return sizeof(Container) + _array.capacity() * sizeof(uint16_t) +
+        _bits.capacity() * sizeof(uint64_t);
+}
+
+void RecordIdBitmap::Container::convertToBitset() {
+    _bits.assign(kNumWords, 0);
+    for (auto low : _array) {
+        _bits[low / 64] |= 1ULL << (low % 64);
+    }
+    std::vector<uint16_t>().swap(_array);
+}
+
+//
+// RecordIdBitmap
+//
+
+void RecordIdBitmap::add(const RecordId& id) {
+    const int64_t high = highBits(id);
+
+    // RecordIds mostly arrive in ascending order, in which case they belong to the last container.
+    auto it = _containers.empty() ? _containers.end() : std::prev(_containers.end());
+    if (it == _containers.end() || it->first != high) {
+        it = _containers.lower_bound(high);
+        if (it == _containers.end() || it->first != high) {
+            it = _containers.emplace_hint(it, high, Container());
+            _memUsage += kContainerNodeOverheadBytes + it->second.getMemUsage();
+        }
+    }
+
+    Container& container = it->second;
+    const size_t memUsageBefore = container.getMemUsage();
+    if (container.add(lowBits(id))) {
+        ++_cardinality;
+        _memUsage = _memUsage - memUsageBefore + container.getMemUsage();
+    }
+}
+
+bool RecordIdBitmap::contains(const RecordId& id) const {
+    auto it = _containers.find(highBits(id));
+    return it != _containers.end() && it->second.contains(lowBits(id));
+}
+
+size_t RecordIdBitmap::numBitsetContainers() const {
+    return std::count_if(_containers.begin(), _containers.end(), [](const auto& entry) {
+        return entry.second.isBitset();
+    });
+}
+
+void RecordIdBitmap::clear() {
+    _containers.clear();
+    _cardinality = 0;
+    _memUsage = 0;
+}
+
+void RecordIdBitmap::swap(RecordIdBitmap& other) {
+    _containers.swap(other._containers);
+    std::swap(_cardinality, other._cardinality);
+    std::swap(_memUsage, other._memUsage);
+}
+
+RecordIdBitmap::Iterator RecordIdBitmap::begin() const {
+    return Iterator(_containers.begin(), _containers.end());
+}
+
+//
+// RecordIdBitmap::Iterator
+//
+
+RecordIdBitmap::Iterator::Iterator(ContainerMap::const_iterator begin,
+                                   ContainerMap::const_iterator end)
+    : _current(begin), _end(end) {
+    seek();
+}
+
+RecordId RecordIdBitmap::Iterator::next() {
+    invariant(more());
+    const RecordId id(static_cast<int64_t>(static_cast<uint64_t>(_current->first) << 16) |
+                      _currentLow);
+    _nextLow = _currentLow + 1;
+    seek();
+    return id;
+}
+
+void RecordIdBitmap::Iterator::seek() {
+    for (; _current != _end; ++_current, _nextLow = 0) {
+        if (_current->second.next(_nextLow, &_currentLow)) {
+            return;
+        }
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,169 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+/**
+ * A compressed set of RecordIds, laid out like a roaring bitmap. The RecordIds are partitioned by
+ * their upper 48 bits, and the lower 16 bits of the RecordIds in each partition are kept in a
+ * container which is a sorted array while it is sparse and a bitset of 2^16 bits once it holds
+ * more than kMaxArrayContainerSize values. Dense ranges of RecordIds, which is what collections
+ * mostly consist of, thus cost about one bit per RecordId.
+ */
+class RecordIdBitmap {
+public:
+    // An array container holding more values than this takes more space than a bitset.
+    static constexpr size_t kMaxArrayContainerSize = 4096;
+
+    class Iterator;
+
+    /**
+     * Adds 'id' to the set. Adding RecordIds in ascending order is the cheapest.
+     */
+    void add(const RecordId& id);
+
+    bool contains(const RecordId& id) const;
+
+    /**
+     * Returns the number of RecordIds in the set.
+     */
+    size_t cardinality() const {
+        return _cardinality;
+    }
+
+    bool empty() const {
+        return _cardinality == 0;
+    }
+
+    /**
+     * Returns the approximate number of bytes used by the set.
+     */
+    size_t getMemUsage() const {
+        return _memUsage;
+    }
+
+    /**
+     * Returns the number of containers, and how many of those are bitsets.
+     */
+    size_t numContainers() const {
+        return _containers.size();
+    }
+    size_t numBitsetContainers() const;
+
+    void clear();
+
+    void swap(RecordIdBitmap& other);
+
+    /**
+     * Returns an iterator over the RecordIds in ascending order. The iterator is invalidated by
+     * any change to the set.
+     */
+    Iterator begin() const;
+
+private:
+    class Container {
+    public:
+        /**
+         * Returns false if 'low' was already in the container.
+         */
+        bool add(uint16_t low);
+
+        bool contains(uint16_t low) const;
+
+        /**
+         * Sets '*low' to the smallest value in the container which is at least 'from', returning
+         * false if there is none.
+         */
+        bool next(uint32_t from, uint16_t* low) const;
+
+        bool isBitset() const {
+            return !_bits.empty();
+        }
+
+        size_t getMemUsage() const;
+
+    private:
+        static constexpr size_t kNumWords = (1 << 16) / 64;
+
+        void convertToBitset();
+
+        // Sorted values, while the container is an array.
+        std::vector<uint16_t> _array;
+
+        // One bit per value, once the container is a bitset.
+        std::vector<uint64_t> _bits;
+    };
+
+    // Keyed by the upper 48 bits of the RecordIds in the container.
+    using ContainerMap = std::map<int64_t, Container>;
+
+    ContainerMap _containers;
+    size_t _cardinality = 0;
+    size_t _memUsage = 0;
+};
+
+/**
+ * Iterates over a RecordIdBitmap in ascending order of RecordId.
+ */
+class RecordIdBitmap::Iterator {
+public:
+    Iterator() = default;
+
+    bool more() const {
+        return _current != _end;
+    }
+
+    /**
+     * Returns the current RecordId and moves to the next one. Must only be called if more().
+     */
+    RecordId next();
+
+private:
+    friend class RecordIdBitmap;
+
+    Iterator(ContainerMap::const_iterator begin, ContainerMap::const_iterator end);
+
+    // Positions the iterator on the first RecordId which is at least '_nextLow' in the current
+    // container or in any container after it.
+    void seek();
+
+    ContainerMap::const_iterator _current{};
+    ContainerMap::const_iterator _end{};
+    uint32_t _nextLow = 0;
+    uint16_t _currentLow = 0;
+};
+
+}  // namespace mongo
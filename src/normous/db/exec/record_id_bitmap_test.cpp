@@ -0,0 +1,148 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <set>
+
+#include "mongo/db/exec/record_id_bitmap.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::vector<RecordId> toVector(const RecordIdBitmap& bitmap) {
+    std::vector<RecordId> out;
+    for (auto it = bitmap.begin(); it.more();) {
+        out.push_back(it.next());
+    }
+    return out;
+}
+
+TEST(RecordIdBitmapTest, EmptyBitmap) {
+    RecordIdBitmap bitmap;
+    ASSERT_TRUE(bitmap.empty());
+    ASSERT_EQ(0U, bitmap.cardinality());
+    ASSERT_FALSE(bitmap.contains(RecordId(1)));
+    ASSERT_FALSE(bitmap.begin().more());
+}
+
+TEST(RecordIdBitmapTest, AddIgnoresDuplicates) {
+    RecordIdBitmap bitmap;
+    bitmap.add(RecordId(5));
+    bitmap.add(RecordId(3));
+    bitmap.add(RecordId(5));
+    ASSERT_EQ(2U, bitmap.cardinality());
+    ASSERT_TRUE(bitmap.contains(RecordId(3)));
+    ASSERT_TRUE(bitmap.contains(RecordId(5)));
+    ASSERT_FALSE(bitmap.contains(RecordId(4)));
+}
+
+TEST(RecordIdBitmapTest, IteratesInAscendingOrderAcrossContainers) {
+    RecordIdBitmap bitmap;
+    std::vector<RecordId> ids{RecordId(1LL << 40),
+                              RecordId(70000),
+                              RecordId(65535),
+                              RecordId(65536),
+                              RecordId(-3),
+                              RecordId(1)};
+    for (auto&& id : ids) {
+        bitmap.add(id);
+    }
+    ASSERT_EQ(4U, bitmap.numContainers());
+
+    std::sort(ids.begin(), ids.end());
+    ASSERT(ids == toVector(bitmap));
+}
+
+TEST(RecordIdBitmapTest, DenseContainerBecomesBitset) {
+    RecordIdBitmap bitmap;
+    for (int64_t i = 1; i <= static_cast<int64_t>(RecordIdBitmap::kMaxArrayContainerSize); ++i) {
+        bitmap.add(RecordId(i));
+    }
+    ASSERT_EQ(0U, bitmap.numBitsetContainers());
+
+    bitmap.add(RecordId(60000));
+    ASSERT_EQ(1U, bitmap.numBitsetContainers());
+    ASSERT_EQ(RecordIdBitmap::kMaxArrayContainerSize + 1, bitmap.cardinality());
+    ASSERT_TRUE(bitmap.contains(RecordId(60000)));
+    ASSERT_TRUE(bitmap.contains(RecordId(4096)));
+    ASSERT_FALSE(bitmap.contains(RecordId(4097)));
+
+    // A bitset holds 2^16 RecordIds in 8KB.
+    for (int64_t i = 0; i < (1 << 16); ++i) {
+        bitmap.add(RecordId(i));
+    }
+    ASSERT_EQ(static_cast<size_t>(1 << 16), bitmap.cardinality());
+    ASSERT_LT(bitmap.getMemUsage(), 9 * 1024U);
+
+    auto ids = toVector(bitmap);
+    ASSERT_EQ(static_cast<size_t>(1 << 16), ids.size());
+    ASSERT_EQ(RecordId(0), ids.front());
+    ASSERT_EQ(RecordId(65535), ids.back());
+}
+
+TEST(RecordIdBitmapTest, MatchesStdSetForRandomRecordIds) {
+    PseudoRandom random(7);
+    RecordIdBitmap bitmap;
+    std::set<RecordId> expected;
+    for (int i = 0; i < 50000; ++i) {
+        // Concentrate the RecordIds in a few containers so that some of them become bitsets.
+        RecordId id(random.nextInt64(200000));
+        bitmap.add(id);
+        expected.insert(id);
+    }
+    ASSERT_GT(bitmap.numBitsetContainers(), 0U);
+    ASSERT_EQ(expected.size(), bitmap.cardinality());
+    ASSERT(std::vector<RecordId>(expected.begin(), expected.end()) == toVector(bitmap));
+    for (int64_t i = 0; i < 1000; ++i) {
+        ASSERT_EQ(expected.count(RecordId(i)) > 0, bitmap.contains(RecordId(i)));
+    }
+}
+
+TEST(RecordIdBitmapTest, ClearAndSwap) {
+    RecordIdBitmap first;
+    RecordIdBitmap second;
+    first.add(RecordId(1));
+    first.add(RecordId(2));
+    second.add(RecordId(3));
+
+    first.swap(second);
+    ASSERT_EQ(1U, first.cardinality());
+    ASSERT_TRUE(first.contains(RecordId(3)));
+    ASSERT_EQ(2U, second.cardinality());
+
+    second.clear();
+    ASSERT_TRUE(second.empty());
+    ASSERT_EQ(0U, second.getMemUsage());
+    ASSERT_FALSE(second.contains(RecordId(1)));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,178 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/simple_projection_exec.h"
+
+#include <cstring>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+const StringData kIdField = "_id"_sd;
+
+}  // namespace
+
+// static
+bool SimpleProjectionExec::supports(const BSONObj& projObj) {
+    if (projObj.isEmpty()) {
+        return false;
+    }
+
+    bool sawInclusion = false;
+    bool sawExclusion = false;
+    for (auto&& elt : projObj) {
+        const auto fieldName = elt.fieldNameStringData();
+        // Object values are projection operators such as $slice, $elemMatch and $meta.
+        if (elt.type() == BSONType::Object || fieldName.find('.') != std::string::npos) {
+            return false;
+        }
+
+        // Any value is allowed for _id, whether the rest of the projection is an inclusion or an
+        // exclusion.
+        if (fieldName == kIdField) {
+            continue;
+        }
+
+        if (elt.trueValue()) {
+            sawInclusion = true;
+        } else {
+            sawExclusion = true;
+        }
+    }
+
+    return !(sawInclusion && sawExclusion);
+}
+
+SimpleProjectionExec::SimpleProjectionExec(const BSONObj& projObj) {
+    invariant(supports(projObj));
+
+    // A projection of only _id is an inclusion or exclusion of _id; otherwise the fields other than
+    // _id decide.
+    BSONElement idElt;
+    bool sawOtherField = false;
+    for (auto&& elt : projObj) {
+        if (elt.fieldNameStringData() == kIdField) {
+            idElt = elt;
+        } else if (!sawOtherField) {
+            sawOtherField = true;
+            _isInclusion = elt.trueValue();
+        }
+    }
+    if (!sawOtherField) {
+        _isInclusion = idElt.trueValue();
+    }
+
+    for (auto&& elt : projObj) {
+        const auto fieldName = elt.fieldNameStringData();
+        if (fieldName == kIdField) {
+            continue;
+        }
+        _fields.push_back(fieldName.toString());
+    }
+
+    // An inclusion projection includes _id unless it is explicitly excluded, and an exclusion
+    // projection only excludes _id if asked to.
+    const bool idExcluded = !idElt.eoo() && !idElt.trueValue();
+    if (_isInclusion != idExcluded) {
+        _fields.push_back(kIdField.toString());
+    }
+
+    buildIndex();
+}
+
+SimpleProjectionExec::SimpleProjectionExec(const std::vector<std::string>& fields,
+                                           bool isInclusion)
+    : _isInclusion(isInclusion), _fields(fields) {
+    buildIndex();
+}
+
+void SimpleProjectionExec::buildIndex() {
+    for (auto&& field : _fields) {
+        if (field.size() >= _fieldsByLength.size()) {
+            _fieldsByLength.resize(field.size() + 1);
+        }
+        _fieldsByLength[field.size()].push_back(field);
+        if (!field.empty()) {
+            _firstBytes.set(static_cast<unsigned char>(field[0]));
+        }
+    }
+}
+
+bool SimpleProjectionExec::isProjectedField(StringData fieldName) const {
+    const size_t size = fieldName.size();
+    if (size >= _fieldsByLength.size()) {
+        return false;
+    }
+
+    const auto& candidates = _fieldsByLength[size];
+    if (candidates.empty()) {
+        return false;
+    }
+    if (size == 0) {
+        return true;
+    }
+    if (!_firstBytes[static_cast<unsigned char>(fieldName[0])]) {
+        return false;
+    }
+
+    for (auto&& candidate : candidates) {
+        if (std::memcmp(candidate.rawData(), fieldName.rawData(), size) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SimpleProjectionExec::transform(const BSONObj& in, BSONObjBuilder* bob) const {
+    // Retained elements which are adjacent in 'in' are copied as one range. Every element of 'in'
+    // must still be looked at, since a document may contain the same field name more than once.
+    const char* runStart = nullptr;
+    const char* runEnd = nullptr;
+    for (auto&& elt : in) {
+        if (keepsField(elt.fieldNameStringData())) {
+            if (!runStart) {
+                runStart = elt.rawdata();
+            }
+            runEnd = elt.rawdata() + elt.size();
+        } else if (runStart) {
+            bob->bb().appendBuf(runStart, runEnd - runStart);
+            runStart = nullptr;
+        }
+    }
+
+    if (runStart) {
+        bob->bb().appendBuf(runStart, runEnd - runStart);
+    }
+}
+
+}  // namespace mongo
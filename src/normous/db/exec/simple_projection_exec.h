@@ -0,0 +1,110 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+
+namespace mongo {
+
+/**
+ * A precompiled form of a simple projection: one which only includes, or only excludes, top-level
+ * fields (e.g. {_id: 0, a: 1, b: 1} or {a: 0, b: 0}). Such projections need neither a
+ * ProjectionExec nor a Document, and are applied in a single pass over the input BSON, copying
+ * each run of adjacent retained elements into the output buffer with one memcpy.
+ *
+ * Field names are matched without hashing or allocating: the projected names are bucketed by
+ * length, and a bitmask over their first bytes rejects most non-matching names of a wide document
+ * before any comparison is made.
+ */
+class SimpleProjectionExec {
+public:
+    /**
+     * Returns true if 'projObj' is a simple inclusion or exclusion projection which can be
+     * compiled into a SimpleProjectionExec. As elsewhere, a field is included if its value is
+     * truthy. Dotted paths, projection operators and any mix of inclusion and exclusion other than
+     * for _id are not supported.
+     */
+    static bool supports(const BSONObj& projObj);
+
+    /**
+     * Compiles 'projObj', which must satisfy supports(). As with find projections, an inclusion
+     * projection includes _id unless it is explicitly excluded.
+     */
+    explicit SimpleProjectionExec(const BSONObj& projObj);
+
+    /**
+     * Builds a projection which includes exactly 'fields' if 'isInclusion' is true, and otherwise
+     * excludes exactly 'fields'. No _id field is added implicitly.
+     */
+    SimpleProjectionExec(const std::vector<std::string>& fields, bool isInclusion);
+
+    bool isInclusion() const {
+        return _isInclusion;
+    }
+
+    /**
+     * Returns true if a top-level field named 'fieldName' is part of the projection's output.
+     */
+    bool keepsField(StringData fieldName) const {
+        return isProjectedField(fieldName) == _isInclusion;
+    }
+
+    /**
+     * Appends the retained elements of 'in' to 'bob', in the order in which they appear in 'in'.
+     */
+    void transform(const BSONObj& in, BSONObjBuilder* bob) const;
+
+private:
+    /**
+     * Populates '_fieldsByLength' and '_firstBytes' from '_fields', which must not change
+     * afterwards.
+     */
+    void buildIndex();
+
+    bool isProjectedField(StringData fieldName) const;
+
+    bool _isInclusion = true;
+
+    // Owns the names pointed into by '_fieldsByLength'.
+    std::vector<std::string> _fields;
+
+    // The i-th entry holds the projected field names of length i.
+    std::vector<std::vector<StringData>> _fieldsByLength;
+
+    // Bit c is set if some projected field name starts with the byte c.
+    std::bitset<256> _firstBytes;
+};
+
+}  // namespace mongo
@@ -0,0 +1,125 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/simple_projection_exec.h"
+#include "mongo/db/json.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+BSONObj applyProjection(const BSONObj& projObj, const BSONObj& in) {
+    SimpleProjectionExec exec(projObj);
+    BSONObjBuilder bob;
+    exec.transform(in, &bob);
+    return bob.obj();
+}
+
+TEST(SimpleProjectionExecTest, SupportsOnlyTopLevelInclusionsOrExclusions) {
+    ASSERT_TRUE(SimpleProjectionExec::supports(fromjson("{a: 1, b: true}")));
+    ASSERT_TRUE(SimpleProjectionExec::supports(fromjson("{a: 0, b: false}")));
+    ASSERT_TRUE(SimpleProjectionExec::supports(fromjson("{_id: 0, a: 1}")));
+    ASSERT_TRUE(SimpleProjectionExec::supports(fromjson("{_id: 1, a: 0}")));
+    ASSERT_TRUE(SimpleProjectionExec::supports(fromjson("{_id: 0}")));
+    ASSERT_TRUE(SimpleProjectionExec::supports(fromjson("{a: 'b', c: [1]}")));
+
+    ASSERT_FALSE(SimpleProjectionExec::supports(BSONObj()));
+    ASSERT_FALSE(SimpleProjectionExec::supports(fromjson("{a: 1, b: 0}")));
+    ASSERT_FALSE(SimpleProjectionExec::supports(fromjson("{'a.b': 1}")));
+    ASSERT_FALSE(SimpleProjectionExec::supports(fromjson("{'a.$': 1}")));
+    ASSERT_FALSE(SimpleProjectionExec::supports(fromjson("{a: {$slice: 2}}")));
+    ASSERT_FALSE(SimpleProjectionExec::supports(fromjson("{a: {$elemMatch: {b: 1}}}")));
+    ASSERT_FALSE(SimpleProjectionExec::supports(fromjson("{a: {$meta: 'textScore'}}")));
+}
+
+TEST(SimpleProjectionExecTest, InclusionIncludesIdByDefault) {
+    BSONObj in = fromjson("{_id: 1, a: 2, b: 3, c: 4}");
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1, b: 3}"), applyProjection(fromjson("{b: 1}"), in));
+    ASSERT_BSONOBJ_EQ(fromjson("{b: 3}"), applyProjection(fromjson("{b: 1, _id: 0}"), in));
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), applyProjection(fromjson("{_id: 1}"), in));
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1, c: 4}"), applyProjection(fromjson("{c: 'yes'}"), in));
+}
+
+TEST(SimpleProjectionExecTest, ExclusionOnlyExcludesListedFields) {
+    BSONObj in = fromjson("{_id: 1, a: 2, b: 3, c: 4}");
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1, a: 2, c: 4}"), applyProjection(fromjson("{b: 0}"), in));
+    ASSERT_BSONOBJ_EQ(fromjson("{a: 2, b: 3, c: 4}"), applyProjection(fromjson("{_id: 0}"), in));
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1, c: 4}"),
+                      applyProjection(fromjson("{a: 0, _id: 1, b: 0}"), in));
+}
+
+TEST(SimpleProjectionExecTest, PreservesInputOrderAndValues) {
+    BSONObj in = fromjson("{z: {x: [1, 2]}, a: 'str', _id: 5, m: null, b: [{c: 1}]}");
+    ASSERT_BSONOBJ_EQ(fromjson("{z: {x: [1, 2]}, _id: 5, b: [{c: 1}]}"),
+                      applyProjection(fromjson("{b: 1, z: 1}"), in));
+    ASSERT_BSONOBJ_EQ(fromjson("{z: {x: [1, 2]}, m: null}"),
+                      applyProjection(fromjson("{a: 0, _id: 0, b: 0}"), in));
+}
+
+TEST(SimpleProjectionExecTest, DistinguishesNamesOfEqualLengthAndFirstByte) {
+    BSONObj in = fromjson("{abc: 1, abd: 2, ab: 3, abcd: 4, bbc: 5}");
+    ASSERT_BSONOBJ_EQ(fromjson("{abd: 2}"), applyProjection(fromjson("{_id: 0, abd: 1}"), in));
+    ASSERT_BSONOBJ_EQ(fromjson("{abc: 1, ab: 3, abcd: 4, bbc: 5}"),
+                      applyProjection(fromjson("{abd: 0}"), in));
+}
+
+TEST(SimpleProjectionExecTest, KeepsEveryCopyOfDuplicateFields) {
+    BSONObj in = BSON("a" << 1 << "b" << 2 << "a" << 3);
+    ASSERT_BSONOBJ_EQ(BSON("a" << 1 << "a" << 3), applyProjection(fromjson("{_id: 0, a: 1}"), in));
+    ASSERT_BSONOBJ_EQ(BSON("b" << 2), applyProjection(fromjson("{a: 0}"), in));
+}
+
+TEST(SimpleProjectionExecTest, HandlesEmptyAndFullyProjectedDocuments) {
+    ASSERT_BSONOBJ_EQ(BSONObj(), applyProjection(fromjson("{a: 1}"), BSONObj()));
+    ASSERT_BSONOBJ_EQ(BSONObj(), applyProjection(fromjson("{a: 0}"), BSONObj()));
+
+    BSONObj in = fromjson("{_id: 1, a: 2}");
+    ASSERT_BSONOBJ_EQ(in, applyProjection(fromjson("{a: 1}"), in));
+    ASSERT_BSONOBJ_EQ(in, applyProjection(fromjson("{b: 0}"), in));
+    ASSERT_BSONOBJ_EQ(BSONObj(), applyProjection(fromjson("{_id: 0, b: 1}"), in));
+}
+
+TEST(SimpleProjectionExecTest, ConstructsFromFieldList) {
+    SimpleProjectionExec inclusion({"a", "_id"}, true);
+    ASSERT_TRUE(inclusion.isInclusion());
+    ASSERT_TRUE(inclusion.keepsField("a"));
+    ASSERT_TRUE(inclusion.keepsField("_id"));
+    ASSERT_FALSE(inclusion.keepsField("b"));
+    ASSERT_FALSE(inclusion.keepsField(""));
+
+    SimpleProjectionExec exclusion({"a"}, false);
+    ASSERT_FALSE(exclusion.isInclusion());
+    ASSERT_FALSE(exclusion.keepsField("a"));
+    ASSERT_TRUE(exclusion.keepsField("_id"));
+    ASSERT_TRUE(exclusion.keepsField("ab"));
+}
+
+}  // namespace
+}  // namespace mongo
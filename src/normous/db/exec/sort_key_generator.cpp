@@ -91,7 +91,7 @@ PlanStage::StageState SortKeyGeneratorStage::doWork(WorkingSetID* out) {
         }
 
         // Add the sort key to the WSM as computed data.
-        member->addComputed(new SortKeyComputedData(sortKey.getValue()));
+        member->emplaceComputed<SortKeyComputedData>(sortKey.getValue());
 
         return PlanStage::ADVANCED;
     }
@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/working_set.h"
 
+#include <cstddef>
+
 #include "mongo/db/bson/dotted_path_support.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/service_context.h"
@@ -38,6 +40,69 @@ using std::string;
 
 namespace dps = ::mongo::dotted_path_support;
 
+//
+// WorkingSetArena
+//
+
+void* WorkingSetArena::allocate(size_t bytes, size_t alignment) {
+    invariant(bytes <= kBlockSize);
+    invariant(alignment <= kGranularity);
+
+    // Every chunk is a multiple of kGranularity in size and starts on such a boundary, so a chunk
+    // on a free list can hold anything of its size.
+    bytes = _roundUp(std::max<size_t>(bytes, 1));
+    const size_t sizeClass = bytes / kGranularity;
+    if (sizeClass < _freeLists.size() && _freeLists[sizeClass]) {
+        void* chunk = _freeLists[sizeClass];
+        _freeLists[sizeClass] = *static_cast<void**>(chunk);
+        _bytesInUse += bytes;
+        return chunk;
+    }
+
+    size_t offset = _offset;
+    if (_blocks.empty() || offset + bytes > kBlockSize) {
+        // Move on to the next block, which may be left over from before the last reset().
+        if (!_blocks.empty()) {
+            ++_currentBlock;
+        }
+        if (_currentBlock == _blocks.size()) {
+            _blocks.emplace_back(new char[kBlockSize]);
+        }
+        offset = 0;
+    }
+
+    _offset = offset + bytes;
+    _bytesInUse += bytes;
+    return _blocks[_currentBlock].get() + offset;
+}
+
+void WorkingSetArena::deallocate(void* ptr, size_t bytes) {
+    bytes = _roundUp(std::max<size_t>(bytes, 1));
+    const size_t sizeClass = bytes / kGranularity;
+    if (sizeClass >= _freeLists.size()) {
+        _freeLists.resize(sizeClass + 1, nullptr);
+    }
+    *static_cast<void**>(ptr) = _freeLists[sizeClass];
+    _freeLists[sizeClass] = ptr;
+    _bytesInUse -= bytes;
+}
+
+void WorkingSetArena::reset() {
+    // Keep the first block for reuse, but give back any others so that a query which once held
+    // many members does not hold on to their memory for its lifetime.
+    if (_blocks.size() > 1) {
+        _blocks.resize(1);
+    }
+    _freeLists.clear();
+    _currentBlock = 0;
+    _offset = 0;
+    _bytesInUse = 0;
+}
+
+//
+// WorkingSet
+//
+
 WorkingSet::MemberHolder::MemberHolder() : member(NULL) {}
 WorkingSet::MemberHolder::~MemberHolder() {}
 
@@ -58,6 +123,8 @@ WorkingSetID WorkingSet::allocate() {
         _data.resize(_data.size() + 1);
         _data.back().nextFreeOrSelf = id;
         _data.back().member = new WorkingSetMember();
+        _data.back().member->_arena = &_arena;
+        ++_numInUse;
         return id;
     }
 
@@ -65,6 +132,7 @@ WorkingSetID WorkingSet::allocate() {
     WorkingSetID id = _freeList;
     _freeList = _data[id].nextFreeOrSelf;
     _data[id].nextFreeOrSelf = id;  // set to self to mark as in-use
+    ++_numInUse;
     return id;
 }
 
@@ -77,6 +145,11 @@ void WorkingSet::free(WorkingSetID i) {
     holder.member->clear();
     holder.nextFreeOrSelf = _freeList;
     _freeList = i;
+
+    // Once no member is in use, nothing refers to the computed data in the arena any more.
+    if (--_numInUse == 0) {
+        _arena.reset();
+    }
 }
 
 void WorkingSet::clear() {
@@ -88,10 +161,38 @@ void WorkingSet::clear() {
     // Since working set is now empty, the free list pointer should
     // point to nothing.
     _freeList = INVALID_ID;
+    _numInUse = 0;
+    _arena.reset();
 
     _yieldSensitiveIds.clear();
 }
 
+WorkingSetID WorkingSet::transferMember(WorkingSet* other, WorkingSetID otherId) {
+    invariant(other != this);
+    WorkingSetMember* source = other->get(otherId);
+
+    WorkingSetID id = allocate();
+    WorkingSetMember* member = get(id);
+    member->recordId = source->recordId;
+    member->obj = std::move(source->obj);
+    member->keyData = std::move(source->keyData);
+    member->isSuspicious = source->isSuspicious;
+    for (size_t i = 0; i < WSM_COMPUTED_NUM_TYPES; i++) {
+        if (source->_computed[i]) {
+            member->addComputed(source->_computed[i]->clone());
+        }
+    }
+
+    if (source->getState() == WorkingSetMember::RID_AND_IDX) {
+        transitionToRecordIdAndIdx(id);
+    } else {
+        member->_state = source->getState();
+    }
+
+    other->free(otherId);
+    return id;
+}
+
 void WorkingSet::transitionToRecordIdAndIdx(WorkingSetID id) {
     WorkingSetMember* member = get(id);
     member->_state = WorkingSetMember::RID_AND_IDX;
@@ -172,8 +273,22 @@ const WorkingSetComputedData* WorkingSetMember::getComputed(
 }
 
 void WorkingSetMember::addComputed(WorkingSetComputedData* data) {
+    setComputed(data, ComputedDataDeleter());
+}
+
+void WorkingSetMember::setComputed(WorkingSetComputedData* data, ComputedDataDeleter deleter) {
     verify(!hasComputed(data->type()));
-    _computed[data->type()].reset(data);
+    _computed[data->type()] =
+        std::unique_ptr<WorkingSetComputedData, ComputedDataDeleter>(data, deleter);
+}
+
+void WorkingSetMember::ComputedDataDeleter::operator()(WorkingSetComputedData* data) const {
+    if (arena) {
+        data->~WorkingSetComputedData();
+        arena->deallocate(data, bytes);
+    } else {
+        delete data;
+    }
 }
 
 bool WorkingSetMember::getFieldDotted(const string& field, BSONElement* out) const {
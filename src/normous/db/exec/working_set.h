@@ -28,6 +28,9 @@
 
 #pragma once
 
+#include <memory>
+#include <new>
+#include <utility>
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
@@ -43,6 +46,77 @@ class WorkingSetMember;
 
 typedef size_t WorkingSetID;
 
+/**
+ * An allocator for the computed data of the members of a WorkingSet. Memory is carved out of
+ * fixed-size blocks in multiples of alignof(std::max_align_t). Memory given back by deallocate()
+ * goes onto a free list for its size and is handed out again before any more is carved out, so a
+ * query which keeps some members while freeing others, such as a top-k sort, only needs as much
+ * memory as the computed data it holds at once.
+ *
+ * reset(), which the WorkingSet calls whenever it has no members in use, reclaims all of the
+ * memory at once. The first block is kept across resets, so a query which holds a bounded number
+ * of members at a time allocates memory for their computed data only once.
+ */
+class WorkingSetArena {
+    MONGO_DISALLOW_COPYING(WorkingSetArena);
+
+public:
+    static constexpr size_t kBlockSize = 4096;
+
+    WorkingSetArena() = default;
+
+    /**
+     * Returns 'bytes' of uninitialized memory aligned to 'alignment', which must be at most
+     * alignof(std::max_align_t). 'bytes' must be at most kBlockSize.
+     */
+    void* allocate(size_t bytes, size_t alignment);
+
+    /**
+     * Makes the memory at 'ptr', which allocate() returned for 'bytes', available again. Any
+     * object constructed in that memory must have been destroyed.
+     */
+    void deallocate(void* ptr, size_t bytes);
+
+    /**
+     * Makes all of the memory handed out by allocate() available again. Any objects constructed
+     * in that memory must have been destroyed.
+     */
+    void reset();
+
+    /**
+     * Returns the number of bytes handed out and not yet given back.
+     */
+    size_t bytesInUse() const {
+        return _bytesInUse;
+    }
+
+    /**
+     * Returns the number of blocks memory is carved out of.
+     */
+    size_t numBlocks() const {
+        return _blocks.size();
+    }
+
+private:
+    static constexpr size_t kGranularity = alignof(std::max_align_t);
+
+    static size_t _roundUp(size_t bytes) {
+        return (bytes + kGranularity - 1) & ~(kGranularity - 1);
+    }
+
+    std::vector<std::unique_ptr<char[]>> _blocks;
+
+    // Heads of the lists of free chunks, indexed by chunk size in units of kGranularity. Each free
+    // chunk holds a pointer to the next one.
+    std::vector<void*> _freeLists;
+
+    // The block currently being allocated from, and the offset of its first free byte.
+    size_t _currentBlock = 0;
+    size_t _offset = 0;
+
+    size_t _bytesInUse = 0;
+};
+
 /**
  * All data in use by a query.  Data is passed through the stage tree by referencing the ID of
  * an element of the working set.  Stages can add elements to the working set, delete elements
@@ -90,6 +164,13 @@ public:
      */
     void clear();
 
+    /**
+     * Moves member 'id' of 'other' into a newly allocated member of this working set, whose id is
+     * returned, and frees it in 'other'. Computed data is copied, since it may live in the arena
+     * of 'other'.
+     */
+    WorkingSetID transferMember(WorkingSet* other, WorkingSetID id);
+
     //
     // WorkingSetMember state transitions
     //
@@ -112,6 +193,13 @@ public:
      */
     std::vector<WorkingSetID> getAndClearYieldSensitiveIds();
 
+    /**
+     * Returns the number of bytes of computed data currently held in this working set's arena.
+     */
+    size_t getArenaBytesInUse() const {
+        return _arena.bytesInUse();
+    }
+
 private:
     struct MemberHolder {
         MemberHolder();
@@ -135,6 +223,13 @@ private:
 
     // Contains ids of WSMs that may need to be adjusted when we next yield.
     std::vector<WorkingSetID> _yieldSensitiveIds;
+
+    // The number of members which are currently allocated and not freed.
+    size_t _numInUse = 0;
+
+    // Holds computed data added to the members through WorkingSetMember::emplaceComputed(). Reset
+    // whenever '_numInUse' drops to zero.
+    WorkingSetArena _arena;
 };
 
 /**
@@ -276,8 +371,28 @@ public:
 
     bool hasComputed(const WorkingSetComputedDataType type) const;
     const WorkingSetComputedData* getComputed(const WorkingSetComputedDataType type) const;
+
+    /**
+     * Takes ownership of 'data', which must have been allocated with new.
+     */
     void addComputed(WorkingSetComputedData* data);
 
+    /**
+     * Constructs computed data of type T from 'args' in the arena of the WorkingSet which owns
+     * this member, or on the heap if there is none. Prefer this to addComputed() for data which
+     * is produced for every result.
+     */
+    template <typename T, typename... Args>
+    void emplaceComputed(Args&&... args) {
+        if (!_arena) {
+            addComputed(new T(std::forward<Args>(args)...));
+            return;
+        }
+        void* storage = _arena->allocate(sizeof(T), alignof(T));
+        setComputed(new (storage) T(std::forward<Args>(args)...),
+                    ComputedDataDeleter(_arena, sizeof(T)));
+    }
+
     /**
      * getFieldDotted uses its state (obj or index data) to produce the field with the provided
      * name.
@@ -297,9 +412,29 @@ public:
 private:
     friend class WorkingSet;
 
+    /**
+     * Destroys computed data, and gives its memory back to the WorkingSetArena it lives in, or
+     * frees it if there is none.
+     */
+    struct ComputedDataDeleter {
+        ComputedDataDeleter() : arena(nullptr), bytes(0) {}
+        ComputedDataDeleter(WorkingSetArena* arena, size_t bytes) : arena(arena), bytes(bytes) {}
+
+        void operator()(WorkingSetComputedData* data) const;
+
+        WorkingSetArena* arena;
+        size_t bytes;
+    };
+
+    void setComputed(WorkingSetComputedData* data, ComputedDataDeleter deleter);
+
     MemberState _state = WorkingSetMember::INVALID;
 
-    std::unique_ptr<WorkingSetComputedData> _computed[WSM_COMPUTED_NUM_TYPES];
+    std::unique_ptr<WorkingSetComputedData, ComputedDataDeleter> _computed[WSM_COMPUTED_NUM_TYPES];
+
+    // The arena of the WorkingSet which owns this member. Not owned, and null if the member does
+    // not belong to a WorkingSet.
+    WorkingSetArena* _arena = nullptr;
 };
 
 }  // namespace mongo
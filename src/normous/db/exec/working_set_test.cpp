@@ -32,6 +32,7 @@
 
 
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_computed_data.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 #include "mongo/db/storage/snapshot.h"
@@ -154,4 +155,152 @@ TEST_F(WorkingSetFixture, getDottedFieldFromIndex) {
     ASSERT_FALSE(member->getFieldDotted("y", &elt));
 }
 
+TEST_F(WorkingSetFixture, emplacedComputedDataIsReadable) {
+    member->emplaceComputed<SortKeyComputedData>(BSON("" << 3));
+    member->emplaceComputed<TextScoreComputedData>(1.5);
+    ASSERT_GT(ws->getArenaBytesInUse(), 0U);
+
+    ASSERT_TRUE(member->hasComputed(WSM_SORT_KEY));
+    auto sortKey = static_cast<const SortKeyComputedData*>(member->getComputed(WSM_SORT_KEY));
+    ASSERT_BSONOBJ_EQ(BSON("" << 3), sortKey->getSortKey());
+
+    ASSERT_TRUE(member->hasComputed(WSM_COMPUTED_TEXT_SCORE));
+    auto score =
+        static_cast<const TextScoreComputedData*>(member->getComputed(WSM_COMPUTED_TEXT_SCORE));
+    ASSERT_EQUALS(1.5, score->getScore());
+
+    ASSERT_FALSE(member->hasComputed(WSM_INDEX_KEY));
+}
+
+TEST_F(WorkingSetFixture, arenaReclaimsComputedDataOfFreedMember) {
+    WorkingSetID otherId = ws->allocate();
+    member->emplaceComputed<TextScoreComputedData>(1.0);
+    ws->get(otherId)->emplaceComputed<TextScoreComputedData>(2.0);
+    const size_t bytesForTwo = ws->getArenaBytesInUse();
+    ASSERT_GT(bytesForTwo, 0U);
+
+    // The freed member's computed data is given back, while the other member's must stay put.
+    ws->free(id);
+    ASSERT_EQUALS(bytesForTwo / 2, ws->getArenaBytesInUse());
+    auto score = static_cast<const TextScoreComputedData*>(
+        ws->get(otherId)->getComputed(WSM_COMPUTED_TEXT_SCORE));
+    ASSERT_EQUALS(2.0, score->getScore());
+
+    ws->free(otherId);
+    ASSERT_EQUALS(0U, ws->getArenaBytesInUse());
+
+    // Recycled members start out without computed data.
+    id = ws->allocate();
+    ASSERT_FALSE(ws->get(id)->hasComputed(WSM_COMPUTED_TEXT_SCORE));
+}
+
+TEST_F(WorkingSetFixture, arenaGrowsPastOneBlock) {
+    std::vector<WorkingSetID> ids{id};
+    const size_t numMembers = 2 * WorkingSetArena::kBlockSize / sizeof(SortKeyComputedData);
+    for (size_t i = 1; i < numMembers; ++i) {
+        ids.push_back(ws->allocate());
+    }
+    for (size_t i = 0; i < ids.size(); ++i) {
+        ws->get(ids[i])->emplaceComputed<SortKeyComputedData>(BSON("" << static_cast<int>(i)));
+    }
+    ASSERT_GT(ws->getArenaBytesInUse(), WorkingSetArena::kBlockSize);
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        auto sortKey = static_cast<const SortKeyComputedData*>(
+            ws->get(ids[i])->getComputed(WSM_SORT_KEY));
+        ASSERT_BSONOBJ_EQ(BSON("" << static_cast<int>(i)), sortKey->getSortKey());
+    }
+
+    for (auto&& memberId : ids) {
+        ws->free(memberId);
+    }
+    ASSERT_EQUALS(0U, ws->getArenaBytesInUse());
+}
+
+TEST_F(WorkingSetFixture, arenaReusesMemoryWhileOtherMembersAreHeld) {
+    // Keep one member alive throughout, the way a top-k sort keeps its current best results, so
+    // that the arena is never reset.
+    member->emplaceComputed<SortKeyComputedData>(BSON("" << 0));
+    const size_t bytesForOne = ws->getArenaBytesInUse();
+
+    const size_t numMembers = 4 * WorkingSetArena::kBlockSize / sizeof(SortKeyComputedData);
+    for (size_t i = 0; i < numMembers; ++i) {
+        WorkingSetID otherId = ws->allocate();
+        ws->get(otherId)->emplaceComputed<SortKeyComputedData>(BSON("" << static_cast<int>(i)));
+        ASSERT_EQUALS(2 * bytesForOne, ws->getArenaBytesInUse());
+        ws->free(otherId);
+    }
+    ASSERT_EQUALS(bytesForOne, ws->getArenaBytesInUse());
+
+    auto sortKey = static_cast<const SortKeyComputedData*>(member->getComputed(WSM_SORT_KEY));
+    ASSERT_BSONOBJ_EQ(BSON("" << 0), sortKey->getSortKey());
+}
+
+TEST(WorkingSetArenaTest, DeallocatedChunksAreReusedBySize) {
+    WorkingSetArena arena;
+    void* small = arena.allocate(8, 8);
+    void* large = arena.allocate(100, 8);
+    const size_t bytesForBoth = arena.bytesInUse();
+
+    arena.deallocate(small, 8);
+    arena.deallocate(large, 100);
+    ASSERT_EQUALS(0U, arena.bytesInUse());
+
+    // Each chunk goes back out for a request of its own size.
+    ASSERT_EQUALS(large, arena.allocate(100, 8));
+    ASSERT_EQUALS(small, arena.allocate(8, 8));
+    ASSERT_EQUALS(bytesForBoth, arena.bytesInUse());
+
+    // Repeatedly allocating and deallocating never carves out more memory.
+    for (size_t i = 0; i < 2 * WorkingSetArena::kBlockSize; ++i) {
+        arena.deallocate(arena.allocate(32, 8), 32);
+    }
+    ASSERT_EQUALS(1U, arena.numBlocks());
+}
+
+TEST_F(WorkingSetFixture, transferMemberMovesDataAndFreesSource) {
+    member->recordId = RecordId(7);
+    member->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("a" << 1));
+    ws->transitionToRecordIdAndObj(id);
+    member->emplaceComputed<TextScoreComputedData>(2.5);
+
+    WorkingSet target;
+    WorkingSetID targetId = target.transferMember(ws.get(), id);
+    ASSERT_TRUE(ws->isFree(id));
+    ASSERT_EQUALS(0U, ws->getArenaBytesInUse());
+
+    WorkingSetMember* transferred = target.get(targetId);
+    ASSERT_EQUALS(WorkingSetMember::RID_AND_OBJ, transferred->getState());
+    ASSERT_EQUALS(RecordId(7), transferred->recordId);
+    ASSERT_BSONOBJ_EQ(BSON("a" << 1), transferred->obj.value());
+    auto score = static_cast<const TextScoreComputedData*>(
+        transferred->getComputed(WSM_COMPUTED_TEXT_SCORE));
+    ASSERT_EQUALS(2.5, score->getScore());
+}
+
+TEST_F(WorkingSetFixture, transferMemberKeepsIndexKeysYieldSensitive) {
+    member->keyData.push_back(IndexKeyDatum(BSON("x" << 1), BSON("" << 5), NULL));
+    ws->transitionToRecordIdAndIdx(id);
+
+    WorkingSet target;
+    WorkingSetID targetId = target.transferMember(ws.get(), id);
+    WorkingSetMember* transferred = target.get(targetId);
+    ASSERT_EQUALS(WorkingSetMember::RID_AND_IDX, transferred->getState());
+    BSONElement elt;
+    ASSERT_TRUE(transferred->getFieldDotted("x", &elt));
+    ASSERT_EQUALS(5, elt.numberInt());
+
+    auto yieldSensitiveIds = target.getAndClearYieldSensitiveIds();
+    ASSERT_EQUALS(1U, yieldSensitiveIds.size());
+    ASSERT_EQUALS(targetId, yieldSensitiveIds[0]);
+}
+
+TEST(WorkingSetMemberTest, emplacedComputedDataWithoutWorkingSetIsOnHeap) {
+    WorkingSetMember member;
+    member.emplaceComputed<GeoDistanceComputedData>(4.0);
+    auto dist =
+        static_cast<const GeoDistanceComputedData*>(member.getComputed(WSM_COMPUTED_GEO_DISTANCE));
+    ASSERT_EQUALS(4.0, dist->getDist());
+}
+
 }  // namespace
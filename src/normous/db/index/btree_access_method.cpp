@@ -65,4 +65,11 @@ void BtreeAccessMethod::doGetKeys(const BSONObj& obj,
     _keyGenerator->getKeys(obj, keys, multikeyPaths);
 }
 
+void BtreeAccessMethod::doGetKeysBatch(const std::vector<BSONObj>& objs,
+                                       std::vector<BSONObjSet>* keys,
+                                       BSONObjSet* multikeyMetadataKeys,
+                                       std::vector<MultikeyPaths>* multikeyPaths) const {
+    _keyGenerator->getKeys(objs, keys, multikeyPaths);
+}
+
 }  // namespace mongo
@@ -52,6 +52,11 @@ private:
                    BSONObjSet* multikeyMetadataKeys,
                    MultikeyPaths* multikeyPaths) const final;
 
+    void doGetKeysBatch(const std::vector<BSONObj>& objs,
+                        std::vector<BSONObjSet>* keys,
+                        BSONObjSet* multikeyMetadataKeys,
+                        std::vector<MultikeyPaths>* multikeyPaths) const final;
+
     // Our keys differ for V0 and V1.
     std::unique_ptr<BtreeKeyGenerator> _keyGenerator;
 };
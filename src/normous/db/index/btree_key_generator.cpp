@@ -132,9 +132,12 @@ void BtreeKeyGenerator::_getKeysArrEltFixed(std::vector<const char*>* fieldNames
         }
     }
 
-    // Recurse.
-    _getKeysWithArray(*fieldNames,
-                      *fixed,
+    // Recurse on copies, since the callee consumes the paths and the caller still needs them for
+    // the remaining array elements.
+    std::vector<const char*> subFieldNames(*fieldNames);
+    std::vector<BSONElement> subFixed(*fixed);
+    _getKeysWithArray(&subFieldNames,
+                      &subFixed,
                       arrEntry.type() == Object ? arrEntry.embeddedObject() : BSONObj(),
                       keys,
                       numNotFound,
@@ -145,6 +148,38 @@ void BtreeKeyGenerator::_getKeysArrEltFixed(std::vector<const char*>* fieldNames
 void BtreeKeyGenerator::getKeys(const BSONObj& obj,
                                 BSONObjSet* keys,
                                 MultikeyPaths* multikeyPaths) const {
+    std::vector<const char*> fieldNames;
+    std::vector<BSONElement> fixed;
+    _getKeysForDocument(obj, keys, multikeyPaths, &fieldNames, &fixed);
+}
+
+void BtreeKeyGenerator::getKeys(const std::vector<BSONObj>& objs,
+                                std::vector<BSONObjSet>* keys,
+                                std::vector<MultikeyPaths>* multikeyPaths) const {
+    invariant(keys->size() == objs.size());
+    invariant(!multikeyPaths || multikeyPaths->size() == objs.size());
+
+    // Reserve the scratch vectors once; assigning into them for each document then reuses their
+    // storage instead of copying '_fieldNames' and '_fixed' into fresh allocations.
+    std::vector<const char*> fieldNames;
+    std::vector<BSONElement> fixed;
+    fieldNames.reserve(_fieldNames.size());
+    fixed.reserve(_fixed.size());
+
+    for (size_t i = 0; i < objs.size(); ++i) {
+        _getKeysForDocument(objs[i],
+                            &(*keys)[i],
+                            multikeyPaths ? &(*multikeyPaths)[i] : nullptr,
+                            &fieldNames,
+                            &fixed);
+    }
+}
+
+void BtreeKeyGenerator::_getKeysForDocument(const BSONObj& obj,
+                                            BSONObjSet* keys,
+                                            MultikeyPaths* multikeyPaths,
+                                            std::vector<const char*>* fieldNames,
+                                            std::vector<BSONElement>* fixed) const {
     if (_isIdIndex) {
         // we special case for speed
         BSONElement e = obj["_id"];
@@ -174,22 +209,26 @@ void BtreeKeyGenerator::getKeys(const BSONObj& obj,
             invariant(multikeyPaths->empty());
             multikeyPaths->resize(_fieldNames.size());
         }
-        // '_fieldNames' and '_fixed' are passed by value so that their copies can be mutated as
-        // part of the _getKeysWithArray method.
-        _getKeysWithArray(_fieldNames, _fixed, obj, keys, 0, _emptyPositionalInfo, multikeyPaths);
+        // '_fieldNames' and '_fixed' are copied into the scratch vectors so that they can be
+        // mutated as part of the _getKeysWithArray method.
+        fieldNames->assign(_fieldNames.begin(), _fieldNames.end());
+        fixed->assign(_fixed.begin(), _fixed.end());
+        _getKeysWithArray(fieldNames, fixed, obj, keys, 0, _emptyPositionalInfo, multikeyPaths);
     }
     if (keys->empty() && !_isSparse) {
         keys->insert(_nullKey);
     }
 }
 
-void BtreeKeyGenerator::_getKeysWithArray(std::vector<const char*> fieldNames,
-                                          std::vector<BSONElement> fixed,
+void BtreeKeyGenerator::_getKeysWithArray(std::vector<const char*>* fieldNamesInOut,
+                                          std::vector<BSONElement>* fixedInOut,
                                           const BSONObj& obj,
                                           BSONObjSet* keys,
                                           unsigned numNotFound,
                                           const std::vector<PositionalPathInfo>& positionalInfo,
                                           MultikeyPaths* multikeyPaths) const {
+    auto& fieldNames = *fieldNamesInOut;
+    auto& fixed = *fixedInOut;
     BSONElement arrElt;
 
     // A set containing the position of any indexed fields in the key pattern that traverse through
@@ -216,7 +255,10 @@ void BtreeKeyGenerator::_getKeysWithArray(std::vector<const char*> fieldNames,
     // path "a.b" causes the index to be multikey, but the key pattern "a.b.0" only indexes the
     // first element of the array, so we'd have a
     // std::vector<boost::optional<size_t>>{{1U}, boost::none}.
-    std::vector<boost::optional<size_t>> arrComponents(fieldNames.size());
+    //
+    // The vector is only sized once an array value has been found, so that documents without
+    // arrays don't pay for the allocation.
+    std::vector<boost::optional<size_t>> arrComponents;
 
     bool mayExpandArrayUnembedded = true;
     for (size_t i = 0; i < fieldNames.size(); ++i) {
@@ -253,6 +295,10 @@ void BtreeKeyGenerator::_getKeysWithArray(std::vector<const char*> fieldNames,
         }
     }
 
+    if (!arrElt.eoo()) {
+        arrComponents.resize(fieldNames.size());
+    }
+
     if (arrElt.eoo()) {
         // No array, so generate a single key.
         if (_isSparse && numNotFound == fieldNames.size()) {
@@ -67,6 +67,19 @@ public:
      */
     void getKeys(const BSONObj& obj, BSONObjSet* keys, MultikeyPaths* multikeyPaths) const;
 
+    /**
+     * Batched variant of the above. Generates the index keys for each document in 'objs' and
+     * stores them in the set at the same position in 'keys', which must have the same number of
+     * elements as 'objs'. The scratch state used to walk the key pattern paths is allocated once
+     * and reused for every document in the batch.
+     *
+     * If the 'multikeyPaths' pointer is non-null, then it must point to a vector of empty vectors
+     * with the same number of elements as 'objs'; each is filled as described above.
+     */
+    void getKeys(const std::vector<BSONObj>& objs,
+                 std::vector<BSONObjSet>* keys,
+                 std::vector<MultikeyPaths>* multikeyPaths) const;
+
 private:
     // These are used by getKeys below.
     std::vector<const char*> _fieldNames;
@@ -130,10 +143,22 @@ private:
     };
 
     /**
-     * This recursive method does the heavy-lifting for getKeys().
+     * Generates the keys for a single document. 'fieldNames' and 'fixed' are scratch vectors which
+     * are reset from '_fieldNames' and '_fixed' before use, so that a caller generating keys for
+     * many documents can reuse their storage.
+     */
+    void _getKeysForDocument(const BSONObj& obj,
+                             BSONObjSet* keys,
+                             MultikeyPaths* multikeyPaths,
+                             std::vector<const char*>* fieldNames,
+                             std::vector<BSONElement>* fixed) const;
+
+    /**
+     * This recursive method does the heavy-lifting for getKeys(). 'fieldNames' and 'fixed' are
+     * modified in place as the paths are traversed.
      */
-    void _getKeysWithArray(std::vector<const char*> fieldNames,
-                           std::vector<BSONElement> fixed,
+    void _getKeysWithArray(std::vector<const char*>* fieldNames,
+                           std::vector<BSONElement>* fixed,
                            const BSONObj& obj,
                            BSONObjSet* keys,
                            unsigned numNotFound,
@@ -1159,4 +1159,50 @@ TEST(BtreeKeyGeneratorTest, GetCollationAwareKeysFromNestedArray) {
         testKeygen(keyPattern, genKeysFrom, expectedKeys, expectedMultikeyPaths, false, &collator));
 }
 
+TEST(BtreeKeyGeneratorTest, BatchedKeysMatchPerDocumentKeys) {
+    BSONObj keyPattern = fromjson("{a: 1, 'b.c': 1}");
+    std::vector<BSONObj> docs{fromjson("{a: 1, b: {c: 2}}"),
+                              fromjson("{a: [1, 2], b: {c: 3}}"),
+                              fromjson("{b: [{c: 1}, {c: 2}]}"),
+                              fromjson("{}"),
+                              fromjson("{a: [], b: {c: []}}"),
+                              fromjson("{a: 5, b: [{c: [1, 2]}, {d: 1}]}"),
+                              fromjson("{a: 'foo', b: {c: null}}")};
+
+    vector<const char*> fieldNames{"a", "b.c"};
+    vector<BSONElement> fixed(2);
+    BtreeKeyGenerator keyGen(fieldNames, fixed, false, nullptr);
+
+    std::vector<BSONObjSet> batchKeys(docs.size(),
+                                      SimpleBSONObjComparator::kInstance.makeBSONObjSet());
+    std::vector<MultikeyPaths> batchMultikeyPaths(docs.size());
+    keyGen.getKeys(docs, &batchKeys, &batchMultikeyPaths);
+
+    for (size_t i = 0; i < docs.size(); ++i) {
+        BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+        MultikeyPaths multikeyPaths;
+        keyGen.getKeys(docs[i], &keys, &multikeyPaths);
+        ASSERT(keysetsEqual(keys, batchKeys[i])) << "document " << docs[i] << ": expected "
+                                                 << dumpKeyset(keys) << ", got "
+                                                 << dumpKeyset(batchKeys[i]);
+        ASSERT(multikeyPaths == batchMultikeyPaths[i])
+            << "document " << docs[i] << ": expected " << dumpMultikeyPaths(multikeyPaths)
+            << ", got " << dumpMultikeyPaths(batchMultikeyPaths[i]);
+    }
+}
+
+TEST(BtreeKeyGeneratorTest, BatchedKeysRejectParallelArrays) {
+    std::vector<BSONObj> docs{fromjson("{a: 1, b: 1}"), fromjson("{a: [1, 2], b: [3, 4]}")};
+
+    vector<const char*> fieldNames{"a", "b"};
+    vector<BSONElement> fixed(2);
+    BtreeKeyGenerator keyGen(fieldNames, fixed, false, nullptr);
+
+    std::vector<BSONObjSet> batchKeys(docs.size(),
+                                      SimpleBSONObjComparator::kInstance.makeBSONObjSet());
+    ASSERT_THROWS_CODE(keyGen.getKeys(docs, &batchKeys, nullptr),
+                       AssertionException,
+                       ErrorCodes::CannotIndexParallelArrays);
+}
+
 }  // namespace
@@ -32,6 +32,7 @@
 
 #include "mongo/db/index/btree_access_method.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -103,6 +104,17 @@ Status checkKeySize(const BSONObj& key) {
 // TODO SERVER-36386: Remove the server parameter
 MONGO_EXPORT_SERVER_PARAMETER(failIndexKeyTooLong, bool, true);
 
+// The number of threads each bulk index build uses to sort and spill its keys, and to read ahead in
+// its spill files while merging them.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildSortThreads, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "internalIndexBuildSortThreads must be between 1 and 64");
+        }
+        return Status::OK();
+    });
+
 // TODO SERVER-36386: Remove the server parameter
 bool failIndexKeyTooLongParam() {
     // Always return true in FCV 4.2 although FCV 4.2 actually never needs to
@@ -220,6 +232,89 @@ Status AbstractIndexAccessMethod::insert(OperationContext* opCtx,
     return Status::OK();
 }
 
+Status AbstractIndexAccessMethod::insertBatch(OperationContext* opCtx,
+                                              const std::vector<BSONObj>& objs,
+                                              const std::vector<RecordId>& locs,
+                                              const InsertDeleteOptions& options,
+                                              int64_t* numInserted) {
+    invariant(numInserted);
+    invariant(objs.size() == locs.size());
+    *numInserted = 0;
+    bool checkIndexKeySize = shouldCheckIndexKeySize(opCtx);
+    BSONObjSet multikeyMetadataKeys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+    std::vector<BSONObjSet> keys;
+    std::vector<MultikeyPaths> multikeyPaths;
+    getKeysForBatch(objs, options.getKeysMode, &keys, &multikeyMetadataKeys, &multikeyPaths);
+
+    // Gather the data keys of every document and sort them into index order, so that the
+    // SortedDataInterface sees one ascending run of inserts rather than one per document.
+    std::vector<BtreeExternalSortComparison::Data> dataKeys;
+    MultikeyPaths batchMultikeyPaths;
+    bool isMultikey = false;
+    for (size_t i = 0; i < objs.size(); ++i) {
+        for (const auto& key : keys[i]) {
+            dataKeys.emplace_back(key, locs[i]);
+        }
+
+        if (!multikeyPaths[i].empty()) {
+            if (batchMultikeyPaths.empty()) {
+                batchMultikeyPaths = multikeyPaths[i];
+            } else {
+                invariant(batchMultikeyPaths.size() == multikeyPaths[i].size());
+                for (size_t j = 0; j < multikeyPaths[i].size(); ++j) {
+                    batchMultikeyPaths[j].insert(multikeyPaths[i][j].begin(),
+                                                 multikeyPaths[i][j].end());
+                }
+            }
+        }
+
+        isMultikey = isMultikey ||
+            shouldMarkIndexAsMultikey(keys[i], multikeyMetadataKeys, multikeyPaths[i]);
+    }
+
+    const BtreeExternalSortComparison comparator(_descriptor->keyPattern(),
+                                                 _descriptor->version());
+    std::sort(dataKeys.begin(),
+              dataKeys.end(),
+              [&](const BtreeExternalSortComparison::Data& lhs,
+                  const BtreeExternalSortComparison::Data& rhs) {
+                  return comparator(lhs, rhs) < 0;
+              });
+
+    auto insertOneKey = [&](const BSONObj& key, const RecordId& recordId) {
+        Status status = checkIndexKeySize ? checkKeySize(key) : Status::OK();
+        if (status.isOK()) {
+            StatusWith<SpecialFormatInserted> ret =
+                _newInterface->insert(opCtx, key, recordId, options.dupsAllowed);
+            status = ret.getStatus();
+            if (status.isOK() && ret.getValue() == SpecialFormatInserted::LongTypeBitsInserted)
+                _btreeState->setIndexKeyStringWithLongTypeBitsExistsOnDisk(opCtx);
+        }
+        return isFatalError(opCtx, status, key) ? status : Status::OK();
+    };
+
+    for (const auto& dataKey : dataKeys) {
+        Status status = insertOneKey(dataKey.first, dataKey.second);
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+    for (const auto& key : multikeyMetadataKeys) {
+        Status status = insertOneKey(key, kMultikeyMetadataKeyId);
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+
+    *numInserted = dataKeys.size() + multikeyMetadataKeys.size();
+
+    if (isMultikey) {
+        _btreeState->setMultikey(opCtx, batchMultikeyPaths);
+    }
+
+    return Status::OK();
+}
+
 void AbstractIndexAccessMethod::removeOneKey(OperationContext* opCtx,
                                              const BSONObj& key,
                                              const RecordId& loc,
@@ -490,9 +585,10 @@ IndexAccessMethod::BulkBuilder::BulkBuilder(const IndexAccessMethod* index,
                                             size_t maxMemoryUsageBytes)
     : _sorter(Sorter::make(
           SortOptions()
-              .TempDir(storageGlobalParams.dbpath + "/_tmp")
+              .TempDir(storageGlobalParams.getSpillDirectory())
               .ExtSortAllowed()
-              .MaxMemoryUsageBytes(maxMemoryUsageBytes),
+              .MaxMemoryUsageBytes(maxMemoryUsageBytes)
+              .NumThreads(internalIndexBuildSortThreads.load()),
           BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version()))),
       _real(index) {}
 
@@ -609,6 +705,7 @@ Status AbstractIndexAccessMethod::commitBulk(OperationContext* opCtx,
     }
 
     LOG(timer.seconds() > 10 ? 0 : 1) << "\t done building bottom layer, going to commit";
+    LOG(1) << "\t sorter stats: " << bulk->_sorter->stats()->toBSON();
 
     WriteUnitOfWork wunit(opCtx);
     SpecialFormatInserted specialFormatInserted = builder->commit(mayInterrupt);
@@ -685,6 +782,49 @@ void AbstractIndexAccessMethod::getKeys(const BSONObj& obj,
     }
 }
 
+void AbstractIndexAccessMethod::getKeysForBatch(const std::vector<BSONObj>& objs,
+                                                GetKeysMode mode,
+                                                std::vector<BSONObjSet>* keys,
+                                                BSONObjSet* multikeyMetadataKeys,
+                                                std::vector<MultikeyPaths>* multikeyPaths) const {
+    keys->assign(objs.size(), SimpleBSONObjComparator::kInstance.makeBSONObjSet());
+    if (multikeyPaths) {
+        multikeyPaths->assign(objs.size(), MultikeyPaths{});
+    }
+
+    try {
+        doGetKeysBatch(objs, keys, multikeyMetadataKeys, multikeyPaths);
+    } catch (const AssertionException&) {
+        if (mode == GetKeysMode::kEnforceConstraints) {
+            throw;
+        }
+
+        // Regenerate the keys one document at a time, so that getKeys() can decide for each
+        // document whether its indexing error may be suppressed.
+        for (size_t i = 0; i < objs.size(); ++i) {
+            (*keys)[i].clear();
+            MultikeyPaths* docMultikeyPaths = nullptr;
+            if (multikeyPaths) {
+                docMultikeyPaths = &(*multikeyPaths)[i];
+                docMultikeyPaths->clear();
+            }
+            getKeys(objs[i], mode, &(*keys)[i], multikeyMetadataKeys, docMultikeyPaths);
+        }
+    }
+}
+
+void AbstractIndexAccessMethod::doGetKeysBatch(const std::vector<BSONObj>& objs,
+                                               std::vector<BSONObjSet>* keys,
+                                               BSONObjSet* multikeyMetadataKeys,
+                                               std::vector<MultikeyPaths>* multikeyPaths) const {
+    for (size_t i = 0; i < objs.size(); ++i) {
+        doGetKeys(objs[i],
+                  &(*keys)[i],
+                  multikeyMetadataKeys,
+                  multikeyPaths ? &(*multikeyPaths)[i] : nullptr);
+    }
+}
+
 bool AbstractIndexAccessMethod::shouldMarkIndexAsMultikey(
     const BSONObjSet& keys,
     const BSONObjSet& multikeyMetadataKeys,
@@ -31,6 +31,7 @@
 #include <atomic>
 #include <memory>
 #include <set>
+#include <vector>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/bson/simple_bsonobj_comparator.h"
@@ -87,7 +88,22 @@ public:
                           int64_t* numInserted) = 0;
 
     /**
-     * Analogous to above, but remove the records instead of inserting them.
+     * Batched variant of insert(). Generates the keys for every document in 'objs' up front and
+     * then inserts them into the index in key order, with each key pointing to the RecordId at the
+     * same position in 'locs'. 'numInserted' will be set to the total number of keys added to the
+     * index for the batch.
+     *
+     * All keys are written at the recovery unit's current timestamp; callers that need distinct
+     * timestamps for different documents must split the batch accordingly.
+     */
+    virtual Status insertBatch(OperationContext* opCtx,
+                               const std::vector<BSONObj>& objs,
+                               const std::vector<RecordId>& locs,
+                               const InsertDeleteOptions& options,
+                               int64_t* numInserted) = 0;
+
+    /**
+     * Analogous to insert(), but remove the records instead of inserting them.
      * 'numDeleted' will be set to the number of keys removed from the index for the document.
      */
     virtual Status remove(OperationContext* opCtx,
@@ -316,6 +332,17 @@ public:
                          BSONObjSet* multikeyMetadataKeys,
                          MultikeyPaths* multikeyPaths) const = 0;
 
+    /**
+     * Batched variant of getKeys(). Resizes 'keys' and 'multikeyPaths' to the number of documents
+     * in 'objs' and fills the element at each position as getKeys() would for the corresponding
+     * document. Multikey metadata keys from all documents are merged into 'multikeyMetadataKeys'.
+     */
+    virtual void getKeysForBatch(const std::vector<BSONObj>& objs,
+                                 GetKeysMode mode,
+                                 std::vector<BSONObjSet>* keys,
+                                 BSONObjSet* multikeyMetadataKeys,
+                                 std::vector<MultikeyPaths>* multikeyPaths) const = 0;
+
     /**
      * Given the set of keys, multikeyMetadataKeys and multikeyPaths generated by a particular
      * document, return 'true' if the index should be marked as multikey and 'false' otherwise.
@@ -419,6 +446,12 @@ public:
                   const InsertDeleteOptions& options,
                   int64_t* numInserted) final;
 
+    Status insertBatch(OperationContext* opCtx,
+                       const std::vector<BSONObj>& objs,
+                       const std::vector<RecordId>& locs,
+                       const InsertDeleteOptions& options,
+                       int64_t* numInserted) final;
+
     Status remove(OperationContext* opCtx,
                   const BSONObj& obj,
                   const RecordId& loc,
@@ -476,6 +509,12 @@ public:
                  BSONObjSet* multikeyMetadataKeys,
                  MultikeyPaths* multikeyPaths) const final;
 
+    void getKeysForBatch(const std::vector<BSONObj>& objs,
+                         GetKeysMode mode,
+                         std::vector<BSONObjSet>* keys,
+                         BSONObjSet* multikeyMetadataKeys,
+                         std::vector<MultikeyPaths>* multikeyPaths) const final;
+
     bool shouldMarkIndexAsMultikey(const BSONObjSet& keys,
                                    const BSONObjSet& multikeyMetadataKeys,
                                    const MultikeyPaths& multikeyPaths) const override;
@@ -502,6 +541,17 @@ protected:
                            BSONObjSet* multikeyMetadataKeys,
                            MultikeyPaths* multikeyPaths) const = 0;
 
+    /**
+     * Fills the element of 'keys' and 'multikeyPaths' at each position with the keys generated for
+     * the document at the same position in 'objs'. Both vectors are already sized to match 'objs'.
+     * The default implementation calls doGetKeys() for each document; index types whose key
+     * generation has per-call setup cost can override this to share it across the batch.
+     */
+    virtual void doGetKeysBatch(const std::vector<BSONObj>& objs,
+                                std::vector<BSONObjSet>* keys,
+                                BSONObjSet* multikeyMetadataKeys,
+                                std::vector<MultikeyPaths>* multikeyPaths) const;
+
     IndexCatalogEntry* const _btreeState;  // owned by IndexCatalogEntry
     const IndexDescriptor* const _descriptor;
 
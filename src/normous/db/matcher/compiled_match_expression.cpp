@@ -0,0 +1,337 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_match_expression.h"
+
+#include <algorithm>
+
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+// The relative costs of evaluating a conjunct with a kernel, through the shared field pass, and
+// against the whole document.
+constexpr double kKernelCost = 1;
+constexpr double kPathCost = 2;
+constexpr double kDocumentCost = 8;
+
+/**
+ * Returns true if a predicate of type 'type' can be evaluated against the value at its path by
+ * matchesSingleElement(), provided that the value is neither missing nor an array.
+ */
+bool isPathMatchType(MatchExpression::MatchType type) {
+    switch (type) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::MATCH_IN:
+        case MatchExpression::REGEX:
+        case MatchExpression::EXISTS:
+        case MatchExpression::MOD:
+        case MatchExpression::TYPE_OPERATOR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isIntegral(const BSONElement& elt) {
+    return elt.type() == NumberInt || elt.type() == NumberLong;
+}
+
+bool compareResultMatches(MatchExpression::MatchType type, int cmp) {
+    switch (type) {
+        case MatchExpression::LT:
+            return cmp < 0;
+        case MatchExpression::LTE:
+            return cmp <= 0;
+        case MatchExpression::EQ:
+            return cmp == 0;
+        case MatchExpression::GT:
+            return cmp > 0;
+        case MatchExpression::GTE:
+            return cmp >= 0;
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+}  // namespace
+
+CompiledMatchExpression::CompiledMatchExpression(const MatchExpression* expr) {
+    invariant(expr);
+    if (MatchExpression::AND == expr->matchType()) {
+        for (size_t i = 0; i < expr->numChildren(); ++i) {
+            addConjunct(expr->getChild(i));
+        }
+    } else {
+        addConjunct(expr);
+    }
+
+    for (size_t i = 0; i < _conjuncts.size(); ++i) {
+        _order.push_back(i);
+    }
+    _fieldValues.resize(_fields.size());
+    _fieldSeen.resize(_fields.size());
+}
+
+void CompiledMatchExpression::addConjunct(const MatchExpression* expr) {
+    _conjuncts.emplace_back();
+    Conjunct& conjunct = _conjuncts.back();
+    conjunct.expr = expr;
+    conjunct.cost = kDocumentCost;
+
+    if (!isPathMatchType(expr->matchType()) || expr->path().empty()) {
+        return;
+    }
+
+    // Split the path into the top-level field, which is read by the shared field pass, and the
+    // components used to descend from it.
+    StringData path = expr->path();
+    size_t dot = path.find('.');
+    StringData topLevelField = path.substr(0, dot);
+    while (dot != std::string::npos) {
+        size_t next = path.find('.', dot + 1);
+        conjunct.subPath.push_back(path.substr(dot + 1, next - (dot + 1)));
+        dot = next;
+    }
+
+    auto it = std::find(_fields.begin(), _fields.end(), topLevelField);
+    conjunct.field = it - _fields.begin();
+    if (it == _fields.end()) {
+        _fields.push_back(topLevelField);
+    }
+    conjunct.cost = kPathCost;
+
+    switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            auto cmp = static_cast<const ComparisonMatchExpression*>(expr);
+            const BSONElement& rhs = cmp->getData();
+            conjunct.compareType = expr->matchType();
+            if (isIntegral(rhs)) {
+                conjunct.kernel = Kernel::kIntCompare;
+                conjunct.intOperand = rhs.numberLong();
+            } else if (rhs.type() == String && !cmp->getCollator()) {
+                conjunct.kernel = Kernel::kStringCompare;
+                conjunct.stringOperand = rhs.valueStringData();
+            }
+            break;
+        }
+        case MatchExpression::MATCH_IN: {
+            // The kernel looks up integers and strings directly. Any other value in the $in list
+            // could compare equal to a value of a different type, e.g. 5.0 to 5.
+            auto in = static_cast<const InMatchExpression*>(expr);
+            if (!in->getRegexes().empty()) {
+                break;
+            }
+            bool allSupported = true;
+            for (auto&& equality : in->getEqualities()) {
+                if (isIntegral(equality)) {
+                    conjunct.intSet.insert(equality.numberLong());
+                } else if (equality.type() == String && !in->getCollator()) {
+                    conjunct.stringSet[equality.valueStringData()] = true;
+                } else {
+                    allSupported = false;
+                    break;
+                }
+            }
+            if (allSupported) {
+                conjunct.kernel = Kernel::kIn;
+            } else {
+                conjunct.intSet.clear();
+                conjunct.stringSet.clear();
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (conjunct.kernel != Kernel::kNone) {
+        conjunct.cost = kKernelCost;
+    }
+}
+
+bool CompiledMatchExpression::matchesBSON(const BSONObj& doc) {
+    _fieldIt = BSONObjIterator(doc);
+    std::fill(_fieldSeen.begin(), _fieldSeen.end(), false);
+
+    bool matched = true;
+    for (size_t idx : _order) {
+        Conjunct& conjunct = _conjuncts[idx];
+        ++conjunct.evaluated;
+        if (!evaluate(conjunct, doc)) {
+            ++conjunct.rejected;
+            matched = false;
+            break;
+        }
+    }
+
+    if (++_docsSinceReorder >= kReorderInterval) {
+        reorder();
+    }
+    return matched;
+}
+
+BSONElement CompiledMatchExpression::getPathValue(const Conjunct& conjunct) {
+    const size_t field = conjunct.field;
+    while (!_fieldSeen[field] && _fieldIt.more()) {
+        BSONElement elt = _fieldIt.next();
+        const StringData name = elt.fieldNameStringData();
+        for (size_t i = 0; i < _fields.size(); ++i) {
+            // Like BSONObj::getField(), use the first of any duplicate fields.
+            if (!_fieldSeen[i] && _fields[i] == name) {
+                _fieldSeen[i] = true;
+                _fieldValues[i] = elt;
+                break;
+            }
+        }
+    }
+    if (!_fieldSeen[field]) {
+        return BSONElement();
+    }
+
+    BSONElement elt = _fieldValues[field];
+    for (auto&& part : conjunct.subPath) {
+        if (elt.type() != Object) {
+            return BSONElement();
+        }
+        elt = elt.embeddedObject().getField(part);
+    }
+    return elt;
+}
+
+bool CompiledMatchExpression::evaluate(const Conjunct& conjunct, const BSONObj& doc) {
+    if (conjunct.field < 0) {
+        return conjunct.expr->matchesBSON(doc);
+    }
+
+    // A missing value or an array needs the path traversal rules of the full expression.
+    BSONElement elt = getPathValue(conjunct);
+    if (elt.eoo() || elt.type() == Array) {
+        return conjunct.expr->matchesBSON(doc);
+    }
+
+    bool result;
+    if (evaluateKernel(conjunct, elt, &result)) {
+        return result;
+    }
+    return conjunct.expr->matchesSingleElement(elt);
+}
+
+bool CompiledMatchExpression::evaluateKernel(const Conjunct& conjunct,
+                                             const BSONElement& elt,
+                                             bool* result) {
+    switch (conjunct.kernel) {
+        case Kernel::kNone:
+            return false;
+        case Kernel::kIntCompare: {
+            if (!isIntegral(elt)) {
+                return false;
+            }
+            const long long value = elt.numberLong();
+            const long long operand = conjunct.intOperand;
+            *result = compareResultMatches(conjunct.compareType,
+                                           value < operand ? -1 : (value == operand ? 0 : 1));
+            return true;
+        }
+        case Kernel::kStringCompare: {
+            if (elt.type() != String) {
+                return false;
+            }
+            *result = compareResultMatches(conjunct.compareType,
+                                           elt.valueStringData().compare(conjunct.stringOperand));
+            return true;
+        }
+        case Kernel::kIn: {
+            if (isIntegral(elt)) {
+                *result = conjunct.intSet.count(elt.numberLong()) > 0;
+                return true;
+            }
+            if (elt.type() == String && !conjunct.stringSet.empty()) {
+                *result = conjunct.stringSet.count(elt.valueStringData()) > 0;
+                return true;
+            }
+            return false;
+        }
+    }
+    MONGO_UNREACHABLE;
+}
+
+void CompiledMatchExpression::reorder() {
+    _docsSinceReorder = 0;
+    if (_order.size() < 2) {
+        return;
+    }
+
+    // Rank the conjuncts by the fraction of documents they reject per unit of cost. A conjunct
+    // which has rarely been evaluated is assumed to reject half of the documents.
+    std::vector<double> scores(_conjuncts.size());
+    for (size_t i = 0; i < _conjuncts.size(); ++i) {
+        Conjunct& conjunct = _conjuncts[i];
+        scores[i] = (conjunct.rejected + 1) / (conjunct.evaluated + 2) / conjunct.cost;
+        conjunct.evaluated /= 2;
+        conjunct.rejected /= 2;
+    }
+    std::stable_sort(_order.begin(), _order.end(), [&](size_t lhs, size_t rhs) {
+        return scores[lhs] > scores[rhs];
+    });
+}
+
+size_t CompiledMatchExpression::numPathConjuncts() const {
+    return std::count_if(_conjuncts.begin(), _conjuncts.end(), [](const Conjunct& conjunct) {
+        return conjunct.field >= 0;
+    });
+}
+
+size_t CompiledMatchExpression::numKernelConjuncts() const {
+    return std::count_if(_conjuncts.begin(), _conjuncts.end(), [](const Conjunct& conjunct) {
+        return conjunct.kernel != Kernel::kNone;
+    });
+}
+
+std::vector<const MatchExpression*> CompiledMatchExpression::getConjunctOrder() const {
+    std::vector<const MatchExpression*> order;
+    for (size_t idx : _order) {
+        order.push_back(_conjuncts[idx].expr);
+    }
+    return order;
+}
+
+}  // namespace mongo
@@ -0,0 +1,159 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+/**
+ * A MatchExpression prepared for repeated evaluation against whole documents, as the filters of
+ * CollectionScan and FetchStage are.
+ *
+ * The top-level conjuncts which are predicates over a single path share one pass over the
+ * document: the document's fields are read only as far as the next predicate needs, and every
+ * field wanted by another predicate is remembered on the way. Comparisons and $in against
+ * integers, or against strings without a collation, are evaluated by kernels specialized to those
+ * types. Arrays, missing fields and paths through arrays are handed back to the original
+ * expression, so the result is always that of MatchExpression::matchesBSON().
+ *
+ * Every kReorderInterval documents, the conjuncts are reordered so that those which reject the
+ * most documents for their cost are evaluated first.
+ *
+ * Not thread-safe: each plan stage compiles its own filter.
+ */
+class CompiledMatchExpression {
+    MONGO_DISALLOW_COPYING(CompiledMatchExpression);
+
+public:
+    static constexpr uint64_t kReorderInterval = 1024;
+
+    /**
+     * 'expr' is not owned, and must outlive this object.
+     */
+    explicit CompiledMatchExpression(const MatchExpression* expr);
+
+    /**
+     * Returns true if 'doc' matches the expression this object was compiled from.
+     */
+    bool matchesBSON(const BSONObj& doc);
+
+    /**
+     * Returns the number of conjuncts which read their path through the shared field pass.
+     */
+    size_t numPathConjuncts() const;
+
+    /**
+     * Returns the number of conjuncts evaluated by a type-specialized kernel.
+     */
+    size_t numKernelConjuncts() const;
+
+    /**
+     * Returns the conjuncts in the order in which they are currently evaluated.
+     */
+    std::vector<const MatchExpression*> getConjunctOrder() const;
+
+private:
+    enum class Kernel {
+        kNone,
+        kIntCompare,
+        kStringCompare,
+        kIn,
+    };
+
+    struct Conjunct {
+        const MatchExpression* expr = nullptr;
+
+        // Index into '_fields' of the top-level field holding this conjunct's path, or -1 if the
+        // conjunct must be evaluated against the whole document.
+        int field = -1;
+
+        // The components of the conjunct's path after the top-level field.
+        std::vector<StringData> subPath;
+
+        Kernel kernel = Kernel::kNone;
+
+        // The operands of the comparison kernels.
+        MatchExpression::MatchType compareType = MatchExpression::EQ;
+        long long intOperand = 0;
+        StringData stringOperand;
+
+        // The operands of the $in kernel.
+        std::unordered_set<long long> intSet;
+        StringMap<bool> stringSet;
+
+        // Relative cost of evaluating the conjunct, used when reordering.
+        double cost = 1;
+
+        // How often the conjunct was evaluated and how often it rejected the document. These are
+        // decayed at each reordering so that the order follows changes in the data.
+        double evaluated = 0;
+        double rejected = 0;
+    };
+
+    void addConjunct(const MatchExpression* expr);
+
+    /**
+     * Returns the value at the path of 'conjunct' in the current document, or an EOO element if
+     * the path is missing or crosses an array. Reads the document's fields as far as needed.
+     */
+    BSONElement getPathValue(const Conjunct& conjunct);
+
+    bool evaluate(const Conjunct& conjunct, const BSONObj& doc);
+
+    static bool evaluateKernel(const Conjunct& conjunct, const BSONElement& elt, bool* result);
+
+    void reorder();
+
+    std::vector<Conjunct> _conjuncts;
+
+    // Indexes into '_conjuncts' in evaluation order.
+    std::vector<size_t> _order;
+
+    // The distinct top-level field names read by the path conjuncts.
+    std::vector<StringData> _fields;
+
+    // Per-document state of the shared field pass. '_fieldValues[i]' holds the value of
+    // '_fields[i]' once it has been seen.
+    BSONObjIterator _fieldIt{BSONObj()};
+    std::vector<BSONElement> _fieldValues;
+    std::vector<bool> _fieldSeen;
+
+    uint64_t _docsSinceReorder = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,193 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_match_expression.h"
+
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::unique_ptr<MatchExpression> parse(const BSONObj& query,
+                                       const CollatorInterface* collator = nullptr) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    expCtx->setCollator(collator);
+    auto result = MatchExpressionParser::parse(query, expCtx);
+    ASSERT_OK(result.getStatus());
+    return std::move(result.getValue());
+}
+
+/**
+ * Asserts that the compiled form of 'query' agrees with the original expression on each of
+ * 'docs'.
+ */
+void assertAgrees(const BSONObj& query,
+                  const std::vector<BSONObj>& docs,
+                  const CollatorInterface* collator = nullptr) {
+    auto expr = parse(query, collator);
+    CompiledMatchExpression compiled(expr.get());
+    for (auto&& doc : docs) {
+        ASSERT_EQ(expr->matchesBSON(doc), compiled.matchesBSON(doc))
+            << "query: " << query << ", document: " << doc;
+    }
+}
+
+const std::vector<BSONObj> kDocs = {
+    fromjson("{}"),
+    fromjson("{a: 5}"),
+    fromjson("{a: 4}"),
+    fromjson("{a: 6}"),
+    fromjson("{a: NumberLong(5)}"),
+    fromjson("{a: 5.0}"),
+    fromjson("{a: 4.5}"),
+    fromjson("{a: NaN}"),
+    fromjson("{a: NumberDecimal('5')}"),
+    fromjson("{a: null}"),
+    fromjson("{a: undefined}"),
+    fromjson("{a: MinKey}"),
+    fromjson("{a: MaxKey}"),
+    fromjson("{a: 'abc'}"),
+    fromjson("{a: 'abd'}"),
+    fromjson("{a: 'ab'}"),
+    fromjson("{a: 'ABC'}"),
+    fromjson("{a: [5]}"),
+    fromjson("{a: [4, 6]}"),
+    fromjson("{a: ['abc']}"),
+    fromjson("{a: []}"),
+    fromjson("{a: {b: 5}}"),
+    fromjson("{a: {b: 'abc', c: 1}}"),
+    fromjson("{a: {b: [5]}}"),
+    fromjson("{a: [{b: 5}]}"),
+    fromjson("{a: {b: {c: 5}}}"),
+    fromjson("{a: 4, a: 5}"),
+    fromjson("{b: 5}"),
+    fromjson("{b: 5, a: 5}"),
+    fromjson("{b: 'abc', a: 'abc'}"),
+    fromjson("{a: true}"),
+};
+
+TEST(CompiledMatchExpressionTest, IntegerComparisonsAgreeWithMatchExpression) {
+    for (auto&& op : {"$eq", "$lt", "$lte", "$gt", "$gte"}) {
+        assertAgrees(BSON("a" << BSON(op << 5)), kDocs);
+        assertAgrees(BSON("a" << BSON(op << 5LL)), kDocs);
+        assertAgrees(BSON("a.b" << BSON(op << 5)), kDocs);
+    }
+}
+
+TEST(CompiledMatchExpressionTest, StringComparisonsAgreeWithMatchExpression) {
+    for (auto&& op : {"$eq", "$lt", "$lte", "$gt", "$gte"}) {
+        assertAgrees(BSON("a" << BSON(op << "abc")), kDocs);
+        assertAgrees(BSON("a.b" << BSON(op << "abc")), kDocs);
+    }
+}
+
+TEST(CompiledMatchExpressionTest, StringComparisonsWithCollationAgreeWithMatchExpression) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kToLowerString);
+    for (auto&& op : {"$eq", "$lt", "$lte", "$gt", "$gte"}) {
+        assertAgrees(BSON("a" << BSON(op << "abc")), kDocs, &collator);
+    }
+    assertAgrees(fromjson("{a: {$in: ['abc', 5]}}"), kDocs, &collator);
+}
+
+TEST(CompiledMatchExpressionTest, InAgreesWithMatchExpression) {
+    assertAgrees(fromjson("{a: {$in: [5, 6]}}"), kDocs);
+    assertAgrees(fromjson("{a: {$in: ['abc', 6]}}"), kDocs);
+    assertAgrees(fromjson("{a: {$in: [5.0, 'ab']}}"), kDocs);
+    assertAgrees(fromjson("{a: {$in: [null, 4]}}"), kDocs);
+    assertAgrees(fromjson("{a: {$in: [/^ab/, 4]}}"), kDocs);
+    assertAgrees(fromjson("{a: {$in: []}}"), kDocs);
+}
+
+TEST(CompiledMatchExpressionTest, OtherPredicatesAgreeWithMatchExpression) {
+    assertAgrees(fromjson("{a: null}"), kDocs);
+    assertAgrees(fromjson("{'a.b': null}"), kDocs);
+    assertAgrees(fromjson("{a: {$exists: true}}"), kDocs);
+    assertAgrees(fromjson("{a: {$exists: false}}"), kDocs);
+    assertAgrees(fromjson("{a: {$type: 'number'}}"), kDocs);
+    assertAgrees(fromjson("{a: {$mod: [2, 1]}}"), kDocs);
+    assertAgrees(fromjson("{a: /^ab/}"), kDocs);
+    assertAgrees(fromjson("{a: {b: 5}}"), kDocs);
+    assertAgrees(fromjson("{a: {$ne: 5}}"), kDocs);
+    assertAgrees(fromjson("{a: {$elemMatch: {$gt: 4}}}"), kDocs);
+    assertAgrees(fromjson("{$or: [{a: 5}, {b: 5}]}"), kDocs);
+}
+
+TEST(CompiledMatchExpressionTest, ConjunctionsAgreeWithMatchExpression) {
+    assertAgrees(fromjson("{a: 5, b: 5}"), kDocs);
+    assertAgrees(fromjson("{a: {$gte: 4, $lt: 6}, b: {$exists: false}}"), kDocs);
+    assertAgrees(fromjson("{a: 'abc', b: {$in: ['abc', 5]}}"), kDocs);
+    assertAgrees(fromjson("{'a.b': 5, 'a.c': 1}"), kDocs);
+    assertAgrees(fromjson("{a: {$gt: 4}, $or: [{b: 5}, {'a.b': 5}]}"), kDocs);
+}
+
+TEST(CompiledMatchExpressionTest, ClassifiesConjuncts) {
+    auto expr =
+        parse(fromjson("{a: 5, 'b.c': 'x', d: {$in: [1, 2]}, e: /x/, $or: [{f: 1}, {g: 1}]}"));
+    CompiledMatchExpression compiled(expr.get());
+    ASSERT_EQ(4U, compiled.numPathConjuncts());
+    ASSERT_EQ(3U, compiled.numKernelConjuncts());
+}
+
+TEST(CompiledMatchExpressionTest, DoubleComparisonsDoNotUseKernel) {
+    auto expr = parse(fromjson("{a: 5.5, b: {$in: [1, 2.5]}}"));
+    CompiledMatchExpression compiled(expr.get());
+    ASSERT_EQ(2U, compiled.numPathConjuncts());
+    ASSERT_EQ(0U, compiled.numKernelConjuncts());
+}
+
+TEST(CompiledMatchExpressionTest, ReordersConjunctsBySelectivity) {
+    auto expr = parse(fromjson("{a: {$gte: 0}, b: 1}"));
+    CompiledMatchExpression compiled(expr.get());
+    const MatchExpression* onA = expr->getChild(0);
+    const MatchExpression* onB = expr->getChild(1);
+    ASSERT_EQ(MatchExpression::GTE, onA->matchType());
+
+    // Every document passes the predicate on 'a', but only one in ten passes the one on 'b'.
+    for (uint64_t i = 0; i < CompiledMatchExpression::kReorderInterval; ++i) {
+        ASSERT_EQ(i % 10 == 0, compiled.matchesBSON(BSON("a" << 1 << "b" << int(i % 10 == 0))));
+    }
+
+    auto order = compiled.getConjunctOrder();
+    ASSERT_EQ(2U, order.size());
+    ASSERT_EQ(onB, order[0]);
+    ASSERT_EQ(onA, order[1]);
+
+    // Reordering does not change the result.
+    ASSERT_TRUE(compiled.matchesBSON(BSON("a" << 1 << "b" << 1)));
+    ASSERT_FALSE(compiled.matchesBSON(BSON("a" << -1 << "b" << 1)));
+    ASSERT_FALSE(compiled.matchesBSON(BSON("a" << 1 << "b" << 0)));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -103,6 +103,8 @@ bool NamespaceString::isLegalClientSystemNS() const {
         return true;
     if (coll() == "system.js")
         return true;
+    if (coll() == "system.statistics")
+        return true;
 
     if (coll() == kSystemDotViewsCollectionName)
         return true;
@@ -76,6 +76,14 @@ public:
         processInternal(input, merging);
     }
 
+    /** Process a batch of inputs which all belong to the same group, in order. Equivalent to
+     *  calling process() on each of them, but lets accumulators with a batch kernel avoid
+     *  unboxing and dispatching on each input separately.
+     */
+    void processBatch(const std::vector<Value>& inputs, bool merging) {
+        processBatchInternal(inputs, merging);
+    }
+
     /** Marks the end of the evaluate() phase and return accumulated result.
      *  toBeMerged should be true when the outputs will be merged by process().
      */
@@ -109,6 +117,13 @@ protected:
     /// Update subclass's internal state based on input
     virtual void processInternal(const Value& input, bool merging) = 0;
 
+    /// Update subclass's internal state based on a batch of inputs. Defaults to one at a time.
+    virtual void processBatchInternal(const std::vector<Value>& inputs, bool merging) {
+        for (auto&& input : inputs) {
+            processInternal(input, merging);
+        }
+    }
+
     const boost::intrusive_ptr<ExpressionContext>& getExpressionContext() const {
         return _expCtx;
     }
@@ -194,6 +209,7 @@ public:
     explicit AccumulatorSum(const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
     void processInternal(const Value& input, bool merging) final;
+    void processBatchInternal(const std::vector<Value>& inputs, bool merging) final;
     Value getValue(bool toBeMerged) final;
     const char* getOpName() const final;
     void reset() final;
@@ -226,6 +242,7 @@ public:
     AccumulatorMinMax(const boost::intrusive_ptr<ExpressionContext>& expCtx, Sense sense);
 
     void processInternal(const Value& input, bool merging) final;
+    void processBatchInternal(const std::vector<Value>& inputs, bool merging) final;
     Value getValue(bool toBeMerged) final;
     const char* getOpName() const final;
     void reset() final;
@@ -282,6 +299,7 @@ public:
     explicit AccumulatorAvg(const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
     void processInternal(const Value& input, bool merging) final;
+    void processBatchInternal(const std::vector<Value>& inputs, bool merging) final;
     Value getValue(bool toBeMerged) final;
     const char* getOpName() const final;
     void reset() final;
@@ -308,6 +326,7 @@ public:
     AccumulatorStdDev(const boost::intrusive_ptr<ExpressionContext>& expCtx, bool isSamp);
 
     void processInternal(const Value& input, bool merging) final;
+    void processBatchInternal(const std::vector<Value>& inputs, bool merging) final;
     Value getValue(bool toBeMerged) final;
     const char* getOpName() const final;
     void reset() final;
@@ -31,6 +31,7 @@
 #include "mongo/db/pipeline/accumulator.h"
 
 #include "mongo/db/pipeline/accumulation_statement.h"
+#include "mongo/db/pipeline/accumulator_batch.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
@@ -92,6 +93,17 @@ void AccumulatorAvg::processInternal(const Value& input, bool merging) {
     _count++;
 }
 
+void AccumulatorAvg::processBatchInternal(const std::vector<Value>& inputs, bool merging) {
+    const BSONType type = accumulator_batch::uniformNumericType(inputs);
+    if (merging || type == EOO) {
+        Accumulator::processBatchInternal(inputs, merging);
+        return;
+    }
+
+    accumulator_batch::sum(inputs, type, &_nonDecimalTotal);
+    _count += inputs.size();
+}
+
 intrusive_ptr<Accumulator> AccumulatorAvg::create(
     const boost::intrusive_ptr<ExpressionContext>& expCtx) {
     return new AccumulatorAvg(expCtx);
@@ -0,0 +1,162 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "mongo/bson/bsontypes.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/platform/overflow_arithmetic.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/summation.h"
+
+namespace mongo {
+
+/**
+ * Helpers for the batch kernels of the numeric accumulators. A batch of inputs which all have the
+ * same numeric type is decoded, kChunkSize values at a time, into a native array on the stack so
+ * that the kernels can run tight loops over contiguous memory rather than dispatching on the type
+ * of each Value. Batches of mixed or non-numeric type take the per-value path instead.
+ */
+namespace accumulator_batch {
+
+constexpr size_t kChunkSize = 64;
+
+/**
+ * Returns the type shared by every value in 'inputs' if it is NumberInt, NumberLong or
+ * NumberDouble, and EOO if 'inputs' is empty or holds any other mix of types.
+ */
+inline BSONType uniformNumericType(const std::vector<Value>& inputs) {
+    if (inputs.empty()) {
+        return EOO;
+    }
+
+    const BSONType type = inputs.front().getType();
+    if (type != NumberInt && type != NumberLong && type != NumberDouble) {
+        return EOO;
+    }
+
+    for (auto&& input : inputs) {
+        if (input.getType() != type) {
+            return EOO;
+        }
+    }
+    return type;
+}
+
+/**
+ * Decodes 'n' NumberInt or NumberLong values starting at 'inputs' into 'out'.
+ */
+inline void decodeLongs(const Value* inputs, size_t n, int64_t* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = inputs[i].getLong();
+    }
+}
+
+/**
+ * Decodes 'n' NumberInt, NumberLong or NumberDouble values starting at 'inputs' into 'out', with
+ * the same conversion as Value::getDouble().
+ */
+inline void decodeDoubles(const Value* inputs, size_t n, double* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = inputs[i].getDouble();
+    }
+}
+
+/**
+ * Adds 'n' values which came from NumberInt inputs to 'total'. The sum of a chunk of 32-bit values
+ * cannot overflow 64 bits, so this is a plain loop the compiler can vectorize.
+ */
+inline void sumInts(const int64_t* vals, size_t n, DoubleDoubleSummation* total) {
+    dassert(n <= kChunkSize);
+    int64_t partial = 0;
+    for (size_t i = 0; i < n; ++i) {
+        partial += vals[i];
+    }
+    total->addLong(partial);
+}
+
+/**
+ * Adds 'n' 64-bit values to 'total', summing them exactly in an integer register and only
+ * spilling into the compensated sum when the partial sum would overflow.
+ */
+inline void sumLongs(const int64_t* vals, size_t n, DoubleDoubleSummation* total) {
+    int64_t partial = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t next;
+        if (mongoSignedAddOverflow64(partial, vals[i], &next)) {
+            total->addLong(partial);
+            next = vals[i];
+        }
+        partial = next;
+    }
+    total->addLong(partial);
+}
+
+/**
+ * Adds 'n' doubles to 'total'. Compensated summation is inherently sequential, so this matches the
+ * per-value path exactly and only saves the unboxing and dispatch.
+ */
+inline void sumDoubles(const double* vals, size_t n, DoubleDoubleSummation* total) {
+    for (size_t i = 0; i < n; ++i) {
+        total->addDouble(vals[i]);
+    }
+}
+
+/**
+ * Adds every value of 'inputs', which must all be of numeric type 'type', to 'total'.
+ */
+inline void sum(const std::vector<Value>& inputs, BSONType type, DoubleDoubleSummation* total) {
+    int64_t longs[kChunkSize];
+    double doubles[kChunkSize];
+    for (size_t begin = 0; begin < inputs.size(); begin += kChunkSize) {
+        const size_t n = std::min(kChunkSize, inputs.size() - begin);
+        switch (type) {
+            case NumberInt:
+                decodeLongs(&inputs[begin], n, longs);
+                sumInts(longs, n, total);
+                break;
+            case NumberLong:
+                decodeLongs(&inputs[begin], n, longs);
+                sumLongs(longs, n, total);
+                break;
+            case NumberDouble:
+                decodeDoubles(&inputs[begin], n, doubles);
+                sumDoubles(doubles, n, total);
+                break;
+            default:
+                MONGO_UNREACHABLE;
+        }
+    }
+}
+
+}  // namespace accumulator_batch
+}  // namespace mongo
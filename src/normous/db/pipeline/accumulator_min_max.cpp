@@ -30,7 +30,10 @@
 
 #include "mongo/db/pipeline/accumulator.h"
 
+#include <cmath>
+
 #include "mongo/db/pipeline/accumulation_statement.h"
+#include "mongo/db/pipeline/accumulator_batch.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/value.h"
 
@@ -61,6 +64,59 @@ void AccumulatorMinMax::processInternal(const Value& input, bool merging) {
     }
 }
 
+namespace {
+/**
+ * Returns the index of the first occurrence of the smallest (or, for MAX, largest) of the 'n'
+ * values at 'vals'. Only a strictly better value replaces the current best, which matches the
+ * tie-breaking of processInternal().
+ */
+template <typename T>
+size_t findExtremeIndex(const T* vals, size_t n, AccumulatorMinMax::Sense sense) {
+    size_t best = 0;
+    if (sense == AccumulatorMinMax::MIN) {
+        for (size_t i = 1; i < n; ++i) {
+            best = vals[i] < vals[best] ? i : best;
+        }
+    } else {
+        for (size_t i = 1; i < n; ++i) {
+            best = vals[i] > vals[best] ? i : best;
+        }
+    }
+    return best;
+}
+}  // namespace
+
+void AccumulatorMinMax::processBatchInternal(const std::vector<Value>& inputs, bool merging) {
+    const BSONType type = accumulator_batch::uniformNumericType(inputs);
+    if (type == EOO) {
+        Accumulator::processBatchInternal(inputs, merging);
+        return;
+    }
+
+    // Find the extreme value of each chunk natively, then offer only that one to processInternal()
+    // so that the comparison against '_val' still follows the full Value ordering.
+    int64_t longs[accumulator_batch::kChunkSize];
+    double doubles[accumulator_batch::kChunkSize];
+    for (size_t begin = 0; begin < inputs.size(); begin += accumulator_batch::kChunkSize) {
+        const size_t n = std::min(accumulator_batch::kChunkSize, inputs.size() - begin);
+        const Value* chunk = &inputs[begin];
+        size_t best;
+        if (type == NumberDouble) {
+            accumulator_batch::decodeDoubles(chunk, n, doubles);
+            if (std::any_of(doubles, doubles + n, [](double d) { return std::isnan(d); })) {
+                // NaN sorts before all other numbers, which native comparisons do not model.
+                Accumulator::processBatchInternal({chunk, chunk + n}, merging);
+                continue;
+            }
+            best = findExtremeIndex(doubles, n, _sense);
+        } else {
+            accumulator_batch::decodeLongs(chunk, n, longs);
+            best = findExtremeIndex(longs, n, _sense);
+        }
+        processInternal(chunk[best], merging);
+    }
+}
+
 Value AccumulatorMinMax::getValue(bool toBeMerged) {
     if (_val.missing()) {
         return Value(BSONNULL);
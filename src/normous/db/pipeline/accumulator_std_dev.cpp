@@ -31,6 +31,7 @@
 #include "mongo/db/pipeline/accumulator.h"
 
 #include "mongo/db/pipeline/accumulation_statement.h"
+#include "mongo/db/pipeline/accumulator_batch.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
@@ -83,6 +84,27 @@ void AccumulatorStdDev::processInternal(const Value& input, bool merging) {
     }
 }
 
+void AccumulatorStdDev::processBatchInternal(const std::vector<Value>& inputs, bool merging) {
+    if (merging || accumulator_batch::uniformNumericType(inputs) == EOO) {
+        Accumulator::processBatchInternal(inputs, merging);
+        return;
+    }
+
+    // The same online algorithm as processInternal(), run over unboxed doubles. Each step depends
+    // on the previous one, so the results are bit-for-bit those of the per-value path.
+    double vals[accumulator_batch::kChunkSize];
+    for (size_t begin = 0; begin < inputs.size(); begin += accumulator_batch::kChunkSize) {
+        const size_t n = std::min(accumulator_batch::kChunkSize, inputs.size() - begin);
+        accumulator_batch::decodeDoubles(&inputs[begin], n, vals);
+        for (size_t i = 0; i < n; ++i) {
+            _count += 1;
+            const double delta = vals[i] - _mean;
+            _mean += delta / _count;
+            _m2 += delta * (vals[i] - _mean);
+        }
+    }
+}
+
 Value AccumulatorStdDev::getValue(bool toBeMerged) {
     if (!toBeMerged) {
         const long long adjustedCount = (_isSamp ? _count - 1 : _count);
@@ -34,6 +34,7 @@
 #include "mongo/db/pipeline/accumulator.h"
 
 #include "mongo/db/pipeline/accumulation_statement.h"
+#include "mongo/db/pipeline/accumulator_batch.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/util/summation.h"
@@ -84,6 +85,17 @@ void AccumulatorSum::processInternal(const Value& input, bool merging) {
     }
 }
 
+void AccumulatorSum::processBatchInternal(const std::vector<Value>& inputs, bool merging) {
+    const BSONType type = accumulator_batch::uniformNumericType(inputs);
+    if (merging || type == EOO) {
+        Accumulator::processBatchInternal(inputs, merging);
+        return;
+    }
+
+    totalType = Value::getWidestNumeric(totalType, type);
+    accumulator_batch::sum(inputs, type, &nonDecimalTotal);
+}
+
 intrusive_ptr<Accumulator> AccumulatorSum::create(
     const boost::intrusive_ptr<ExpressionContext>& expCtx) {
     return new AccumulatorSum(expCtx);
@@ -91,6 +91,15 @@ static void assertExpectedResults(
                 ASSERT_VALUE_EQ(op.second, result);
                 ASSERT_EQUALS(op.second.getType(), result.getType());
             }
+
+            // Asserts that result equals expected result when the input is processed as a batch.
+            {
+                boost::intrusive_ptr<Accumulator> accum(factory(expCtx));
+                accum->processBatch(op.first, false);
+                Value result = accum->getValue(false);
+                ASSERT_VALUE_EQ(op.second, result);
+                ASSERT_EQUALS(op.second.getType(), result.getType());
+            }
         } catch (...) {
             log() << "failed with arguments: " << Value(op.first);
             throw;
@@ -334,6 +343,68 @@ TEST(Accumulators, Sum) {
          {{Value(9), Value()}, Value(9)}});
 }
 
+/**
+ * Asserts that processing 'inputs' as one batch gives the same result, including its type, as
+ * processing them one at a time, both for the final and for the mergeable output.
+ */
+static void assertBatchMatchesPerValue(const std::vector<Value>& inputs) {
+    intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+    for (auto&& name : {"$sum", "$avg", "$min", "$max", "$stdDevPop", "$stdDevSamp"}) {
+        auto factory = AccumulationStatement::getFactory(name);
+        boost::intrusive_ptr<Accumulator> perValue(factory(expCtx));
+        boost::intrusive_ptr<Accumulator> batched(factory(expCtx));
+        for (auto&& input : inputs) {
+            perValue->process(input, false);
+        }
+        batched->processBatch(inputs, false);
+
+        for (bool toBeMerged : {false, true}) {
+            Value expected = perValue->getValue(toBeMerged);
+            Value result = batched->getValue(toBeMerged);
+            ASSERT_VALUE_EQ(expected, result);
+            ASSERT_EQUALS(expected.getType(), result.getType()) << name;
+        }
+    }
+}
+
+TEST(Accumulators, BatchOfIntsMatchesPerValueProcessing) {
+    std::vector<Value> inputs;
+    for (int i = 0; i < 1000; ++i) {
+        inputs.push_back(Value(i % 2 ? numeric_limits<int>::max() - i : -i * 7));
+    }
+    assertBatchMatchesPerValue(inputs);
+}
+
+TEST(Accumulators, BatchOfLongsMatchesPerValueProcessing) {
+    std::vector<Value> inputs;
+    for (long long i = 0; i < 300; ++i) {
+        inputs.push_back(Value(i % 3 ? numeric_limits<long long>::max() - i : -i));
+    }
+    assertBatchMatchesPerValue(inputs);
+}
+
+TEST(Accumulators, BatchOfDoublesMatchesPerValueProcessing) {
+    std::vector<Value> inputs;
+    for (int i = 0; i < 200; ++i) {
+        inputs.push_back(Value(i % 5 ? 1.0 / (i + 1) : 1e100));
+    }
+    inputs.push_back(Value(-0.0));
+    inputs.push_back(Value(0.0));
+    inputs.push_back(Value(numeric_limits<double>::quiet_NaN()));
+    inputs.push_back(Value(-numeric_limits<double>::infinity()));
+    assertBatchMatchesPerValue(inputs);
+}
+
+TEST(Accumulators, BatchOfMixedTypesMatchesPerValueProcessing) {
+    assertBatchMatchesPerValue({Value(1),
+                                Value(2LL),
+                                Value(3.5),
+                                Value(Decimal128("4.25")),
+                                Value(BSONNULL),
+                                Value("string"_sd),
+                                Value()});
+}
+
 TEST(Accumulators, AddToSetRespectsCollation) {
     intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
     CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kAlwaysEqual);
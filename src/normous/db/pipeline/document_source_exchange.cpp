@@ -99,6 +99,12 @@ Exchange::Exchange(ExchangeSpec spec, std::unique_ptr<Pipeline, PipelineDeleter>
         uassert(50899, "Exchange boundaries must not be specified.", _boundaries.empty());
     }
 
+    if (_policy == ExchangePolicyEnum::kHash) {
+        uassert(50973,
+                str::stream() << "The key pattern " << _keyPattern << " must have at least one key",
+                !_keyPaths.empty());
+    }
+
     // We will manually detach and reattach when iterating '_pipeline', we expect it to start in the
     // detached state.
     _pipeline->detachFromOperationContext();
@@ -235,6 +241,7 @@ DocumentSource::GetNextResult Exchange::getNext(OperationContext* opCtx, size_t
         // Execute only in case we have not encountered an error.
         uassertStatusOKWithContext(_errorInLoadNextBatch,
                                    "Exchange failed due to an error on different thread.");
+        uassertStatusOKWithContext(_abortStatus, "Exchange was aborted.");
 
         // Check if we have a document.
         if (!_consumers[consumerId]->isEmpty()) {
@@ -327,6 +334,11 @@ size_t Exchange::loadNextBatch() {
                 if (full)
                     return target;
             } break;
+            case ExchangePolicyEnum::kHash: {
+                size_t target = getHashTargetConsumer(input.getDocument());
+                if (_consumers[target]->appendDocument(std::move(input), _maxBufferSize))
+                    return target;
+            } break;
             default:
                 MONGO_UNREACHABLE;
         }
@@ -379,6 +391,46 @@ size_t Exchange::getTargetConsumer(const Document& input) {
     return cid;
 }
 
+size_t Exchange::getHashTargetConsumer(const Document& input) {
+    // Build the key as a single array so that all the fields contribute to one hash. Unlike the
+    // range policy, a missing field is treated as null rather than sending the document to
+    // consumer 0, which keeps the distribution consistent with $group semantics.
+    BSONObjBuilder kb;
+    {
+        BSONArrayBuilder arr(kb.subarrayStart(""));
+        for (auto&& path : _keyPaths) {
+            auto value = input.getNestedField(path);
+            if (value.missing()) {
+                arr.appendNull();
+            } else {
+                value.addToBsonArray(&arr);
+            }
+        }
+    }
+
+    auto hash =
+        BSONElementHasher::hash64(kb.done().firstElement(), BSONElementHasher::DEFAULT_HASH_SEED);
+
+    // Map the hash onto a bucket, and the bucket onto a consumer.
+    size_t bucket = static_cast<unsigned long long>(hash) % _consumerIds.size();
+
+    size_t cid = _consumerIds[bucket];
+    invariant(cid < _consumers.size());
+
+    return cid;
+}
+
+void Exchange::abort(Status reason) {
+    invariant(!reason.isOK());
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    if (_abortStatus.isOK()) {
+        _abortStatus = std::move(reason);
+    }
+    _haveBufferSpace.notify_all();
+}
+
 void Exchange::dispose(OperationContext* opCtx, size_t consumerId) {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
 
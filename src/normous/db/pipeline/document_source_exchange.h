@@ -83,11 +83,20 @@ public:
 
     void dispose(OperationContext* opCtx, size_t consumerId);
 
+    /**
+     * Fails the exchange with 'reason', waking up every consumer blocked waiting for buffer space.
+     * Subsequent calls to getNext() throw. Used when a consumer stops draining its buffer early
+     * (e.g. it failed), as otherwise the remaining consumers could wait for it forever.
+     */
+    void abort(Status reason);
+
 private:
     size_t loadNextBatch();
 
     size_t getTargetConsumer(const Document& input);
 
+    size_t getHashTargetConsumer(const Document& input);
+
     class ExchangeBuffer {
     public:
         bool appendDocument(DocumentSource::GetNextResult input, size_t limit);
@@ -147,6 +156,10 @@ private:
     // state all other producing threads will fail too.
     Status _errorInLoadNextBatch{Status::OK()};
 
+    // A status set by abort(). Unlike '_errorInLoadNextBatch' it does not imply that the 'inner'
+    // pipeline was left attached to the operation context of the loading thread.
+    Status _abortStatus{Status::OK()};
+
     size_t _roundRobinCounter{0};
 
     // A rundown counter of consumers disposing of the pipelines. Only the last consumer will
@@ -474,6 +474,125 @@ TEST_F(DocumentSourceExchangeTest, RangeRandomHashExchangeNConsumer) {
     ASSERT_EQ(nDocs, processedDocs.load());
 }
 
+TEST_F(DocumentSourceExchangeTest, HashExchangeNConsumer) {
+    const size_t nDocs = 500;
+    auto source = getRandomMockSource(nDocs, getNewSeed());
+
+    const size_t nConsumers = 4;
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kHash);
+    spec.setKey(BSON("a"
+                     << "hashed"));
+    spec.setConsumers(nConsumers);
+    spec.setBufferSize(1024);
+
+    boost::intrusive_ptr<Exchange> ex =
+        new Exchange(std::move(spec), unittest::assertGet(Pipeline::create({source}, getExpCtx())));
+
+    std::vector<boost::intrusive_ptr<DocumentSourceExchange>> prods;
+
+    for (size_t idx = 0; idx < nConsumers; ++idx) {
+        prods.push_back(new DocumentSourceExchange(getExpCtx(), ex, idx));
+    }
+
+    std::vector<executor::TaskExecutor::CallbackHandle> handles;
+
+    // The set of key values seen by every consumer.
+    std::vector<std::set<int>> keys(nConsumers);
+    AtomicWord<size_t> processedDocs{0};
+
+    for (size_t id = 0; id < nConsumers; ++id) {
+        auto handle = _executor->scheduleWork(
+            [prods, id, &keys, &processedDocs](const executor::TaskExecutor::CallbackArgs& cb) {
+                PseudoRandom prng(getNewSeed());
+
+                size_t docs = 0;
+                for (auto input = prods[id]->getNext(); input.isAdvanced();
+                     input = prods[id]->getNext()) {
+                    keys[id].insert(input.getDocument()["a"].getInt());
+                    ++docs;
+
+                    sleepmillis(prng.nextInt32() % 20 + 1);
+                }
+                processedDocs.fetchAndAdd(docs);
+            });
+
+        handles.emplace_back(std::move(handle.getValue()));
+    }
+
+    for (auto& h : handles)
+        _executor->wait(h);
+
+    ASSERT_EQ(nDocs, processedDocs.load());
+
+    // Every key value must have been sent to exactly one consumer.
+    std::set<int> allKeys;
+    size_t totalKeys = 0;
+    for (auto&& consumerKeys : keys) {
+        allKeys.insert(consumerKeys.begin(), consumerKeys.end());
+        totalKeys += consumerKeys.size();
+    }
+    ASSERT_EQ(allKeys.size(), totalKeys);
+}
+
+TEST_F(DocumentSourceExchangeTest, HashExchangeTreatsMissingAsNull) {
+    auto source = DocumentSourceMock::create();
+    for (int i = 0; i < 10; ++i) {
+        source->queue.emplace_back(Document{{"b", i}});
+        source->queue.emplace_back(Document{{"a", BSONNULL}, {"b", i}});
+    }
+
+    const size_t nConsumers = 8;
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kHash);
+    spec.setKey(BSON("a"
+                     << "hashed"));
+    spec.setConsumers(nConsumers);
+
+    boost::intrusive_ptr<Exchange> ex =
+        new Exchange(std::move(spec), unittest::assertGet(Pipeline::create({source}, getExpCtx())));
+
+    // The buffers are large enough to hold every document, so a single thread can drain the
+    // consumers one after another.
+    size_t consumersWithDocs = 0;
+    size_t docs = 0;
+    for (size_t id = 0; id < nConsumers; ++id) {
+        size_t consumerDocs = 0;
+        for (auto input = ex->getNext(getExpCtx()->opCtx, id); input.isAdvanced();
+             input = ex->getNext(getExpCtx()->opCtx, id)) {
+            ++consumerDocs;
+        }
+
+        docs += consumerDocs;
+        if (consumerDocs > 0) {
+            ++consumersWithDocs;
+        }
+    }
+
+    ASSERT_EQ(docs, 20u);
+    ASSERT_EQ(consumersWithDocs, 1u);
+}
+
+TEST_F(DocumentSourceExchangeTest, AbortedExchangeFailsConsumers) {
+    auto source = getMockSource(10);
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kRoundRobin);
+    spec.setConsumers(2);
+
+    boost::intrusive_ptr<Exchange> ex =
+        new Exchange(std::move(spec), unittest::assertGet(Pipeline::create({source}, getExpCtx())));
+
+    ex->abort({ErrorCodes::QueryPlanKilled, "test abort"});
+
+    ASSERT_THROWS_CODE(
+        ex->getNext(getExpCtx()->opCtx, 0), AssertionException, ErrorCodes::QueryPlanKilled);
+    ASSERT_THROWS_CODE(
+        ex->getNext(getExpCtx()->opCtx, 1), AssertionException, ErrorCodes::QueryPlanKilled);
+}
+
 TEST_F(DocumentSourceExchangeTest, RejectNoConsumers) {
     BSONObj spec = BSON("policy"
                         << "broadcast"
@@ -655,4 +774,33 @@ TEST_F(DocumentSourceExchangeTest, RejectInvalidMissingKeys) {
         50967);
 }
 
+TEST_F(DocumentSourceExchangeTest, RejectHashMissingKeys) {
+    BSONObj spec = BSON("policy"
+                        << "hash"
+                        << "consumers"
+                        << 2);
+    ASSERT_THROWS_CODE(
+        Exchange(parseSpec(spec), unittest::assertGet(Pipeline::create({}, getExpCtx()))),
+        AssertionException,
+        50973);
+}
+
+TEST_F(DocumentSourceExchangeTest, RejectHashBoundaries) {
+    BSONObj spec = BSON("policy"
+                        << "hash"
+                        << "consumers"
+                        << 1
+                        << "key"
+                        << BSON("a"
+                                << "hashed")
+                        << "boundaries"
+                        << BSON_ARRAY(BSON("a" << MINKEY) << BSON("a" << MAXKEY))
+                        << "consumerIds"
+                        << BSON_ARRAY(0));
+    ASSERT_THROWS_CODE(
+        Exchange(parseSpec(spec), unittest::assertGet(Pipeline::create({}, getExpCtx()))),
+        AssertionException,
+        50899);
+}
+
 }  // namespace mongo
@@ -126,7 +126,7 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNext() {
     }
 
     if (_spilled) {
-        return getNextSpilled();
+        return spillsByPartition() ? getNextPartitioned() : getNextSpilled();
     } else if (_streaming) {
         return getNextStreaming();
     } else {
@@ -140,22 +140,10 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
         return GetNextResult::makeEOF();
 
     _currentId = _firstPartOfNextGroup.first;
-    const size_t numAccumulators = _accumulatedFields.size();
     while (pExpCtx->getValueComparator().evaluate(_currentId == _firstPartOfNextGroup.first)) {
         // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
         // At loop exit, it is the first value to be processed in the next group.
-        switch (numAccumulators) {  // mirrors switch in spill()
-            case 1:                 // Single accumulators serialize as a single Value.
-                _currentAccumulators[0]->process(_firstPartOfNextGroup.second, true);
-            case 0:  // No accumulators so no Values.
-                break;
-            default: {  // Multiple accumulators serialize as an array of Values.
-                const vector<Value>& accumulatorStates = _firstPartOfNextGroup.second.getArray();
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    _currentAccumulators[i]->process(accumulatorStates[i], true);
-                }
-            }
-        }
+        mergeAccumulatorStates(_firstPartOfNextGroup.second, _currentAccumulators);
 
         if (!_sorterIterator->more()) {
             dispose();
@@ -168,6 +156,23 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
     return makeDocument(_currentId, _currentAccumulators, pExpCtx->needsMerge);
 }
 
+DocumentSource::GetNextResult DocumentSourceGroup::getNextPartitioned() {
+    // We aren't streaming, and we have spilled to hash partitions. '_groups' holds the groups of
+    // the partition currently being returned.
+    if (_groups->empty())
+        return GetNextResult::makeEOF();
+
+    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+
+    if (++groupsIterator == _groups->end()) {
+        loadNextPartition();
+        if (_groups->empty())
+            dispose();
+    }
+
+    return std::move(out);
+}
+
 DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
     // Not spilled, and not streaming.
     if (_groups->empty())
@@ -223,6 +228,8 @@ void DocumentSourceGroup::doDispose() {
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
     _sorterIterator.reset();
+    _partitionWriters.clear();
+    _spilledPartitions.clear();
 
     // Make us look done.
     groupsIterator = _groups->end();
@@ -276,10 +283,21 @@ Value DocumentSourceGroup::serialize(boost::optional<ExplainOptions::Verbosity>
         insides["$doingMerge"] = Value(true);
     }
 
+    MutableDocument out;
     if (explain && findRelevantInputSort()) {
-        return Value(DOC("$streamingGroup" << insides.freeze()));
+        out["$streamingGroup"] = insides.freezeToValue();
+    } else {
+        out[getSourceName()] = insides.freezeToValue();
+    }
+
+    if (explain && *explain >= ExplainOptions::Verbosity::kExecStats) {
+        out["spillStats"] = Value(Document{{"usedDisk", _usedDisk},
+                                           {"spills", _spillStats.spills},
+                                           {"partitionsSpilled", _spillStats.partitionsSpilled},
+                                           {"bytesSpilled", _spillStats.bytesSpilled},
+                                           {"maxRecursionDepth", _spillStats.maxRecursionDepth}});
     }
-    return Value(DOC(getSourceName() << insides.freeze()));
+    return out.freezeToValue();
 }
 
 DepsTracker::State DocumentSourceGroup::getDependencies(DepsTracker* deps) const {
@@ -343,6 +361,7 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
       _initialized(false),
       _groups(pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>()),
       _spilled(false),
+      _numSpillPartitions(internalDocumentSourceGroupSpillPartitions.load()),
       _allowDiskUse(pExpCtx->allowDiskUse && !pExpCtx->inMongos) {}
 
 void DocumentSourceGroup::addAccumulator(AccumulationStatement accumulationStatement) {
@@ -436,6 +455,28 @@ namespace {
 
 using GroupsMap = DocumentSourceGroup::GroupsMap;
 
+// The number of times a spilled partition which still does not fit within the memory limit is
+// split again before it is aggregated regardless of the limit. A partition can only fail to
+// shrink when most of its data belongs to a handful of very large groups.
+const int kMaxSpillRecursionDepth = 4;
+
+/**
+ * Returns the partition of a group whose _id hashes to 'hash' at the given spill recursion depth.
+ * The hash is remixed with the depth so that when a partition is split again, its groups spread
+ * over all of the new partitions rather than landing in the same one.
+ */
+size_t partitionForHash(size_t hash, int depth, size_t numPartitions) {
+    uint64_t mixed = hash ^ (static_cast<uint64_t>(depth) * 0x9e3779b97f4a7c15ULL);
+
+    // The 64-bit finalizer of MurmurHash3.
+    mixed ^= mixed >> 33;
+    mixed *= 0xff51afd7ed558ccdULL;
+    mixed ^= mixed >> 33;
+    mixed *= 0xc4ceb9fe1a85ec53ULL;
+    mixed ^= mixed >> 33;
+    return mixed % numPartitions;
+}
+
 class SorterComparator {
 public:
     typedef pair<Value, Value> Data;
@@ -555,6 +596,53 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     }
 
 
+    // The accumulator inputs of a run of consecutive documents which belong to the same group are
+    // buffered column-wise and handed to that group's accumulators together, so that accumulators
+    // with a batch kernel can process them without dispatching on every value. 'batchGroup' points
+    // into '_groups', so the batch must be flushed before '_groups' is spilled or this loop exits.
+    const size_t maxBatchSize = internalDocumentSourceGroupBatchSize.load();
+    Accumulators* batchGroup = nullptr;
+    Value batchId;
+    size_t batchSize = 0;
+    size_t batchMemoryUsageBytes = 0;
+    vector<vector<Value>> batchInputs(numAccumulators);
+    for (auto&& column : batchInputs) {
+        column.reserve(maxBatchSize);
+    }
+
+    auto flushBatch = [&]() {
+        if (batchSize == 0) {
+            return;
+        }
+
+        // Subtract the group's old memory usage and the buffered inputs. The new usage of the
+        // accumulators is added back after processing.
+        _memoryUsageBytes -= batchMemoryUsageBytes;
+        for (size_t i = 0; i < numAccumulators; i++) {
+            Accumulator* accumulator = (*batchGroup)[i].get();
+            _memoryUsageBytes -= accumulator->memUsageForSorter();
+            if (batchSize == 1) {
+                accumulator->process(batchInputs[i].front(), _doingMerge);
+            } else {
+                accumulator->processBatch(batchInputs[i], _doingMerge);
+            }
+            _memoryUsageBytes += accumulator->memUsageForSorter();
+            batchInputs[i].clear();
+        }
+
+        batchGroup = nullptr;
+        batchSize = 0;
+        batchMemoryUsageBytes = 0;
+    };
+
+    auto spillGroups = [&]() {
+        if (spillsByPartition()) {
+            spillToPartitions(0);
+        } else {
+            _sortedFiles.push_back(spill());
+        }
+    };
+
     // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
     GetNextResult input = pSource->getNext();
     for (; input.isAdvanced(); input = pSource->getNext()) {
@@ -563,7 +651,8 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
                     "Exceeded memory limit for $group, but didn't allow external sort."
                     " Pass allowDiskUse:true to opt in.",
                     _allowDiskUse);
-            _sortedFiles.push_back(spill());
+            flushBatch();
+            spillGroups();
             _memoryUsageBytes = 0;
         }
 
@@ -572,49 +661,59 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         auto rootDocument = input.releaseDocument();
         Value id = computeId(rootDocument);
 
-        // Look for the _id value in the map. If it's not there, add a new entry with a blank
-        // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
-        // looking it up in '_groups' multiple times.
-        const size_t oldSize = _groups->size();
-        vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
-        const bool inserted = _groups->size() != oldSize;
-
-        if (inserted) {
-            _memoryUsageBytes += id.getApproximateSize();
-
-            // Add the accumulators
-            group.reserve(numAccumulators);
-            for (auto&& accumulatedField : _accumulatedFields) {
-                group.push_back(accumulatedField.makeAccumulator(pExpCtx));
-            }
-        } else {
-            for (auto&& groupObj : group) {
-                // subtract old mem usage. New usage added back after processing.
-                _memoryUsageBytes -= groupObj->memUsageForSorter();
+        bool inserted = false;
+        const bool extendsBatch = batchSize > 0 && batchSize < maxBatchSize &&
+            pExpCtx->getValueComparator().evaluate(batchId == id);
+        if (!extendsBatch) {
+            flushBatch();
+
+            // Look for the _id value in the map. If it's not there, add a new entry with a blank
+            // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
+            // looking it up in '_groups' multiple times.
+            const size_t oldSize = _groups->size();
+            vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
+            inserted = _groups->size() != oldSize;
+
+            if (inserted) {
+                _memoryUsageBytes += id.getApproximateSize();
+
+                // Add the accumulators, counting their initial memory usage, which flushBatch()
+                // subtracts before processing the group's first batch.
+                group.reserve(numAccumulators);
+                for (auto&& accumulatedField : _accumulatedFields) {
+                    group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+                    _memoryUsageBytes += group.back()->memUsageForSorter();
+                }
             }
-        }
 
-        /* tickle all the accumulators for the group we found */
-        dassert(numAccumulators == group.size());
+            /* tickle all the accumulators for the group we found */
+            dassert(numAccumulators == group.size());
+            batchGroup = &group;
+            batchId = std::move(id);
+        }
 
         for (size_t i = 0; i < numAccumulators; i++) {
-            group[i]->process(_accumulatedFields[i].expression->evaluate(rootDocument),
-                              _doingMerge);
-
-            _memoryUsageBytes += group[i]->memUsageForSorter();
+            Value accumulatorInput = _accumulatedFields[i].expression->evaluate(rootDocument);
+            batchMemoryUsageBytes += accumulatorInput.getApproximateSize();
+            _memoryUsageBytes += accumulatorInput.getApproximateSize();
+            batchInputs[i].push_back(std::move(accumulatorInput));
         }
+        ++batchSize;
 
         if (kDebugBuild && !storageGlobalParams.readOnly) {
             // In debug mode, spill every time we have a duplicate id to stress merge logic.
-            if (!inserted &&                 // is a dup
+            if (!extendsBatch &&             // found by looking up '_groups'
+                !inserted &&                 // is a dup
                 !pExpCtx->inMongos &&        // can't spill to disk in mongos
                 !_allowDiskUse &&            // don't change behavior when testing external sort
-                _sortedFiles.size() < 20) {  // don't open too many FDs
+                _spillStats.spills < 20) {   // don't open too many FDs
 
-                _sortedFiles.push_back(spill());
+                flushBatch();
+                spillGroups();
             }
         }
     }
+    flushBatch();
 
     switch (input.getStatus()) {
         case DocumentSource::GetNextResult::ReturnStatus::kAdvanced: {
@@ -625,7 +724,16 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
             // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
+            if (spillsByPartition() && _usedDisk) {
+                _spilled = true;
+                if (!_groups->empty()) {
+                    spillToPartitions(0);
+                }
+                finishPartitions(0);
+
+                // Load the groups of the first partition to return.
+                loadNextPartition();
+            } else if (!_sortedFiles.empty()) {
                 _spilled = true;
                 if (!_groups->empty()) {
                     _sortedFiles.push_back(spill());
@@ -674,34 +782,153 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
     stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator(pExpCtx->getValueComparator()));
 
     SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
-    switch (_accumulatedFields.size()) {  // same as ptrs[i]->second.size() for all i.
-        case 0:                           // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        writer.addAlreadySorted(ptrs[i]->first, serializeAccumulatorStates(ptrs[i]->second));
+    }
+
+    _groups->clear();
+
+    shared_ptr<Sorter<Value, Value>::Iterator> iterator(writer.done());
+    ++_spillStats.spills;
+    _spillStats.bytesSpilled += writer.bytesWritten();
+    return iterator;
+}
+
+void DocumentSourceGroup::spillToPartitions(int depth) {
+    _usedDisk = true;
+    for (auto&& group : *_groups) {
+        writeToPartition(group.first, serializeAccumulatorStates(group.second), depth);
+    }
+    _groups->clear();
+    ++_spillStats.spills;
+}
+
+void DocumentSourceGroup::writeToPartition(const Value& id,
+                                           const Value& accumulatorStates,
+                                           int depth) {
+    if (_partitionWriters.empty()) {
+        _partitionWriters.resize(_numSpillPartitions);
+    }
+
+    const size_t partition =
+        partitionForHash(pExpCtx->getValueComparator().hash(id), depth, _numSpillPartitions);
+    auto& writer = _partitionWriters[partition];
+    if (!writer) {
+        // Partitions are only created once they have data, since empty spill files can't be read.
+        writer = stdx::make_unique<SortedFileWriter<Value, Value>>(
+            SortOptions().TempDir(pExpCtx->tempDir));
+    }
+    writer->addAlreadySorted(id, accumulatorStates);
+}
+
+void DocumentSourceGroup::finishPartitions(int depth) {
+    for (auto&& writer : _partitionWriters) {
+        if (!writer) {
+            continue;
+        }
+
+        _spilledPartitions.push_back(
+            {std::unique_ptr<Sorter<Value, Value>::Iterator>(writer->done()), depth});
+        ++_spillStats.partitionsSpilled;
+        _spillStats.bytesSpilled += writer->bytesWritten();
+        writer.reset();
+    }
+}
+
+void DocumentSourceGroup::loadNextPartition() {
+    const size_t numAccumulators = _accumulatedFields.size();
+
+    _groups->clear();
+    _memoryUsageBytes = 0;
+
+    while (_groups->empty() && !_spilledPartitions.empty()) {
+        SpilledPartition partition = std::move(_spilledPartitions.back());
+        _spilledPartitions.pop_back();
+
+        bool split = false;
+        while (partition.iterator->more()) {
+            auto next = partition.iterator->next();
+
+            if (!split && _memoryUsageBytes > _maxMemoryUsageBytes &&
+                partition.depth < kMaxSpillRecursionDepth) {
+                // This partition does not fit in memory either. Split the groups aggregated from
+                // it so far, and everything left to read, into finer partitions.
+                spillToPartitions(partition.depth + 1);
+                _memoryUsageBytes = 0;
+                split = true;
             }
-            break;
 
-        case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+            if (split) {
+                writeToPartition(next.first, next.second, partition.depth + 1);
+                continue;
             }
-            break;
 
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+            const size_t oldSize = _groups->size();
+            Accumulators& group = (*_groups)[next.first];
+            if (_groups->size() != oldSize) {
+                _memoryUsageBytes += next.first.getApproximateSize();
+                group.reserve(numAccumulators);
+                for (auto&& accumulatedField : _accumulatedFields) {
+                    group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+                }
+            } else {
+                for (auto&& accum : group) {
+                    _memoryUsageBytes -= accum->memUsageForSorter();
                 }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
             }
-            break;
+
+            mergeAccumulatorStates(next.second, group);
+            for (auto&& accum : group) {
+                _memoryUsageBytes += accum->memUsageForSorter();
+            }
+        }
+
+        if (split) {
+            finishPartitions(partition.depth + 1);
+            _spillStats.maxRecursionDepth =
+                std::max(_spillStats.maxRecursionDepth, partition.depth + 1);
+        }
     }
 
-    _groups->clear();
+    groupsIterator = _groups->begin();
+}
+
+Value DocumentSourceGroup::serializeAccumulatorStates(const Accumulators& accums) const {
+    switch (accums.size()) {
+        case 0:  // no values, essentially a distinct
+            return Value();
+
+        case 1:  // just one value, use optimized serialization as single Value
+            return accums[0]->getValue(/*toBeMerged=*/true);
+
+        default: {  // multiple values, serialize as array-typed Value
+            vector<Value> states;
+            states.reserve(accums.size());
+            for (auto&& accum : accums) {
+                states.push_back(accum->getValue(/*toBeMerged=*/true));
+            }
+            return Value(std::move(states));
+        }
+    }
+}
+
+void DocumentSourceGroup::mergeAccumulatorStates(const Value& accumulatorStates,
+                                                 const Accumulators& accums) const {
+    switch (accums.size()) {  // mirrors switch in serializeAccumulatorStates()
+        case 0:               // No accumulators so no Values.
+            break;
 
-    return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
+        case 1:  // Single accumulators serialize as a single Value.
+            accums[0]->process(accumulatorStates, true);
+            break;
+
+        default: {  // Multiple accumulators serialize as an array of Values.
+            const vector<Value>& states = accumulatorStates.getArray();
+            for (size_t i = 0; i < accums.size(); i++) {
+                accums[i]->process(states[i], true);
+            }
+        }
+    }
 }
 
 boost::optional<BSONObj> DocumentSourceGroup::findRelevantInputSort() const {
@@ -776,7 +1003,8 @@ BSONObjSet DocumentSourceGroup::getOutputSorts() {
                        // False negatives are OK.
     }
 
-    if (!(_streaming || _spilled)) {
+    // Groups spilled by hash partition come back in no particular order.
+    if (!(_streaming || (_spilled && !spillsByPartition()))) {
         return SimpleBSONObjComparator::kInstance.makeBSONObjSet();
     }
 
@@ -1013,6 +1241,32 @@ DocumentSourceGroup::rewriteGroupAsTransformOnFirstDocument() const {
 
     return GroupFromFirstDocumentTransformation::create(pExpCtx, groupId, std::move(fields));
 }
+
+BSONObj DocumentSourceGroup::getHashPartitionKeyPattern() const {
+    std::set<std::string> fields;
+    for (auto&& idExpr : _idExpressions) {
+        auto fieldPathExpr = dynamic_cast<ExpressionFieldPath*>(idExpr.get());
+        if (!fieldPathExpr || !fieldPathExpr->isRootFieldPath()) {
+            return BSONObj();
+        }
+
+        // Only a single field below $$CURRENT is accepted. Grouping by $$ROOT would not partition
+        // anything, and a dotted path may traverse an array, in which case $group and the exchange
+        // would disagree on the value of the key.
+        const auto& fieldPath = fieldPathExpr->getFieldPath();
+        if (fieldPath.getPathLength() != 2) {
+            return BSONObj();
+        }
+
+        fields.insert(fieldPath.tail().fullPath());
+    }
+
+    BSONObjBuilder keyPattern;
+    for (auto&& field : fields) {
+        keyPattern << field << "hashed";
+    }
+    return keyPattern.obj();
+}
 }  // namespace mongo
 
 #include "mongo/db/sorter/sorter.cpp"
@@ -178,6 +178,18 @@ public:
     std::unique_ptr<GroupFromFirstDocumentTransformation> rewriteGroupAsTransformOnFirstDocument()
         const;
 
+    /**
+     * Returns a key pattern of the form {a: "hashed", b: "hashed", ...} naming top-level fields of
+     * the input document such that any two documents with equal values for those fields also fall
+     * into the same group. This is possible when the group key consists only of references to
+     * top-level fields, e.g. {_id: "$a"} or {_id: {x: "$a", y: "$b"}}. Returns an empty object
+     * when no such key pattern exists.
+     *
+     * A hash exchange on this key pattern partitions the input so that every group is computed
+     * entirely by one consumer, which allows the $group to be executed in parallel.
+     */
+    BSONObj getHashPartitionKeyPattern() const;
+
 protected:
     void doDispose() final;
 
@@ -192,6 +204,7 @@ private:
      */
     GetNextResult getNextStreaming();
     GetNextResult getNextSpilled();
+    GetNextResult getNextPartitioned();
     GetNextResult getNextStandard();
 
     /**
@@ -219,6 +232,51 @@ private:
      */
     std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+    /**
+     * Returns true if this $group spills by hash partitioning its groups rather than by sorting
+     * them. See internalDocumentSourceGroupSpillPartitions.
+     */
+    bool spillsByPartition() const {
+        return _numSpillPartitions >= 2;
+    }
+
+    /**
+     * Writes the groups map into the on-disk partitions at the given recursion depth, choosing the
+     * partition of each group by hashing its _id, and clears the map.
+     */
+    void spillToPartitions(int depth);
+
+    /**
+     * Appends a single group, given as its _id and its serialized accumulator states, to its
+     * partition at the given recursion depth.
+     */
+    void writeToPartition(const Value& id, const Value& accumulatorStates, int depth);
+
+    /**
+     * Finishes writing the partitions at the given recursion depth and queues the non-empty ones
+     * for re-aggregation.
+     */
+    void finishPartitions(int depth);
+
+    /**
+     * Re-aggregates queued partitions into the groups map until it holds at least one group or no
+     * partitions remain. A partition which does not fit within the memory limit is split again
+     * with a different hash function, up to a maximum recursion depth.
+     */
+    void loadNextPartition();
+
+    /**
+     * Returns the states of 'accums' in the format written to disk when spilling: nothing if
+     * there are no accumulators, the single state if there is one, and an array of the states
+     * otherwise.
+     */
+    Value serializeAccumulatorStates(const Accumulators& accums) const;
+
+    /**
+     * Merges states produced by serializeAccumulatorStates() into 'accums'.
+     */
+    void mergeAccumulatorStates(const Value& accumulatorStates, const Accumulators& accums) const;
+
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
     /**
@@ -261,6 +319,30 @@ private:
     std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> _sortedFiles;
     bool _spilled;
 
+    // Number of hash partitions to spill into, or 0 to spill sorted runs.
+    const size_t _numSpillPartitions;
+
+    // Only used when spilling by partition. One writer per partition at the depth currently being
+    // written, created when the first group is written to that partition.
+    std::vector<std::unique_ptr<SortedFileWriter<Value, Value>>> _partitionWriters;
+
+    // Only used when spilling by partition. The partitions which have been written but not yet
+    // re-aggregated.
+    struct SpilledPartition {
+        std::unique_ptr<Sorter<Value, Value>::Iterator> iterator;
+        int depth;
+    };
+    std::vector<SpilledPartition> _spilledPartitions;
+
+    // Statistics about spilling reported by explain with executionStats verbosity.
+    struct SpillStats {
+        long long spills = 0;             // Times the groups map was written to disk.
+        long long partitionsSpilled = 0;  // Partition files written, at any depth.
+        long long bytesSpilled = 0;
+        int maxRecursionDepth = 0;  // Deepest level at which a partition had to be split again.
+    };
+    SpillStats _spillStats;
+
     // Only used when '_spilled' is false.
     GroupsMap::iterator groupsIterator;
 
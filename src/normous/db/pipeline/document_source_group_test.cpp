@@ -47,12 +47,14 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/unordered_set.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -139,6 +141,78 @@ TEST_F(DocumentSourceGroupTest, ShouldBeAbleToPauseLoadingWhileSpilled) {
     ASSERT_EQ(idSet.count(2), 1UL);
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldSpillToHashPartitionsAndReaggregateEachPartition) {
+    const auto oldSpillPartitions = internalDocumentSourceGroupSpillPartitions.load();
+    internalDocumentSourceGroupSpillPartitions.store(4);
+    ON_BLOCK_EXIT([oldSpillPartitions] {
+        internalDocumentSourceGroupSpillPartitions.store(oldSpillPartitions);
+    });
+
+    auto expCtx = getExpCtx();
+
+    // Allow the $group stage to spill to disk.
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    // Small enough that neither the input nor a quarter of the groups fit in memory, so that the
+    // partitions have to be split again.
+    const size_t maxMemoryUsageBytes = 500;
+    const int numGroups = 100;
+    const int docsPerGroup = 10;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement sumStatement{"total",
+                                       ExpressionFieldPath::parse(expCtx, "$x", vps),
+                                       AccumulationStatement::getFactory("$sum")};
+    AccumulationStatement countStatement{"count",
+                                         ExpressionConstant::create(expCtx, Value(1)),
+                                         AccumulationStatement::getFactory("$sum")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$key", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {sumStatement, countStatement}, maxMemoryUsageBytes);
+
+    std::deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < numGroups * docsPerGroup; ++i) {
+        inputs.push_back(Document{{"key", i % numGroups}, {"x", i}});
+        if (i == numGroups) {
+            inputs.push_back(DocumentSource::GetNextResult::makePauseExecution());
+        }
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    ASSERT_TRUE(group->getNext().isPaused());
+
+    std::map<int, Document> results;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_EQ(results.count(doc["_id"].getInt()), 0UL);
+        results[doc["_id"].getInt()] = doc;
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+
+    ASSERT_EQ(results.size(), static_cast<size_t>(numGroups));
+    for (int key = 0; key < numGroups; ++key) {
+        // The sum of key, key + numGroups, key + 2 * numGroups, ...
+        const int expectedTotal =
+            key * docsPerGroup + numGroups * docsPerGroup * (docsPerGroup - 1) / 2;
+        ASSERT_DOCUMENT_EQ(
+            results[key],
+            (Document{{"_id", key}, {"total", expectedTotal}, {"count", docsPerGroup}}));
+    }
+
+    ASSERT_TRUE(group->getOutputSorts().empty());
+
+    auto explain = group->serialize(ExplainOptions::Verbosity::kExecStats).getDocument();
+    auto spillStats = explain["spillStats"].getDocument();
+    ASSERT_TRUE(spillStats["usedDisk"].getBool());
+    ASSERT_GT(spillStats["spills"].getLong(), 1LL);
+    ASSERT_GT(spillStats["partitionsSpilled"].getLong(), 4LL);
+    ASSERT_GT(spillStats["bytesSpilled"].getLong(), 0LL);
+    ASSERT_GTE(spillStats["maxRecursionDepth"].getInt(), 1);
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldErrorIfNotAllowedToSpillToDiskAndResultSetIsTooLarge) {
     auto expCtx = getExpCtx();
     const size_t maxMemoryUsageBytes = 1000;
@@ -189,6 +263,76 @@ TEST_F(DocumentSourceGroupTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldCountInitialMemoryUsageOfNewGroupsAccumulators) {
+    auto expCtx = getExpCtx();
+    expCtx->inMongos = true;  // Disallow external sort.
+                              // This is the only way to do this in a debug build.
+
+    // Room for the _id values of all of the groups, but not for their accumulators as well.
+    const int numGroups = 20;
+    const size_t idBytes = Value(0).getApproximateSize();
+    const size_t accumulatorBytes =
+        AccumulationStatement::getFactory("$sum")(expCtx)->memUsageForSorter();
+    const size_t maxMemoryUsageBytes = numGroups * (idBytes + accumulatorBytes / 2);
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement sumStatement{"total",
+                                       ExpressionFieldPath::parse(expCtx, "$x", vps),
+                                       AccumulationStatement::getFactory("$sum")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$_id", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {sumStatement}, maxMemoryUsageBytes);
+
+    std::deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i <= numGroups; ++i) {
+        inputs.push_back(Document{{"_id", i % numGroups}, {"x", 1}});
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldAccumulateRunsOfTheSameGroupAcrossPauses) {
+    auto expCtx = getExpCtx();
+    expCtx->inMongos = true;  // Disallow external sort.
+                              // This is the only way to do this in a debug build.
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement sumStatement{"total",
+                                       ExpressionFieldPath::parse(expCtx, "$x", vps),
+                                       AccumulationStatement::getFactory("$sum")};
+    AccumulationStatement maxStatement{"max",
+                                       ExpressionFieldPath::parse(expCtx, "$x", vps),
+                                       AccumulationStatement::getFactory("$max")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$_id", vps);
+    auto group =
+        DocumentSourceGroup::create(expCtx, groupByExpression, {sumStatement, maxStatement});
+
+    // Runs of consecutive documents in the same group, one of which is interrupted by a pause and
+    // one of which is of mixed type.
+    auto mock = DocumentSourceMock::create({Document{{"_id", 0}, {"x", 1}},
+                                            Document{{"_id", 0}, {"x", 2}},
+                                            DocumentSource::GetNextResult::makePauseExecution(),
+                                            Document{{"_id", 0}, {"x", 3}},
+                                            Document{{"_id", 1}, {"x", 4}},
+                                            Document{{"_id", 1}, {"x", 5.5}},
+                                            Document{{"_id", 1}, {"x", "str"_sd}},
+                                            Document{{"_id", 0}, {"x", 4}}});
+    group->setSource(mock.get());
+
+    ASSERT_TRUE(group->getNext().isPaused());
+
+    std::map<int, Document> results;
+    for (auto next = group->getNext(); next.isAdvanced(); next = group->getNext()) {
+        auto doc = next.releaseDocument();
+        results[doc["_id"].getInt()] = doc;
+    }
+    ASSERT_EQ(results.size(), 2UL);
+    ASSERT_DOCUMENT_EQ(results[0], (Document{{"_id", 0}, {"total", 10}, {"max", 4}}));
+    ASSERT_DOCUMENT_EQ(results[1], (Document{{"_id", 1}, {"total", 9.5}, {"max", "str"_sd}}));
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldReportSingleFieldGroupKeyAsARename) {
     auto expCtx = getExpCtx();
     VariablesParseState vps = expCtx->variablesParseState;
@@ -227,6 +371,47 @@ TEST_F(DocumentSourceGroupTest, ShouldNotReportDottedGroupKeyAsARename) {
     ASSERT_EQ(modifiedPathsRet.renames.size(), 0UL);
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldReportSingleFieldGroupKeyAsHashPartitionKey) {
+    auto expCtx = getExpCtx();
+    VariablesParseState vps = expCtx->variablesParseState;
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$x", vps);
+    auto group = DocumentSourceGroup::create(expCtx, groupByExpression, {});
+    ASSERT_BSONOBJ_EQ(group->getHashPartitionKeyPattern(),
+                      BSON("x"
+                           << "hashed"));
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldReportMultipleFieldGroupKeysAsHashPartitionKey) {
+    auto expCtx = getExpCtx();
+    VariablesParseState vps = expCtx->variablesParseState;
+    auto x = ExpressionFieldPath::parse(expCtx, "$x", vps);
+    auto y = ExpressionFieldPath::parse(expCtx, "$y", vps);
+    auto groupByExpression = ExpressionObject::create(expCtx, {{"y", y}, {"x", x}, {"z", x}});
+    auto group = DocumentSourceGroup::create(expCtx, groupByExpression, {});
+    ASSERT_BSONOBJ_EQ(group->getHashPartitionKeyPattern(),
+                      BSON("x"
+                           << "hashed"
+                           << "y"
+                           << "hashed"));
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldNotReportHashPartitionKeyForDottedOrComputedGroupKeys) {
+    auto expCtx = getExpCtx();
+    VariablesParseState vps = expCtx->variablesParseState;
+
+    auto xDotY = ExpressionFieldPath::parse(expCtx, "$x.y", vps);
+    ASSERT_BSONOBJ_EQ(DocumentSourceGroup::create(expCtx, xDotY, {})->getHashPartitionKeyPattern(),
+                      BSONObj());
+
+    auto root = ExpressionFieldPath::parse(expCtx, "$$ROOT", vps);
+    ASSERT_BSONOBJ_EQ(DocumentSourceGroup::create(expCtx, root, {})->getHashPartitionKeyPattern(),
+                      BSONObj());
+
+    auto constant = ExpressionConstant::create(expCtx, Value(BSONNULL));
+    ASSERT_BSONOBJ_EQ(
+        DocumentSourceGroup::create(expCtx, constant, {})->getHashPartitionKeyPattern(), BSONObj());
+}
+
 BSONObj toBson(const intrusive_ptr<DocumentSource>& source) {
     vector<Value> arr;
     source->serializeToArray(arr);
@@ -226,6 +226,22 @@ BSONObj buildEqualityOrQuery(const std::string& fieldName, const BSONArray& valu
     return orBuilder.obj();
 }
 
+/**
+ * Throws if 'resultsSize' bytes of documents from 'fromNs' are too many to be added to a single
+ * document. 'describeMatch' is only called to build the error message, and returns what the
+ * documents were matched against.
+ */
+template <typename DescribeMatch>
+void assertResultsFitInDocument(const NamespaceString& fromNs,
+                                int resultsSize,
+                                const DescribeMatch& describeMatch) {
+    uassert(4568,
+            str::stream() << "Total size of documents in " << fromNs.coll() << " matching "
+                          << describeMatch()
+                          << " exceeds maximum document size",
+            resultsSize <= BSONObjMaxInternalSize);
+}
+
 }  // namespace
 
 DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
@@ -235,7 +251,8 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
         return unwindResult();
     }
 
-    auto nextInput = pSource->getNext();
+    std::vector<Document> hashJoinResults;
+    auto nextInput = useHashJoin() ? nextHashJoinedInput(&hashJoinResults) : pSource->getNext();
     if (!nextInput.isAdvanced()) {
         return nextInput;
     }
@@ -246,6 +263,24 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
+    if (_hashJoin) {
+        std::vector<Value> results;
+        int objsize = 0;
+        for (auto&& result : hashJoinResults) {
+            objsize += result.getApproximateSize();
+            assertResultsFitInDocument(_fromNs, objsize, [&]() -> std::string {
+                return makeMatchStageFromInput(
+                           inputDoc, *_localField, _foreignField->fullPath(), BSONObj())
+                    .toString();
+            });
+            results.emplace_back(std::move(result));
+        }
+
+        MutableDocument output(std::move(inputDoc));
+        output.setNestedField(_as, Value(std::move(results)));
+        return output.freeze();
+    }
+
     if (!wasConstructedWithPipelineSyntax()) {
         auto matchStage =
             makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
@@ -259,12 +294,9 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     int objsize = 0;
     while (auto result = pipeline->getNext()) {
         objsize += result->getApproximateSize();
-        uassert(4568,
-                str::stream() << "Total size of documents in " << _fromNs.coll()
-                              << " matching pipeline "
-                              << getUserPipelineDefinition()
-                              << " exceeds maximum document size",
-                objsize <= BSONObjMaxInternalSize);
+        assertResultsFitInDocument(_fromNs, objsize, [&]() -> std::string {
+            return str::stream() << "pipeline " << getUserPipelineDefinition();
+        });
         results.emplace_back(std::move(*result));
     }
     for (auto&& source : pipeline->getSources()) {
@@ -456,6 +488,96 @@ std::string DocumentSourceLookUp::getUserPipelineDefinition() {
     return _resolvedPipeline.back().toString();
 }
 
+bool DocumentSourceLookUp::useHashJoin() {
+    if (_hashJoin) {
+        return true;
+    }
+    if (_hashJoinRejected) {
+        return false;
+    }
+    if (wasConstructedWithPipelineSyntax() || !internalDocumentSourceLookupUseHashJoin.load()) {
+        _hashJoinRejected = true;
+        return false;
+    }
+
+    // Read the foreign collection without the trailing per-document $match, but filtered by any
+    // $match we have absorbed.
+    std::vector<BSONObj> buildPipelineSpec(_resolvedPipeline.begin(),
+                                           std::prev(_resolvedPipeline.end()));
+    if (_additionalFilter) {
+        buildPipelineSpec.push_back(BSON("$match" << *_additionalFilter));
+    }
+    auto buildPipeline = uassertStatusOK(
+        pExpCtx->mongoProcessInterface->makePipeline(buildPipelineSpec, _fromExpCtx));
+
+    auto hashJoin = stdx::make_unique<LookupHashJoin>(
+        _fromExpCtx,
+        *_localField,
+        *_foreignField,
+        _additionalFilter.value_or(BSONObj()),
+        internalDocumentSourceLookupHashJoinMaxMemoryBytes.load());
+    const bool built = hashJoin->build(buildPipeline.get());
+    _usedDisk = _usedDisk || buildPipeline->usedDisk() || hashJoin->usedDisk();
+    if (!built) {
+        // The foreign collection does not fit in memory and we may not spill it, so fall back to
+        // querying it for each input document.
+        _hashJoinRejected = true;
+        return false;
+    }
+
+    _hashJoin = std::move(hashJoin);
+    return true;
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::nextHashJoinedInput(
+    std::vector<Document>* results) {
+    if (_hashJoinBuffer.empty()) {
+        if (_hashJoinBatchEnd) {
+            auto batchEnd = std::move(*_hashJoinBatchEnd);
+            _hashJoinBatchEnd = boost::none;
+            return batchEnd;
+        }
+
+        // Read inputs until the batch is large enough, or our source pauses or is exhausted.
+        std::vector<Document> inputs;
+        size_t inputsSizeBytes = 0;
+        do {
+            auto nextInput = pSource->getNext();
+            if (!nextInput.isAdvanced()) {
+                if (inputs.empty()) {
+                    return nextInput;
+                }
+                _hashJoinBatchEnd = std::move(nextInput);
+                break;
+            }
+            inputs.push_back(nextInput.releaseDocument());
+            inputsSizeBytes += inputs.back().getApproximateSize();
+        } while (inputsSizeBytes < _hashJoin->probeBatchSizeBytes());
+
+        auto joined = _hashJoin->probe(inputs);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            _hashJoinBuffer.emplace_back(std::move(inputs[i]), std::move(joined[i]));
+        }
+    }
+
+    auto next = std::move(_hashJoinBuffer.front());
+    _hashJoinBuffer.pop_front();
+    *results = std::move(next.second);
+    return std::move(next.first);
+}
+
+boost::optional<Document> DocumentSourceLookUp::nextUnwindValue() {
+    if (!_hashJoin) {
+        return _pipeline->getNext();
+    }
+    if (_hashJoinResults.empty()) {
+        return boost::none;
+    }
+    auto next = std::move(_hashJoinResults.front());
+    _hashJoinResults.pop_front();
+    return next;
+}
+
 bool DocumentSourceLookUp::usedDisk() {
     if (_pipeline)
         _usedDisk = _usedDisk || _pipeline->usedDisk();
@@ -468,6 +590,9 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _hashJoin.reset();
+    _hashJoinBuffer.clear();
+    _hashJoinResults.clear();
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
@@ -560,36 +685,43 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_pipeline || !_nextValue) {
-        auto nextInput = pSource->getNext();
+    while (!_input || !_nextValue) {
+        std::vector<Document> hashJoinResults;
+        auto nextInput = useHashJoin() ? nextHashJoinedInput(&hashJoinResults) : pSource->getNext();
         if (!nextInput.isAdvanced()) {
             return nextInput;
         }
 
         _input = nextInput.releaseDocument();
 
-        if (!wasConstructedWithPipelineSyntax()) {
-            BSONObj filter = _additionalFilter.value_or(BSONObj());
-            auto matchStage =
-                makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
-            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-            _resolvedPipeline.back() = matchStage;
-        }
+        if (_hashJoin) {
+            _hashJoinResults.assign(std::make_move_iterator(hashJoinResults.begin()),
+                                    std::make_move_iterator(hashJoinResults.end()));
+        } else {
+            if (!wasConstructedWithPipelineSyntax()) {
+                BSONObj filter = _additionalFilter.value_or(BSONObj());
+                auto matchStage = makeMatchStageFromInput(
+                    *_input, *_localField, _foreignField->fullPath(), filter);
+                // We've already allocated space for the trailing $match stage in
+                // '_resolvedPipeline'.
+                _resolvedPipeline.back() = matchStage;
+            }
 
-        if (_pipeline) {
-            _usedDisk = _usedDisk || _pipeline->usedDisk();
-            _pipeline->dispose(pExpCtx->opCtx);
-        }
+            if (_pipeline) {
+                _usedDisk = _usedDisk || _pipeline->usedDisk();
+                _pipeline->dispose(pExpCtx->opCtx);
+            }
 
-        _pipeline = buildPipeline(*_input);
+            _pipeline = buildPipeline(*_input);
 
-        // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
-        // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
-        // outer Pipeline that will propagate dispose() calls before being destroyed.
-        _pipeline.get_deleter().dismissDisposal();
+            // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
+            // potentially be used by multiple OperationContexts, and the $lookup stage is part of
+            // an outer Pipeline that will propagate dispose() calls before being destroyed.
+            _pipeline.get_deleter().dismissDisposal();
+        }
 
         _cursorIndex = 0;
-        _nextValue = _pipeline->getNext();
+        _nextValue = nextUnwindValue();
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_nextValue) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -607,7 +739,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
     invariant(bool(_input) && bool(_nextValue));
     auto currentValue = *_nextValue;
-    _nextValue = _pipeline->getNext();
+    _nextValue = nextUnwindValue();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
     MutableDocument output(_nextValue ? *_input : std::move(*_input));
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_match.h"
@@ -36,6 +37,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
+#include "mongo/db/pipeline/lookup_hash_join.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 #include "mongo/db/pipeline/value_comparator.h"
 
@@ -238,6 +240,25 @@ private:
 
     GetNextResult unwindResult();
 
+    /**
+     * Returns whether input documents should be joined by probing '_hashJoin' rather than by
+     * querying the foreign collection once per document. The hash join is built from the foreign
+     * collection on the first call.
+     */
+    bool useHashJoin();
+
+    /**
+     * Returns the next result from our source, placing the foreign documents it joins with in
+     * 'results' if it is a document. Inputs are read and probed against '_hashJoin' in batches.
+     */
+    GetNextResult nextHashJoinedInput(std::vector<Document>* results);
+
+    /**
+     * Returns the next foreign document joined with '_input' when unwinding, or boost::none if
+     * there are no more.
+     */
+    boost::optional<Document> nextUnwindValue();
+
     /**
      * Copies 'vars' and 'vps' to the Variables and VariablesParseState objects in 'expCtx'. These
      * copies provide access to 'let' defined variables in sub-pipeline execution.
@@ -317,6 +338,17 @@ private:
 
     std::vector<LetVariable> _letVariables;
 
+    // Used instead of per-document queries for the localField/foreignField syntax when
+    // internalDocumentSourceLookupUseHashJoin is enabled. '_hashJoinRejected' is set if the hash
+    // join is disabled or the foreign collection could not be held within its memory limit.
+    std::unique_ptr<LookupHashJoin> _hashJoin;
+    bool _hashJoinRejected = false;
+
+    // Inputs which have been probed against '_hashJoin' but not yet returned, along with the
+    // documents they join with, and the result which ended the batch if it was not a document.
+    std::deque<std::pair<Document, std::vector<Document>>> _hashJoinBuffer;
+    boost::optional<GetNextResult> _hashJoinBatchEnd;
+
     boost::intrusive_ptr<DocumentSourceMatch> _matchSrc;
     boost::intrusive_ptr<DocumentSourceUnwind> _unwindSrc;
 
@@ -326,6 +358,8 @@ private:
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
+    // When '_hashJoin' is in use, the remaining results for '_input' in place of '_pipeline'.
+    std::deque<Document> _hashJoinResults;
 };
 
 }  // namespace mongo
@@ -41,12 +41,15 @@
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
 #include "mongo/db/pipeline/field_path.h"
+#include "mongo/db/pipeline/lookup_hash_join.h"
 #include "mongo/db/pipeline/stub_mongo_process_interface.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -685,6 +688,179 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     lookup->dispose();
 }
 
+/**
+ * Returns the foreign collection and input documents used to compare the hash join with per
+ * document queries, covering array, missing and numerically equal values.
+ */
+deque<DocumentSource::GetNextResult> makeHashJoinForeignContents() {
+    return {Document(fromjson("{_id: 0, a: 1}")),
+            Document(fromjson("{_id: 1, a: [1, 2]}")),
+            Document(fromjson("{_id: 2, a: {b: 1}}")),
+            Document(fromjson("{_id: 3}")),
+            Document(fromjson("{_id: 4, a: 2.0}"))};
+}
+
+void assertHashJoinResults(DocumentSourceLookUp* lookup) {
+    auto mockLocalSource =
+        DocumentSourceMock::create({Document(fromjson("{x: 1}")),
+                                    DocumentSource::GetNextResult::makePauseExecution(),
+                                    Document(fromjson("{x: [2]}")),
+                                    Document()});
+    lookup->setSource(mockLocalSource.get());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       Document(fromjson("{x: 1, as: [{_id: 0, a: 1}, {_id: 1, a: [1, 2]}]}")));
+
+    ASSERT_TRUE(lookup->getNext().isPaused());
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       Document(fromjson("{x: [2], as: [{_id: 1, a: [1, 2]}, {_id: 4, a: 2.0}]}")));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), Document(fromjson("{as: [{_id: 3}]}")));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinShouldReturnSameResultsAsPerDocumentQueries) {
+    const auto oldUseHashJoin = internalDocumentSourceLookupUseHashJoin.load();
+    internalDocumentSourceLookupUseHashJoin.store(true);
+    ON_BLOCK_EXIT(
+        [oldUseHashJoin] { internalDocumentSourceLookupUseHashJoin.store(oldUseHashJoin); });
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto parsed = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'x', foreignField: 'a', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    // The mock returns the whole foreign collection for every query, so only the hash join's own
+    // filtering produces the expected matches.
+    expCtx->mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(makeHashJoinForeignContents());
+
+    assertHashJoinResults(lookup);
+    ASSERT_FALSE(lookup->usedDisk());
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinShouldFallBackToPerDocumentQueriesWithoutDiskUse) {
+    const auto oldUseHashJoin = internalDocumentSourceLookupUseHashJoin.load();
+    internalDocumentSourceLookupUseHashJoin.store(true);
+    ON_BLOCK_EXIT(
+        [oldUseHashJoin] { internalDocumentSourceLookupUseHashJoin.store(oldUseHashJoin); });
+    const auto oldMaxMemory = internalDocumentSourceLookupHashJoinMaxMemoryBytes.load();
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(1);
+    ON_BLOCK_EXIT([oldMaxMemory] {
+        internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(oldMaxMemory);
+    });
+
+    auto expCtx = getExpCtx();
+    expCtx->allowDiskUse = false;
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto parsed = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'x', foreignField: 'a', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    // The foreign collection does not fit in memory, so each input is joined by running its $match
+    // over the mocked collection instead.
+    expCtx->mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(makeHashJoinForeignContents());
+
+    assertHashJoinResults(lookup);
+    ASSERT_FALSE(lookup->usedDisk());
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinShouldSpillAndPreserveInputOrderWhileUnwinding) {
+    const auto oldUseHashJoin = internalDocumentSourceLookupUseHashJoin.load();
+    internalDocumentSourceLookupUseHashJoin.store(true);
+    ON_BLOCK_EXIT(
+        [oldUseHashJoin] { internalDocumentSourceLookupUseHashJoin.store(oldUseHashJoin); });
+    const auto oldMaxMemory = internalDocumentSourceLookupHashJoinMaxMemoryBytes.load();
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(1);
+    ON_BLOCK_EXIT([oldMaxMemory] {
+        internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(oldMaxMemory);
+    });
+
+    // Allow the foreign collection to be spilled. This must be set before the $lookup is created,
+    // since it copies the ExpressionContext for the foreign collection.
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceLookUpTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    auto parsed = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'foreign', localField: 'x', foreignField: 'k', as: 'as'}}")
+            .firstElement(),
+        expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    const bool preserveNullAndEmptyArrays = false;
+    const boost::optional<std::string> includeArrayIndex = boost::none;
+    lookup->setUnwindStage(
+        DocumentSourceUnwind::create(expCtx, "as", preserveNullAndEmptyArrays, includeArrayIndex));
+
+    auto mockLocalSource = DocumentSourceMock::create({Document(fromjson("{x: 'a'}")),
+                                                       Document(fromjson("{x: 'c'}")),
+                                                       Document(fromjson("{x: 'b'}")),
+                                                       Document(fromjson("{x: 'a'}"))});
+    lookup->setSource(mockLocalSource.get());
+
+    expCtx->mongoProcessInterface = std::make_shared<MockMongoInterface>(
+        deque<DocumentSource::GetNextResult>{Document(fromjson("{_id: 0, k: 'a'}")),
+                                             Document(fromjson("{_id: 1, k: 'b'}")),
+                                             Document(fromjson("{_id: 2, k: 'a'}"))});
+
+    // With such a small memory limit each input is probed in its own batch, so the partition read
+    // for the first 'a' must still be readable for the second.
+    for (auto&& expected : {"{x: 'a', as: {_id: 0, k: 'a'}}",
+                            "{x: 'a', as: {_id: 2, k: 'a'}}",
+                            "{x: 'b', as: {_id: 1, k: 'b'}}",
+                            "{x: 'a', as: {_id: 0, k: 'a'}}",
+                            "{x: 'a', as: {_id: 2, k: 'a'}}"}) {
+        auto next = lookup->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(next.releaseDocument(), Document(fromjson(expected)));
+    }
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_TRUE(lookup->usedDisk());
+    lookup->dispose();
+}
+
+TEST(LookupHashJoinForeignKeys, ShouldIncludeArrayElementsAndNullForMissingPaths) {
+    std::vector<Value> keys;
+    LookupHashJoin::getForeignKeys(fromjson("{a: [{b: 1}, {b: [2, 3]}, {c: 4}, 5]}"),
+                                   FieldPath("a.b"),
+                                   &keys);
+
+    ASSERT_VALUE_EQ(Value(keys),
+                    Value(BSON_ARRAY(1 << BSON_ARRAY(2 << 3) << 2 << 3 << BSONNULL << BSONNULL
+                                       << BSONNULL)));
+}
+
+TEST(LookupHashJoinForeignKeys, ShouldFollowPositionalPathComponents) {
+    std::vector<Value> keys;
+    LookupHashJoin::getForeignKeys(fromjson("{a: [7, 8]}"), FieldPath("a.1"), &keys);
+
+    ASSERT_VALUE_EQ(Value(keys), Value(BSON_ARRAY(BSONNULL << BSONNULL << 8 << BSONNULL)));
+}
+
 TEST_F(DocumentSourceLookUpTest, LookupReportsAsFieldIsModified) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
@@ -0,0 +1,327 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_parallel_group.h"
+
+#include <algorithm>
+
+#include "mongo/db/client.h"
+#include "mongo/db/pipeline/document_source_match.h"
+#include "mongo/db/pipeline/document_source_project.h"
+#include "mongo/db/pipeline/document_source_single_document_transformation.h"
+#include "mongo/db/pipeline/document_source_unwind.h"
+#include "mongo/db/pipeline/mongo_process_interface.h"
+#include "mongo/db/pipeline/parallel_aggregation.h"
+#include "mongo/db/service_context.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+constexpr StringData DocumentSourceParallelGroup::kStageName;
+constexpr size_t DocumentSourceParallelGroup::kMaxBufferedBytes;
+
+bool DocumentSourceParallelGroup::canRunInProducer(const DocumentSource& source) {
+    return dynamic_cast<const DocumentSourceMatch*>(&source) ||
+        dynamic_cast<const DocumentSourceSingleDocumentTransformation*>(&source) ||
+        dynamic_cast<const DocumentSourceUnwind*>(&source);
+}
+
+boost::intrusive_ptr<DocumentSourceParallelGroup> DocumentSourceParallelGroup::create(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    const Pipeline::SourceContainer& producerSources,
+    const boost::intrusive_ptr<DocumentSourceGroup>& group,
+    size_t nConsumers) {
+    invariant(nConsumers > 1);
+
+    // The hash exchange is not collation-aware, so a non-simple collation could split one group
+    // across consumers.
+    if (!canRunAggregationInParallel(expCtx) || expCtx->getCollator()) {
+        return nullptr;
+    }
+
+    // A $group which merges partial results is not the place to fan out, and one which could be
+    // answered with a DISTINCT_SCAN should be left alone for PipelineD.
+    if (group->doingMerge() || group->rewriteGroupAsTransformOnFirstDocument()) {
+        return nullptr;
+    }
+
+    auto keyPattern = group->getHashPartitionKeyPattern();
+    if (keyPattern.isEmpty()) {
+        return nullptr;
+    }
+
+    for (auto&& source : producerSources) {
+        invariant(canRunInProducer(*source));
+    }
+
+    // The producer pipeline is driven by consumer threads, which attach it to their own operation
+    // contexts, so it needs its own ExpressionContext and MongoProcessInterface. The stages are
+    // rebuilt from their serialized form against the new context.
+    std::vector<Value> serializedStages;
+    for (auto&& source : producerSources) {
+        source->serializeToArray(serializedStages);
+    }
+
+    std::vector<BSONObj> rawProducer;
+    for (auto&& stage : serializedStages) {
+        rawProducer.push_back(stage.getDocument().toBson());
+    }
+
+    auto producerExpCtx = expCtx->copyWith(expCtx->ns, expCtx->uuid);
+    producerExpCtx->mongoProcessInterface = MongoProcessInterface::create(expCtx->opCtx);
+    auto producer = uassertStatusOK(Pipeline::parse(rawProducer, producerExpCtx));
+
+    // Only the fields used by the $group need to cross the exchange, and limiting them here also
+    // lets PipelineD generate a projection for the cursor.
+    DepsTracker deps;
+    group->getDependencies(&deps);
+    if (!deps.needWholeDocument) {
+        producer->addFinalSource(
+            DocumentSourceProject::create(deps.toProjection(), producerExpCtx));
+    }
+
+    group->serializeToArray(serializedStages);
+    auto groupSpec = serializedStages.back().getDocument().toBson();
+
+    std::vector<boost::intrusive_ptr<ExpressionContext>> consumerExpCtxs;
+    for (size_t idx = 0; idx < nConsumers; ++idx) {
+        consumerExpCtxs.emplace_back(expCtx->copyWith(expCtx->ns, expCtx->uuid));
+    }
+
+    return new DocumentSourceParallelGroup(expCtx,
+                                           std::move(producer),
+                                           std::move(serializedStages),
+                                           std::move(groupSpec),
+                                           std::move(keyPattern),
+                                           std::move(consumerExpCtxs));
+}
+
+DocumentSourceParallelGroup::DocumentSourceParallelGroup(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    std::unique_ptr<Pipeline, PipelineDeleter> producer,
+    std::vector<Value> serializedStages,
+    BSONObj groupSpec,
+    BSONObj keyPattern,
+    std::vector<boost::intrusive_ptr<ExpressionContext>> consumerExpCtxs)
+    : DocumentSource(expCtx),
+      _producer(std::move(producer)),
+      _serializedStages(std::move(serializedStages)),
+      _groupSpec(std::move(groupSpec)),
+      _keyPattern(std::move(keyPattern)),
+      _consumerExpCtxs(std::move(consumerExpCtxs)) {}
+
+DocumentSourceParallelGroup::~DocumentSourceParallelGroup() {
+    // Normally the threads are stopped by dispose(), but make sure that none of them outlives the
+    // state it refers to.
+    stopConsumers();
+}
+
+void DocumentSourceParallelGroup::serializeToArray(
+    std::vector<Value>& array, boost::optional<ExplainOptions::Verbosity> explain) const {
+    array.insert(array.end(), _serializedStages.begin(), _serializedStages.end());
+}
+
+void DocumentSourceParallelGroup::startConsumers() {
+    invariant(!_started);
+    _started = true;
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kHash);
+    spec.setConsumers(_consumerExpCtxs.size());
+    spec.setKey(_keyPattern);
+
+    _exchange = new Exchange(std::move(spec), std::move(_producer));
+
+    // The consumer pipelines are built here, but are only ever used by their own threads.
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers;
+    for (size_t idx = 0; idx < _consumerExpCtxs.size(); ++idx) {
+        auto& consumerExpCtx = _consumerExpCtxs[idx];
+        boost::intrusive_ptr<DocumentSource> exchangeSource =
+            new DocumentSourceExchange(consumerExpCtx, _exchange, idx);
+        auto group = DocumentSourceGroup::createFromBson(_groupSpec.firstElement(), consumerExpCtx);
+        consumers.emplace_back(
+            uassertStatusOK(Pipeline::create({exchangeSource, group}, consumerExpCtx)));
+
+        // The pipeline will be disposed by its thread, using that thread's operation context.
+        consumers.back().get_deleter().dismissDisposal();
+    }
+
+    auto serviceContext = pExpCtx->opCtx->getServiceContext();
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _activeConsumers = consumers.size();
+    for (size_t idx = 0; idx < consumers.size(); ++idx) {
+        _threads.emplace_back(
+            [ this, serviceContext, idx, consumer = std::move(consumers[idx]) ]() mutable {
+                runConsumer(serviceContext, idx, std::move(consumer));
+            });
+    }
+}
+
+void DocumentSourceParallelGroup::runConsumer(ServiceContext* serviceContext,
+                                              size_t consumerId,
+                                              std::unique_ptr<Pipeline, PipelineDeleter> consumer) {
+    const std::string threadName = str::stream() << "parallelGroup-" << consumerId;
+    Client::initThread(threadName, serviceContext, nullptr);
+    auto opCtx = cc().makeOperationContext();
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_shuttingDown) {
+            stdx::lock_guard<Client> clientLock(cc());
+            serviceContext->killOperation(opCtx.get(), ErrorCodes::QueryPlanKilled);
+        }
+        _consumerOpCtxs.push_back(opCtx.get());
+    }
+
+    _consumerExpCtxs[consumerId]->opCtx = opCtx.get();
+
+    Status status = Status::OK();
+    try {
+        for (auto next = consumer->getNext(); next; next = consumer->getNext()) {
+            if (!pushResult(std::move(*next))) {
+                break;
+            }
+        }
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+    }
+
+    if (!status.isOK()) {
+        LOG(1) << "parallel $group consumer " << consumerId << " failed: " << status;
+
+        // This consumer no longer drains its exchange buffer, so make sure the other consumers do
+        // not wait for it.
+        _exchange->abort(status);
+    }
+
+    consumer->dispose(opCtx.get());
+    consumer.reset();
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _consumerOpCtxs.erase(
+        std::find(_consumerOpCtxs.begin(), _consumerOpCtxs.end(), opCtx.get()));
+    _consumerExpCtxs[consumerId]->opCtx = nullptr;
+
+    // Errors caused by shutting the consumers down are of no interest to anybody.
+    if (!status.isOK() && _consumerError.isOK() && !_shuttingDown) {
+        _consumerError = status;
+    }
+    --_activeConsumers;
+    _resultsChanged.notify_all();
+}
+
+bool DocumentSourceParallelGroup::pushResult(Document doc) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    _resultsChanged.wait(lk, [&] {
+        return _shuttingDown || !_consumerError.isOK() || _bytesInResults < kMaxBufferedBytes;
+    });
+
+    if (_shuttingDown || !_consumerError.isOK()) {
+        return false;
+    }
+
+    _bytesInResults += doc.getApproximateSize();
+    _results.push_back(std::move(doc));
+    _resultsChanged.notify_all();
+    return true;
+}
+
+DocumentSource::GetNextResult DocumentSourceParallelGroup::getNext() {
+    pExpCtx->checkForInterrupt();
+
+    if (!_started) {
+        startConsumers();
+    }
+
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    pExpCtx->opCtx->waitForConditionOrInterrupt(_resultsChanged, lk, [&] {
+        return !_results.empty() || _activeConsumers == 0 || !_consumerError.isOK();
+    });
+
+    uassertStatusOKWithContext(_consumerError, "parallel $group failed");
+
+    if (_results.empty()) {
+        invariant(_activeConsumers == 0);
+        return GetNextResult::makeEOF();
+    }
+
+    auto doc = std::move(_results.front());
+    _results.pop_front();
+    _bytesInResults -= doc.getApproximateSize();
+    _resultsChanged.notify_all();
+
+    return std::move(doc);
+}
+
+void DocumentSourceParallelGroup::stopConsumers() {
+    std::vector<stdx::thread> threads;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_threads.empty()) {
+            return;
+        }
+
+        _shuttingDown = true;
+        _resultsChanged.notify_all();
+
+        // Interrupt consumers which are busy loading the exchange or computing their groups.
+        for (auto opCtx : _consumerOpCtxs) {
+            stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+            opCtx->getServiceContext()->killOperation(opCtx, ErrorCodes::QueryPlanKilled);
+        }
+
+        threads.swap(_threads);
+    }
+
+    // Consumers which are blocked waiting for exchange buffer space are not interruptible.
+    _exchange->abort({ErrorCodes::QueryPlanKilled, "parallel $group is shutting down"});
+
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+}
+
+void DocumentSourceParallelGroup::doDispose() {
+    if (_producer) {
+        // Execution never started, so the producer pipeline is still ours to dispose.
+        _producer->dispose(pExpCtx->opCtx);
+        _producer.get_deleter().dismissDisposal();
+        _producer.reset();
+    }
+
+    stopConsumers();
+    _results.clear();
+    _bytesInResults = 0;
+}
+
+}  // namespace mongo
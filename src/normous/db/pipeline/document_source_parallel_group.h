@@ -0,0 +1,206 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/pipeline/document_source_exchange.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+
+namespace mongo {
+
+/**
+ * Executes a $group on several threads at once. The stages preceding the $group are moved into a
+ * 'producer' pipeline whose output is distributed by a hash Exchange on the group key, so every
+ * group is computed entirely by one of the consumer pipelines. Each consumer pipeline consists of
+ * a DocumentSourceExchange followed by a copy of the $group and is run on its own thread with its
+ * own Client and OperationContext. Because the consumers compute disjoint sets of groups, merging
+ * their output is a simple union.
+ *
+ * This stage is never parsed from user input; it is created by Pipeline::optimizePipeline() when
+ * the internalQueryParallelGroupConsumers knob is set. The cursor source is attached to the
+ * producer pipeline by PipelineD, which is why the rewrite happens before the cursor exists.
+ */
+class DocumentSourceParallelGroup final : public DocumentSource {
+public:
+    static constexpr StringData kStageName = "$_internalParallelGroup"_sd;
+
+    // The maximum number of bytes of group output buffered for the consumer of this stage.
+    static constexpr size_t kMaxBufferedBytes = 16 * 1024 * 1024;
+
+    /**
+     * Returns true if 'source' may be moved into the producer pipeline. Only stages which
+     * transform documents one at a time and do not need to talk to other parts of the system are
+     * accepted, since the producer pipeline is run on whichever consumer thread loads the exchange.
+     */
+    static bool canRunInProducer(const DocumentSource& source);
+
+    /**
+     * Attempts to build a stage which computes 'group' over the output of 'producerSources' with
+     * 'nConsumers' threads. Returns nullptr if the $group or the aggregation as a whole is not
+     * eligible for the rewrite. The stages in 'producerSources' and 'group' are not modified; they
+     * are copied into pipelines with their own ExpressionContexts, as those cannot be shared
+     * between threads.
+     */
+    static boost::intrusive_ptr<DocumentSourceParallelGroup> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        const Pipeline::SourceContainer& producerSources,
+        const boost::intrusive_ptr<DocumentSourceGroup>& group,
+        size_t nConsumers);
+
+    ~DocumentSourceParallelGroup();
+
+    GetNextResult getNext() final;
+
+    const char* getSourceName() const final {
+        return kStageName.rawData();
+    }
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kBlocking,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kNone,
+                                     DiskUseRequirement::kWritesTmpData,
+                                     FacetRequirement::kNotAllowed,
+                                     TransactionRequirement::kNotAllowed);
+
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+    /**
+     * Serializes as the original stages, i.e. the producer stages followed by the $group, so that
+     * the rewrite is invisible to anything which re-parses the pipeline.
+     */
+    void serializeToArray(
+        std::vector<Value>& array,
+        boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+    DepsTracker::State getDependencies(DepsTracker* deps) const final {
+        return DepsTracker::State::EXHAUSTIVE_ALL;
+    }
+
+    /**
+     * The pipeline which feeds the exchange. PipelineD attaches the cursor source to it. Must not
+     * be called once execution has started.
+     */
+    Pipeline* getProducerPipeline() const {
+        invariant(_producer);
+        return _producer.get();
+    }
+
+    size_t getConsumers() const {
+        return _consumerExpCtxs.size();
+    }
+
+protected:
+    void doDispose() final;
+
+private:
+    DocumentSourceParallelGroup(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        std::unique_ptr<Pipeline, PipelineDeleter> producer,
+        std::vector<Value> serializedStages,
+        BSONObj groupSpec,
+        BSONObj keyPattern,
+        std::vector<boost::intrusive_ptr<ExpressionContext>> consumerExpCtxs);
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final {
+        MONGO_UNREACHABLE;  // Should call serializeToArray instead.
+    }
+
+    /**
+     * Builds the exchange and the consumer pipelines, and starts one thread per consumer.
+     */
+    void startConsumers();
+
+    /**
+     * The body of a consumer thread.
+     */
+    void runConsumer(ServiceContext* serviceContext,
+                     size_t consumerId,
+                     std::unique_ptr<Pipeline, PipelineDeleter> consumer);
+
+    /**
+     * Called by a consumer thread to hand over a document. Blocks while the output buffer is full.
+     * Returns false if the consumer should stop because this stage is shutting down.
+     */
+    bool pushResult(Document doc);
+
+    /**
+     * Stops all consumer threads and waits for them to exit.
+     */
+    void stopConsumers();
+
+    // The stages preceding the $group, owned by this stage until execution starts, at which point
+    // ownership passes to the exchange.
+    std::unique_ptr<Pipeline, PipelineDeleter> _producer;
+
+    // The original producer stages and $group, serialized before the rewrite.
+    const std::vector<Value> _serializedStages;
+
+    // The specification of the $group run by every consumer.
+    const BSONObj _groupSpec;
+
+    const BSONObj _keyPattern;
+
+    // One ExpressionContext per consumer pipeline.
+    const std::vector<boost::intrusive_ptr<ExpressionContext>> _consumerExpCtxs;
+
+    boost::intrusive_ptr<Exchange> _exchange;
+
+    bool _started = false;
+
+    // Everything below is shared with the consumer threads and guarded by '_mutex'.
+    stdx::mutex _mutex;
+    stdx::condition_variable _resultsChanged;
+
+    std::deque<Document> _results;
+    size_t _bytesInResults = 0;
+
+    // The number of consumer threads that have not yet finished producing output.
+    size_t _activeConsumers = 0;
+
+    // The first error encountered by any consumer thread.
+    Status _consumerError{Status::OK()};
+
+    bool _shuttingDown = false;
+
+    // The operations of running consumer threads, so that they can be interrupted on shutdown.
+    std::vector<OperationContext*> _consumerOpCtxs;
+
+    std::vector<stdx::thread> _threads;
+};
+
+}  // namespace mongo
@@ -0,0 +1,246 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_parallel_scan.h"
+
+#include <algorithm>
+
+#include "mongo/db/client.h"
+#include "mongo/db/service_context.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+constexpr StringData DocumentSourceParallelScan::kStageName;
+constexpr size_t DocumentSourceParallelScan::kMaxBufferedBytes;
+
+boost::intrusive_ptr<DocumentSourceParallelScan> DocumentSourceParallelScan::create(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> workers,
+    size_t nThreads) {
+    invariant(!workers.empty());
+    invariant(nThreads > 0);
+
+    std::vector<Value> serializedWorker = workers.front()->serialize();
+
+    for (auto&& worker : workers) {
+        invariant(worker->getContext() != expCtx);
+
+        // The workers are driven by pool threads, which attach them to their own operation
+        // contexts and dispose of them.
+        worker->detachFromOperationContext();
+        worker.get_deleter().dismissDisposal();
+    }
+
+    return new DocumentSourceParallelScan(
+        expCtx, std::move(workers), std::move(serializedWorker), nThreads);
+}
+
+DocumentSourceParallelScan::DocumentSourceParallelScan(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> workers,
+    std::vector<Value> serializedWorker,
+    size_t nThreads)
+    : DocumentSource(expCtx),
+      _workers(std::move(workers)),
+      _serializedWorker(std::move(serializedWorker)),
+      _nThreads(nThreads) {}
+
+DocumentSourceParallelScan::~DocumentSourceParallelScan() {
+    // Normally the pool is stopped by dispose(), but make sure that no worker outlives the state
+    // it refers to.
+    stopWorkers();
+}
+
+Value DocumentSourceParallelScan::serialize(
+    boost::optional<ExplainOptions::Verbosity> explain) const {
+    return Value(Document{{kStageName,
+                           Document{{"threads", static_cast<long long>(_nThreads)},
+                                    {"ranges", static_cast<long long>(_workers.size())},
+                                    {"pipeline", Value(_serializedWorker)}}}});
+}
+
+void DocumentSourceParallelScan::startWorkers() {
+    invariant(!_pool);
+
+    ThreadPool::Options options;
+    options.poolName = "parallel collection scan pool";
+    options.threadNamePrefix = "parallelScan-";
+    options.minThreads = 0;
+    options.maxThreads = _nThreads;
+    options.onCreateThread = [](const std::string& name) { Client::initThread(name); };
+    _pool = stdx::make_unique<ThreadPool>(options);
+    _pool->startup();
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _activeWorkers = _workers.size();
+    }
+
+    // Ranges are scheduled in order, so the collection is read roughly front to back.
+    for (size_t rangeId = 0; rangeId < _workers.size(); ++rangeId) {
+        invariant(_pool->schedule([this, rangeId] { runWorker(rangeId); }));
+    }
+}
+
+void DocumentSourceParallelScan::runWorker(size_t rangeId) {
+    auto worker = std::move(_workers[rangeId]);
+    auto opCtx = cc().makeOperationContext();
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_shuttingDown || !_workerError.isOK()) {
+            stdx::lock_guard<Client> clientLock(cc());
+            opCtx->getServiceContext()->killOperation(opCtx.get(), ErrorCodes::QueryPlanKilled);
+        }
+        _workerOpCtxs.push_back(opCtx.get());
+    }
+
+    worker->reattachToOperationContext(opCtx.get());
+
+    Status status = Status::OK();
+    try {
+        for (auto next = worker->getNext(); next; next = worker->getNext()) {
+            if (!pushResult(std::move(*next))) {
+                break;
+            }
+        }
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+    }
+
+    worker->dispose(opCtx.get());
+    worker.reset();
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _workerOpCtxs.erase(std::find(_workerOpCtxs.begin(), _workerOpCtxs.end(), opCtx.get()));
+
+    // Errors caused by interrupting the workers are of no interest to anybody.
+    if (!status.isOK() && _workerError.isOK() && !_shuttingDown) {
+        LOG(1) << "parallel collection scan of range " << rangeId << " failed: " << status;
+        _workerError = status;
+
+        // The query is going to fail, so there is no point in letting the other workers finish.
+        for (auto workerOpCtx : _workerOpCtxs) {
+            stdx::lock_guard<Client> clientLock(*workerOpCtx->getClient());
+            workerOpCtx->getServiceContext()->killOperation(workerOpCtx,
+                                                            ErrorCodes::QueryPlanKilled);
+        }
+    }
+    --_activeWorkers;
+    _resultsChanged.notify_all();
+}
+
+bool DocumentSourceParallelScan::pushResult(Document doc) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    _resultsChanged.wait(lk, [&] {
+        return _shuttingDown || !_workerError.isOK() || _bytesInResults < kMaxBufferedBytes;
+    });
+
+    if (_shuttingDown || !_workerError.isOK()) {
+        return false;
+    }
+
+    _bytesInResults += doc.getApproximateSize();
+    _results.push_back(std::move(doc));
+    _resultsChanged.notify_all();
+    return true;
+}
+
+DocumentSource::GetNextResult DocumentSourceParallelScan::getNext() {
+    pExpCtx->checkForInterrupt();
+
+    if (!_pool) {
+        startWorkers();
+    }
+
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    pExpCtx->opCtx->waitForConditionOrInterrupt(_resultsChanged, lk, [&] {
+        return !_results.empty() || _activeWorkers == 0 || !_workerError.isOK();
+    });
+
+    uassertStatusOKWithContext(_workerError, "parallel collection scan failed");
+
+    if (_results.empty()) {
+        invariant(_activeWorkers == 0);
+        return GetNextResult::makeEOF();
+    }
+
+    auto doc = std::move(_results.front());
+    _results.pop_front();
+    _bytesInResults -= doc.getApproximateSize();
+    _resultsChanged.notify_all();
+
+    return std::move(doc);
+}
+
+void DocumentSourceParallelScan::stopWorkers() {
+    if (!_pool) {
+        return;
+    }
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _shuttingDown = true;
+        _resultsChanged.notify_all();
+
+        // Interrupt workers which are busy scanning. Workers which have not started yet interrupt
+        // themselves.
+        for (auto opCtx : _workerOpCtxs) {
+            stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+            opCtx->getServiceContext()->killOperation(opCtx, ErrorCodes::QueryPlanKilled);
+        }
+    }
+
+    _pool->shutdown();
+    _pool->join();
+    _pool.reset();
+}
+
+void DocumentSourceParallelScan::doDispose() {
+    if (!_pool) {
+        // Execution never started, so the workers are still ours to dispose.
+        for (auto&& worker : _workers) {
+            if (worker) {
+                worker->reattachToOperationContext(pExpCtx->opCtx);
+                worker->dispose(pExpCtx->opCtx);
+                worker.reset();
+            }
+        }
+    }
+
+    stopWorkers();
+    _results.clear();
+    _bytesInResults = 0;
+}
+
+}  // namespace mongo
@@ -0,0 +1,167 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/pipeline/pipeline.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
+
+namespace mongo {
+
+/**
+ * Scans a collection on several threads at once. The collection is split into ranges of
+ * RecordIds, each of which is read by its own 'worker' pipeline: a DocumentSourceCursor over a
+ * collection scan of that range, followed by the stages which preceded a $group and a copy of the
+ * $group which outputs partial results. The workers are run on a pool of threads, each with its
+ * own Client and OperationContext, and this stage returns the union of their output. The $group
+ * which merges the partial results follows this stage in the pipeline.
+ *
+ * This stage is never parsed from user input; it is created by PipelineD when the
+ * internalQueryParallelCollectionScanThreads knob is set. Each worker reads in its own storage
+ * snapshot, so like a single-threaded scan which yields, the scan as a whole does not observe the
+ * collection at a single point in time.
+ */
+class DocumentSourceParallelScan final : public DocumentSource {
+public:
+    static constexpr StringData kStageName = "$_internalParallelScan"_sd;
+
+    // The maximum number of bytes of worker output buffered for the consumer of this stage.
+    static constexpr size_t kMaxBufferedBytes = 16 * 1024 * 1024;
+
+    /**
+     * Creates a stage which runs each of 'workers' to completion on a pool of 'nThreads'
+     * threads. The workers must each have their own ExpressionContext, and are detached from the
+     * current operation here; this stage disposes of them.
+     */
+    static boost::intrusive_ptr<DocumentSourceParallelScan> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> workers,
+        size_t nThreads);
+
+    ~DocumentSourceParallelScan();
+
+    GetNextResult getNext() final;
+
+    const char* getSourceName() const final {
+        return kStageName.rawData();
+    }
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kBlocking,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kNone,
+                                     DiskUseRequirement::kWritesTmpData,
+                                     FacetRequirement::kNotAllowed,
+                                     TransactionRequirement::kNotAllowed);
+
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+    DepsTracker::State getDependencies(DepsTracker* deps) const final {
+        return DepsTracker::State::EXHAUSTIVE_ALL;
+    }
+
+    size_t getThreads() const {
+        return _nThreads;
+    }
+
+    size_t getRanges() const {
+        return _workers.size();
+    }
+
+protected:
+    void doDispose() final;
+
+private:
+    DocumentSourceParallelScan(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                               std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> workers,
+                               std::vector<Value> serializedWorker,
+                               size_t nThreads);
+
+    /**
+     * Starts the thread pool and schedules every worker on it.
+     */
+    void startWorkers();
+
+    /**
+     * Runs the worker pipeline for the range with index 'rangeId' on a pool thread.
+     */
+    void runWorker(size_t rangeId);
+
+    /**
+     * Called by a worker to hand over a document. Blocks while the output buffer is full. Returns
+     * false if the worker should stop because this stage is shutting down or another worker
+     * failed.
+     */
+    bool pushResult(Document doc);
+
+    /**
+     * Interrupts all workers and waits for the thread pool to drain.
+     */
+    void stopWorkers();
+
+    // One pipeline per range. A worker's entry is reset by the thread that runs it.
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> _workers;
+
+    // The stages of the first worker pipeline, serialized before execution for explain output.
+    const std::vector<Value> _serializedWorker;
+
+    const size_t _nThreads;
+
+    std::unique_ptr<ThreadPool> _pool;
+
+    // Everything below is shared with the worker threads and guarded by '_mutex'.
+    stdx::mutex _mutex;
+    stdx::condition_variable _resultsChanged;
+
+    std::deque<Document> _results;
+    size_t _bytesInResults = 0;
+
+    // The number of workers that have not yet finished producing output.
+    size_t _activeWorkers = 0;
+
+    // The first error encountered by any worker.
+    Status _workerError{Status::OK()};
+
+    bool _shuttingDown = false;
+
+    // The operations of running workers, so that they can be interrupted.
+    std::vector<OperationContext*> _workerOpCtxs;
+};
+
+}  // namespace mongo
@@ -39,6 +39,7 @@
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/query/collation/collation_index_key.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/s/query/document_source_merge_cursors.h"
 
 namespace mongo {
@@ -126,10 +127,13 @@ DocumentSource::GetNextResult DocumentSourceSort::getNext() {
 void DocumentSourceSort::serializeToArray(
     std::vector<Value>& array, boost::optional<ExplainOptions::Verbosity> explain) const {
     if (explain) {  // always one Value for combined $sort + $limit
-        array.push_back(
-            Value(DOC(kStageName << DOC(
-                          "sortKey" << sortKeyPattern(SortKeySerialization::kForExplain) << "limit"
-                                    << (_limitSrc ? Value(_limitSrc->getLimit()) : Value())))));
+        MutableDocument inner(DOC(
+            "sortKey" << sortKeyPattern(SortKeySerialization::kForExplain) << "limit"
+                      << (_limitSrc ? Value(_limitSrc->getLimit()) : Value())));
+        if (*explain >= ExplainOptions::Verbosity::kExecStats && _sorterStats) {
+            inner["sorterStats"] = Value(_sorterStats->toBSON());
+        }
+        array.push_back(Value(DOC(kStageName << inner.freeze())));
     } else {  // one Value for $sort and maybe a Value for $limit
         MutableDocument inner(sortKeyPattern(SortKeySerialization::kForPipelineSerialization));
         array.push_back(Value(DOC(kStageName << inner.freeze())));
@@ -311,6 +315,7 @@ SortOptions DocumentSourceSort::makeSortOptions() const {
         opts.extSortAllowed = true;
         opts.tempDir = pExpCtx->tempDir;
     }
+    opts.NumThreads(internalDocumentSourceSortThreads.load());
 
     return opts;
 }
@@ -347,6 +352,7 @@ void DocumentSourceSort::loadingDone() {
     }
     _output.reset(_sorter->done());
     _usedDisk = _sorter->usedDisk() || _usedDisk;
+    _sorterStats = _sorter->stats();
     _sorter.reset();
     _populated = true;
 }
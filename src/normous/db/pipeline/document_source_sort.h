@@ -262,6 +262,8 @@ private:
     std::unique_ptr<MySorter> _sorter;
     std::unique_ptr<MySorter::Iterator> _output;
     bool _usedDisk = false;
+    // Kept after '_sorter' is released so that the merge phase can be reported by explain.
+    std::shared_ptr<const SorterStats> _sorterStats;
 };
 
 }  // namespace mongo
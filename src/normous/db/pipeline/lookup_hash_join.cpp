@@ -0,0 +1,333 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/lookup_hash_join.h"
+
+#include <algorithm>
+
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/extensions_callback_noop.h"
+#include "mongo/db/pipeline/document_path_support.h"
+#include "mongo/db/pipeline/document_source_lookup.h"
+#include "mongo/db/pipeline/pipeline.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+
+constexpr size_t LookupHashJoin::kNumPartitions;
+
+namespace {
+
+/**
+ * Appends the keys for the value 'elem' found at the first 'depth' components of 'path'.
+ */
+void appendKeysAtPath(const BSONElement& elem,
+                      const FieldPath& path,
+                      size_t depth,
+                      std::vector<Value>* keys) {
+    if (depth == path.getPathLength()) {
+        // An equality predicate matches a leaf array either as a whole or by any of its elements.
+        keys->push_back(Value(elem));
+        if (elem.type() == BSONType::Array) {
+            for (auto&& arrayElem : elem.Obj()) {
+                keys->push_back(Value(arrayElem));
+            }
+        }
+        return;
+    }
+
+    switch (elem.type()) {
+        case BSONType::Object: {
+            auto child = elem.Obj()[path.getFieldName(depth)];
+            if (child.eoo()) {
+                keys->push_back(Value(BSONNULL));
+            } else {
+                appendKeysAtPath(child, path, depth + 1, keys);
+            }
+            break;
+        }
+        case BSONType::Array: {
+            // Arrays along the path are traversed implicitly, but a numeric path component may
+            // also refer to a position within the array.
+            for (auto&& arrayElem : elem.Obj()) {
+                appendKeysAtPath(arrayElem, path, depth, keys);
+            }
+            auto positional = elem.Obj()[path.getFieldName(depth)];
+            if (!positional.eoo()) {
+                appendKeysAtPath(positional, path, depth + 1, keys);
+            }
+            keys->push_back(Value(BSONNULL));
+            break;
+        }
+        default:
+            // The rest of the path is missing.
+            keys->push_back(Value(BSONNULL));
+            break;
+    }
+}
+
+}  // namespace
+
+LookupHashJoin::LookupHashJoin(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                               FieldPath localField,
+                               FieldPath foreignField,
+                               BSONObj additionalFilter,
+                               size_t maxMemoryUsageBytes)
+    : _expCtx(expCtx),
+      _localField(std::move(localField)),
+      _foreignField(std::move(foreignField)),
+      _additionalFilter(additionalFilter.getOwned()),
+      _maxMemoryUsageBytes(maxMemoryUsageBytes),
+      _table(expCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>()) {}
+
+void LookupHashJoin::getForeignKeys(const BSONObj& foreignDoc,
+                                    const FieldPath& foreignField,
+                                    std::vector<Value>* keys) {
+    auto elem = foreignDoc[foreignField.getFieldName(0)];
+    if (elem.eoo()) {
+        keys->push_back(Value(BSONNULL));
+        return;
+    }
+    appendKeysAtPath(elem, foreignField, 1, keys);
+}
+
+bool LookupHashJoin::build(Pipeline* foreignPipeline) {
+    long long ordinal = 0;
+    while (auto next = foreignPipeline->getNext()) {
+        if (_spilled) {
+            writeToPartitions(ordinal++, next->toBson());
+            continue;
+        }
+
+        insert(next->toBson());
+        ++ordinal;
+
+        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+            if (!_expCtx->allowDiskUse || _expCtx->inMongos) {
+                return false;
+            }
+            spill();
+        }
+    }
+
+    for (auto&& writer : _partitionWriters) {
+        _partitions.emplace_back(writer ? writer->done() : nullptr);
+    }
+    _partitionWriters.clear();
+    return true;
+}
+
+void LookupHashJoin::insert(BSONObj foreignDoc) {
+    const size_t position = _foreignDocs.size();
+
+    std::vector<Value> keys;
+    getForeignKeys(foreignDoc, _foreignField, &keys);
+    for (auto&& key : keys) {
+        auto& positions = _table[key];
+        if (positions.empty()) {
+            _memoryUsageBytes += key.getApproximateSize();
+        }
+        if (positions.empty() || positions.back() != position) {
+            positions.push_back(position);
+            _memoryUsageBytes += sizeof(size_t);
+        }
+    }
+
+    _memoryUsageBytes += foreignDoc.objsize() + sizeof(BSONObj);
+    _foreignDocs.push_back(std::move(foreignDoc));
+}
+
+void LookupHashJoin::spill() {
+    _spilled = true;
+    _partitionWriters.resize(kNumPartitions);
+    for (size_t position = 0; position < _foreignDocs.size(); ++position) {
+        writeToPartitions(position, _foreignDocs[position]);
+    }
+    _foreignDocs.clear();
+    _table.clear();
+    _memoryUsageBytes = 0;
+}
+
+void LookupHashJoin::writeToPartitions(long long ordinal, const BSONObj& foreignDoc) {
+    std::vector<Value> keys;
+    getForeignKeys(foreignDoc, _foreignField, &keys);
+
+    // A document is written once to each partition that one of its keys hashes to.
+    std::vector<bool> written(kNumPartitions, false);
+    for (auto&& key : keys) {
+        const size_t partition = partitionFor(key);
+        if (written[partition]) {
+            continue;
+        }
+        written[partition] = true;
+
+        auto& writer = _partitionWriters[partition];
+        if (!writer) {
+            // Partitions are only created once they have data, since empty spill files can't be
+            // read.
+            writer = stdx::make_unique<SortedFileWriter<Value, BSONObj>>(
+                SortOptions().TempDir(_expCtx->tempDir));
+        }
+        writer->addAlreadySorted(Value(ordinal), foreignDoc);
+    }
+}
+
+size_t LookupHashJoin::partitionFor(const Value& key) const {
+    return _expCtx->getValueComparator().hash(key) % kNumPartitions;
+}
+
+std::vector<Value> LookupHashJoin::getLocalKeys(const Document& input) const {
+    std::vector<Value> keys;
+    document_path_support::visitAllValuesAtPath(
+        input, _localField, [&](const Value& nextValue) { keys.push_back(nextValue); });
+    if (keys.empty()) {
+        // Missing values are treated as null.
+        keys.push_back(Value(BSONNULL));
+    }
+    return keys;
+}
+
+std::vector<std::vector<Document>> LookupHashJoin::probe(const std::vector<Document>& inputs) {
+    auto candidates = _spilled ? probePartitions(inputs) : probeInMemory(inputs);
+
+    std::vector<std::vector<Document>> results;
+    results.reserve(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        results.push_back(filterCandidates(inputs[i], std::move(candidates[i])));
+    }
+    return results;
+}
+
+std::vector<std::vector<LookupHashJoin::Candidate>> LookupHashJoin::probeInMemory(
+    const std::vector<Document>& inputs) {
+    std::vector<std::vector<Candidate>> candidates(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        for (auto&& key : getLocalKeys(inputs[i])) {
+            auto it = _table.find(key);
+            if (it == _table.end()) {
+                continue;
+            }
+            for (auto&& position : it->second) {
+                candidates[i].push_back(
+                    {static_cast<long long>(position), _foreignDocs[position]});
+            }
+        }
+    }
+    return candidates;
+}
+
+std::vector<std::vector<LookupHashJoin::Candidate>> LookupHashJoin::probePartitions(
+    const std::vector<Document>& inputs) {
+    // Hash the keys of the whole batch, noting which partitions they can be found in.
+    auto inputsByKey = _expCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>();
+    std::vector<bool> needed(kNumPartitions, false);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        for (auto&& key : getLocalKeys(inputs[i])) {
+            auto& positions = inputsByKey[key];
+            if (positions.empty() || positions.back() != i) {
+                positions.push_back(i);
+            }
+            needed[partitionFor(key)] = true;
+        }
+    }
+
+    std::vector<std::vector<Candidate>> candidates(inputs.size());
+    std::vector<Value> keys;
+    for (size_t partition = 0; partition < kNumPartitions; ++partition) {
+        if (!needed[partition] || !_partitions[partition]) {
+            continue;
+        }
+
+        // A spilled partition can only be iterated once, so it is copied to a new file as it is
+        // read for any later batches.
+        SortedFileWriter<Value, BSONObj> rewritten(SortOptions().TempDir(_expCtx->tempDir));
+        while (_partitions[partition]->more()) {
+            auto next = _partitions[partition]->next();
+            rewritten.addAlreadySorted(next.first, next.second);
+
+            // The document read from the file is only valid until the next read.
+            BSONObj owned;
+            keys.clear();
+            getForeignKeys(next.second, _foreignField, &keys);
+            for (auto&& key : keys) {
+                if (partitionFor(key) != partition) {
+                    continue;
+                }
+                auto it = inputsByKey.find(key);
+                if (it == inputsByKey.end()) {
+                    continue;
+                }
+                if (!owned.isOwned()) {
+                    owned = next.second.getOwned();
+                }
+                for (auto&& i : it->second) {
+                    candidates[i].push_back({next.first.getLong(), owned});
+                }
+            }
+        }
+        _partitions[partition].reset(rewritten.done());
+    }
+    return candidates;
+}
+
+std::vector<Document> LookupHashJoin::filterCandidates(const Document& input,
+                                                       std::vector<Candidate> candidates) const {
+    std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.ordinal < rhs.ordinal;
+    });
+    candidates.erase(std::unique(candidates.begin(),
+                                 candidates.end(),
+                                 [](const auto& lhs, const auto& rhs) {
+                                     return lhs.ordinal == rhs.ordinal;
+                                 }),
+                     candidates.end());
+
+    // The query is parsed even when there are no candidates, so that inputs which cannot be
+    // joined fail in the same way as with the nested loop strategy.
+    auto matchStage = DocumentSourceLookUp::makeMatchStageFromInput(
+        input, _localField, _foreignField.fullPath(), _additionalFilter);
+    auto matcher = uassertStatusOK(MatchExpressionParser::parse(matchStage["$match"].Obj(),
+                                                                _expCtx,
+                                                                ExtensionsCallbackNoop(),
+                                                                Pipeline::kAllowedMatcherFeatures));
+
+    std::vector<Document> results;
+    for (auto&& candidate : candidates) {
+        if (matcher->matchesBSON(candidate.doc)) {
+            results.emplace_back(candidate.doc);
+        }
+    }
+    return results;
+}
+
+}  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -0,0 +1,156 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <memory>
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/field_path.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/sorter/sorter.h"
+
+namespace mongo {
+
+class Pipeline;
+
+/**
+ * Joins documents against a foreign collection on equality of 'localField' and 'foreignField', for
+ * a $lookup specified with the {localField: ..., foreignField: ...} syntax. Rather than querying
+ * the foreign collection once per input document, the foreign documents are read once into a hash
+ * table keyed on the values of 'foreignField', which each input document then probes.
+ *
+ * Keys are hashed and compared using the collation of the ExpressionContext. The keys stored for a
+ * foreign document are a superset of the values an equality predicate on 'foreignField' can match
+ * it with, and every candidate found in the table is checked against the same query the nested
+ * loop strategy would have run, so both strategies return the same documents in the same order.
+ *
+ * If the foreign documents exceed the memory budget and disk use is allowed, they are spilled to a
+ * set of files partitioned by key hash. Inputs are then probed in batches, reading only the
+ * partitions which hold a key of some input in the batch.
+ */
+class LookupHashJoin {
+public:
+    LookupHashJoin(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                   FieldPath localField,
+                   FieldPath foreignField,
+                   BSONObj additionalFilter,
+                   size_t maxMemoryUsageBytes);
+
+    /**
+     * Reads every document from 'foreignPipeline' into the hash table. Returns false if the
+     * documents exceeded the memory budget while disk use is not allowed, in which case this join
+     * cannot be used.
+     */
+    bool build(Pipeline* foreignPipeline);
+
+    /**
+     * Returns, for each document in 'inputs', the foreign documents it joins with.
+     */
+    std::vector<std::vector<Document>> probe(const std::vector<Document>& inputs);
+
+    /**
+     * The approximate number of bytes of input documents which should be probed together. Only
+     * spilled joins benefit from probing more than one input at a time.
+     */
+    size_t probeBatchSizeBytes() const {
+        return _spilled ? _maxMemoryUsageBytes : 0;
+    }
+
+    bool usedDisk() const {
+        return _spilled;
+    }
+
+    /**
+     * Appends to 'keys' the values under which 'foreignDoc' must be found when probing for
+     * matches on 'foreignField'. Values an equality predicate on 'foreignField' can match are
+     * included, along with null when the path is missing from some branch of the document.
+     */
+    static void getForeignKeys(const BSONObj& foreignDoc,
+                               const FieldPath& foreignField,
+                               std::vector<Value>* keys);
+
+private:
+    using Partition = SortIteratorInterface<Value, BSONObj>;
+
+    // A foreign document which may join with an input document, along with its position in the
+    // foreign pipeline's output.
+    struct Candidate {
+        long long ordinal;
+        BSONObj doc;
+    };
+
+    /**
+     * Returns the values of 'localField' in 'input', as used by the nested loop strategy.
+     */
+    std::vector<Value> getLocalKeys(const Document& input) const;
+
+    /**
+     * Checks each of 'candidates' against the query the nested loop strategy would have run for
+     * 'input', returning the matches in the order they were read from the foreign pipeline.
+     */
+    std::vector<Document> filterCandidates(const Document& input,
+                                           std::vector<Candidate> candidates) const;
+
+    size_t partitionFor(const Value& key) const;
+
+    void insert(BSONObj foreignDoc);
+    void spill();
+    void writeToPartitions(long long ordinal, const BSONObj& foreignDoc);
+
+    std::vector<std::vector<Candidate>> probeInMemory(const std::vector<Document>& inputs);
+    std::vector<std::vector<Candidate>> probePartitions(const std::vector<Document>& inputs);
+
+    static constexpr size_t kNumPartitions = 32;
+
+    boost::intrusive_ptr<ExpressionContext> _expCtx;
+    const FieldPath _localField;
+    const FieldPath _foreignField;
+    const BSONObj _additionalFilter;
+    const size_t _maxMemoryUsageBytes;
+
+    size_t _memoryUsageBytes = 0;
+    bool _spilled = false;
+
+    // Foreign documents in the order they were read, while the join is held in memory.
+    std::vector<BSONObj> _foreignDocs;
+    // Maps each foreign key to the positions in '_foreignDocs' of the documents stored under it.
+    ValueUnorderedMap<std::vector<size_t>> _table;
+
+    // Once spilled, the foreign documents stored under the keys which hash to each partition, or
+    // null for partitions which are empty. Partitions are rewritten each time they are read.
+    std::vector<std::unique_ptr<SortedFileWriter<Value, BSONObj>>> _partitionWriters;
+    std::vector<std::unique_ptr<Partition>> _partitions;
+};
+
+}  // namespace mongo
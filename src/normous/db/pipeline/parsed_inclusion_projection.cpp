@@ -345,12 +345,30 @@ void ParsedInclusionProjection::parse(const BSONObj& spec) {
     uassert(16403,
             str::stream() << "$project requires at least one output field: " << spec.toString(),
             atLeastOneFieldInOutput);
+
+    if (_root->isSimpleInclusion()) {
+        _simpleExec.emplace(_root->getIncludedFields(), true);
+    }
 }
 
 Document ParsedInclusionProjection::applyProjection(const Document& inputDoc) const {
+    MutableDocument output;
+    if (_simpleExec) {
+        // There is nothing to compute or recurse into, so just test each top-level field name
+        // against the precompiled projection.
+        auto it = inputDoc.fieldIterator();
+        while (it.more()) {
+            auto fieldPair = it.next();
+            if (_simpleExec->keepsField(fieldPair.first)) {
+                output.addField(fieldPair.first, fieldPair.second);
+            }
+        }
+        output.copyMetaDataFrom(inputDoc);
+        return output.freeze();
+    }
+
     // All expressions will be evaluated in the context of the input document, before any
     // transformations have been applied.
-    MutableDocument output;
     _root->applyInclusions(inputDoc, &output);
     _root->addComputedFields(&output, inputDoc);
 
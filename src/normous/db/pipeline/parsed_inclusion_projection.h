@@ -28,8 +28,10 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 
+#include "mongo/db/exec/simple_projection_exec.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/parsed_aggregation_projection.h"
@@ -122,6 +124,21 @@ public:
         return _pathToNode;
     }
 
+    /**
+     * Returns true if this node only includes fields at its own level, with no computed fields and
+     * no nested inclusions.
+     */
+    bool isSimpleInclusion() const {
+        return _expressions.empty() && _children.empty();
+    }
+
+    /**
+     * Returns the names of the fields included at this node's level.
+     */
+    std::vector<std::string> getIncludedFields() const {
+        return {_inclusions.begin(), _inclusions.end()};
+    }
+
     /**
      * Recursively add all paths that are preserved by this inclusion projection.
      */
@@ -286,6 +303,10 @@ private:
 
     // The InclusionNode tree does most of the execution work once constructed.
     std::unique_ptr<InclusionNode> _root;
+
+    // Set if the projection only includes top-level fields, in which case it is applied without
+    // walking the InclusionNode tree.
+    boost::optional<SimpleProjectionExec> _simpleExec;
 };
 }  // namespace parsed_aggregation_projection
 }  // namespace mongo
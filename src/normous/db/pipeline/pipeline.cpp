@@ -41,13 +41,16 @@
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_geo_near.h"
+#include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_out.h"
+#include "mongo/db/pipeline/document_source_parallel_group.h"
 #include "mongo/db/pipeline/document_source_project.h"
 #include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -272,6 +275,8 @@ void Pipeline::optimizePipeline() {
             }
         }
         _sources.swap(optimizedSources);
+
+        parallelizeGroup();
     } catch (DBException& ex) {
         ex.addContext("Failed to optimize pipeline");
         throw;
@@ -279,6 +284,35 @@ void Pipeline::optimizePipeline() {
     stitch();
 }
 
+void Pipeline::parallelizeGroup() {
+    const int nConsumers = internalQueryParallelGroupConsumers.load();
+    if (nConsumers < 2 || _splitState != SplitState::kUnsplit) {
+        return;
+    }
+
+    // Look for a $group preceded only by stages that can be moved into the producer pipeline.
+    auto groupItr = std::find_if(_sources.begin(), _sources.end(), [](const auto& source) {
+        return !DocumentSourceParallelGroup::canRunInProducer(*source);
+    });
+    if (groupItr == _sources.end()) {
+        return;
+    }
+
+    auto group = dynamic_cast<DocumentSourceGroup*>(groupItr->get());
+    if (!group) {
+        return;
+    }
+
+    auto parallelGroup = DocumentSourceParallelGroup::create(
+        pCtx, SourceContainer(_sources.begin(), groupItr), group, nConsumers);
+    if (!parallelGroup) {
+        return;
+    }
+
+    _sources.erase(_sources.begin(), std::next(groupItr));
+    _sources.push_front(std::move(parallelGroup));
+}
+
 bool Pipeline::aggSupportsWriteConcern(const BSONObj& cmd) {
     auto pipelineElement = cmd["pipeline"];
     if (pipelineElement.type() != BSONType::Array) {
@@ -388,6 +388,13 @@ private:
      */
     void validateCommon() const;
 
+    /**
+     * If enabled by internalQueryParallelGroupConsumers, replaces the first $group of the pipeline
+     * together with the stages preceding it with a DocumentSourceParallelGroup, which computes the
+     * $group on several threads by hash-partitioning its input on the group key.
+     */
+    void parallelizeGroup();
+
     /**
      * Returns Status::OK if the pipeline can run on mongoS, or an error with a message explaining
      * why it cannot.
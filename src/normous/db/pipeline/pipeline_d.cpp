@@ -40,6 +40,7 @@
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/db_raii.h"
+#include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/multi_iterator.h"
 #include "mongo/db/exec/shard_filter.h"
@@ -56,14 +57,19 @@
 #include "mongo/db/pipeline/document_source_geo_near_cursor.h"
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_match.h"
+#include "mongo/db/pipeline/document_source_parallel_group.h"
+#include "mongo/db/pipeline/document_source_parallel_scan.h"
 #include "mongo/db/pipeline/document_source_sample.h"
 #include "mongo/db/pipeline/document_source_sample_from_random_cursor.h"
 #include "mongo/db/pipeline/document_source_single_document_transformation.h"
 #include "mongo/db/pipeline/document_source_sort.h"
+#include "mongo/db/pipeline/mongo_process_interface.h"
+#include "mongo/db/pipeline/parallel_aggregation.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/s/sharding_state.h"
@@ -138,6 +144,85 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> createRandomCursorEx
         opCtx, std::move(ws), std::move(stage), collection, PlanExecutor::YIELD_AUTO);
 }
 
+/**
+ * Canonicalizes the filter of a parallel collection scan, using the collation of 'expCtx'.
+ */
+std::unique_ptr<CanonicalQuery> canonicalizeParallelScanQuery(
+    OperationContext* opCtx,
+    const NamespaceString& nss,
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    const BSONObj& queryObj) {
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(queryObj);
+    qr->setCollation(expCtx->getCollator() ? expCtx->getCollator()->getSpec().toBSON()
+                                           : expCtx->collation);
+
+    const ExtensionsCallbackReal extensionsCallback(opCtx, &nss);
+    return uassertStatusOK(CanonicalQuery::canonicalize(
+        opCtx, std::move(qr), expCtx, extensionsCallback, Pipeline::kAllowedMatcherFeatures));
+}
+
+/**
+ * Returns true if every plan the query planner can produce for 'cq' is a plain collection scan,
+ * meaning that no index can help answer it.
+ */
+bool queryRequiresCollectionScan(OperationContext* opCtx,
+                                 Collection* collection,
+                                 CanonicalQuery* cq) {
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(opCtx, collection, cq, &plannerParams);
+
+    auto solutions = QueryPlanner::plan(*cq, plannerParams);
+    if (!solutions.isOK() || solutions.getValue().empty()) {
+        return false;
+    }
+
+    return std::all_of(
+        solutions.getValue().begin(), solutions.getValue().end(), [](const auto& solution) {
+            return solution->root->getType() == STAGE_COLLSCAN;
+        });
+}
+
+/**
+ * Chooses up to 'nRanges' - 1 RecordIds which split 'collection' into ranges of roughly equal
+ * size, by sampling it with a random cursor. Returns the split points in increasing order, or an
+ * empty vector if the storage engine cannot sample the collection.
+ */
+std::vector<RecordId> chooseParallelScanSplitPoints(OperationContext* opCtx,
+                                                    Collection* collection,
+                                                    size_t nRanges) {
+    const size_t kSamplesPerRange = 10;
+
+    auto randomCursor = collection->getRecordStore()->getRandomCursor(opCtx);
+    if (!randomCursor) {
+        return {};
+    }
+
+    std::vector<RecordId> samples;
+    for (size_t i = 0; i < nRanges * kSamplesPerRange; ++i) {
+        auto record = randomCursor->next();
+        if (!record) {
+            break;
+        }
+        samples.push_back(record->id);
+    }
+
+    std::sort(samples.begin(), samples.end());
+    samples.erase(std::unique(samples.begin(), samples.end()), samples.end());
+    if (samples.empty()) {
+        return {};
+    }
+
+    std::vector<RecordId> splitPoints;
+    for (size_t i = 1; i < nRanges; ++i) {
+        const auto& splitPoint = samples[i * samples.size() / nRanges];
+        if (splitPoints.empty() || splitPoints.back() < splitPoint) {
+            splitPoints.push_back(splitPoint);
+        }
+    }
+    return splitPoints;
+}
+
 StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExecutor(
     OperationContext* opCtx,
     Collection* collection,
@@ -273,6 +358,16 @@ void PipelineD::prepareCursorSource(Collection* collection,
     // We will be modifying the source vector as we go.
     Pipeline::SourceContainer& sources = pipeline->_sources;
 
+    // A parallel $group reads its input through its own producer pipeline, so that is where the
+    // cursor belongs.
+    if (!sources.empty()) {
+        if (auto parallelGroup =
+                dynamic_cast<DocumentSourceParallelGroup*>(sources.front().get())) {
+            prepareCursorSource(collection, nss, aggRequest, parallelGroup->getProducerPipeline());
+            return;
+        }
+    }
+
     if (!sources.empty() && !sources.front()->constraints().requiresInputDocSource) {
         return;
     }
@@ -280,6 +375,10 @@ void PipelineD::prepareCursorSource(Collection* collection,
     // We are going to generate an input cursor, so we need to be holding the collection lock.
     dassert(expCtx->opCtx->lockState()->isCollectionLockedForMode(nss.ns(), MODE_IS));
 
+    if (collection && prepareParallelScanCursorSource(collection, nss, aggRequest, pipeline)) {
+        return;
+    }
+
     if (!sources.empty()) {
         auto sampleStage = dynamic_cast<DocumentSourceSample*>(sources.front().get());
         // Optimize an initial $sample stage if possible.
@@ -354,6 +453,127 @@ getSortAndGroupStagesFromPipeline(const Pipeline::SourceContainer& sources) {
 
 }  // namespace
 
+bool PipelineD::prepareParallelScanCursorSource(Collection* collection,
+                                                const NamespaceString& nss,
+                                                const AggregationRequest* aggRequest,
+                                                Pipeline* pipeline) {
+    // Each thread reads several ranges, so that threads which finish early can pick up the slack.
+    const size_t kRangesPerThread = 4;
+
+    const int nThreads = internalQueryParallelCollectionScanThreads.load();
+    auto expCtx = pipeline->getContext();
+    auto opCtx = expCtx->opCtx;
+    if (nThreads < 2 || !canRunAggregationInParallel(expCtx) ||
+        (aggRequest && !aggRequest->getHint().isEmpty())) {
+        return false;
+    }
+
+    // Capped collections and the oplog have their own scanning rules, and sharded collections
+    // would need every range to be filtered by the shard's metadata.
+    if (collection->isCapped() || nss.isOplog() ||
+        ShardingState::get(opCtx)->needCollectionMetadata(opCtx, nss.ns()) ||
+        collection->getRecordStore()->numRecords(opCtx) <
+            internalQueryParallelCollectionScanMinRecords.load()) {
+        return false;
+    }
+
+    // Look for a $group preceded only by stages which transform documents one at a time.
+    Pipeline::SourceContainer& sources = pipeline->_sources;
+    auto groupItr = std::find_if(sources.begin(), sources.end(), [](const auto& source) {
+        return !DocumentSourceParallelGroup::canRunInProducer(*source);
+    });
+    if (groupItr == sources.end()) {
+        return false;
+    }
+
+    auto group = dynamic_cast<DocumentSourceGroup*>(groupItr->get());
+    if (!group || group->doingMerge() || group->rewriteGroupAsTransformOnFirstDocument()) {
+        return false;
+    }
+
+    // Only scans which could not have used an index are worth splitting.
+    const BSONObj queryObj = pipeline->getInitialQuery();
+    if (!queryObj.isEmpty()) {
+        auto cq = canonicalizeParallelScanQuery(opCtx, nss, expCtx, queryObj);
+        if (!queryRequiresCollectionScan(opCtx, collection, cq.get())) {
+            return false;
+        }
+    }
+
+    // Probe the storage engine for support of scans which start in the middle of a collection.
+    const auto splitPoints =
+        chooseParallelScanSplitPoints(opCtx, collection, nThreads * kRangesPerThread);
+    if (splitPoints.empty() || !collection->getCursor(opCtx)->seekAtOrAfter(splitPoints.front())) {
+        return false;
+    }
+
+    // Every worker runs a copy of the stages up to and including the $group, rebuilt from their
+    // serialized form against its own ExpressionContext. The worker's $group outputs partial
+    // results, which are combined by the merging $group.
+    std::vector<Value> serializedStages;
+    for (auto itr = sources.begin(); itr != std::next(groupItr); ++itr) {
+        (*itr)->serializeToArray(serializedStages);
+    }
+
+    std::vector<BSONObj> rawStages;
+    for (auto&& stage : serializedStages) {
+        rawStages.push_back(stage.getDocument().toBson());
+    }
+
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> workers;
+    for (size_t rangeId = 0; rangeId <= splitPoints.size(); ++rangeId) {
+        auto workerExpCtx = expCtx->copyWith(nss, expCtx->uuid);
+        workerExpCtx->needsMerge = true;
+        workerExpCtx->mongoProcessInterface = MongoProcessInterface::create(opCtx);
+        auto worker = uassertStatusOK(Pipeline::parse(rawStages, workerExpCtx));
+
+        // The initial $match is absorbed by the collection scan.
+        if (!queryObj.isEmpty()) {
+            invariant(dynamic_cast<DocumentSourceMatch*>(worker->_sources.front().get()));
+            worker->_sources.pop_front();
+        }
+
+        auto cq = canonicalizeParallelScanQuery(opCtx, nss, workerExpCtx, queryObj);
+
+        CollectionScanParams params;
+        params.collection = collection;
+        params.direction = CollectionScanParams::FORWARD;
+        if (rangeId > 0) {
+            params.minRecord = splitPoints[rangeId - 1];
+        }
+        if (rangeId < splitPoints.size()) {
+            params.maxRecord = splitPoints[rangeId];
+        }
+
+        auto ws = stdx::make_unique<WorkingSet>();
+        auto root = stdx::make_unique<CollectionScan>(
+            opCtx, params, ws.get(), queryObj.isEmpty() ? nullptr : cq->root());
+        auto exec = uassertStatusOK(PlanExecutor::make(opCtx,
+                                                       std::move(ws),
+                                                       std::move(root),
+                                                       std::move(cq),
+                                                       collection,
+                                                       PlanExecutor::YIELD_AUTO));
+
+        auto deps = worker->getDependencies(DepsTracker::MetadataAvailable::kNoMetadata);
+        addCursorSource(worker.get(),
+                        DocumentSourceCursor::create(collection, std::move(exec), workerExpCtx),
+                        deps,
+                        queryObj);
+        workers.push_back(std::move(worker));
+    }
+
+    LOG(1) << "splitting the collection scan of " << nss << " into " << workers.size()
+           << " ranges over " << nThreads << " threads";
+
+    auto mergingGroup = group->mergingLogic().mergingStage;
+    sources.erase(sources.begin(), std::next(groupItr));
+    pipeline->addInitialSource(std::move(mergingGroup));
+    pipeline->addInitialSource(
+        DocumentSourceParallelScan::create(expCtx, std::move(workers), nThreads));
+    return true;
+}
+
 void PipelineD::prepareGenericCursorSource(Collection* collection,
                                            const NamespaceString& nss,
                                            const AggregationRequest* aggRequest,
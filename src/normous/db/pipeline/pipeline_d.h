@@ -105,6 +105,19 @@ public:
 private:
     PipelineD();  // does not exist:  prevent instantiation
 
+    /**
+     * If enabled by internalQueryParallelCollectionScanThreads, and 'pipeline' is a $group over a
+     * collection scan of 'collection' preceded only by stages which transform documents one at a
+     * time, splits the scan into RecordId ranges which are read and partially grouped on several
+     * threads. The stages up to and including the $group are replaced by a
+     * DocumentSourceParallelScan and the $group which merges its output. Returns false, leaving
+     * 'pipeline' unchanged, if the pipeline, the operation or the collection is not eligible.
+     */
+    static bool prepareParallelScanCursorSource(Collection* collection,
+                                                const NamespaceString& nss,
+                                                const AggregationRequest* aggRequest,
+                                                Pipeline* pipeline);
+
     /**
      * Creates a PlanExecutor to be used in the initial cursor source. If the query system can use
      * an index to provide a more efficient sort or projection, the sort and/or projection will be
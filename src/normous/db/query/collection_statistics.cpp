@@ -0,0 +1,469 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/collection_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+#include "mongo/bson/bsonelement_comparator.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/bson/dotted_path_support.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace dps = ::mongo::dotted_path_support;
+
+constexpr StringData CollectionStatistics::kStatisticsCollectionName;
+
+namespace {
+
+const BSONElementComparator kValueComparator(BSONElementComparator::FieldNamesMode::kIgnore,
+                                             nullptr);
+
+/**
+ * The finalizer of MurmurHash3, used to spread the bits of the BSON hash over the whole word
+ * before they are split into a register index and a run of leading zeros.
+ */
+uint64_t mixBits(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+bool isValueLess(const BSONObj& lhs, const BSONObj& rhs) {
+    return kValueComparator.evaluate(lhs.firstElement() < rhs.firstElement());
+}
+
+bool isAllValues(const Interval& interval) {
+    const auto isMinMax = [](const BSONElement& low, const BSONElement& high) {
+        return low.type() == BSONType::MinKey && high.type() == BSONType::MaxKey;
+    };
+    return isMinMax(interval.start, interval.end) || isMinMax(interval.end, interval.start);
+}
+
+Status parseNumberArray(const BSONObj& obj, StringData fieldName, std::vector<double>* out) {
+    BSONElement elt = obj[fieldName];
+    if (elt.type() != BSONType::Array) {
+        return Status(ErrorCodes::FailedToParse,
+                      str::stream() << "field statistics '" << fieldName << "' must be an array");
+    }
+    for (auto&& value : elt.Obj()) {
+        if (!value.isNumber()) {
+            return Status(ErrorCodes::FailedToParse,
+                          str::stream() << "field statistics '" << fieldName
+                                        << "' must only contain numbers");
+        }
+        out->push_back(value.numberDouble());
+    }
+    return Status::OK();
+}
+
+}  // namespace
+
+DistinctCountSketch::DistinctCountSketch() : _registers(kNumRegisters, 0) {}
+
+void DistinctCountSketch::add(const BSONElement& value) {
+    const uint64_t hash = mixBits(kValueComparator.hash(value));
+    const size_t index = hash >> (64 - kPrecision);
+
+    // The position of the first set bit among the remaining bits, counting from one.
+    uint8_t rank = 1;
+    for (uint64_t rest = hash << kPrecision; rank <= 64 - kPrecision && !(rest >> 63);
+         rest <<= 1) {
+        ++rank;
+    }
+    _registers[index] = std::max(_registers[index], rank);
+}
+
+void DistinctCountSketch::merge(const DistinctCountSketch& other) {
+    for (size_t i = 0; i < kNumRegisters; ++i) {
+        _registers[i] = std::max(_registers[i], other._registers[i]);
+    }
+}
+
+double DistinctCountSketch::estimate() const {
+    const double m = kNumRegisters;
+    double sum = 0;
+    size_t numZeros = 0;
+    for (auto reg : _registers) {
+        sum += std::ldexp(1.0, -reg);
+        numZeros += (reg == 0);
+    }
+
+    const double alpha = 0.7213 / (1 + 1.079 / m);
+    const double raw = alpha * m * m / sum;
+
+    // Small cardinalities are estimated far more accurately by counting the empty registers.
+    if (raw <= 2.5 * m && numZeros > 0) {
+        return m * std::log(m / numZeros);
+    }
+    return raw;
+}
+
+FieldStatistics::Builder::Builder(std::string path) : _path(std::move(path)) {}
+
+void FieldStatistics::Builder::addDocument(const BSONObj& doc) {
+    if (_hasArrays) {
+        return;
+    }
+
+    BSONElementSet elements;
+    std::set<size_t> arrayComponents;
+    dps::extractAllElementsAlongPath(doc, _path, elements, false, &arrayComponents);
+    if (!arrayComponents.empty() || elements.size() > 1 ||
+        (elements.size() == 1 && elements.begin()->type() == BSONType::Array)) {
+        // The histogram would no longer count documents, so there is no point in collecting
+        // further values.
+        _hasArrays = true;
+        _values.clear();
+        return;
+    }
+
+    BSONObjBuilder bob;
+    if (elements.empty()) {
+        bob.appendNull("");
+    } else {
+        bob.appendAs(*elements.begin(), "");
+    }
+    _values.push_back(bob.obj());
+    _sketch.add(_values.back().firstElement());
+}
+
+FieldStatistics FieldStatistics::Builder::done(long long numRecords, size_t numBuckets) {
+    invariant(numBuckets > 0);
+
+    FieldStatistics stats;
+    stats._hasArrays = _hasArrays;
+    stats._numSampled = _values.size();
+
+    std::sort(_values.begin(), _values.end(), isValueLess);
+
+    const double depth = std::ceil(static_cast<double>(_values.size()) / numBuckets);
+    BSONArrayBuilder bounds;
+    double rangeCount = 0;
+    double rangeDistinct = 0;
+    double numSingletons = 0;
+    for (size_t i = 0; i < _values.size();) {
+        size_t end = i + 1;
+        while (end < _values.size() && !isValueLess(_values[i], _values[end])) {
+            ++end;
+        }
+
+        const double count = end - i;
+        if (count == 1) {
+            ++numSingletons;
+        }
+
+        if (stats._boundCounts.empty() || end == _values.size() || rangeCount + count >= depth) {
+            bounds.append(_values[i].firstElement());
+            stats._boundCounts.push_back(count);
+            stats._rangeCounts.push_back(rangeCount);
+            stats._rangeDistincts.push_back(rangeDistinct);
+            rangeCount = 0;
+            rangeDistinct = 0;
+        } else {
+            rangeCount += count;
+            ++rangeDistinct;
+        }
+        i = end;
+    }
+    stats._bounds = bounds.obj();
+
+    // The sketch only saw the sample. Scale its count up to the whole collection with the
+    // Haas-Stokes 'Duj1' estimator, which assumes that values seen once in the sample are the
+    // ones likely to have unseen neighbours.
+    const double sampled = _values.size();
+    const double sampleDistinct = _sketch.estimate();
+    stats._numDistinct = sampleDistinct;
+    if (sampled > 0 && numRecords > sampled) {
+        const double denominator = sampled - numSingletons + numSingletons * sampled / numRecords;
+        if (denominator > 0) {
+            stats._numDistinct = std::min<double>(
+                numRecords, std::max(sampleDistinct, sampled * sampleDistinct / denominator));
+        }
+    }
+
+    stats.init();
+    _values.clear();
+    return stats;
+}
+
+void FieldStatistics::init() {
+    _boundValues.clear();
+    _cumulativeCounts.clear();
+
+    double cumulative = 0;
+    size_t i = 0;
+    for (auto&& bound : _bounds) {
+        _boundValues.push_back(bound);
+        _cumulativeCounts.push_back(cumulative);
+        cumulative += _rangeCounts[i] + _boundCounts[i];
+        ++i;
+    }
+}
+
+StatusWith<FieldStatistics> FieldStatistics::parse(const BSONObj& obj) {
+    FieldStatistics stats;
+
+    BSONElement numSampled = obj["numSampled"];
+    BSONElement numDistinct = obj["numDistinct"];
+    if (!numSampled.isNumber() || !numDistinct.isNumber()) {
+        return Status(ErrorCodes::FailedToParse,
+                      "field statistics must have numeric 'numSampled' and 'numDistinct'");
+    }
+    stats._numSampled = numSampled.safeNumberLong();
+    stats._numDistinct = numDistinct.numberDouble();
+    stats._hasArrays = obj["hasArrays"].trueValue();
+
+    BSONElement bounds = obj["bounds"];
+    if (bounds.type() != BSONType::Array) {
+        return Status(ErrorCodes::FailedToParse, "field statistics 'bounds' must be an array");
+    }
+    stats._bounds = bounds.Obj().getOwned();
+
+    for (auto&& field : {std::make_pair("boundCounts"_sd, &stats._boundCounts),
+                         std::make_pair("rangeCounts"_sd, &stats._rangeCounts),
+                         std::make_pair("rangeDistincts"_sd, &stats._rangeDistincts)}) {
+        Status status = parseNumberArray(obj, field.first, field.second);
+        if (!status.isOK()) {
+            return status;
+        }
+        if (field.second->size() != static_cast<size_t>(stats._bounds.nFields())) {
+            return Status(ErrorCodes::FailedToParse,
+                          str::stream() << "field statistics '" << field.first
+                                        << "' must have one entry per bound");
+        }
+    }
+
+    stats.init();
+    return {std::move(stats)};
+}
+
+BSONObj FieldStatistics::toBSON() const {
+    BSONObjBuilder bob;
+    bob.append("numSampled", _numSampled);
+    bob.append("numDistinct", _numDistinct);
+    bob.append("hasArrays", _hasArrays);
+    bob.appendArray("bounds", _bounds);
+    bob.append("boundCounts", _boundCounts);
+    bob.append("rangeCounts", _rangeCounts);
+    bob.append("rangeDistincts", _rangeDistincts);
+    return bob.obj();
+}
+
+size_t FieldStatistics::findBucket(const BSONElement& value) const {
+    return std::lower_bound(_boundValues.begin(),
+                            _boundValues.end(),
+                            value,
+                            [](const BSONElement& bound, const BSONElement& val) {
+                                return bound.woCompare(val, 0) < 0;
+                            }) -
+        _boundValues.begin();
+}
+
+double FieldStatistics::estimateFractionBelow(const BSONElement& value, bool inclusive) const {
+    const size_t bucket = findBucket(value);
+    if (bucket == _boundValues.size()) {
+        return 1.0;
+    }
+
+    double below = _cumulativeCounts[bucket];
+    if (value.woCompare(_boundValues[bucket], 0) == 0) {
+        below += _rangeCounts[bucket] + (inclusive ? _boundCounts[bucket] : 0);
+    } else {
+        // Nothing is known about where the value lies within the bucket.
+        below += _rangeCounts[bucket] / 2;
+    }
+    return below / _numSampled;
+}
+
+double FieldStatistics::estimatePointFraction(const BSONElement& value) const {
+    const size_t bucket = findBucket(value);
+    if (bucket < _boundValues.size()) {
+        if (value.woCompare(_boundValues[bucket], 0) == 0) {
+            return _boundCounts[bucket] / _numSampled;
+        }
+        if (_rangeCounts[bucket] > 0) {
+            return _rangeCounts[bucket] / std::max(1.0, _rangeDistincts[bucket]) / _numSampled;
+        }
+    }
+
+    // The sample never saw this value, so it is at most as common as the rarest value.
+    return 1.0 / std::max({_numDistinct, static_cast<double>(_numSampled), 1.0});
+}
+
+boost::optional<double> FieldStatistics::estimateFraction(const OrderedIntervalList& oil) const {
+    if (_hasArrays || _boundValues.empty()) {
+        return boost::none;
+    }
+
+    double fraction = 0;
+    for (auto&& interval : oil.intervals) {
+        if (interval.isPoint()) {
+            fraction += estimatePointFraction(interval.start);
+            continue;
+        }
+
+        BSONElement low = interval.start;
+        BSONElement high = interval.end;
+        bool lowInclusive = interval.startInclusive;
+        bool highInclusive = interval.endInclusive;
+        if (low.woCompare(high, 0) > 0) {
+            std::swap(low, high);
+            std::swap(lowInclusive, highInclusive);
+        }
+        fraction += std::max(0.0,
+                             estimateFractionBelow(high, highInclusive) -
+                                 estimateFractionBelow(low, !lowInclusive));
+    }
+    return std::min(fraction, 1.0);
+}
+
+StatusWith<CollectionStatistics> CollectionStatistics::parse(const BSONObj& obj) {
+    BSONElement numRecords = obj["numRecords"];
+    if (!numRecords.isNumber()) {
+        return Status(ErrorCodes::FailedToParse,
+                      "collection statistics must have a numeric 'numRecords'");
+    }
+    CollectionStatistics stats(numRecords.safeNumberLong());
+
+    BSONElement fields = obj["fields"];
+    if (fields.type() != BSONType::Array) {
+        return Status(ErrorCodes::FailedToParse, "collection statistics 'fields' must be an array");
+    }
+    for (auto&& field : fields.Obj()) {
+        if (field.type() != BSONType::Object || field.Obj()["path"].type() != BSONType::String) {
+            return Status(ErrorCodes::FailedToParse,
+                          "collection statistics 'fields' must be objects with a 'path' string");
+        }
+        auto fieldStats = FieldStatistics::parse(field.Obj());
+        if (!fieldStats.isOK()) {
+            return fieldStats.getStatus();
+        }
+        stats.setField(field.Obj()["path"].str(), std::move(fieldStats.getValue()));
+    }
+    return {std::move(stats)};
+}
+
+BSONObj CollectionStatistics::toBSON(StringData collName) const {
+    BSONObjBuilder bob;
+    bob.append("_id", collName);
+    bob.append("numRecords", _numRecords);
+
+    // Field paths may be dotted, so they are stored as values rather than field names.
+    BSONArrayBuilder fields(bob.subarrayStart("fields"));
+    for (auto&& field : _fields) {
+        BSONObjBuilder fieldBob(fields.subobjStart());
+        fieldBob.append("path", field.first);
+        fieldBob.appendElements(field.second.toBSON());
+    }
+    fields.doneFast();
+    return bob.obj();
+}
+
+const FieldStatistics* CollectionStatistics::getField(StringData path) const {
+    auto it = _fields.find(path.toString());
+    return it == _fields.end() ? nullptr : &it->second;
+}
+
+boost::optional<double> CollectionStatistics::estimateScanFraction(
+    const QuerySolutionNode* node) const {
+    switch (node->getType()) {
+        case STAGE_COLLSCAN:
+            return 1.0;
+        case STAGE_IXSCAN:
+            return estimateIndexScanFraction(static_cast<const IndexScanNode*>(node));
+        default:
+            break;
+    }
+
+    if (node->children.empty()) {
+        return boost::none;
+    }
+
+    // Every scan beneath an intersection or union runs to completion, so their costs add up.
+    double fraction = 0;
+    for (auto&& child : node->children) {
+        auto childFraction = estimateScanFraction(child);
+        if (!childFraction) {
+            return boost::none;
+        }
+        fraction += *childFraction;
+    }
+    return fraction;
+}
+
+boost::optional<double> CollectionStatistics::estimateIndexScanFraction(
+    const IndexScanNode* node) const {
+    const IndexEntry& index = node->index;
+    if (index.type != INDEX_BTREE || index.multikey || index.collator ||
+        node->bounds.isSimpleRange) {
+        return boost::none;
+    }
+
+    // Bounds over a field only narrow the scan while the bounds over every field before it are
+    // points.
+    double fraction = 1.0;
+    for (size_t i = 0; i < node->bounds.fields.size(); ++i) {
+        const OrderedIntervalList& oil = node->bounds.fields[i];
+        if (oil.intervals.size() == 1 && isAllValues(oil.intervals.front())) {
+            break;
+        }
+
+        const FieldStatistics* field = getField(oil.name);
+        auto estimate = field ? field->estimateFraction(oil) : boost::none;
+        if (!estimate) {
+            if (i == 0) {
+                return boost::none;
+            }
+            break;
+        }
+        fraction *= *estimate;
+
+        const bool allPoints =
+            std::all_of(oil.intervals.begin(), oil.intervals.end(), [](const Interval& interval) {
+                return interval.isPoint();
+            });
+        if (!allPoints) {
+            break;
+        }
+    }
+    return fraction;
+}
+
+}  // namespace mongo
@@ -0,0 +1,217 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+struct IndexScanNode;
+struct OrderedIntervalList;
+struct QuerySolutionNode;
+
+/**
+ * A HyperLogLog sketch estimating the number of distinct values added to it, using a fixed
+ * kNumRegisters bytes of memory regardless of how many values are seen. Values which compare
+ * equal under the simple BSON comparison, such as 1 and 1.0, are counted once.
+ */
+class DistinctCountSketch {
+public:
+    static const int kPrecision = 10;
+    static const size_t kNumRegisters = 1 << kPrecision;
+
+    DistinctCountSketch();
+
+    void add(const BSONElement& value);
+
+    /**
+     * Folds the values seen by 'other' into this sketch.
+     */
+    void merge(const DistinctCountSketch& other);
+
+    double estimate() const;
+
+private:
+    std::vector<uint8_t> _registers;
+};
+
+/**
+ * Statistics describing the values of a single field, as gathered by the 'analyze' command.
+ *
+ * The values are summarized by an equi-depth histogram: each bucket covers roughly the same
+ * number of sampled values and is described by its (inclusive) upper bound, the number of
+ * sampled values equal to that bound, and the number of values and distinct values lying strictly
+ * between the previous bound and this one. The first bound is always the smallest value seen.
+ * Documents missing the field are counted as null, matching their index keys.
+ *
+ * Fields found to hold arrays have no histogram, since a document then produces several index
+ * keys and the counts no longer estimate the number of documents.
+ */
+class FieldStatistics {
+public:
+    static const size_t kDefaultNumBuckets = 100;
+
+    /**
+     * Accumulates the values of one field over a set of documents.
+     */
+    class Builder {
+    public:
+        explicit Builder(std::string path);
+
+        void addDocument(const BSONObj& doc);
+
+        FieldStatistics done(long long numRecords, size_t numBuckets);
+
+    private:
+        std::string _path;
+        std::vector<BSONObj> _values;
+        DistinctCountSketch _sketch;
+        bool _hasArrays = false;
+    };
+
+    FieldStatistics() = default;
+
+    static StatusWith<FieldStatistics> parse(const BSONObj& obj);
+
+    BSONObj toBSON() const;
+
+    /**
+     * Returns the estimated fraction of the collection whose value for this field falls within
+     * 'oil', or boost::none if there is no histogram to estimate from.
+     */
+    boost::optional<double> estimateFraction(const OrderedIntervalList& oil) const;
+
+    double estimatePointFraction(const BSONElement& value) const;
+
+    /**
+     * Returns the estimated fraction of values which are less than 'value', or also equal to it
+     * when 'inclusive' is true.
+     */
+    double estimateFractionBelow(const BSONElement& value, bool inclusive) const;
+
+    double getNumDistinct() const {
+        return _numDistinct;
+    }
+
+    long long getNumSampled() const {
+        return _numSampled;
+    }
+
+    bool hasArrays() const {
+        return _hasArrays;
+    }
+
+    size_t numBuckets() const {
+        return _boundValues.size();
+    }
+
+private:
+    /**
+     * Sets up '_boundValues' and '_cumulativeCounts' from '_bounds' and the bucket counts.
+     */
+    void init();
+
+    size_t findBucket(const BSONElement& value) const;
+
+    long long _numSampled = 0;
+    double _numDistinct = 0;
+    bool _hasArrays = false;
+
+    // The upper bound of each bucket, stored as the elements of an array.
+    BSONObj _bounds;
+    std::vector<BSONElement> _boundValues;
+
+    std::vector<double> _boundCounts;
+    std::vector<double> _rangeCounts;
+    std::vector<double> _rangeDistincts;
+
+    // The number of sampled values lying in the buckets before each bucket.
+    std::vector<double> _cumulativeCounts;
+};
+
+/**
+ * The statistics gathered for a collection by the 'analyze' command. These are persisted in the
+ * database's 'system.statistics' collection, keyed by collection name, and installed in the
+ * collection's CollectionInfoCache for use by the query planner.
+ */
+class CollectionStatistics {
+public:
+    static constexpr StringData kStatisticsCollectionName = "system.statistics"_sd;
+
+    CollectionStatistics() = default;
+    explicit CollectionStatistics(long long numRecords) : _numRecords(numRecords) {}
+
+    static StatusWith<CollectionStatistics> parse(const BSONObj& obj);
+
+    /**
+     * Serializes these statistics as a document of the statistics collection, with _id
+     * 'collName'.
+     */
+    BSONObj toBSON(StringData collName) const;
+
+    void setField(const std::string& path, FieldStatistics stats) {
+        _fields[path] = std::move(stats);
+    }
+
+    /**
+     * Returns the statistics for 'path', or nullptr if it was not analyzed.
+     */
+    const FieldStatistics* getField(StringData path) const;
+
+    long long getNumRecords() const {
+        return _numRecords;
+    }
+
+    const std::map<std::string, FieldStatistics>& getFields() const {
+        return _fields;
+    }
+
+    /**
+     * Estimates the number of index keys and documents the plan rooted at 'node' examines, as a
+     * fraction of the number of documents in the collection. Returns boost::none if the plan
+     * contains a leaf whose cost cannot be estimated from these statistics.
+     */
+    boost::optional<double> estimateScanFraction(const QuerySolutionNode* node) const;
+
+private:
+    boost::optional<double> estimateIndexScanFraction(const IndexScanNode* node) const;
+
+    long long _numRecords = 0;
+    std::map<std::string, FieldStatistics> _fields;
+};
+
+}  // namespace mongo
@@ -0,0 +1,262 @@
+/**
+ *    Copyright (C) 2018 MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/query/collection_statistics.cpp
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/json.h"
+#include "mongo/db/query/collection_statistics.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/db/query/index_bounds_builder.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const size_t kNumBuckets = FieldStatistics::kDefaultNumBuckets;
+
+FieldStatistics buildStatistics(StringData path,
+                                const std::vector<BSONObj>& docs,
+                                long long numRecords = 0) {
+    FieldStatistics::Builder builder(path.toString());
+    for (auto&& doc : docs) {
+        builder.addDocument(doc);
+    }
+    return builder.done(numRecords ? numRecords : docs.size(), kNumBuckets);
+}
+
+/**
+ * Returns 'numValues' documents {a: <i mod numDistinct>}.
+ */
+std::vector<BSONObj> makeDocs(int numValues, int numDistinct) {
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < numValues; ++i) {
+        docs.push_back(BSON("a" << i % numDistinct));
+    }
+    return docs;
+}
+
+OrderedIntervalList makeOil(const std::string& name, std::vector<Interval> intervals) {
+    OrderedIntervalList oil(name);
+    oil.intervals = std::move(intervals);
+    return oil;
+}
+
+Interval point(int value) {
+    return IndexBoundsBuilder::makePointInterval(BSON("" << value));
+}
+
+Interval range(int low, int high) {
+    return Interval(BSON("" << low << "" << high), true, false);
+}
+
+TEST(DistinctCountSketchTest, EstimatesDistinctValues) {
+    DistinctCountSketch sketch;
+    for (int i = 0; i < 100000; ++i) {
+        sketch.add(BSON("" << i % 20000).firstElement());
+    }
+    ASSERT_APPROX_EQUAL(20000.0, sketch.estimate(), 20000 * 0.1);
+}
+
+TEST(DistinctCountSketchTest, SmallCountsAreAccurate) {
+    DistinctCountSketch sketch;
+    ASSERT_EQ(0.0, sketch.estimate());
+    for (int i = 0; i < 10; ++i) {
+        sketch.add(BSON("" << i).firstElement());
+        sketch.add(BSON("" << static_cast<double>(i)).firstElement());
+        sketch.add(BSON("" << std::to_string(i)).firstElement());
+    }
+    ASSERT_APPROX_EQUAL(20.0, sketch.estimate(), 2.0);
+}
+
+TEST(DistinctCountSketchTest, MergeCountsTheUnion) {
+    DistinctCountSketch left;
+    DistinctCountSketch right;
+    for (int i = 0; i < 5000; ++i) {
+        left.add(BSON("" << i).firstElement());
+        right.add(BSON("" << i + 2500).firstElement());
+    }
+    left.merge(right);
+    ASSERT_APPROX_EQUAL(7500.0, left.estimate(), 7500 * 0.1);
+}
+
+TEST(FieldStatisticsTest, UniformRangeAndPointEstimates) {
+    auto stats = buildStatistics("a", makeDocs(10000, 1000));
+    ASSERT_EQ(10000, stats.getNumSampled());
+    ASSERT_LTE(stats.numBuckets(), kNumBuckets + 1);
+    ASSERT_APPROX_EQUAL(1000.0, stats.getNumDistinct(), 100.0);
+
+    ASSERT_APPROX_EQUAL(0.1, *stats.estimateFraction(makeOil("a", {range(100, 200)})), 0.02);
+    ASSERT_APPROX_EQUAL(0.5, *stats.estimateFraction(makeOil("a", {range(0, 500)})), 0.02);
+    ASSERT_APPROX_EQUAL(0.001, *stats.estimateFraction(makeOil("a", {point(500)})), 0.001);
+    ASSERT_APPROX_EQUAL(
+        0.002, *stats.estimateFraction(makeOil("a", {point(500), point(700)})), 0.002);
+
+    // A descending interval covers the same values as its ascending counterpart.
+    ASSERT_APPROX_EQUAL(0.1,
+                        *stats.estimateFraction(
+                            makeOil("a", {Interval(BSON("" << 200 << "" << 100), false, true)})),
+                        0.02);
+}
+
+TEST(FieldStatisticsTest, ValuesOutsideTheHistogram) {
+    auto stats = buildStatistics("a", makeDocs(1000, 100));
+    ASSERT_EQ(0.0, stats.estimateFractionBelow(BSON("" << -1).firstElement(), true));
+    ASSERT_EQ(0.0, stats.estimateFractionBelow(BSON("" << MINKEY).firstElement(), true));
+    ASSERT_EQ(1.0, stats.estimateFractionBelow(BSON("" << MAXKEY).firstElement(), true));
+    ASSERT_EQ(1.0, stats.estimateFractionBelow(BSON("" << "string").firstElement(), true));
+    ASSERT_EQ(1.0, *stats.estimateFraction(makeOil("a", {IndexBoundsBuilder::allValues()})));
+    ASSERT_LTE(*stats.estimateFraction(makeOil("a", {point(1000)})), 0.01);
+}
+
+TEST(FieldStatisticsTest, FrequentValuesBecomeBounds) {
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 10000; ++i) {
+        docs.push_back(BSON("a" << (i % 2 ? 0 : i)));
+    }
+    auto stats = buildStatistics("a", docs);
+    ASSERT_APPROX_EQUAL(0.5, stats.estimatePointFraction(BSON("" << 0).firstElement()), 0.001);
+    ASSERT_LTE(stats.estimatePointFraction(BSON("" << 4).firstElement()), 0.01);
+}
+
+TEST(FieldStatisticsTest, MissingFieldsCountAsNull) {
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 1000; ++i) {
+        docs.push_back(i % 4 ? BSON("a" << BSON("b" << i)) : BSON("c" << i));
+    }
+    auto stats = buildStatistics("a.b", docs);
+    ASSERT_APPROX_EQUAL(
+        0.25, stats.estimatePointFraction(BSON("" << BSONNULL).firstElement()), 0.001);
+}
+
+TEST(FieldStatisticsTest, ArraysPreventEstimates) {
+    auto docs = makeDocs(1000, 10);
+    docs.push_back(BSON("a" << BSON_ARRAY(1 << 2)));
+    auto stats = buildStatistics("a", docs);
+    ASSERT(stats.hasArrays());
+    ASSERT_FALSE(stats.estimateFraction(makeOil("a", {point(1)})));
+
+    auto nested = buildStatistics("a.b", {BSON("a" << BSON_ARRAY(BSON("b" << 1)))});
+    ASSERT(nested.hasArrays());
+}
+
+TEST(FieldStatisticsTest, SampledDistinctCountIsScaledToTheCollection) {
+    // Every sampled value is unique, so the collection probably holds many more.
+    auto stats = buildStatistics("a", makeDocs(1000, 1000), 100000);
+    ASSERT_GT(stats.getNumDistinct(), 10000.0);
+
+    // Every value is seen many times, so the sample has probably seen them all.
+    stats = buildStatistics("a", makeDocs(1000, 10), 100000);
+    ASSERT_APPROX_EQUAL(10.0, stats.getNumDistinct(), 1.0);
+}
+
+TEST(CollectionStatisticsTest, RoundTripsThroughBSON) {
+    CollectionStatistics stats(5000);
+    stats.setField("a", buildStatistics("a", makeDocs(5000, 50)));
+    stats.setField("b.c", buildStatistics("b.c", {BSON("b" << BSON("c" << "x"))}));
+
+    BSONObj doc = stats.toBSON("coll");
+    ASSERT_EQ("coll", doc["_id"].str());
+
+    auto parsed = CollectionStatistics::parse(doc);
+    ASSERT_OK(parsed.getStatus());
+    ASSERT_EQ(5000, parsed.getValue().getNumRecords());
+    ASSERT_BSONOBJ_EQ(doc, parsed.getValue().toBSON("coll"));
+
+    const FieldStatistics* field = parsed.getValue().getField("a");
+    ASSERT(field);
+    ASSERT_EQ(stats.getField("a")->estimatePointFraction(BSON("" << 7).firstElement()),
+              field->estimatePointFraction(BSON("" << 7).firstElement()));
+    ASSERT(parsed.getValue().getField("b.c"));
+    ASSERT_FALSE(parsed.getValue().getField("b"));
+}
+
+TEST(CollectionStatisticsTest, ParseRejectsMalformedDocuments) {
+    ASSERT_NOT_OK(CollectionStatistics::parse(fromjson("{fields: []}")).getStatus());
+    ASSERT_NOT_OK(
+        CollectionStatistics::parse(fromjson("{numRecords: 1, fields: [1]}")).getStatus());
+    ASSERT_NOT_OK(CollectionStatistics::parse(
+                      fromjson("{numRecords: 1, fields: [{path: 'a', numSampled: 1, numDistinct: "
+                               "1, bounds: [1, 2], boundCounts: [1], rangeCounts: [0, 0], "
+                               "rangeDistincts: [0, 0]}]}"))
+                      .getStatus());
+}
+
+TEST(CollectionStatisticsTest, EstimatesScanFractionOfSolutions) {
+    CollectionStatistics stats(10000);
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 10000; ++i) {
+        docs.push_back(BSON("a" << i % 100 << "b" << i % 1000));
+    }
+    stats.setField("a", buildStatistics("a", docs));
+    stats.setField("b", buildStatistics("b", docs));
+
+    CollectionScanNode collscan;
+    ASSERT_EQ(1.0, *stats.estimateScanFraction(&collscan));
+
+    // The bounds over 'b' narrow the scan, since the bounds over 'a' are a point.
+    IndexScanNode ixscan(IndexEntry(BSON("a" << 1 << "b" << 1), "a_1_b_1"));
+    ixscan.bounds.fields.push_back(makeOil("a", {point(5)}));
+    ixscan.bounds.fields.push_back(makeOil("b", {range(0, 500)}));
+    ASSERT_APPROX_EQUAL(0.005, *stats.estimateScanFraction(&ixscan), 0.002);
+
+    // They no longer do once the bounds over 'a' are a range.
+    ixscan.bounds.fields[0] = makeOil("a", {range(0, 50)});
+    ASSERT_APPROX_EQUAL(0.5, *stats.estimateScanFraction(&ixscan), 0.05);
+
+    // The scans beneath a FETCH or an OR are added up.
+    auto fetch = stdx::make_unique<FetchNode>();
+    auto first = new IndexScanNode(IndexEntry(BSON("a" << 1), "a_1"));
+    first->bounds.fields.push_back(makeOil("a", {range(0, 10)}));
+    auto second = new IndexScanNode(IndexEntry(BSON("b" << 1), "b_1"));
+    second->bounds.fields.push_back(makeOil("b", {range(0, 100)}));
+    auto orNode = new OrNode();
+    orNode->children.push_back(first);
+    orNode->children.push_back(second);
+    fetch->children.push_back(orNode);
+    ASSERT_APPROX_EQUAL(0.2, *stats.estimateScanFraction(fetch.get()), 0.03);
+
+    // Nothing is known about 'c'.
+    IndexScanNode unknown(IndexEntry(BSON("c" << 1), "c_1"));
+    unknown.bounds.fields.push_back(makeOil("c", {point(1)}));
+    ASSERT_FALSE(stats.estimateScanFraction(&unknown));
+
+    // Multikey indexes produce several keys per document.
+    IndexEntry multikeyEntry(BSON("a" << 1), "a_1");
+    multikeyEntry.multikey = true;
+    IndexScanNode multikey(multikeyEntry);
+    multikey.bounds.fields.push_back(makeOil("a", {point(1)}));
+    ASSERT_FALSE(stats.estimateScanFraction(&multikey));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -353,6 +353,20 @@ void Explain::statsToBSON(const PlanStageStats& stats,
                 bob->appendNumber(string(stream() << "failedAnd_" << i), spec->failedAnd[i]);
             }
         }
+    } else if (STAGE_AND_BITMAP == stats.stageType || STAGE_OR_BITMAP == stats.stageType) {
+        BitmapMergeStats* spec = static_cast<BitmapMergeStats*>(stats.specific.get());
+
+        if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
+            bob->appendNumber("memUsage", spec->memUsage);
+            bob->appendNumber("memLimit", spec->memLimit);
+            bob->appendNumber("containers", spec->containers);
+            bob->appendNumber("bitsetContainers", spec->bitsetContainers);
+
+            for (size_t i = 0; i < spec->bitmapAfterChild.size(); ++i) {
+                bob->appendNumber(string(stream() << "bitmapAfterChild_" << i),
+                                  spec->bitmapAfterChild[i]);
+            }
+        }
     } else if (STAGE_COLLSCAN == stats.stageType) {
         CollectionScanStats* spec = static_cast<CollectionScanStats*>(stats.specific.get());
         bob->append("direction", spec->direction > 0 ? "forward" : "backward");
@@ -58,6 +58,7 @@
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/ops/update_lifecycle.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/collection_statistics.h"
 #include "mongo/db/query/collation/collator_factory_interface.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/index_bounds_builder.h"
@@ -212,8 +213,14 @@ void fillOutPlannerParams(OperationContext* opCtx,
         plannerParams->options |= QueryPlannerParams::GENERATE_COVERED_IXSCANS;
     }
 
+    if (internalQueryPlannerGenerateSkipScans.load()) {
+        plannerParams->options |= QueryPlannerParams::GENERATE_SKIP_SCANS;
+    }
+
     plannerParams->options |= QueryPlannerParams::SPLIT_LIMITED_SORT;
 
+    plannerParams->collectionStats = collection->infoCache()->getCollectionStatistics();
+
     if (shouldWaitForOplogVisibility(
             opCtx, collection, canonicalQuery->getQueryRequest().isTailable())) {
         plannerParams->options |= QueryPlannerParams::OPLOG_SCAN_WAIT_FOR_VISIBLE;
@@ -341,8 +348,9 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
             }
 
             // Stuff the right data into the params depending on what proj impl we use.
-            if (canonicalQuery->getProj()->requiresDocument() ||
-                canonicalQuery->getProj()->wantIndexKey() ||
+            const bool simpleDoc = !canonicalQuery->getProj()->requiresDocument() ||
+                canonicalQuery->getProj()->isSimpleExclusion();
+            if (!simpleDoc || canonicalQuery->getProj()->wantIndexKey() ||
                 canonicalQuery->getProj()->wantSortKey() ||
                 canonicalQuery->getProj()->hasDottedFieldPath()) {
                 params.fullExpression = canonicalQuery->root();
@@ -381,6 +389,13 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
 
             if (statusWithQs.isOK()) {
                 auto querySolution = std::move(statusWithQs.getValue());
+
+                boost::optional<double> estimatedScanFraction;
+                if (plannerParams.collectionStats) {
+                    estimatedScanFraction = plannerParams.collectionStats->estimateScanFraction(
+                        querySolution->root.get());
+                }
+
                 if ((plannerParams.options & QueryPlannerParams::IS_COUNT) &&
                     turnIxscanIntoCount(querySolution.get())) {
                     LOG(2) << "Using fast count: " << redact(canonicalQuery->toStringShort());
@@ -400,7 +415,9 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
                                                     canonicalQuery.get(),
                                                     plannerParams,
                                                     cs->decisionWorks,
-                                                    rawRoot);
+                                                    rawRoot,
+                                                    estimatedScanFraction,
+                                                    cs->cheapestEstimatedScanFraction);
                 return PrepareExecutionResult(
                     std::move(canonicalQuery), std::move(querySolution), std::move(root));
             }
@@ -466,7 +483,8 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
             std::move(canonicalQuery), std::move(solutions[0]), std::move(root));
     } else {
         // Many solutions. Create a MultiPlanStage to pick the best, update the cache,
-        // and so on. The working set will be shared by all candidate plans.
+        // and so on. The working set will be shared by all candidate plans, unless their trial
+        // periods run concurrently.
         auto multiPlanStage = make_unique<MultiPlanStage>(opCtx, collection, canonicalQuery.get());
 
         for (size_t ix = 0; ix < solutions.size(); ++ix) {
@@ -474,13 +492,13 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
                 solutions[ix]->cacheData->indexFilterApplied = plannerParams.indexFiltersApplied;
             }
 
-            // version of StageBuild::build when WorkingSet is shared
+            WorkingSet* candidateWs = multiPlanStage->getCandidateWorkingSet(ws);
             PlanStage* nextPlanRoot;
             verify(StageBuilder::build(
-                opCtx, collection, *canonicalQuery, *solutions[ix], ws, &nextPlanRoot));
+                opCtx, collection, *canonicalQuery, *solutions[ix], candidateWs, &nextPlanRoot));
 
             // Takes ownership of 'nextPlanRoot'.
-            multiPlanStage->addPlan(std::move(solutions[ix]), nextPlanRoot, ws);
+            multiPlanStage->addPlan(std::move(solutions[ix]), nextPlanRoot, candidateWs);
         }
 
         root = std::move(multiPlanStage);
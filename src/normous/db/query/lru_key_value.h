@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <functional>
 #include <list>
 #include <memory>
 
@@ -51,12 +52,12 @@ namespace mongo {
  * The add(), get(), and remove() operations are all O(1).
  *
  * The keys of generic type K map to values of type V*. The V*
- * pointers are owned by the kv-store.
+ * pointers are owned by the kv-store. Keys are hashed with 'KeyHasher'.
  *
  * TODO: We could move this into the util/ directory and do any cleanup necessary to make it
  * fully general.
  */
-template <class K, class V>
+template <class K, class V, class KeyHasher = std::hash<K>>
 class LRUKeyValue {
 public:
     LRUKeyValue(size_t maxSize) : _maxSize(maxSize), _currentSize(0){};
@@ -71,7 +72,7 @@ public:
     typedef typename KVList::iterator KVListIt;
     typedef typename KVList::const_iterator KVListConstIt;
 
-    typedef stdx::unordered_map<K, KVListIt> KVMap;
+    typedef stdx::unordered_map<K, KVListIt, KeyHasher> KVMap;
     typedef typename KVMap::const_iterator KVMapConstIt;
 
     /**
@@ -143,11 +144,9 @@ public:
         V* foundEntry = found->second;
 
         // Promote the kv-store entry to the front of the list.
-        // It is now the most recently used.
-        _kvMap.erase(i);
-        _kvList.erase(found);
-        _kvList.push_front(std::make_pair(key, foundEntry));
-        _kvMap[key] = _kvList.begin();
+        // It is now the most recently used. Splicing keeps 'found'
+        // valid, so the map entry does not need to be rewritten.
+        _kvList.splice(_kvList.begin(), _kvList, found);
 
         *entryOut = foundEntry;
         return Status::OK();
@@ -122,6 +122,15 @@ public:
         return _hasDottedFieldPath;
     }
 
+    /**
+     * Returns true if the projection only excludes top-level fields (e.g. {a: 0, b: 0}), and so
+     * can be applied to a document without a ProjectionExec.
+     */
+    bool isSimpleExclusion() const {
+        return !_isInclusionProjection && _metaFields.empty() && _arrayFields.empty() &&
+            !_hasDottedFieldPath;
+    }
+
 private:
     /**
      * Must go through ::make
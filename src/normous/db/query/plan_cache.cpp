@@ -45,6 +45,7 @@
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
 #include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/collection_statistics.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_solution.h"
@@ -52,6 +53,7 @@
 #include "mongo/util/hex.h"
 #include "mongo/util/log.h"
 #include "mongo/util/transitional_tools_do_not_use/vector_spooling.h"
+#include <third_party/murmurhash3/MurmurHash3.h>
 
 namespace mongo {
 namespace {
@@ -443,7 +445,8 @@ CachedSolution::CachedSolution(const PlanCacheKey& key, const PlanCacheEntry& en
       sort(entry.sort.getOwned()),
       projection(entry.projection.getOwned()),
       collation(entry.collation.getOwned()),
-      decisionWorks(entry.works) {
+      decisionWorks(entry.works),
+      cheapestEstimatedScanFraction(entry.cheapestEstimatedScanFraction) {
     // CachedSolution should not having any references into
     // cache entry. All relevant data should be cloned/copied.
     for (size_t i = 0; i < entry.plannerData.size(); ++i) {
@@ -506,6 +509,7 @@ PlanCacheEntry* PlanCacheEntry::clone() const {
     entry->timeOfCreation = timeOfCreation;
     entry->isActive = isActive;
     entry->works = works;
+    entry->cheapestEstimatedScanFraction = cheapestEstimatedScanFraction;
 
     // Copy performance stats.
     entry->feedback = feedback;
@@ -612,6 +616,10 @@ std::string SolutionCacheData::toString() const {
                                  << "tree=" << this->tree->toString() << ")";
         case COLLSCAN_SOLN:
             return "(collection scan)";
+        case SKIP_SCAN_SOLN:
+            verify(this->tree.get());
+            return str::stream() << "(skip scan solution: "
+                                 << "tree=" << this->tree->toString() << ")";
         case USE_INDEX_TAGS_SOLN:
             verify(this->tree.get());
             return str::stream() << "(index-tagged expression tree: "
@@ -624,14 +632,52 @@ std::string SolutionCacheData::toString() const {
 // PlanCache
 //
 
-PlanCache::PlanCache() : PlanCache(internalQueryCacheSize.load()) {}
+BSONObj PlanCache::PartitionStats::toBSON() const {
+    return BSON("entries" << static_cast<long long>(entries) << "hits" << hits << "misses"
+                          << misses
+                          << "evictions"
+                          << evictions);
+}
 
-PlanCache::PlanCache(size_t size) : _cache(size) {}
+PlanCache::PartitionStats PlanCache::Partition::stats() const {
+    PartitionStats partitionStats;
+    partitionStats.entries = cache.size();
+    partitionStats.hits = hits;
+    partitionStats.misses = misses;
+    partitionStats.evictions = evictions;
+    return partitionStats;
+}
 
-PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize.load()), _ns(ns) {}
+PlanCache::PlanCache()
+    : PlanCache(internalQueryCacheSize.load(), internalQueryCachePartitions.load()) {}
+
+PlanCache::PlanCache(size_t size, size_t numPartitions) {
+    // Never create more partitions than entries, so that every partition can hold at least one.
+    numPartitions = std::max(std::min(numPartitions, size), size_t(1));
+    const size_t partitionSize = (size + numPartitions - 1) / numPartitions;
+    for (size_t i = 0; i < numPartitions; ++i) {
+        _partitions.push_back(stdx::make_unique<Partition>(partitionSize));
+    }
+}
+
+PlanCache::PlanCache(const std::string& ns) : PlanCache() {
+    _ns = ns;
+}
 
 PlanCache::~PlanCache() {}
 
+PlanCache::HashedKey PlanCache::hashKey(PlanCacheKey key) {
+    std::uint64_t hash[2];
+    MurmurHash3_x64_128(key.data(), key.size(), 0, hash);
+    return {std::move(key), hash[0]};
+}
+
+PlanCache::Partition& PlanCache::partitionFor(const HashedKey& key) const {
+    // Use the high half of the hash to pick the partition, leaving the low half, which the
+    // partition's hash table buckets on, independent of the choice.
+    return *_partitions[(key.hash >> 32) % _partitions.size()];
+}
+
 std::unique_ptr<CachedSolution> PlanCache::getCacheEntryIfActive(const PlanCacheKey& key) const {
 
     PlanCache::GetResult res = get(key);
@@ -858,7 +904,8 @@ Status PlanCache::set(const CanonicalQuery& query,
                       const std::vector<QuerySolution*>& solns,
                       std::unique_ptr<PlanRankingDecision> why,
                       Date_t now,
-                      boost::optional<double> worksGrowthCoefficient) {
+                      boost::optional<double> worksGrowthCoefficient,
+                      const CollectionStatistics* collectionStats) {
     invariant(why);
 
     if (solns.empty()) {
@@ -878,23 +925,24 @@ Status PlanCache::set(const CanonicalQuery& query,
                       "candidate ordering entries in decision must match solutions");
     }
 
-    const auto key = computeKey(query);
+    const auto key = hashKey(computeKey(query));
     const size_t newWorks = why->stats[0]->common.works;
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    auto& partition = partitionFor(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
     bool isNewEntryActive = false;
     uint32_t queryHash;
     if (internalQueryCacheDisableInactiveEntries.load()) {
         // All entries are always active.
         isNewEntryActive = true;
-        queryHash = PlanCache::computeQueryHash(key);
+        queryHash = PlanCache::computeQueryHash(key.key);
     } else {
         PlanCacheEntry* oldEntry = nullptr;
-        Status cacheStatus = _cache.get(key, &oldEntry);
+        Status cacheStatus = partition.cache.get(key, &oldEntry);
         invariant(cacheStatus.isOK() || cacheStatus == ErrorCodes::NoSuchKey);
         if (oldEntry) {
             queryHash = oldEntry->queryHash;
         } else {
-            queryHash = PlanCache::computeQueryHash(key);
+            queryHash = PlanCache::computeQueryHash(key.key);
         }
 
         auto newState = getNewEntryState(
@@ -921,6 +969,17 @@ Status PlanCache::set(const CanonicalQuery& query,
     }
     newEntry->timeOfCreation = now;
 
+    if (collectionStats) {
+        for (auto&& soln : solns) {
+            auto estimate =
+                soln->root ? collectionStats->estimateScanFraction(soln->root.get()) : boost::none;
+            if (estimate && (!newEntry->cheapestEstimatedScanFraction ||
+                             *estimate < *newEntry->cheapestEstimatedScanFraction)) {
+                newEntry->cheapestEstimatedScanFraction = estimate;
+            }
+        }
+    }
+
     // Strip projections on $-prefixed fields, as these are added by internal callers of the query
     // system and are not considered part of the user projection.
     BSONObjBuilder projBuilder;
@@ -932,9 +991,10 @@ Status PlanCache::set(const CanonicalQuery& query,
     }
     newEntry->projection = projBuilder.obj();
 
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(key, newEntry.release());
+    std::unique_ptr<PlanCacheEntry> evictedEntry = partition.cache.add(key, newEntry.release());
 
     if (NULL != evictedEntry.get()) {
+        ++partition.evictions;
         LOG(1) << _ns << ": plan cache maximum size exceeded - "
                << "removed least recently used entry " << redact(evictedEntry->toString());
     }
@@ -948,10 +1008,11 @@ void PlanCache::deactivate(const CanonicalQuery& query) {
         return;
     }
 
-    PlanCacheKey key = computeKey(query);
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    const auto key = hashKey(computeKey(query));
+    auto& partition = partitionFor(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
         return;
@@ -966,14 +1027,18 @@ PlanCache::GetResult PlanCache::get(const CanonicalQuery& query) const {
 }
 
 PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    const auto hashedKey = hashKey(key);
+    auto& partition = partitionFor(hashedKey);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(hashedKey, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
+        ++partition.misses;
         return {CacheEntryState::kNotPresent, nullptr};
     }
     invariant(entry);
+    ++partition.hits;
 
     auto state =
         entry->isActive ? CacheEntryState::kPresentActive : CacheEntryState::kPresentInactive;
@@ -981,11 +1046,12 @@ PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
 }
 
 Status PlanCache::feedback(const CanonicalQuery& cq, double score) {
-    PlanCacheKey ck = computeKey(cq);
+    const auto ck = hashKey(computeKey(cq));
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    auto& partition = partitionFor(ck);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(ck, &entry);
+    Status cacheStatus = partition.cache.get(ck, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -1000,13 +1066,17 @@ Status PlanCache::feedback(const CanonicalQuery& cq, double score) {
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    const auto key = hashKey(computeKey(canonicalQuery));
+    auto& partition = partitionFor(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
+    return partition.cache.remove(key);
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    _cache.clear();
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> cacheLock(partition->mutex);
+        partition->cache.clear();
+    }
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
@@ -1022,11 +1092,12 @@ uint32_t PlanCache::computeQueryHash(const PlanCacheKey& key) {
 }
 
 StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQuery& query) const {
-    PlanCacheKey key = computeKey(query);
+    const auto key = hashKey(computeKey(query));
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    auto& partition = partitionFor(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -1036,20 +1107,35 @@ StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQ
 }
 
 std::vector<std::unique_ptr<PlanCacheEntry>> PlanCache::getAllEntries() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     std::vector<std::unique_ptr<PlanCacheEntry>> entries;
 
-    for (auto&& cacheEntry : _cache) {
-        auto entry = cacheEntry.second;
-        entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> cacheLock(partition->mutex);
+        for (auto&& cacheEntry : partition->cache) {
+            auto entry = cacheEntry.second;
+            entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
+        }
     }
 
     return entries;
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.size();
+    size_t size = 0;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> cacheLock(partition->mutex);
+        size += partition->cache.size();
+    }
+    return size;
+}
+
+std::vector<PlanCache::PartitionStats> PlanCache::getPartitionStats() const {
+    std::vector<PartitionStats> stats;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> cacheLock(partition->mutex);
+        stats.push_back(partition->stats());
+    }
+    return stats;
 }
 
 void PlanCache::notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries) {
@@ -1060,13 +1146,25 @@ std::vector<BSONObj> PlanCache::getMatchingStats(
     const std::function<BSONObj(const PlanCacheEntry&)>& serializationFunc,
     const std::function<bool(const BSONObj&)>& filterFunc) const {
     std::vector<BSONObj> results;
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
 
-    for (auto&& cacheEntry : _cache) {
-        const auto entry = cacheEntry.second;
-        auto serializedEntry = serializationFunc(*entry);
-        if (filterFunc(serializedEntry)) {
-            results.push_back(serializedEntry);
+    for (size_t i = 0; i < _partitions.size(); ++i) {
+        auto& partition = *_partitions[i];
+        stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
+
+        BSONObjBuilder partitionBuilder;
+        partitionBuilder.append("id", static_cast<int>(i));
+        partitionBuilder.appendElements(partition.stats().toBSON());
+        const BSONObj partitionObj = partitionBuilder.obj();
+
+        for (auto&& cacheEntry : partition.cache) {
+            const auto entry = cacheEntry.second;
+            BSONObjBuilder serializedEntry;
+            serializedEntry.appendElements(serializationFunc(*entry));
+            serializedEntry.append("partition", partitionObj);
+            auto serializedObj = serializedEntry.obj();
+            if (filterFunc(serializedObj)) {
+                results.push_back(std::move(serializedObj));
+            }
         }
     }
 
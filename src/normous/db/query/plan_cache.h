@@ -29,7 +29,9 @@
 #pragma once
 
 #include <boost/optional/optional.hpp>
+#include <memory>
 #include <set>
+#include <vector>
 
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
@@ -158,6 +160,10 @@ struct SolutionCacheData {
         // The cached plan is a collection scan.
         COLLSCAN_SOLN,
 
+        // The cached plan skips between the distinct
+        // leading values of the index stored in 'tree'.
+        SKIP_SCAN_SOLN,
+
         // Build the solution by using 'tree'
         // to tag the match expression.
         USE_INDEX_TAGS_SOLN
@@ -172,6 +178,7 @@ struct SolutionCacheData {
     bool indexFilterApplied;
 };
 
+class CollectionStatistics;
 class PlanCacheEntry;
 
 /**
@@ -205,6 +212,10 @@ public:
     // The number of work cycles taken to decide on a winning plan when the plan was first
     // cached.
     size_t decisionWorks;
+
+    // The smallest fraction of the collection which any of the candidate plans was estimated to
+    // examine when the plan was cached, if the collection had statistics to estimate it.
+    boost::optional<double> cheapestEstimatedScanFraction;
 };
 
 /**
@@ -279,6 +290,11 @@ public:
     // trigger a replan. Running a query of the same shape while this cache entry is inactive may
     // cause this value to be increased.
     size_t works = 0;
+
+    // The smallest fraction of the collection which any of the candidate plans was estimated to
+    // examine, if the collection had statistics to estimate it. Computed once, when the entry is
+    // created, so that using the cached plan does not require enumerating the candidates again.
+    boost::optional<double> cheapestEstimatedScanFraction;
 };
 
 /**
@@ -326,11 +342,29 @@ public:
     static bool shouldCacheQuery(const CanonicalQuery& query);
 
     /**
-     * If omitted, namespace set to empty string.
+     * Hit, miss and eviction counts for one partition of the cache.
+     */
+    struct PartitionStats {
+        BSONObj toBSON() const;
+
+        size_t entries = 0;
+        long long hits = 0;
+        long long misses = 0;
+        long long evictions = 0;
+    };
+
+    /**
+     * If omitted, namespace set to empty string and the cache is split into
+     * 'internalQueryCachePartitions' partitions.
      */
     PlanCache();
 
-    PlanCache(size_t size);
+    /**
+     * Creates a cache holding about 'size' entries, split evenly between 'numPartitions'
+     * independently locked partitions. Each partition evicts its own least recently used entry
+     * when it fills up.
+     */
+    PlanCache(size_t size, size_t numPartitions = 1);
 
     PlanCache(const std::string& ns);
 
@@ -348,13 +382,17 @@ public:
      * an inactive cache entry.  If boost::none is provided, the function will use
      * 'internalQueryCacheWorksGrowthCoefficient'.
      *
+     * If 'collectionStats' is provided, the entry records the smallest fraction of the collection
+     * any of 'solns' is estimated to examine.
+     *
      * If the mapping was set successfully, returns Status::OK(), even if it evicted another entry.
      */
     Status set(const CanonicalQuery& query,
                const std::vector<QuerySolution*>& solns,
                std::unique_ptr<PlanRankingDecision> why,
                Date_t now,
-               boost::optional<double> worksGrowthCoefficient = boost::none);
+               boost::optional<double> worksGrowthCoefficient = boost::none,
+               const CollectionStatistics* collectionStats = nullptr);
 
     /**
      * Set a cache entry back to the 'inactive' state. Rather than completely evicting an entry
@@ -450,6 +488,11 @@ public:
      */
     size_t size() const;
 
+    /**
+     * Returns the counters of each partition of the cache, in partition order.
+     */
+    std::vector<PartitionStats> getPartitionStats() const;
+
     /**
      * Updates internal state kept about the collection's indexes.  Must be called when the set
      * of indexes on the associated collection have changed.
@@ -460,13 +503,57 @@ public:
 
     /**
      * Iterates over the plan cache. For each entry, serializes the PlanCacheEntry according to
-     * 'serializationFunc'. Returns a vector of all serialized entries which match 'filterFunc'.
+     * 'serializationFunc' and appends a "partition" subobject describing the partition holding the
+     * entry. Returns a vector of all serialized entries which match 'filterFunc'.
      */
     std::vector<BSONObj> getMatchingStats(
         const std::function<BSONObj(const PlanCacheEntry&)>& serializationFunc,
         const std::function<bool(const BSONObj&)>& filterFunc) const;
 
 private:
+    /**
+     * A PlanCacheKey together with its 64-bit hash. The hash is computed once per operation and is
+     * used both to select the partition holding the key and as the key's hash within it.
+     */
+    struct HashedKey {
+        bool operator==(const HashedKey& other) const {
+            return hash == other.hash && key == other.key;
+        }
+
+        PlanCacheKey key;
+        std::uint64_t hash;
+    };
+
+    struct HashedKeyHasher {
+        std::size_t operator()(const HashedKey& hashedKey) const {
+            return hashedKey.hash;
+        }
+    };
+
+    /**
+     * One independently locked slice of the cache.
+     */
+    struct Partition {
+        explicit Partition(size_t size) : cache(size) {}
+
+        // Returns the current counters of this partition. Requires holding 'mutex'.
+        PartitionStats stats() const;
+
+        LRUKeyValue<HashedKey, PlanCacheEntry, HashedKeyHasher> cache;
+
+        // Counters reported through getPartitionStats(). Like 'cache', protected by 'mutex'.
+        long long hits = 0;
+        long long misses = 0;
+        long long evictions = 0;
+
+        // Protects 'cache' and the counters.
+        stdx::mutex mutex;
+    };
+
+    static HashedKey hashKey(PlanCacheKey key);
+
+    Partition& partitionFor(const HashedKey& key) const;
+
     struct NewEntryState {
         bool shouldBeCreated = false;
         bool shouldBeActive = false;
@@ -482,10 +569,9 @@ private:
     void encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const;
     void encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const;
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
-
-    // Protects _cache.
-    mutable stdx::mutex _cacheMutex;
+    // The cache entries, spread across the partitions by the hash of their key. Each partition
+    // has its own lock, so lookups of different query shapes rarely contend.
+    std::vector<std::unique_ptr<Partition>> _partitions;
 
     // Full namespace of collection.
     std::string _ns;
@@ -806,7 +806,71 @@ TEST(PlanCacheTest, GetMatchingStatsMatchesAndSerializesCorrectly) {
     // Verify the output of getMatchingStats().
     auto getStatsResult = planCache.getMatchingStats(serializer, matcher);
     ASSERT_EQ(1U, getStatsResult.size());
-    ASSERT_BSONOBJ_EQ(BSON("works" << 5), getStatsResult[0]);
+    ASSERT_EQ(5, getStatsResult[0]["works"].numberInt());
+
+    // Each serialized entry also describes the partition holding it.
+    BSONObj partition = getStatsResult[0]["partition"].Obj();
+    ASSERT(partition.hasField("id"));
+    ASSERT_GTE(partition["entries"].numberLong(), 1);
+}
+
+TEST(PlanCacheTest, PartitionedCacheFindsEveryEntry) {
+    PlanCache planCache(100, 4);
+    ASSERT_EQ(4U, planCache.getPartitionStats().size());
+
+    const std::vector<std::string> queries{
+        "{a: 1}", "{b: 1}", "{c: 1}", "{a: 1, b: 1}", "{a: {$gt: 1}}", "{d: 1}", "{e: 1}"};
+    for (auto&& query : queries) {
+        unique_ptr<CanonicalQuery> cq(canonicalize(query.c_str()));
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kNotPresent);
+        addCacheEntryForShape(*cq, &planCache);
+    }
+    ASSERT_EQ(queries.size(), planCache.size());
+    ASSERT_EQ(queries.size(), planCache.getAllEntries().size());
+
+    for (auto&& query : queries) {
+        unique_ptr<CanonicalQuery> cq(canonicalize(query.c_str()));
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
+    }
+
+    // Every shape missed once before being added and hit once afterwards.
+    size_t entries = 0;
+    long long hits = 0;
+    long long misses = 0;
+    for (auto&& stats : planCache.getPartitionStats()) {
+        entries += stats.entries;
+        hits += stats.hits;
+        misses += stats.misses;
+        ASSERT_EQ(0, stats.evictions);
+    }
+    ASSERT_EQ(queries.size(), entries);
+    ASSERT_EQ(static_cast<long long>(queries.size()), hits);
+    ASSERT_EQ(static_cast<long long>(queries.size()), misses);
+
+    for (auto&& query : queries) {
+        unique_ptr<CanonicalQuery> cq(canonicalize(query.c_str()));
+        ASSERT_OK(planCache.remove(*cq));
+    }
+    ASSERT_EQ(0U, planCache.size());
+}
+
+TEST(PlanCacheTest, PartitionStatsCountEvictions) {
+    PlanCache planCache(1);
+
+    unique_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}"));
+    addCacheEntryForShape(*cqA, &planCache);
+    unique_ptr<CanonicalQuery> cqB(canonicalize("{b: 1}"));
+    addCacheEntryForShape(*cqB, &planCache);
+
+    auto stats = planCache.getPartitionStats();
+    ASSERT_EQ(1U, stats.size());
+    ASSERT_EQ(1U, stats[0].entries);
+    ASSERT_EQ(1, stats[0].evictions);
+}
+
+TEST(PlanCacheTest, PartitionCountIsBoundedByCacheSize) {
+    PlanCache planCache(2, 16);
+    ASSERT_EQ(2U, planCache.getPartitionStats().size());
 }
 
 /**
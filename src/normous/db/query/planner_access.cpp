@@ -136,6 +136,23 @@ std::vector<bool> canProvideSortWithMergeSort(
     return shouldReverseScan;
 }
 
+/**
+ * Returns true if 'expr' is a predicate which can bound a trailing field of a skip scan.
+ */
+bool isSkipScanPredicate(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::MATCH_IN:
+            return true;
+        default:
+            return false;
+    }
+}
+
 }  // namespace
 
 namespace mongo {
@@ -1014,6 +1031,12 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::buildIndexedAnd(
             auto asn = stdx::make_unique<AndSortedNode>();
             asn->addChildren(std::move(ixscanNodes));
             andResult = std::move(asn);
+        } else if (!inArrayOperator && internalQueryPlannerEnableBitmapIntersection.load()) {
+            // The bitmap only keeps RecordIds, which is fine since the fetch added below
+            // evaluates the entire predicate anyway.
+            auto abn = stdx::make_unique<AndBitmapNode>();
+            abn->addChildren(std::move(ixscanNodes));
+            andResult = std::move(abn);
         } else if (internalQueryPlannerEnableHashIntersection.load()) {
             {
                 auto ahn = stdx::make_unique<AndHashNode>();
@@ -1046,7 +1069,8 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::buildIndexedAnd(
         return andResult;
     }
 
-    if (andResult->getType() == STAGE_AND_HASH || andResult->getType() == STAGE_AND_SORTED) {
+    if (andResult->getType() == STAGE_AND_HASH || andResult->getType() == STAGE_AND_SORTED ||
+        andResult->getType() == STAGE_AND_BITMAP) {
         // We got an index intersection solution, so we aren't allowed to answer predicates exactly
         // using the index. This is because the index intersection stage finds documents that match
         // each index's predicate, but the document isn't guaranteed to be in a state where it
@@ -1094,6 +1118,14 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::buildIndexedOr(
     const QueryPlannerParams& params) {
 
     const bool inArrayOperator = !ownedRoot;
+
+    // A bitmap union returns nothing but RecordIds, so it needs a fetch which rechecks the entire
+    // predicate. Clone it before processIndexScans() detaches the children of 'root'.
+    std::unique_ptr<MatchExpression> clonedRoot;
+    if (!inArrayOperator && internalQueryPlannerEnableBitmapIntersection.load()) {
+        clonedRoot = root->shallowClone();
+    }
+
     std::vector<std::unique_ptr<QuerySolutionNode>> ixscanNodes;
     if (!processIndexScans(query, root, inArrayOperator, indices, params, &ixscanNodes)) {
         return NULL;
@@ -1143,6 +1175,19 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::buildIndexedOr(
             msn->sort = query.getQueryRequest().getSort();
             msn->addChildren(std::move(ixscanNodes));
             orResult = std::move(msn);
+        } else if (clonedRoot &&
+                   std::none_of(ixscanNodes.begin(), ixscanNodes.end(), [](const auto& node) {
+                       return node->fetched() || isTextNode(node.get());
+                   })) {
+            // Fetching the documents is left to the fetch above the union, so that no child has
+            // fetched a document which the union would then have to throw away.
+            auto obn = stdx::make_unique<OrBitmapNode>();
+            obn->addChildren(std::move(ixscanNodes));
+
+            auto fetch = stdx::make_unique<FetchNode>();
+            fetch->filter = std::move(clonedRoot);
+            fetch->children.push_back(obn.release());
+            return std::move(fetch);
         } else {
             auto orn = stdx::make_unique<OrNode>();
             orn->addChildren(std::move(ixscanNodes));
@@ -1291,6 +1336,66 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::scanWholeIndex(
     return solnRoot;
 }
 
+std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeSkipScan(
+    const IndexEntry& index, const CanonicalQuery& query, const QueryPlannerParams& params) {
+    invariant(index.type == INDEX_BTREE && !index.multikey && !index.sparse && !index.filterExpr);
+
+    // Only the children of a top-level AND must hold for every matching document, so those are
+    // the only predicates which can be used to bound the scan.
+    std::vector<const MatchExpression*> predicates;
+    const MatchExpression* root = query.root();
+    if (MatchExpression::AND == root->matchType()) {
+        for (size_t i = 0; i < root->numChildren(); ++i) {
+            predicates.push_back(root->getChild(i));
+        }
+    } else {
+        predicates.push_back(root);
+    }
+
+    unique_ptr<IndexScanNode> isn = make_unique<IndexScanNode>(index);
+    isn->addKeyMetadata = query.getQueryRequest().returnKey();
+    isn->queryCollator = query.getCollator();
+    isn->bounds.fields.resize(index.keyPattern.nFields());
+
+    // The leading field is always scanned in full. The IndexBoundsChecker used by the index scan
+    // seeks to the next leading value as soon as a key falls beyond the bounds of a trailing field.
+    bool hasTrailingBounds = false;
+    size_t fieldNo = 0;
+    BSONObjIterator it(index.keyPattern);
+    while (it.more()) {
+        BSONElement keyElt = it.next();
+        OrderedIntervalList* oil = &isn->bounds.fields[fieldNo];
+        IndexBoundsBuilder::allValuesForField(keyElt, oil);
+
+        if (fieldNo > 0) {
+            for (auto&& pred : predicates) {
+                if (!isSkipScanPredicate(pred) || pred->path() != keyElt.fieldNameStringData()) {
+                    continue;
+                }
+
+                // The fetch below re-applies the full filter, so the tightness does not matter.
+                IndexBoundsBuilder::BoundsTightness tightness;
+                IndexBoundsBuilder::translateAndIntersect(pred, keyElt, index, oil, &tightness);
+                hasTrailingBounds = true;
+            }
+        }
+        ++fieldNo;
+    }
+
+    if (!hasTrailingBounds) {
+        return nullptr;
+    }
+
+    IndexBoundsBuilder::alignBounds(&isn->bounds, index.keyPattern);
+
+    unique_ptr<FetchNode> fetch = make_unique<FetchNode>();
+    fetch->filter = query.root()->shallowClone();
+    fetch->children.push_back(isn.release());
+
+    std::unique_ptr<QuerySolutionNode> solnRoot = std::move(fetch);
+    return solnRoot;
+}
+
 void QueryPlannerAccess::addFilterToSolutionNode(QuerySolutionNode* node,
                                                  MatchExpression* match,
                                                  MatchExpression::MatchType type) {
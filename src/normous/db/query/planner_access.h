@@ -109,6 +109,19 @@ public:
                                                              const QueryPlannerParams& params,
                                                              int direction = 1);
 
+    /**
+     * Return a plan that scans every distinct value of the leading field of the provided compound
+     * index, using the query's predicates over the trailing fields to bound the keys examined under
+     * each of those values. The index scan seeks from one leading value to the next rather than
+     * walking the keys in between. Returns nullptr if the query has no predicate over a trailing
+     * field of the index.
+     *
+     * The index must be a non-multikey, non-sparse btree index without a partial filter.
+     */
+    static std::unique_ptr<QuerySolutionNode> makeSkipScan(const IndexEntry& index,
+                                                           const CanonicalQuery& query,
+                                                           const QueryPlannerParams& params);
+
     /**
      * Return a plan that scans the provided index from [startKey to endKey).
      */
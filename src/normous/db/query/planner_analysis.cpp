@@ -666,10 +666,12 @@ std::unique_ptr<QuerySolution> QueryPlannerAnalysis::analyzeDataAccess(
         return NULL;
     }
 
-    // A solution can be blocking if it has a blocking sort stage or
-    // a hashed AND stage.
+    // A solution can be blocking if it has a blocking sort stage,
+    // a hashed AND stage or a bitmap AND or OR stage.
     bool hasAndHashStage = hasNode(solnRoot.get(), STAGE_AND_HASH);
-    soln->hasBlockingStage = hasSortStage || hasAndHashStage;
+    bool hasBitmapStage =
+        hasNode(solnRoot.get(), STAGE_AND_BITMAP) || hasNode(solnRoot.get(), STAGE_OR_BITMAP);
+    soln->hasBlockingStage = hasSortStage || hasAndHashStage || hasBitmapStage;
 
     const QueryRequest& qr = query.getQueryRequest();
 
@@ -695,6 +697,11 @@ std::unique_ptr<QuerySolution> QueryPlannerAnalysis::analyzeDataAccess(
                 fetch->children.push_back(solnRoot.release());
                 solnRoot.reset(fetch);
             }
+
+            // An exclusion of top-level fields can still use the simple document path.
+            if (query.getProj()->isSimpleExclusion()) {
+                projType = ProjectionNode::SIMPLE_DOC;
+            }
         } else if (!query.getProj()->wantIndexKey()) {
             // The only way we're here is if it's a simple inclusion projection. Often such
             // simple projections are eligible for an optimized execution path. However, in some
@@ -38,8 +38,28 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationCollFraction, double, 0
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanEvaluationMaxResults, int, 101);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryMultiPlannerParallelTrials, bool, false);
+
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(internalQueryMultiPlannerTrialThreads, int, 8)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 100) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryMultiPlannerTrialThreads must be between 1 and 100");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheSize, int, 5000);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCachePartitions, int, 16)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 1024) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryCachePartitions must be between 1 and 1024");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheFeedbacksStored, int, 20);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheEvictionRatio, double, 10.0);
@@ -69,6 +89,17 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableIndexIntersection, bool,
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableHashIntersection, bool, false);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableBitmapIntersection, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryBitmapMergeMaxMemoryBytes, int, 32 * 1024 * 1024)
+    ->withValidator([](const int& newVal) {
+        if (newVal <= 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryBitmapMergeMaxMemoryBytes must be greater than 0");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanOrChildrenIndependently, bool, true);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
@@ -79,6 +110,8 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnableCompiledFilters, bool, true);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryFacetBufferSizeBytes, int, 100 * 1024 * 1024);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceSortMaxBlockingSortBytes,
@@ -103,6 +136,24 @@ MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupMaxMemoryBytes,
         return Status::OK();
     });
 
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupBatchSize, int, 128)
+    ->withValidator([](const int& newVal) {
+        if (newVal <= 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalDocumentSourceGroupBatchSize must be > 0");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupSpillPartitions, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 1024) {
+            return Status(ErrorCodes::BadValue,
+                          "internalDocumentSourceGroupSpillPartitions must be between 0 and 1024");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalInsertMaxBatchSize,
                               int,
                               internalQueryExecYieldIterations.load() / 2);
@@ -111,9 +162,69 @@ MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceCursorBatchSizeBytes, int, 4
 
 MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupCacheSizeBytes, int, 100 * 1024 * 1024);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceSortThreads, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "internalDocumentSourceSortThreads must be between 1 and 64");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupUseHashJoin, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupHashJoinMaxMemoryBytes,
+                              int,
+                              100 * 1024 * 1024)
+    ->withValidator([](const int& newVal) {
+        if (newVal <= 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalDocumentSourceLookupHashJoinMaxMemoryBytes must be > 0");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerGenerateCoveredWholeIndexScans, bool, false);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerGenerateSkipScans, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerStatsPruneRatio, double, 10.0)
+    ->withValidator([](const double& newVal) {
+        if (newVal != 0.0 && newVal < 1.0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryPlannerStatsPruneRatio must be 0 or >= 1.0");
+        }
+        return Status::OK();
+    });
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryIgnoreUnknownJSONSchemaKeywords, bool, false);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryProhibitBlockingMergeOnMongoS, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelGroupConsumers, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 100) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryParallelGroupConsumers must be between 0 and 100");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanThreads, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 100) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryParallelCollectionScanThreads must be between 0 and 100");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelCollectionScanMinRecords, int, 10000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "internalQueryParallelCollectionScanMinRecords must be >= 0");
+        }
+        return Status::OK();
+    });
 }  // namespace mongo
@@ -48,6 +48,12 @@ extern AtomicDouble internalQueryPlanEvaluationCollFraction;
 // Stop working plans once a plan returns this many results.
 extern AtomicInt32 internalQueryPlanEvaluationMaxResults;
 
+// Do we run the trial periods of the candidate plans concurrently, each on its own thread?
+extern AtomicBool internalQueryMultiPlannerParallelTrials;
+
+// The number of threads shared by all the concurrently running trial periods. Startup only.
+extern int internalQueryMultiPlannerTrialThreads;
+
 // Do we give a big ranking bonus to intersection plans?
 extern AtomicBool internalQueryForceIntersectionPlans;
 
@@ -57,6 +63,13 @@ extern AtomicBool internalQueryPlannerEnableIndexIntersection;
 // Do we use hash-based intersection for rooted $and queries?
 extern AtomicBool internalQueryPlannerEnableHashIntersection;
 
+// Do we intersect and union index scans over RecordId bitmaps instead of hash tables?
+extern AtomicBool internalQueryPlannerEnableBitmapIntersection;
+
+// The maximum size of the RecordId bitmaps built by a bitmap intersection or union, beyond which
+// the stage fails.
+extern AtomicInt32 internalQueryBitmapMergeMaxMemoryBytes;
+
 //
 // plan cache
 //
@@ -64,6 +77,10 @@ extern AtomicBool internalQueryPlannerEnableHashIntersection;
 // How many entries in the cache?
 extern AtomicInt32 internalQueryCacheSize;
 
+// How many independently locked partitions is each collection's plan cache split into? The
+// entries are spread across the partitions by the hash of their query shape.
+extern AtomicInt32 internalQueryCachePartitions;
+
 // How many feedback entries do we collect before possibly evicting from the cache based on bad
 // performance?
 extern AtomicInt32 internalQueryCacheFeedbacksStored;
@@ -105,6 +122,16 @@ extern AtomicInt32 internalQueryMaxScansToExplode;
 // Allow the planner to generate covered whole index scans, rather than falling back to a COLLSCAN.
 extern AtomicBool internalQueryPlannerGenerateCoveredWholeIndexScans;
 
+// Allow the planner to generate index scans which skip between the distinct values of an
+// unconstrained leading field, in order to use predicates over the trailing fields of the index.
+extern AtomicBool internalQueryPlannerGenerateSkipScans;
+
+// When statistics gathered by the 'analyze' command are available, candidate plans estimated to
+// scan more than this many times the keys or documents of the cheapest candidate are discarded
+// before the trial period, and a cached plan which would be discarded is evicted without a trial
+// period. Zero disables both.
+extern AtomicDouble internalQueryPlannerStatsPruneRatio;
+
 // Ignore unknown JSON Schema keywords.
 extern AtomicBool internalQueryIgnoreUnknownJSONSchemaKeywords;
 
@@ -120,6 +147,9 @@ extern AtomicInt32 internalQueryExecYieldIterations;
 // Yield if it's been at least this many milliseconds since we last yielded.
 extern AtomicInt32 internalQueryExecYieldPeriodMS;
 
+// Whether collection scans and fetches evaluate their filters through a CompiledMatchExpression.
+extern AtomicBool internalQueryEnableCompiledFilters;
+
 // Limit the size that we write without yielding to 16MB / 64 (max expected number of indexes)
 const int64_t insertVectorMaxBytes = 256 * 1024;
 
@@ -130,11 +160,44 @@ extern AtomicInt64 internalDocumentSourceSortMaxBlockingSortBytes;
 
 extern AtomicInt64 internalDocumentSourceGroupMaxMemoryBytes;
 
+// The maximum number of consecutive documents of the same group whose accumulator inputs $group
+// buffers and processes as one batch. A value of 1 processes every document on its own.
+extern AtomicInt32 internalDocumentSourceGroupBatchSize;
+
+// When a $group exceeds its memory limit, it spills its groups into this many files partitioned by
+// a hash of the group key and later re-aggregates each file on its own. Values less than 2 instead
+// spill sorted runs which are merged back together.
+extern AtomicInt32 internalDocumentSourceGroupSpillPartitions;
+
 extern AtomicInt32 internalInsertMaxBatchSize;
 
 extern AtomicInt32 internalDocumentSourceCursorBatchSizeBytes;
 
 extern AtomicInt32 internalDocumentSourceLookupCacheSizeBytes;
 
+// The number of threads a $sort uses to sort and spill its input, and to read ahead in its spill
+// files while merging them.
+extern AtomicInt32 internalDocumentSourceSortThreads;
+
+// Whether a $lookup using the localField/foreignField syntax builds a hash table over the foreign
+// collection instead of querying it once per input document.
+extern AtomicBool internalDocumentSourceLookupUseHashJoin;
+
+// The maximum size of the hash table built by a hash-joined $lookup before it spills the foreign
+// collection to disk.
+extern AtomicInt32 internalDocumentSourceLookupHashJoinMaxMemoryBytes;
+
 extern AtomicBool internalQueryProhibitBlockingMergeOnMongoS;
+
+// The number of threads a hash-partitioned $group is split across. Values less than 2 disable the
+// rewrite.
+extern AtomicInt32 internalQueryParallelGroupConsumers;
+
+// The number of threads an aggregation which begins with a $group over a collection scan splits
+// that scan across, each thread scanning its own ranges of RecordIds. Values less than 2 disable
+// the rewrite.
+extern AtomicInt32 internalQueryParallelCollectionScanThreads;
+
+// Collections with fewer records than this are always scanned by a single thread.
+extern AtomicInt32 internalQueryParallelCollectionScanMinRecords;
 }  // namespace mongo
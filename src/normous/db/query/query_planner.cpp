@@ -44,6 +44,7 @@
 #include "mongo/db/matcher/expression_geo.h"
 #include "mongo/db/matcher/expression_text.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/collection_statistics.h"
 #include "mongo/db/query/collation/collation_index_key.h"
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/plan_cache.h"
@@ -134,6 +135,9 @@ string optionString(size_t options) {
             case QueryPlannerParams::STRICT_DISTINCT_ONLY:
                 ss << "STRICT_DISTINCT_ONLY ";
                 break;
+            case QueryPlannerParams::GENERATE_SKIP_SCANS:
+                ss << "GENERATE_SKIP_SCANS ";
+                break;
             case QueryPlannerParams::DEFAULT:
                 MONGO_UNREACHABLE;
                 break;
@@ -288,6 +292,73 @@ std::unique_ptr<QuerySolution> buildWholeIXSoln(const IndexEntry& index,
     return QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(solnRoot));
 }
 
+/**
+ * Returns true if 'index' can be scanned by skipping between the distinct values of its leading
+ * field. See QueryPlannerAccess::makeSkipScan().
+ */
+bool canSkipScan(const IndexEntry& index, const CanonicalQuery& query) {
+    return index.type == INDEX_BTREE && index.keyPattern.nFields() > 1 && !index.multikey &&
+        !index.sparse && !index.filterExpr &&
+        CollatorInterface::collatorsMatch(index.collator, query.getCollator());
+}
+
+std::unique_ptr<QuerySolution> buildSkipScanSoln(const IndexEntry& index,
+                                                 const CanonicalQuery& query,
+                                                 const QueryPlannerParams& params) {
+    std::unique_ptr<QuerySolutionNode> solnRoot(
+        QueryPlannerAccess::makeSkipScan(index, query, params));
+    if (!solnRoot) {
+        return nullptr;
+    }
+    return QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(solnRoot));
+}
+
+/**
+ * Discards the solutions in 'out' which the collection statistics in 'params' estimate to examine
+ * more than internalQueryPlannerStatsPruneRatio times as many keys and documents as the cheapest
+ * solution, so that the trial period does not have to spend works on them. Solutions which could
+ * run to completion within the trial period anyway, and solutions whose cost cannot be estimated,
+ * are kept. A sort or limit lets a plan stop early, which the estimates do not account for, so
+ * such queries are left alone.
+ */
+void pruneSolutionsByEstimatedCost(const CanonicalQuery& query,
+                                   const QueryPlannerParams& params,
+                                   std::vector<std::unique_ptr<QuerySolution>>* out) {
+    const double pruneRatio = internalQueryPlannerStatsPruneRatio.load();
+    const QueryRequest& qr = query.getQueryRequest();
+    if (!params.collectionStats || pruneRatio == 0.0 || out->size() < 2 ||
+        !qr.getSort().isEmpty() || qr.getLimit() || qr.getNToReturn() || qr.isTailable()) {
+        return;
+    }
+
+    std::vector<boost::optional<double>> estimates;
+    boost::optional<double> cheapest;
+    for (auto&& soln : *out) {
+        estimates.push_back(params.collectionStats->estimateScanFraction(soln->root.get()));
+        if (estimates.back() && (!cheapest || *estimates.back() < *cheapest)) {
+            cheapest = estimates.back();
+        }
+    }
+    if (!cheapest) {
+        return;
+    }
+
+    const double numRecords = params.collectionStats->getNumRecords();
+    const double trialWorks = internalQueryPlanEvaluationWorks.load();
+    std::vector<std::unique_ptr<QuerySolution>> kept;
+    for (size_t i = 0; i < out->size(); ++i) {
+        const auto& estimate = estimates[i];
+        if (estimate && *estimate > pruneRatio * *cheapest && *estimate * numRecords > trialWorks) {
+            LOG(5) << "Planner: discarding soln estimated to examine " << *estimate
+                   << " of the collection, against " << *cheapest << " for the cheapest:" << endl
+                   << redact((*out)[i]->toString());
+            continue;
+        }
+        kept.push_back(std::move((*out)[i]));
+    }
+    out->swap(kept);
+}
+
 bool providesSort(const CanonicalQuery& query, const BSONObj& kp) {
     return query.getQueryRequest().getSort().isPrefixOf(kp, SimpleBSONElementComparator::kInstance);
 }
@@ -457,6 +528,13 @@ StatusWith<std::unique_ptr<QuerySolution>> QueryPlanner::planFromCache(
         } else {
             return {std::move(soln)};
         }
+    } else if (SolutionCacheData::SKIP_SCAN_SOLN == winnerCacheData.solnType) {
+        auto soln = buildSkipScanSoln(*winnerCacheData.tree->entry, query, params);
+        if (!soln) {
+            return Status(ErrorCodes::BadValue, "plan cache error: skip scan soln");
+        } else {
+            return {std::move(soln)};
+        }
     } else if (SolutionCacheData::COLLSCAN_SOLN == winnerCacheData.solnType) {
         // The cached solution is a collection scan. We don't cache collscans
         // with tailable==true, hence the false below.
@@ -1003,8 +1081,41 @@ StatusWith<std::vector<std::unique_ptr<QuerySolution>>> QueryPlanner::plan(
     // The caller can explicitly ask for a collscan.
     bool collscanRequested = (params.options & QueryPlannerParams::INCLUDE_COLLSCAN);
 
+    // No indexed plans?  A compound index whose leading field is unconstrained may still be able
+    // to answer the query by seeking from one leading value to the next. Whether that beats a
+    // collection scan depends on how many distinct leading values there are, which the planner
+    // cannot know, so a collscan is offered alongside and the plans are ranked by trial.
+    bool skipScanGenerated = false;
+    if (params.options & QueryPlannerParams::GENERATE_SKIP_SCANS && 0 == out.size() &&
+        possibleToCollscan && !isTailable) {
+        for (auto&& index : fullIndexList) {
+            if (out.size() >= params.maxIndexedSolutions) {
+                break;
+            }
+            if (!canSkipScan(index, query)) {
+                continue;
+            }
+
+            auto soln = buildSkipScanSoln(index, query, params);
+            if (soln) {
+                LOG(5) << "Planner: outputting skip scan soln:" << endl
+                       << redact(soln->toString());
+                PlanCacheIndexTree* indexTree = new PlanCacheIndexTree();
+                indexTree->setIndexEntry(index);
+
+                SolutionCacheData* scd = new SolutionCacheData();
+                scd->tree.reset(indexTree);
+                scd->solnType = SolutionCacheData::SKIP_SCAN_SOLN;
+                soln->cacheData.reset(scd);
+
+                out.push_back(std::move(soln));
+                skipScanGenerated = true;
+            }
+        }
+    }
+
     // No indexed plans?  We must provide a collscan if possible or else we can't run the query.
-    bool collscanNeeded = (0 == out.size() && canTableScan);
+    bool collscanNeeded = ((0 == out.size() || skipScanGenerated) && canTableScan);
 
     if (possibleToCollscan && (collscanRequested || collscanNeeded)) {
         auto collscan = buildCollscanSoln(query, isTailable, params);
@@ -1017,6 +1128,8 @@ StatusWith<std::vector<std::unique_ptr<QuerySolution>>> QueryPlanner::plan(
         }
     }
 
+    pruneSolutionsByEstimatedCost(query, params, &out);
+
     return {std::move(out)};
 }
 
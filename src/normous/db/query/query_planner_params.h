@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "mongo/db/jsobj.h"
@@ -36,6 +37,8 @@
 
 namespace mongo {
 
+class CollectionStatistics;
+
 struct QueryPlannerParams {
     QueryPlannerParams()
         : options(DEFAULT),
@@ -96,6 +99,11 @@ struct QueryPlannerParams {
         // return exactly one document per value of the distinct field. See the comments above the
         // declaration of getExecutorDistinct() for more detail.
         STRICT_DISTINCT_ONLY = 1 << 11,
+
+        // Set this to generate IXSCAN plans over compound indexes whose leading field is
+        // unconstrained, seeking past each distinct leading value to the keys which satisfy the
+        // predicates over the trailing fields.
+        GENERATE_SKIP_SCANS = 1 << 12,
     };
 
     // See Options enum above.
@@ -116,6 +124,11 @@ struct QueryPlannerParams {
     // plans via the MultiPlanStage, and the set of possible plans is very large for certain
     // index+query combinations.
     size_t maxIndexedSolutions;
+
+    // Statistics gathered over the collection by the 'analyze' command, if any. When present,
+    // the planner uses them to discard candidate plans which are estimated to do far more work
+    // than the cheapest one.
+    std::shared_ptr<const CollectionStatistics> collectionStats;
 };
 
 }  // namespace mongo
@@ -1500,6 +1500,28 @@ TEST_F(QueryPlannerTest, ProjNonCovering) {
         "{ixscan: {filter: null, pattern: {x: 1}}}}}}}");
 }
 
+TEST_F(QueryPlannerTest, SimpleExclusionProjUsesSimpleDocPath) {
+    addIndex(BSON("x" << 1));
+    runQuerySortProj(fromjson("{x: {$gt: 1}}"), BSONObj(), fromjson("{_id: 0, y: 0}"));
+
+    ASSERT_EQUALS(getNumSolutions(), 2U);
+    assertSolutionExists(
+        "{proj: {spec: {_id: 0, y: 0}, type: 'simple', node: {cscan: "
+        "{dir: 1, filter: {x: {$gt: 1}}}}}}");
+    assertSolutionExists(
+        "{proj: {spec: {_id: 0, y: 0}, type: 'simple', node: {fetch: {filter: null, node: "
+        "{ixscan: {filter: null, pattern: {x: 1}}}}}}}");
+}
+
+TEST_F(QueryPlannerTest, DottedExclusionProjUsesDefaultPath) {
+    runQuerySortProj(fromjson("{x: 1}"), BSONObj(), fromjson("{'y.z': 0}"));
+
+    ASSERT_EQUALS(getNumSolutions(), 1U);
+    assertSolutionExists(
+        "{proj: {spec: {'y.z': 0}, type: 'default', node: {cscan: "
+        "{dir: 1, filter: {x: 1}}}}}");
+}
+
 //
 // Basic sort
 //
@@ -3732,6 +3754,64 @@ TEST_F(QueryPlannerTest, IntersectDisableAndHash) {
     internalQueryPlannerEnableHashIntersection.store(oldEnableHashIntersection);
 }
 
+TEST_F(QueryPlannerTest, IntersectBitmapInsteadOfAndHash) {
+    bool oldEnableBitmapIntersection = internalQueryPlannerEnableBitmapIntersection.load();
+    internalQueryPlannerEnableBitmapIntersection.store(true);
+    params.options = QueryPlannerParams::NO_TABLE_SCAN | QueryPlannerParams::INDEX_INTERSECTION;
+
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("b" << 1));
+
+    runQuery(fromjson("{a: {$gt: 1}, b: {$lt: 5}}"));
+
+    // The fetch above the bitmap intersection rechecks the entire predicate.
+    assertNumSolutions(3U);
+    assertSolutionExists(
+        "{fetch: {filter: {a: {$gt: 1}, b: {$lt: 5}}, node: {andBitmap: {nodes: ["
+        "{ixscan: {filter: null, pattern: {a:1}}},"
+        "{ixscan: {filter: null, pattern: {b:1}}}]}}}}");
+
+    internalQueryPlannerEnableBitmapIntersection.store(oldEnableBitmapIntersection);
+}
+
+TEST_F(QueryPlannerTest, BitmapUnionOfIndexedOr) {
+    bool oldEnableBitmapIntersection = internalQueryPlannerEnableBitmapIntersection.load();
+    internalQueryPlannerEnableBitmapIntersection.store(true);
+
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("b" << 1));
+
+    runQuery(fromjson("{c: 1, $or: [{a: {$gt: 1}}, {b: {$lt: 5}}]}"));
+
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: {c: 1}, node: {fetch: {filter: {$or: [{a: {$gt: 1}}, {b: {$lt: 5}}]}, "
+        "node: {orBitmap: {nodes: ["
+        "{ixscan: {filter: null, pattern: {a:1}}},"
+        "{ixscan: {filter: null, pattern: {b:1}}}]}}}}}}");
+
+    internalQueryPlannerEnableBitmapIntersection.store(oldEnableBitmapIntersection);
+}
+
+TEST_F(QueryPlannerTest, NoBitmapUnionWhenMergeSortProvidesSort) {
+    bool oldEnableBitmapIntersection = internalQueryPlannerEnableBitmapIntersection.load();
+    internalQueryPlannerEnableBitmapIntersection.store(true);
+    params.options = QueryPlannerParams::NO_TABLE_SCAN;
+
+    addIndex(BSON("a" << 1 << "c" << 1));
+    addIndex(BSON("b" << 1 << "c" << 1));
+
+    runQuerySortProj(fromjson("{$or: [{a: 1}, {b: 1}]}"), BSON("c" << 1), BSONObj());
+
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{fetch: {node: {mergeSort: {nodes: ["
+        "{ixscan: {pattern: {a: 1, c: 1}}}, {ixscan: {pattern: {b: 1, c: 1}}}]}}}}");
+
+    internalQueryPlannerEnableBitmapIntersection.store(oldEnableBitmapIntersection);
+}
+
 //
 // Index intersection cases for SERVER-12825: make sure that
 // we don't generate an ixisect plan if a compound index is
@@ -5688,4 +5768,62 @@ TEST_F(QueryPlannerTest, EmptyQueryWithProjectionUsesCollscanIfIndexCollationDif
         "{proj: {spec: {_id: 0, a: 1}, node: "
         "{cscan: {dir: 1}}}}");
 }
+
+TEST_F(QueryPlannerTest, TrailingFieldPredicateUsesSkipScanIfEnabled) {
+    params.options = QueryPlannerParams::GENERATE_SKIP_SCANS;
+    addIndex(BSON("a" << 1 << "b" << 1));
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(2);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: {b: 5}, node: {ixscan: {filter: null, pattern: {a: 1, b: 1}, "
+        "bounds: {a: [['MinKey', 'MaxKey', true, true]], b: [[5, 5, true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, TrailingFieldPredicateDoesNotUseSkipScanIfDisabled) {
+    params.options &= ~QueryPlannerParams::GENERATE_SKIP_SCANS;
+    addIndex(BSON("a" << 1 << "b" << 1));
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(1);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanIntersectsPredicatesOverDescendingTrailingFields) {
+    params.options = QueryPlannerParams::GENERATE_SKIP_SCANS;
+    addIndex(BSON("a" << 1 << "b" << -1 << "c" << 1));
+    runQuery(fromjson("{b: {$gt: 5, $lte: 10}, d: 1}"));
+    assertNumSolutions(2);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: {b: {$gt: 5, $lte: 10}, d: 1}, node: {ixscan: {filter: null, "
+        "pattern: {a: 1, b: -1, c: 1}, bounds: {a: [['MinKey', 'MaxKey', true, true]], "
+        "b: [[10, 5, true, false]], c: [['MinKey', 'MaxKey', true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanNotUsedIfIndexIsMultikey) {
+    params.options = QueryPlannerParams::GENERATE_SKIP_SCANS;
+    constexpr bool isMultikey = true;
+    addIndex(BSON("a" << 1 << "b" << 1), isMultikey);
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(1);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanNotUsedIfAnotherIndexHasLeadingFieldPredicate) {
+    params.options = QueryPlannerParams::GENERATE_SKIP_SCANS;
+    addIndex(BSON("a" << 1 << "b" << 1));
+    addIndex(BSON("c" << 1));
+    runQuery(fromjson("{b: 5, c: 1}"));
+    assertNumSolutions(1);
+    assertSolutionExists(
+        "{fetch: {filter: {b: 5}, node: {ixscan: {filter: null, pattern: {c: 1}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanNotUsedUnderOr) {
+    params.options = QueryPlannerParams::GENERATE_SKIP_SCANS;
+    addIndex(BSON("a" << 1 << "b" << 1));
+    runQuery(fromjson("{$or: [{b: 5}, {d: 1}]}"));
+    assertNumSolutions(1);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
 }  // namespace
@@ -587,6 +587,17 @@ bool QueryPlannerTestLib::solutionMatches(const BSONObj& testSoln,
         }
 
         return childrenMatch(andSortedObj, asn, relaxBoundsCheck);
+    } else if (STAGE_AND_BITMAP == trueSoln->getType() ||
+               STAGE_OR_BITMAP == trueSoln->getType()) {
+        BSONElement el =
+            testSoln[STAGE_AND_BITMAP == trueSoln->getType() ? "andBitmap" : "orBitmap"];
+        if (el.eoo() || !el.isABSONObj()) {
+            return false;
+        }
+        BSONObj bitmapObj = el.Obj();
+        invariant(bsonObjFieldsAreInSet(bitmapObj, {"nodes"}));
+
+        return childrenMatch(bitmapObj, trueSoln, relaxBoundsCheck);
     } else if (STAGE_PROJECTION == trueSoln->getType()) {
         const ProjectionNode* pn = static_cast<const ProjectionNode*>(trueSoln);
 
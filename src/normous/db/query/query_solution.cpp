@@ -307,6 +307,62 @@ QuerySolutionNode* AndHashNode::clone() const {
     return copy;
 }
 
+//
+// AndBitmapNode
+//
+
+AndBitmapNode::AndBitmapNode() : _sort(SimpleBSONObjComparator::kInstance.makeBSONObjSet()) {}
+
+AndBitmapNode::~AndBitmapNode() {}
+
+void AndBitmapNode::appendToString(mongoutils::str::stream* ss, int indent) const {
+    addIndent(ss, indent);
+    *ss << "AND_BITMAP\n";
+    addCommon(ss, indent);
+    for (size_t i = 0; i < children.size(); ++i) {
+        addIndent(ss, indent + 1);
+        *ss << "Child " << i << ":\n";
+        children[i]->appendToString(ss, indent + 1);
+    }
+}
+
+QuerySolutionNode* AndBitmapNode::clone() const {
+    AndBitmapNode* copy = new AndBitmapNode();
+    cloneBaseData(copy);
+
+    copy->_sort = this->_sort;
+
+    return copy;
+}
+
+//
+// OrBitmapNode
+//
+
+OrBitmapNode::OrBitmapNode() : _sort(SimpleBSONObjComparator::kInstance.makeBSONObjSet()) {}
+
+OrBitmapNode::~OrBitmapNode() {}
+
+void OrBitmapNode::appendToString(mongoutils::str::stream* ss, int indent) const {
+    addIndent(ss, indent);
+    *ss << "OR_BITMAP\n";
+    addCommon(ss, indent);
+    for (size_t i = 0; i < children.size(); ++i) {
+        addIndent(ss, indent + 1);
+        *ss << "Child " << i << ":\n";
+        children[i]->appendToString(ss, indent + 1);
+    }
+}
+
+QuerySolutionNode* OrBitmapNode::clone() const {
+    OrBitmapNode* copy = new OrBitmapNode();
+    cloneBaseData(copy);
+
+    copy->_sort = this->_sort;
+
+    return copy;
+}
+
 //
 // AndSortedNode
 //
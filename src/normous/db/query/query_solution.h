@@ -371,6 +371,69 @@ struct AndSortedNode : public QuerySolutionNode {
     BSONObjSet _sort;
 };
 
+/**
+ * Intersects the RecordIds of its children in a bitmap. Only RecordIds are output, so the node
+ * must sit below a fetch which evaluates the entire predicate.
+ */
+struct AndBitmapNode : public QuerySolutionNode {
+    AndBitmapNode();
+    virtual ~AndBitmapNode();
+
+    virtual StageType getType() const {
+        return STAGE_AND_BITMAP;
+    }
+
+    virtual void appendToString(mongoutils::str::stream* ss, int indent) const;
+
+    bool fetched() const {
+        return false;
+    }
+    bool hasField(const std::string& field) const {
+        return false;
+    }
+    bool sortedByDiskLoc() const {
+        return true;
+    }
+    const BSONObjSet& getSort() const {
+        return _sort;
+    }
+
+    QuerySolutionNode* clone() const;
+
+    BSONObjSet _sort;
+};
+
+/**
+ * The union counterpart of AndBitmapNode.
+ */
+struct OrBitmapNode : public QuerySolutionNode {
+    OrBitmapNode();
+    virtual ~OrBitmapNode();
+
+    virtual StageType getType() const {
+        return STAGE_OR_BITMAP;
+    }
+
+    virtual void appendToString(mongoutils::str::stream* ss, int indent) const;
+
+    bool fetched() const {
+        return false;
+    }
+    bool hasField(const std::string& field) const {
+        return false;
+    }
+    bool sortedByDiskLoc() const {
+        return true;
+    }
+    const BSONObjSet& getSort() const {
+        return _sort;
+    }
+
+    QuerySolutionNode* clone() const;
+
+    BSONObjSet _sort;
+};
+
 struct OrNode : public QuerySolutionNode {
     OrNode();
     virtual ~OrNode();
@@ -38,6 +38,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/exec/and_hash.h"
 #include "mongo/db/exec/and_sorted.h"
+#include "mongo/db/exec/bitmap_merge.h"
 #include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/count_scan.h"
 #include "mongo/db/exec/distinct_scan.h"
@@ -219,6 +220,22 @@ PlanStage* buildStages(OperationContext* opCtx,
             }
             return ret.release();
         }
+        case STAGE_AND_BITMAP:
+        case STAGE_OR_BITMAP: {
+            const auto mergeType = root->getType() == STAGE_AND_BITMAP
+                ? BitmapMergeStage::MergeType::kIntersection
+                : BitmapMergeStage::MergeType::kUnion;
+            auto ret = make_unique<BitmapMergeStage>(opCtx, ws, mergeType);
+            for (size_t i = 0; i < root->children.size(); ++i) {
+                PlanStage* childStage =
+                    buildStages(opCtx, collection, cq, qsol, root->children[i], ws);
+                if (nullptr == childStage) {
+                    return nullptr;
+                }
+                ret->addChild(childStage);
+            }
+            return ret.release();
+        }
         case STAGE_SORT_MERGE: {
             const MergeSortNode* msn = static_cast<const MergeSortNode*>(root);
             MergeSortStageParams params;
@@ -36,6 +36,11 @@ namespace mongo {
 enum StageType {
     STAGE_AND_HASH,
     STAGE_AND_SORTED,
+
+    // Intersects or unions the RecordIds produced by its children in a compressed bitmap.
+    STAGE_AND_BITMAP,
+    STAGE_OR_BITMAP,
+
     STAGE_CACHED_PLAN,
     STAGE_COLLSCAN,
 
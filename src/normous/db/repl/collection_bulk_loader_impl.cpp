@@ -83,6 +83,7 @@ Status CollectionBulkLoaderImpl::init(const std::vector<BSONObj>& secondaryIndex
             _secondaryIndexesBlock->removeExistingIndexes(&specs);
             if (specs.size()) {
                 _secondaryIndexesBlock->ignoreUniqueConstraint();
+                _secondaryIndexesBlock->streamInserts();
                 auto status = _secondaryIndexesBlock->init(specs).getStatus();
                 if (!status.isOK()) {
                     return status;
@@ -91,6 +92,7 @@ Status CollectionBulkLoaderImpl::init(const std::vector<BSONObj>& secondaryIndex
                 _secondaryIndexesBlock.reset();
             }
             if (!_idIndexSpec.isEmpty()) {
+                _idIndexBlock->streamInserts();
                 auto status = _idIndexBlock->init(_idIndexSpec).getStatus();
                 if (!status.isOK()) {
                     return status;
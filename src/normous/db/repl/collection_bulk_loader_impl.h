@@ -45,6 +45,9 @@ namespace repl {
 /**
  * Class in charge of building a collection during data loading (like initial sync).
  *
+ * The keys of the inserted documents are generated on a thread per index while documents are still
+ * being inserted, so commit() is left to sort the keys and load them into the indexes.
+ *
  * Note: Call commit when done inserting documents.
  */
 class CollectionBulkLoaderImpl : public CollectionBulkLoader {
@@ -32,6 +32,7 @@
 
 #include "mongo/db/repl/collection_cloner.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "mongo/base/string_data.h"
@@ -46,7 +47,9 @@
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/rpc/get_status_from_command_result.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/destructor_guard.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -73,6 +76,30 @@ MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncListIndexesAttempts, int, 3);
 MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncCollectionFindAttempts, int, 3);
 // Whether to use the "exhaust cursor" feature when retrieving collection data.
 MONGO_EXPORT_STARTUP_SERVER_PARAMETER(collectionClonerUsesExhaust, bool, true);
+
+// The most _id ranges a collection is split into to be cloned concurrently, each over its own
+// cursor. A value of 1 clones every collection with a single query.
+MONGO_EXPORT_SERVER_PARAMETER(initialSyncCollectionClonerMaxRanges, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "initialSyncCollectionClonerMaxRanges must be between 1 and 64");
+        }
+        return Status::OK();
+    });
+
+// The fewest documents, going by the count taken before cloning, in each _id range.
+MONGO_EXPORT_SERVER_PARAMETER(initialSyncCollectionClonerMinDocumentsPerRange, int, 100000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "initialSyncCollectionClonerMinDocumentsPerRange must be at least 1");
+        }
+        return Status::OK();
+    });
+
+// The number of _id values sampled on the sync source per range to choose the range bounds.
+const int kSamplesPerRange = 20;
 }  // namespace
 
 // Failpoint which causes initial sync to hang before establishing its cursor to clone the
@@ -264,6 +291,9 @@ void CollectionCloner::_cancelRemainingWork_inlock() {
     if (_queryState == QueryState::kRunning) {
         _queryState = QueryState::kCanceling;
         _clientConnection->shutdownAndDisallowReconnect();
+        for (auto&& conn : _rangeConnections) {
+            conn->shutdownAndDisallowReconnect();
+        }
     } else {
         _queryState = QueryState::kFinished;
     }
@@ -490,6 +520,7 @@ void CollectionCloner::_beginCollectionCallback(const executor::TaskExecutor::Ca
                     stdx::lock_guard<stdx::mutex> lock(_mutex);
                     _queryState = QueryState::kFinished;
                     _clientConnection.reset();
+                    _rangeConnections.clear();
                 }
                 _condition.notify_all();
             });
@@ -550,13 +581,36 @@ void CollectionCloner::_runQuery(const executor::TaskExecutor::CallbackArgs& cal
     auto onCompletionGuard =
         std::make_shared<OnCompletionGuard>(cancelRemainingWorkInLock, finishCallbackFn);
 
+    auto splitPoints = _sampleRangeSplitPoints();
+    if (splitPoints.empty()) {
+        if (!_queryCollection(_clientConnection.get(), Query(), onCompletionGuard, boost::none)) {
+            return;
+        }
+    } else if (!_runRangeQueries(splitPoints, onCompletionGuard)) {
+        return;
+    }
+    waitForDbWorker();
+    stdx::lock_guard<stdx::mutex> lock(_mutex);
+    onCompletionGuard->setResultAndCancelRemainingWork_inlock(lock, Status::OK());
+}
+
+bool CollectionCloner::_queryCollection(DBClientConnection* conn,
+                                        const Query& query,
+                                        std::shared_ptr<OnCompletionGuard> onCompletionGuard,
+                                        boost::optional<size_t> rangeIndex) {
     try {
-        _clientConnection->query(
-            [this, onCompletionGuard](DBClientCursorBatchIterator& iter) {
+        conn->query(
+            [this, onCompletionGuard, rangeIndex](DBClientCursorBatchIterator& iter) {
                 _handleNextBatch(onCompletionGuard, iter);
+                if (rangeIndex) {
+                    stdx::lock_guard<stdx::mutex> lk(_mutex);
+                    auto& range = _stats.ranges[*rangeIndex];
+                    ++range.receivedBatches;
+                    range.documentsFetched += iter.n();
+                }
             },
             NamespaceStringOrUUID(_sourceNss.db().toString(), *_options.uuid),
-            Query(),
+            query,
             nullptr /* fieldsToReturn */,
             QueryOption_NoCursorTimeout | QueryOption_SlaveOk |
                 (collectionClonerUsesExhaust ? QueryOption_Exhaust : 0),
@@ -571,24 +625,168 @@ void CollectionCloner::_runQuery(const executor::TaskExecutor::CallbackArgs& cal
             // cloning.  If so, we'll execute the drop during oplog application, so it's OK to
             // just stop cloning.
             _verifyCollectionWasDropped(lock, queryStatus, onCompletionGuard);
-            return;
+            return false;
         } else if (queryStatus.code() != ErrorCodes::NamespaceNotFound) {
             // NamespaceNotFound means the collection was dropped before we started cloning, so
             // we're OK to ignore the error.  Any other error we must report.
             onCompletionGuard->setResultAndCancelRemainingWork_inlock(lock, queryStatus);
-            return;
+            return false;
         }
     }
-    waitForDbWorker();
-    stdx::lock_guard<stdx::mutex> lock(_mutex);
-    onCompletionGuard->setResultAndCancelRemainingWork_inlock(lock, Status::OK());
+    return true;
+}
+
+std::vector<BSONObj> CollectionCloner::_sampleRangeSplitPoints() {
+    // The ranges are bounded by keys of the _id index, which must therefore exist and order the
+    // _id values as the sampling does. Capped collections must be cloned in their natural order.
+    if (_idIndexSpec.isEmpty() || _options.capped || !_options.collation.isEmpty()) {
+        return {};
+    }
+
+    size_t numRanges = 0;
+    {
+        LockGuard lk(_mutex);
+        numRanges = std::min(
+            static_cast<size_t>(initialSyncCollectionClonerMaxRanges.load()),
+            _stats.documentToCopy /
+                static_cast<size_t>(initialSyncCollectionClonerMinDocumentsPerRange.load()));
+    }
+    if (numRanges < 2) {
+        return {};
+    }
+
+    const int sampleSize = static_cast<int>(numRanges) * kSamplesPerRange;
+    BSONObj result;
+    StatusWith<CursorResponse> response(ErrorCodes::InternalError, "no sampling response");
+    try {
+        _clientConnection->runCommand(
+            _sourceNss.db().toString(),
+            BSON("aggregate" << _sourceNss.coll() << "pipeline"
+                             << BSON_ARRAY(BSON("$sample" << BSON("size" << sampleSize))
+                                           << BSON("$project" << BSON("_id" << 1))
+                                           << BSON("$sort" << BSON("_id" << 1)))
+                             << "cursor"
+                             << BSON("batchSize" << sampleSize)),
+            result,
+            QueryOption_SlaveOk);
+        response = CursorResponse::parseFromBSON(result);
+    } catch (const DBException& e) {
+        // A network error, including the connection being shut down by a cancellation, is
+        // reported by the single query that follows.
+        response = e.toStatus();
+    }
+    if (!response.isOK()) {
+        log() << "CollectionCloner ns: '" << _sourceNss.ns()
+              << "' will be cloned with a single query because sampling its _id values failed: "
+              << response.getStatus();
+        return {};
+    }
+
+    // Take evenly spaced values of the sorted sample as the bounds between ranges.
+    const auto& samples = response.getValue().getBatch();
+    std::vector<BSONObj> splitPoints;
+    for (size_t i = 1; i < numRanges && !samples.empty(); ++i) {
+        BSONElement id = samples[i * samples.size() / numRanges]["_id"];
+        if (id.eoo()) {
+            continue;
+        }
+        BSONObj splitPoint = id.wrap();
+        if (!splitPoints.empty() && splitPoints.back().woCompare(splitPoint) >= 0) {
+            continue;
+        }
+        splitPoints.push_back(splitPoint);
+    }
+    return splitPoints;
+}
+
+bool CollectionCloner::_runRangeQueries(const std::vector<BSONObj>& splitPoints,
+                                        std::shared_ptr<OnCompletionGuard> onCompletionGuard) {
+    const size_t numRanges = splitPoints.size() + 1;
+    std::vector<Query> queries;
+    std::vector<DBClientConnection*> connections;
+    {
+        LockGuard lk(_mutex);
+        if (_queryState != QueryState::kRunning) {
+            // Connections made from here on would not be shut down by the cancellation.
+            onCompletionGuard->setResultAndCancelRemainingWork_inlock(
+                lk, {ErrorCodes::CallbackCanceled, "Collection cloning cancelled."});
+            return false;
+        }
+
+        for (size_t i = 0; i < numRanges; ++i) {
+            RangeStats range;
+            Query query;
+            query.hint(BSON("_id" << 1));
+            if (i > 0) {
+                range.min = splitPoints[i - 1];
+                query.minKey(range.min);
+            }
+            if (i < splitPoints.size()) {
+                range.max = splitPoints[i];
+                query.maxKey(range.max);
+            }
+            _stats.ranges.push_back(range);
+            queries.push_back(query);
+
+            if (i == 0) {
+                connections.push_back(_clientConnection.get());
+            } else {
+                _rangeConnections.push_back(_createClientFn());
+                connections.push_back(_rangeConnections.back().get());
+            }
+        }
+    }
+    log() << "CollectionCloner ns: '" << _sourceNss.ns() << "' will be cloned in " << numRanges
+          << " _id ranges";
+
+    auto cloneRange = [&](size_t i) {
+        DBClientConnection* conn = connections[i];
+        if (i > 0) {
+            Status status = conn->connect(_source, StringData());
+            try {
+                if (status.isOK() && !replAuthenticate(conn)) {
+                    status = {ErrorCodes::AuthenticationFailed,
+                              str::stream() << "Failed to authenticate to " << _source};
+                }
+            } catch (const DBException& e) {
+                status = e.toStatus();
+            }
+            if (!status.isOK()) {
+                LockGuard lk(_mutex);
+                onCompletionGuard->setResultAndCancelRemainingWork_inlock(lk, status);
+                return false;
+            }
+        }
+        if (!_queryCollection(conn, queries[i], onCompletionGuard, i)) {
+            return false;
+        }
+        LockGuard lk(_mutex);
+        _stats.ranges[i].done = true;
+        return true;
+    };
+
+    // The first range is cloned on this thread, and each other range on a thread of its own.
+    std::vector<char> succeeded(numRanges, false);
+    std::vector<stdx::thread> threads;
+    for (size_t i = 1; i < numRanges; ++i) {
+        threads.emplace_back([&, i] {
+            setThreadName(str::stream() << "CollectionClonerRange-" << i);
+            succeeded[i] = cloneRange(i);
+        });
+    }
+    succeeded[0] = cloneRange(0);
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    return std::all_of(succeeded.begin(), succeeded.end(), [](char ok) { return ok; });
 }
 
 void CollectionCloner::_handleNextBatch(std::shared_ptr<OnCompletionGuard> onCompletionGuard,
                                         DBClientCursorBatchIterator& iter) {
-    _stats.receivedBatches++;
     {
         stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _stats.receivedBatches++;
         uassert(ErrorCodes::CallbackCanceled,
                 "Collection cloning cancelled.",
                 _queryState != QueryState::kCanceling);
@@ -802,6 +1000,25 @@ void CollectionCloner::Stats::append(BSONObjBuilder* builder) const {
         }
     }
     builder->appendNumber("receivedBatches", receivedBatches);
+    if (!ranges.empty()) {
+        BSONArrayBuilder rangesBuilder(builder->subarrayStart("ranges"));
+        for (auto&& range : ranges) {
+            BSONObjBuilder rangeBuilder(rangesBuilder.subobjStart());
+            range.append(&rangeBuilder);
+        }
+    }
+}
+
+void CollectionCloner::RangeStats::append(BSONObjBuilder* builder) const {
+    if (!min.isEmpty()) {
+        builder->appendAs(min.firstElement(), "min");
+    }
+    if (!max.isEmpty()) {
+        builder->appendAs(max.firstElement(), "max");
+    }
+    builder->appendNumber("documentsFetched", documentsFetched);
+    builder->appendNumber("receivedBatches", receivedBatches);
+    builder->appendBool("done", done);
 }
 }  // namespace repl
 }  // namespace mongo
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 #include <string>
 #include <vector>
@@ -69,6 +70,19 @@ public:
     using RemoteCommandCallbackArgs = executor::TaskExecutor::RemoteCommandCallbackArgs;
     using OnCompletionGuard = CallbackCompletionGuard<Status>;
 
+    /**
+     * Progress of cloning one of the _id ranges a large collection is split into.
+     */
+    struct RangeStats {
+        BSONObj min;  // The inclusive lower bound as {_id: <value>}, or empty for the first range.
+        BSONObj max;  // The exclusive upper bound as {_id: <value>}, or empty for the last range.
+        size_t documentsFetched{0};
+        size_t receivedBatches{0};
+        bool done{false};
+
+        void append(BSONObjBuilder* builder) const;
+    };
+
     struct Stats {
         static constexpr StringData kDocumentsToCopyFieldName = "documentsToCopy"_sd;
         static constexpr StringData kDocumentsCopiedFieldName = "documentsCopied"_sd;
@@ -81,6 +95,7 @@ public:
         size_t indexes{0};
         size_t fetchedBatches{0};  // This is actually inserted batches.
         size_t receivedBatches{0};
+        std::vector<RangeStats> ranges;  // Empty unless the collection is cloned in ranges.
 
         std::string toString() const;
         BSONObj toBSON() const;
@@ -217,6 +232,30 @@ private:
      */
     void _runQuery(const executor::TaskExecutor::CallbackArgs& callbackData);
 
+    /**
+     * Runs 'query' over 'conn', handing each batch to _handleNextBatch(). If 'rangeIndex' is set,
+     * the progress of that range is recorded in '_stats'. Returns false if the query failed in a
+     * way that ends the clone, in which case the result has been set on 'onCompletionGuard'.
+     */
+    bool _queryCollection(DBClientConnection* conn,
+                          const Query& query,
+                          std::shared_ptr<OnCompletionGuard> onCompletionGuard,
+                          boost::optional<size_t> rangeIndex);
+
+    /**
+     * Returns the _id values at which to split the collection into ranges to be cloned
+     * concurrently, sampled on the sync source over '_clientConnection'. Returns an empty vector
+     * if the collection should be cloned with a single query.
+     */
+    std::vector<BSONObj> _sampleRangeSplitPoints();
+
+    /**
+     * Clones the ranges delimited by 'splitPoints' concurrently, each over its own cursor and
+     * connection. Returns false if any range failed in a way that ends the clone.
+     */
+    bool _runRangeQueries(const std::vector<BSONObj>& splitPoints,
+                          std::shared_ptr<OnCompletionGuard> onCompletionGuard);
+
     /**
      * Put all results from a query batch into a buffer to be inserted, and schedule
      * it to be inserted.
@@ -297,6 +336,10 @@ private:
     // (M) Client connection used for query.
     std::unique_ptr<DBClientConnection> _clientConnection;
 
+    // (M) Client connections used for the ranges after the first when the collection is cloned in
+    // ranges. The first range uses '_clientConnection'.
+    std::vector<std::unique_ptr<DBClientConnection>> _rangeConnections;
+
     // State transitions:
     // PreStart --> Running --> ShuttingDown --> Complete
     // It is possible to skip intermediate states. For example,
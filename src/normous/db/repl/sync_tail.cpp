@@ -35,14 +35,17 @@
 #include "third_party/murmurhash3/MurmurHash3.h"
 #include <boost/functional/hash.hpp>
 #include <memory>
+#include <queue>
 
 #include "mongo/base/counter.h"
 #include "mongo/bson/bsonelement_comparator.h"
 #include "mongo/bson/timestamp.h"
+#include "mongo/db/bson/dotted_path_support.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/document_validation.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/catalog/uuid_catalog.h"
 #include "mongo/db/catalog_raii.h"
 #include "mongo/db/client.h"
@@ -67,6 +70,7 @@
 #include "mongo/db/repl/repl_set_config.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/session_update_tracker.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/session.h"
 #include "mongo/db/session_txn_record_gen.h"
@@ -74,6 +78,7 @@
 #include "mongo/db/storage/recovery_unit.h"
 #include "mongo/db/transaction_participant.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/unordered_map.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -100,6 +105,42 @@ ServerStatusMetricField<Counter64> displayAttemptsToBecomeSecondary(
 TimerStats applyBatchStats;
 ServerStatusMetricField<TimerStats> displayOpBatchesApplied("repl.apply.batches", &applyBatchStats);
 
+// Number of batches and time between the wall clock time of the last operation in each batch and
+// the batch being applied.
+TimerStats applyLagStats;
+ServerStatusMetricField<TimerStats> displayApplyLag("repl.apply.lag", &applyLagStats);
+
+// Batches assigned to writer threads with a dependency graph, and how parallel they were. The
+// ratio of ops to busiestWriterOps is the speedup over applying the batches on a single thread.
+Counter64 dependencyGraphBatches;
+ServerStatusMetricField<Counter64> displayDependencyGraphBatches(
+    "repl.apply.dependencyGraph.batches", &dependencyGraphBatches);
+Counter64 dependencyGraphOps;
+ServerStatusMetricField<Counter64> displayDependencyGraphOps("repl.apply.dependencyGraph.ops",
+                                                             &dependencyGraphOps);
+Counter64 dependencyGraphGroups;
+ServerStatusMetricField<Counter64> displayDependencyGraphGroups(
+    "repl.apply.dependencyGraph.independentGroups", &dependencyGraphGroups);
+Counter64 dependencyGraphLargestGroupOps;
+ServerStatusMetricField<Counter64> displayDependencyGraphLargestGroupOps(
+    "repl.apply.dependencyGraph.largestGroupOps", &dependencyGraphLargestGroupOps);
+Counter64 dependencyGraphBusiestWriterOps;
+ServerStatusMetricField<Counter64> displayDependencyGraphBusiestWriterOps(
+    "repl.apply.dependencyGraph.busiestWriterOps", &dependencyGraphBusiestWriterOps);
+
+// Whether the operations of each batch are assigned to writer threads by building a graph of the
+// documents and unique index keys they depend on, rather than by hashing each operation on its own.
+MONGO_EXPORT_SERVER_PARAMETER(replApplierDependencyScheduling, bool, false);
+
+// Whether steady state replication writes the next batch into the oplog and assigns its operations
+// to writer threads while the current batch is being applied. At most one batch is prepared ahead.
+MONGO_EXPORT_SERVER_PARAMETER(replApplierPipelineBatches, bool, false);
+
+// Number of batches prepared while the previous batch was being applied.
+Counter64 pipelinedBatches;
+ServerStatusMetricField<Counter64> displayPipelinedBatches("repl.apply.pipelinedBatches",
+                                                           &pipelinedBatches);
+
 class ApplyBatchFinalizer {
 public:
     ApplyBatchFinalizer(ReplicationCoordinator* replCoord) : _replCoord(replCoord) {}
@@ -446,17 +487,25 @@ public:
     struct CollectionProperties {
         bool isCapped = false;
         const CollatorInterface* collator = nullptr;
+
+        // Key patterns of the unique indexes other than the _id index, leaving out sparse and
+        // partial ones, which most documents may be missing from. Only filled in for batches
+        // scheduled with a dependency graph.
+        std::vector<BSONObj> uniqueKeyPatterns;
     };
 
-    CollectionProperties getCollectionProperties(OperationContext* opCtx,
-                                                 const StringMapTraits::HashedKey& ns) {
+    explicit CachedCollectionProperties(bool withUniqueKeyPatterns)
+        : _withUniqueKeyPatterns(withUniqueKeyPatterns) {}
+
+    const CollectionProperties& getCollectionProperties(OperationContext* opCtx,
+                                                        const StringMapTraits::HashedKey& ns) {
         auto it = _cache.find(ns);
         if (it != _cache.end()) {
             return it->second;
         }
 
-        auto collProperties = getCollectionPropertiesImpl(opCtx, ns.key());
-        _cache[ns] = collProperties;
+        auto& collProperties = _cache[ns];
+        collProperties = getCollectionPropertiesImpl(opCtx, ns.key());
         return collProperties;
     }
 
@@ -477,12 +526,155 @@ private:
 
         collProperties.isCapped = collection->isCapped();
         collProperties.collator = collection->getDefaultCollator();
+        if (_withUniqueKeyPatterns) {
+            auto it = collection->getIndexCatalog()->getIndexIterator(opCtx, true);
+            while (it.more()) {
+                const IndexDescriptor* desc = it.next();
+                if (desc->unique() && !desc->isIdIndex() && !desc->isSparse() &&
+                    !desc->isPartial()) {
+                    collProperties.uniqueKeyPatterns.push_back(desc->keyPattern().getOwned());
+                }
+            }
+        }
         return collProperties;
     }
 
+    const bool _withUniqueKeyPatterns;
     StringMap<CollectionProperties> _cache;
 };
 
+/**
+ * Assigns the operations of a batch to writer threads so that operations which depend on each
+ * other go to the same writer, in oplog order, while independent groups of operations are spread
+ * over all of the writers to even out the number of operations each one applies.
+ *
+ * Each operation is added with the hashes of the keys it touches: the document it modifies, the
+ * unique index keys it inserts, or its whole collection when its operations must be applied in
+ * order. Operations sharing a key, directly or through other operations, form a group.
+ */
+class DependencyGraphScheduler {
+public:
+    void add(OplogEntry* op, const std::vector<uint32_t>& keys) {
+        const size_t index = _ops.size();
+        _ops.push_back(op);
+        _parents.push_back(index);
+        for (auto key : keys) {
+            auto inserted = _opByKey.emplace(key, index);
+            if (!inserted.second) {
+                _union(inserted.first->second, index);
+            }
+        }
+    }
+
+    /**
+     * Hands each group, largest first, to the writer with the fewest operations so far.
+     */
+    void assign(std::vector<MultiApplier::OperationPtrs>* writerVectors) {
+        const size_t kNoGroup = std::numeric_limits<size_t>::max();
+        std::vector<size_t> groupByRoot(_ops.size(), kNoGroup);
+        std::vector<MultiApplier::OperationPtrs> groups;
+        for (size_t i = 0; i < _ops.size(); ++i) {
+            auto& group = groupByRoot[_find(i)];
+            if (group == kNoGroup) {
+                group = groups.size();
+                groups.emplace_back();
+            }
+            groups[group].push_back(_ops[i]);
+        }
+
+        std::stable_sort(groups.begin(),
+                         groups.end(),
+                         [](const MultiApplier::OperationPtrs& lhs,
+                            const MultiApplier::OperationPtrs& rhs) {
+                             return lhs.size() > rhs.size();
+                         });
+
+        using WriterLoad = std::pair<size_t, size_t>;  // (number of operations, writer)
+        std::priority_queue<WriterLoad, std::vector<WriterLoad>, std::greater<WriterLoad>> writers;
+        for (size_t i = 0; i < writerVectors->size(); ++i) {
+            writers.emplace((*writerVectors)[i].size(), i);
+        }
+        size_t busiestWriterOps = 0;
+        for (auto&& group : groups) {
+            auto writer = writers.top();
+            writers.pop();
+            auto& writerOps = (*writerVectors)[writer.second];
+            writerOps.insert(writerOps.end(), group.begin(), group.end());
+            writer.first += group.size();
+            busiestWriterOps = std::max(busiestWriterOps, writer.first);
+            writers.push(writer);
+        }
+
+        dependencyGraphBatches.increment();
+        dependencyGraphOps.increment(_ops.size());
+        dependencyGraphGroups.increment(groups.size());
+        dependencyGraphLargestGroupOps.increment(groups.empty() ? 0 : groups.front().size());
+        dependencyGraphBusiestWriterOps.increment(busiestWriterOps);
+    }
+
+private:
+    size_t _find(size_t i) {
+        while (_parents[i] != i) {
+            _parents[i] = _parents[_parents[i]];
+            i = _parents[i];
+        }
+        return i;
+    }
+
+    void _union(size_t lhs, size_t rhs) {
+        lhs = _find(lhs);
+        rhs = _find(rhs);
+        if (lhs != rhs) {
+            // Keep the earliest operation as the root, so that groups are numbered in oplog order.
+            _parents[std::max(lhs, rhs)] = std::min(lhs, rhs);
+        }
+    }
+
+    std::vector<OplogEntry*> _ops;
+    std::vector<size_t> _parents;
+    stdx::unordered_map<uint32_t, size_t> _opByKey;
+};
+
+/**
+ * Returns the hashes of the values that 'op', an insert or a replacement-style update, gives the
+ * fields of each of 'uniqueKeyPatterns', seeded with 'nsHash'. Key patterns for which 'op' is
+ * missing a field, or has an array, are skipped: every such document would hash alike, so all of
+ * them would be kept in one group even though their index keys differ.
+ *
+ * Secondaries apply operations with unique constraints relaxed, so these keys are not needed to
+ * apply a batch correctly; they keep documents that claim the same unique key in oplog order.
+ */
+void hashUniqueIndexKeys(const OplogEntry& op,
+                         uint32_t nsHash,
+                         const std::vector<BSONObj>& uniqueKeyPatterns,
+                         const CollatorInterface* collator,
+                         std::vector<uint32_t>* keys) {
+    const BSONObj& doc = op.getObject();
+    if (op.getOpType() != OpTypeEnum::kInsert &&
+        (op.getOpType() != OpTypeEnum::kUpdate || doc.firstElementFieldName()[0] == '$')) {
+        return;
+    }
+
+    BSONElementComparator elementHasher(BSONElementComparator::FieldNamesMode::kIgnore, collator);
+    for (size_t i = 0; i < uniqueKeyPatterns.size(); ++i) {
+        uint32_t hash = nsHash;
+        MurmurHash3_x86_32(&i, sizeof(i), hash, &hash);
+        bool hashable = true;
+        for (auto&& field : uniqueKeyPatterns[i]) {
+            BSONElement value = dotted_path_support::extractElementAtPath(doc, field.fieldName());
+            if (value.eoo() || value.type() == BSONType::Array) {
+                hashable = false;
+                break;
+            }
+            const size_t valueHash = elementHasher.hash(value);
+            MurmurHash3_x86_32(&valueHash, sizeof(valueHash), hash, &hash);
+        }
+        if (hashable) {
+            keys->push_back(hash);
+        }
+    }
+}
+
 /**
  * ops - This only modifies the isForCappedCollection field on each op. It does not alter the ops
  *      vector in any other way.
@@ -490,35 +682,42 @@ private:
  * derivedOps - If provided, this function inserts a decomposition of applyOps operations
  *      and instructions for updating the transactions table.
  * sessionUpdateTracker - if provided, keeps track of session info from ops.
+ * scheduler - if provided, ops are added to it rather than to writerVectors, along with the keys
+ *      they depend on.
  */
 void fillWriterVectors(OperationContext* opCtx,
                        MultiApplier::Operations* ops,
                        std::vector<MultiApplier::OperationPtrs>* writerVectors,
                        std::vector<MultiApplier::Operations>* derivedOps,
-                       SessionUpdateTracker* sessionUpdateTracker) {
+                       SessionUpdateTracker* sessionUpdateTracker,
+                       DependencyGraphScheduler* scheduler) {
     const auto serviceContext = opCtx->getServiceContext();
     const auto storageEngine = serviceContext->getStorageEngine();
 
     const bool supportsDocLocking = storageEngine->supportsDocLocking();
     const uint32_t numWriters = writerVectors->size();
 
-    CachedCollectionProperties collPropertiesCache;
+    CachedCollectionProperties collPropertiesCache(scheduler != nullptr);
+    std::vector<uint32_t> keys;
 
     for (auto&& op : *ops) {
         StringMapTraits::HashedKey hashedNs(op.getNss().ns());
         uint32_t hash = hashedNs.hash();
+        keys.clear();
 
         // We need to track all types of ops, including type 'n' (these are generated from chunk
         // migrations).
         if (sessionUpdateTracker) {
             if (auto newOplogWrites = sessionUpdateTracker->updateOrFlush(op)) {
                 derivedOps->emplace_back(std::move(*newOplogWrites));
-                fillWriterVectors(opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+                fillWriterVectors(
+                    opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr, scheduler);
             }
         }
 
         if (op.isCrudOpType()) {
-            auto collProperties = collPropertiesCache.getCollectionProperties(opCtx, hashedNs);
+            const auto& collProperties =
+                collPropertiesCache.getCollectionProperties(opCtx, hashedNs);
 
             // For doc locking engines, include the _id of the document in the hash so we get
             // parallelism even if all writes are to a single collection.
@@ -538,6 +737,14 @@ void fillWriterVectors(OperationContext* opCtx,
                 // bulk insert them.
                 op.isForCappedCollection = true;
             }
+
+            if (scheduler && !collProperties.isCapped) {
+                hashUniqueIndexKeys(op,
+                                    hashedNs.hash(),
+                                    collProperties.uniqueKeyPatterns,
+                                    collProperties.collator,
+                                    &keys);
+            }
         }
 
         // Extract applyOps operations and fill writers with extracted operations using this
@@ -547,7 +754,8 @@ void fillWriterVectors(OperationContext* opCtx,
                 derivedOps->emplace_back(ApplyOps::extractOperations(op));
 
                 // Nested entries cannot have different session updates.
-                fillWriterVectors(opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+                fillWriterVectors(
+                    opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr, scheduler);
             } catch (...) {
                 fassertFailedWithStatusNoTrace(
                     50711,
@@ -558,6 +766,12 @@ void fillWriterVectors(OperationContext* opCtx,
             continue;
         }
 
+        if (scheduler) {
+            keys.push_back(hash);
+            scheduler->add(&op, keys);
+            continue;
+        }
+
         auto& writer = (*writerVectors)[hash % numWriters];
         if (writer.empty()) {
             writer.reserve(8);  // Skip a few growth rounds
@@ -570,13 +784,24 @@ void fillWriterVectors(OperationContext* opCtx,
                        MultiApplier::Operations* ops,
                        std::vector<MultiApplier::OperationPtrs>* writerVectors,
                        std::vector<MultiApplier::Operations>* derivedOps) {
+    boost::optional<DependencyGraphScheduler> scheduler;
+    if (replApplierDependencyScheduling.load()) {
+        scheduler.emplace();
+    }
+
     SessionUpdateTracker sessionUpdateTracker;
-    fillWriterVectors(opCtx, ops, writerVectors, derivedOps, &sessionUpdateTracker);
+    fillWriterVectors(
+        opCtx, ops, writerVectors, derivedOps, &sessionUpdateTracker, scheduler.get_ptr());
 
     auto newOplogWrites = sessionUpdateTracker.flushAll();
     if (!newOplogWrites.empty()) {
         derivedOps->emplace_back(std::move(newOplogWrites));
-        fillWriterVectors(opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+        fillWriterVectors(
+            opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr, scheduler.get_ptr());
+    }
+
+    if (scheduler) {
+        scheduler->assign(writerVectors);
     }
 }
 
@@ -751,6 +976,13 @@ void SyncTail::_oplogApplication(OplogBuffer* oplogBuffer,
     // Get replication consistency markers.
     OpTime minValid;
 
+    // The next batch to apply, if it was taken from the batcher and prepared while the previous
+    // batch was being applied.
+    std::unique_ptr<PreparedBatch> nextBatch;
+
+    // Set if the batcher signaled shutdown while the previous batch was being applied.
+    bool batcherShutDown = false;
+
     while (true) {  // Exits on message from OpQueueBatcher.
         // Use a new operation context each iteration, as otherwise we may appear to use a single
         // collection name to refer to collections with different UUIDs.
@@ -778,26 +1010,35 @@ void SyncTail::_oplogApplication(OplogBuffer* oplogBuffer,
         // Transition to SECONDARY state, if possible.
         tryToGoLiveAsASecondary(&opCtx, replCoord, minValid);
 
-        long long termWhenBufferIsEmpty = replCoord->getTerm();
-        // Blocks up to a second waiting for a batch to be ready to apply. If one doesn't become
-        // ready in time, we'll loop again so we can do the above checks periodically.
-        OpQueue ops = batcher->getNextBatch(Seconds(1));
-        if (ops.empty()) {
-            if (ops.mustShutdown()) {
+        std::unique_ptr<PreparedBatch> batch = std::move(nextBatch);
+        if (!batch) {
+            if (batcherShutDown) {
                 // Shut down and exit oplog application loop.
                 return;
             }
-            if (MONGO_FAIL_POINT(rsSyncApplyStop)) {
-                continue;
+
+            long long termWhenBufferIsEmpty = replCoord->getTerm();
+            // Blocks up to a second waiting for a batch to be ready to apply. If one doesn't become
+            // ready in time, we'll loop again so we can do the above checks periodically.
+            OpQueue ops = batcher->getNextBatch(Seconds(1));
+            if (ops.empty()) {
+                if (ops.mustShutdown()) {
+                    // Shut down and exit oplog application loop.
+                    return;
+                }
+                if (MONGO_FAIL_POINT(rsSyncApplyStop)) {
+                    continue;
+                }
+                // Signal drain complete if we're in Draining state and the buffer is empty.
+                replCoord->signalDrainComplete(&opCtx, termWhenBufferIsEmpty);
+                continue;  // Try again.
             }
-            // Signal drain complete if we're in Draining state and the buffer is empty.
-            replCoord->signalDrainComplete(&opCtx, termWhenBufferIsEmpty);
-            continue;  // Try again.
+            batch = stdx::make_unique<PreparedBatch>(ops.releaseBatch());
         }
 
-        // Extract some info from ops that we'll need after releasing the batch below.
-        const auto firstOpTimeInBatch = ops.front().getOpTime();
-        const auto lastOpTimeInBatch = ops.back().getOpTime();
+        // Extract some info from ops that we'll need after applying the batch below.
+        const auto firstOpTimeInBatch = batch->ops.front().getOpTime();
+        const auto lastOpTimeInBatch = batch->ops.back().getOpTime();
         const auto lastAppliedOpTimeAtStartOfBatch = replCoord->getMyLastAppliedOpTime();
 
         // Make sure the oplog doesn't go back in time or repeat an entry.
@@ -814,10 +1055,31 @@ void SyncTail::_oplogApplication(OplogBuffer* oplogBuffer,
         // Don't allow the fsync+lock thread to see intermediate states of batch application.
         stdx::lock_guard<SimpleMutex> fsynclk(filesLockedFsync);
 
-        // Apply the operations in this batch. 'multiApply' returns the optime of the last op that
+        // While this batch is being applied, the next one may be written into the oplog past the
+        // oplog truncate-after point and assigned to writer threads, but 'minValid' is only moved
+        // to its end once it is about to be applied itself. This is only done after batches of
+        // CRUD operations, which do not change the collection properties the assignment reads.
+        stdx::function<void(OperationContext*)> prepareNextBatch;
+        if (replApplierPipelineBatches.load() &&
+            std::none_of(batch->ops.begin(), batch->ops.end(), [](const OplogEntry& op) {
+                return op.isCommand();
+            })) {
+            prepareNextBatch = [&](OperationContext* applierOpCtx) {
+                OpQueue ops = batcher->getNextBatch(Seconds(0));
+                if (ops.empty()) {
+                    batcherShutDown = ops.mustShutdown();
+                    return;
+                }
+                nextBatch = stdx::make_unique<PreparedBatch>(ops.releaseBatch());
+                _prepareBatch(applierOpCtx, nextBatch.get());
+                pipelinedBatches.increment();
+            };
+        }
+
+        // Apply the operations in this batch. '_multiApply' returns the optime of the last op that
         // was applied, which should be the last optime in the batch.
         auto lastOpTimeAppliedInBatch =
-            fassertNoTrace(34437, multiApply(&opCtx, ops.releaseBatch()));
+            fassertNoTrace(34437, _multiApply(&opCtx, batch.get(), prepareNextBatch));
         invariant(lastOpTimeAppliedInBatch == lastOpTimeInBatch);
 
         // In order to provide resilience in the event of a crash in the middle of batch
@@ -1218,7 +1480,29 @@ Status multiSyncApply(OperationContext* opCtx,
 
 StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::Operations ops) {
     invariant(!ops.empty());
+    PreparedBatch batch(std::move(ops));
+    return _multiApply(opCtx, &batch, {});
+}
+
+void SyncTail::_prepareBatch(OperationContext* opCtx, PreparedBatch* batch) {
+    invariant(!batch->prepared);
+
+    // Write batch of ops into oplog.
+    if (!_options.skipWritesToOplog) {
+        _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, batch->ops.front().getTimestamp());
+        scheduleWritesToOplog(opCtx, _storageInterface, _writerPool, batch->ops);
+    }
+
+    batch->writerVectors.resize(_writerPool->getStats().numThreads);
+    fillWriterVectors(opCtx, &batch->ops, &batch->writerVectors, &batch->derivedOps);
+    batch->prepared = true;
+}
 
+StatusWith<OpTime> SyncTail::_multiApply(
+    OperationContext* opCtx,
+    PreparedBatch* batch,
+    const stdx::function<void(OperationContext*)>& whileApplying) {
+    const MultiApplier::Operations& ops = batch->ops;
     LOG(2) << "replication batch size is " << ops.size();
     // Stop all readers until we're done. This also prevents doc-locking engines from deleting old
     // entries from the oplog until we finish writing.
@@ -1266,24 +1550,12 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
             }
         });
 
-        // Write batch of ops into oplog.
-        if (!_options.skipWritesToOplog) {
-            _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, ops.front().getTimestamp());
-            scheduleWritesToOplog(opCtx, _storageInterface, _writerPool, ops);
+        // Unless the batch was prepared while the previous batch was being applied, write it into
+        // the oplog and assign its operations to the writer threads now.
+        if (!batch->prepared) {
+            _prepareBatch(opCtx, batch);
         }
 
-        // Holds 'pseudo operations' generated by secondaries to aid in replication.
-        // Keep in scope until all operations in 'ops' and 'derivedOps' have been applied.
-        // Pseudo operations include:
-        // - applyOps operations expanded to individual ops.
-        // - ops to update config.transactions. Normal writes to config.transactions in the
-        //   primary don't create an oplog entry, so extract info from writes with transactions
-        //   and create a pseudo oplog.
-        std::vector<MultiApplier::Operations> derivedOps;
-
-        std::vector<MultiApplier::OperationPtrs> writerVectors(_writerPool->getStats().numThreads);
-        fillWriterVectors(opCtx, &ops, &writerVectors, &derivedOps);
-
         // Wait for writes to finish before applying ops.
         _writerPool->waitForIdle();
 
@@ -1295,7 +1567,17 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
 
         {
             std::vector<Status> statusVector(_writerPool->getStats().numThreads, Status::OK());
-            applyOps(writerVectors, _writerPool, _applyFunc, this, &statusVector, &multikeyVector);
+            applyOps(batch->writerVectors,
+                     _writerPool,
+                     _applyFunc,
+                     this,
+                     &statusVector,
+                     &multikeyVector);
+
+            // Let the caller get the next batch going while the writer threads apply this one.
+            if (whileApplying) {
+                whileApplying(opCtx);
+            }
             _writerPool->waitForIdle();
 
             // If any of the statuses is not ok, return error.
@@ -1320,6 +1602,13 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
     const auto storageEngine = opCtx->getServiceContext()->getStorageEngine();
     storageEngine->replicationBatchIsComplete();
 
+    // Record how long after the last operation in the batch was written on the primary the batch
+    // was applied here.
+    if (auto wallClockTime = ops.back().getWallClockTime()) {
+        applyLagStats.recordMillis(
+            static_cast<int>(durationCount<Milliseconds>(Date_t::now() - *wallClockTime)));
+    }
+
     // Use this fail point to hold the PBWM lock and prevent the batch from completing.
     if (MONGO_FAIL_POINT(pauseBatchApplicationBeforeCompletion)) {
         log() << "pauseBatchApplicationBeforeCompletion fail point enabled. Blocking until fail "
@@ -236,6 +236,46 @@ public:
     StatusWith<OpTime> multiApply(OperationContext* opCtx, MultiApplier::Operations ops);
 
 private:
+    /**
+     * A batch of operations, along with the work that must be done before the batch can be
+     * applied: writing it into the oplog and assigning its operations to writer threads.
+     */
+    struct PreparedBatch {
+        explicit PreparedBatch(MultiApplier::Operations batchOps) : ops(std::move(batchOps)) {}
+
+        MultiApplier::Operations ops;
+
+        // Holds 'pseudo operations' generated by secondaries to aid in replication.
+        // Keep in scope until all operations in 'ops' and 'derivedOps' have been applied.
+        // Pseudo operations include:
+        // - applyOps operations expanded to individual ops.
+        // - ops to update config.transactions. Normal writes to config.transactions in the
+        //   primary don't create an oplog entry, so extract info from writes with transactions
+        //   and create a pseudo oplog.
+        std::vector<MultiApplier::Operations> derivedOps;
+
+        std::vector<MultiApplier::OperationPtrs> writerVectors;
+
+        // Set by _prepareBatch().
+        bool prepared = false;
+    };
+
+    /**
+     * Sets the oplog truncate-after point to the start of 'batch', schedules the writes of its
+     * operations to the oplog on the writer threads, and fills its writer vectors. Does not wait
+     * for the oplog writes to finish.
+     */
+    void _prepareBatch(OperationContext* opCtx, PreparedBatch* batch);
+
+    /**
+     * Applies 'batch' as multiApply() does, preparing it first if need be. Once the writer threads
+     * have been handed the operations of 'batch', calls 'whileApplying', if set, before waiting for
+     * them to finish.
+     */
+    StatusWith<OpTime> _multiApply(OperationContext* opCtx,
+                                   PreparedBatch* batch,
+                                   const stdx::function<void(OperationContext*)>& whileApplying);
+
     /**
      * Pops the operation at the front of the OplogBuffer.
      * Updates stats on BackgroundSync.
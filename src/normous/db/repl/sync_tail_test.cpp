@@ -61,6 +61,7 @@
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/db/repl/sync_tail.h"
 #include "mongo/db/service_context_d_test_fixture.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/session_catalog_mongod.h"
 #include "mongo/db/session_txn_record_gen.h"
 #include "mongo/stdx/mutex.h"
@@ -523,6 +524,207 @@ TEST_F(SyncTailTest, MultiApplyAssignsOperationsToWriterThreadsBasedOnNamespaceH
     ASSERT_EQUALS(op2, lastEntry);
 }
 
+TEST_F(SyncTailTest, MultiApplyWithDependencySchedulingSpreadsIndependentOperationsEvenly) {
+    auto dependencyScheduling =
+        ServerParameterSet::getGlobal()->getMap().find("replApplierDependencyScheduling")->second;
+    ASSERT_OK(dependencyScheduling->setFromString("true"));
+    ON_BLOCK_EXIT([&] { dependencyScheduling->setFromString("false").ignore(); });
+
+    const size_t numWriters = 4;
+    auto writerPool = OplogApplier::makeWriterPool(numWriters);
+
+    stdx::mutex mutex;
+    std::vector<MultiApplier::Operations> operationsApplied;
+    auto applyOperationFn =
+        [&mutex, &operationsApplied](OperationContext* opCtx,
+                                     MultiApplier::OperationPtrs* operationsForWriterThreadToApply,
+                                     SyncTail* st,
+                                     WorkerMultikeyPathInfo*) -> Status {
+        stdx::lock_guard<stdx::mutex> lock(mutex);
+        operationsApplied.emplace_back();
+        for (auto&& opPtr : *operationsForWriterThreadToApply) {
+            operationsApplied.back().push_back(*opPtr);
+        }
+        return Status::OK();
+    };
+
+    // Three operations on each of four collections. Whether the operations on a collection depend
+    // on each other or only on their own documents, every writer gets the same share of them.
+    MultiApplier::Operations ops;
+    for (int i = 0; i < 12; ++i) {
+        NamespaceString nss("test.t" + std::to_string(i % numWriters));
+        ops.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(i + 1), 0), 1LL}, nss, BSON("_id" << i)));
+    }
+
+    SyncTail syncTail(nullptr,
+                      getConsistencyMarkers(),
+                      getStorageInterface(),
+                      applyOperationFn,
+                      writerPool.get());
+    auto lastOpTime = unittest::assertGet(syncTail.multiApply(_opCtx.get(), ops));
+    ASSERT_EQUALS(ops.back().getOpTime(), lastOpTime);
+
+    stdx::lock_guard<stdx::mutex> lock(mutex);
+    ASSERT_EQUALS(numWriters, operationsApplied.size());
+    for (auto&& applied : operationsApplied) {
+        ASSERT_EQUALS(3U, applied.size());
+        // The operations on each collection a writer applies are in oplog order.
+        for (size_t i = 0; i < applied.size(); ++i) {
+            for (size_t j = i + 1; j < applied.size(); ++j) {
+                if (applied[i].getNss() == applied[j].getNss()) {
+                    ASSERT_LT(applied[i].getOpTime(), applied[j].getOpTime());
+                }
+            }
+        }
+    }
+}
+
+TEST_F(SyncTailTest, MultiApplyWithDependencySchedulingIgnoresMissingUniqueIndexFields) {
+    auto dependencyScheduling =
+        ServerParameterSet::getGlobal()->getMap().find("replApplierDependencyScheduling")->second;
+    ASSERT_OK(dependencyScheduling->setFromString("true"));
+    ON_BLOCK_EXIT([&] { dependencyScheduling->setFromString("false").ignore(); });
+
+    NamespaceString nss("test.t");
+    {
+        auto createOp = makeCreateCollectionOplogEntry(
+            {Timestamp(Seconds(1), 0), 1LL}, nss, BSON("uuid" << kUuid));
+        auto indexOp = makeCommandOplogEntry({Timestamp(Seconds(2), 0), 1LL},
+                                             nss,
+                                             BSON("createIndexes" << nss.coll() << "v" << 2
+                                                                  << "key"
+                                                                  << BSON("a" << 1)
+                                                                  << "name"
+                                                                  << "a_1"
+                                                                  << "unique"
+                                                                  << true),
+                                             kUuid);
+        SyncTail syncTail(nullptr, nullptr, nullptr, {}, nullptr);
+        WorkerMultikeyPathInfo pathInfo;
+        MultiApplier::OperationPtrs setupOps = {&createOp, &indexOp};
+        ASSERT_OK(multiSyncApply(_opCtx.get(), &setupOps, &syncTail, &pathInfo));
+    }
+
+    const size_t numWriters = 4;
+    auto writerPool = OplogApplier::makeWriterPool(numWriters);
+
+    stdx::mutex mutex;
+    std::vector<size_t> opsPerWriter;
+    auto applyOperationFn =
+        [&mutex, &opsPerWriter](OperationContext* opCtx,
+                                MultiApplier::OperationPtrs* operationsForWriterThreadToApply,
+                                SyncTail* st,
+                                WorkerMultikeyPathInfo*) -> Status {
+        stdx::lock_guard<stdx::mutex> lock(mutex);
+        opsPerWriter.push_back(operationsForWriterThreadToApply->size());
+        return Status::OK();
+    };
+
+    // None of the documents has a value for the unique index's field, so they do not claim the
+    // same key and every writer gets the same share of them.
+    MultiApplier::Operations ops;
+    for (int i = 0; i < 8; ++i) {
+        ops.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(i + 3), 0), 1LL}, nss, BSON("_id" << i << "b" << i)));
+    }
+
+    SyncTail syncTail(nullptr,
+                      getConsistencyMarkers(),
+                      getStorageInterface(),
+                      applyOperationFn,
+                      writerPool.get());
+    auto lastOpTime = unittest::assertGet(syncTail.multiApply(_opCtx.get(), ops));
+    ASSERT_EQUALS(ops.back().getOpTime(), lastOpTime);
+
+    stdx::lock_guard<stdx::mutex> lock(mutex);
+    ASSERT_EQUALS(numWriters, opsPerWriter.size());
+    for (auto numOps : opsPerWriter) {
+        ASSERT_EQUALS(2U, numOps);
+    }
+}
+
+TEST_F(SyncTailTest, MultiApplyWithDependencySchedulingKeepsInsertsOfTheSameUniqueKeyTogether) {
+    auto dependencyScheduling =
+        ServerParameterSet::getGlobal()->getMap().find("replApplierDependencyScheduling")->second;
+    ASSERT_OK(dependencyScheduling->setFromString("true"));
+    ON_BLOCK_EXIT([&] { dependencyScheduling->setFromString("false").ignore(); });
+
+    NamespaceString nss("test.t");
+    {
+        auto createOp = makeCreateCollectionOplogEntry(
+            {Timestamp(Seconds(1), 0), 1LL}, nss, BSON("uuid" << kUuid));
+        auto indexOp = makeCommandOplogEntry({Timestamp(Seconds(2), 0), 1LL},
+                                             nss,
+                                             BSON("createIndexes" << nss.coll() << "v" << 2
+                                                                  << "key"
+                                                                  << BSON("a" << 1)
+                                                                  << "name"
+                                                                  << "a_1"
+                                                                  << "unique"
+                                                                  << true),
+                                             kUuid);
+        SyncTail syncTail(nullptr, nullptr, nullptr, {}, nullptr);
+        WorkerMultikeyPathInfo pathInfo;
+        MultiApplier::OperationPtrs setupOps = {&createOp, &indexOp};
+        ASSERT_OK(multiSyncApply(_opCtx.get(), &setupOps, &syncTail, &pathInfo));
+    }
+
+    const size_t numWriters = 4;
+    auto writerPool = OplogApplier::makeWriterPool(numWriters);
+
+    stdx::mutex mutex;
+    std::vector<std::vector<int>> idsPerWriter;
+    auto applyOperationFn =
+        [&mutex, &idsPerWriter](OperationContext* opCtx,
+                                MultiApplier::OperationPtrs* operationsForWriterThreadToApply,
+                                SyncTail* st,
+                                WorkerMultikeyPathInfo*) -> Status {
+        stdx::lock_guard<stdx::mutex> lock(mutex);
+        idsPerWriter.emplace_back();
+        for (auto&& opPtr : *operationsForWriterThreadToApply) {
+            idsPerWriter.back().push_back(opPtr->getIdElement().numberInt());
+        }
+        return Status::OK();
+    };
+
+    // The documents with _id 1 and 6 claim the same key in the unique index, so whichever is
+    // inserted second must see the first: both go to the same writer, in oplog order. The other
+    // documents have keys of their own.
+    MultiApplier::Operations ops;
+    for (int i = 0; i < 8; ++i) {
+        const int a = (i == 1 || i == 6) ? 100 : i;
+        ops.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(i + 3), 0), 1LL}, nss, BSON("_id" << i << "a" << a)));
+    }
+
+    SyncTail syncTail(nullptr,
+                      getConsistencyMarkers(),
+                      getStorageInterface(),
+                      applyOperationFn,
+                      writerPool.get());
+    auto lastOpTime = unittest::assertGet(syncTail.multiApply(_opCtx.get(), ops));
+    ASSERT_EQUALS(ops.back().getOpTime(), lastOpTime);
+
+    stdx::lock_guard<stdx::mutex> lock(mutex);
+    size_t numApplied = 0;
+    size_t writersWithSameKey = 0;
+    for (auto&& ids : idsPerWriter) {
+        numApplied += ids.size();
+        auto first = std::find(ids.begin(), ids.end(), 1);
+        auto second = std::find(ids.begin(), ids.end(), 6);
+        if (first == ids.end() && second == ids.end()) {
+            continue;
+        }
+        ++writersWithSameKey;
+        ASSERT(first != ids.end());
+        ASSERT(second != ids.end());
+        ASSERT(first < second);
+    }
+    ASSERT_EQUALS(ops.size(), numApplied);
+    ASSERT_EQUALS(1U, writersWithSameKey);
+}
+
 TEST_F(SyncTailTest, MultiSyncApplyUsesSyncApplyToApplyOperation) {
     NamespaceString nss("local." + _agent.getSuiteName() + "_" + _agent.getTestName());
     auto op = makeCreateCollectionOplogEntry({Timestamp(Seconds(1), 0), 1LL}, nss);
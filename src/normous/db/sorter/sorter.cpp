@@ -49,6 +49,7 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <snappy.h>
+#include <third_party/murmurhash3/MurmurHash3.h>
 #include <vector>
 
 #include "mongo/base/string_data.h"
@@ -59,10 +60,13 @@
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/s/is_mongos.h"
+#include "mongo/stdx/future.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/destructor_guard.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/system_tick_source.h"
+#include "mongo/util/timer.h"
 #include "mongo/util/unowned_ptr.h"
 
 namespace mongo {
@@ -79,6 +83,14 @@ inline std::string myErrnoWithDescription() {
     return sb.str();
 }
 
+// Checksum of a block as it is stored on disk, i.e. after compression and encryption. It is
+// written after the block's size header and verified before the block is decoded.
+inline uint32_t blockChecksum(const char* data, int32_t size) {
+    uint32_t checksum;
+    MurmurHash3_x86_32(data, std::abs(size), 0, &checksum);
+    return checksum;
+}
+
 template <typename Data, typename Comparator>
 void dassertCompIsSane(const Comparator& comp, const Data& lhs, const Data& rhs) {
 #if defined(MONGO_CONFIG_DEBUG_BUILD) && !defined(_MSC_VER)
@@ -102,6 +114,31 @@ void dassertCompIsSane(const Comparator& comp, const Data& lhs, const Data& rhs)
 #endif
 }
 
+/**
+ * Splits [begin, end) into at most 'numChunks' contiguous chunks of nearly equal size and calls
+ * 'fn(chunkBegin, chunkEnd)' on each of them on its own thread. Returns the results in chunk order,
+ * rethrowing the first exception thrown by any chunk once all of them have finished.
+ */
+template <typename Iterator, typename Function>
+auto forEachChunkConcurrently(Iterator begin, Iterator end, size_t numChunks, const Function& fn)
+    -> std::vector<decltype(fn(begin, end))> {
+    const size_t size = std::distance(begin, end);
+    const size_t chunkSize = (size + numChunks - 1) / numChunks;
+
+    std::vector<stdx::future<decltype(fn(begin, end))>> futures;
+    for (size_t offset = 0; offset < size; offset += chunkSize) {
+        const auto chunkBegin = begin + offset;
+        const auto chunkEnd = begin + std::min(offset + chunkSize, size);
+        futures.push_back(stdx::async(stdx::launch::async, fn, chunkBegin, chunkEnd));
+    }
+
+    std::vector<decltype(fn(begin, end))> results;
+    for (auto&& future : futures) {
+        results.push_back(future.get());
+    }
+    return results;
+}
+
 /** Ensures a named file is deleted when this object goes out of scope */
 class FileDeleter {
 public:
@@ -154,9 +191,11 @@ public:
 
     FileIterator(const std::string& fileName,
                  const Settings& settings,
-                 std::shared_ptr<FileDeleter> fileDeleter)
+                 std::shared_ptr<FileDeleter> fileDeleter,
+                 bool readAhead = false)
         : _settings(settings),
           _done(false),
+          _readAhead(readAhead),
           _fileName(fileName),
           _fileDeleter(fileDeleter),
           _file(_fileName.c_str(), std::ios::in | std::ios::binary) {
@@ -187,6 +226,12 @@ public:
     }
 
 private:
+    // A block of the file after decryption and decompression. A null 'data' means EOF.
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
     void fillIfNeeded() {
         verify(!_done);
 
@@ -195,25 +240,49 @@ private:
     }
 
     void fill() {
-        int32_t rawSize;
-        read(&rawSize, sizeof(rawSize));
-        if (_done)
+        Block block = _nextBlock.valid() ? _nextBlock.get() : readBlock();
+        if (!block.data) {
+            _done = true;
             return;
+        }
+
+        _buffer = std::move(block.data);
+        _reader.reset(new BufReader(_buffer.get(), block.size));
+
+        if (_readAhead) {
+            // Read and decode the next block while this one is being consumed. Only one read is
+            // ever outstanding, so '_file' is never used by two threads at once.
+            _nextBlock = stdx::async(stdx::launch::async, [this] { return readBlock(); });
+        }
+    }
+
+    Block readBlock() {
+        int32_t rawSize;
+        if (!read(&rawSize, sizeof(rawSize)))
+            return Block();
 
         // negative size means compressed
         const bool compressed = rawSize < 0;
         int32_t blockSize = std::abs(rawSize);
 
-        _buffer.reset(new char[blockSize]);
-        read(_buffer.get(), blockSize);
-        massert(16816, "file too short?", !_done);
+        uint32_t checksum;
+        massert(50978,
+                "file too short to hold a block checksum",
+                read(&checksum, sizeof(checksum)));
+
+        std::unique_ptr<char[]> buffer(new char[blockSize]);
+        massert(16816, "file too short?", read(buffer.get(), blockSize));
+        massert(50974,
+                str::stream() << "checksum mismatch in block of file \"" << _fileName
+                              << "\"; the file may be corrupt",
+                blockChecksum(buffer.get(), blockSize) == checksum);
 
         auto encryptionHooks = EncryptionHooks::get(getGlobalServiceContext());
         if (encryptionHooks->enabled()) {
             std::unique_ptr<char[]> out(new char[blockSize]);
             size_t outLen;
             Status status =
-                encryptionHooks->unprotectTmpData(reinterpret_cast<uint8_t*>(_buffer.get()),
+                encryptionHooks->unprotectTmpData(reinterpret_cast<uint8_t*>(buffer.get()),
                                                   blockSize,
                                                   reinterpret_cast<uint8_t*>(out.get()),
                                                   blockSize,
@@ -222,38 +291,37 @@ private:
                     str::stream() << "Failed to unprotect data: " << status.toString(),
                     status.isOK());
             blockSize = outLen;
-            _buffer.swap(out);
+            buffer.swap(out);
         }
 
+        Block block;
         if (!compressed) {
-            _reader.reset(new BufReader(_buffer.get(), blockSize));
-            return;
+            block.data = std::move(buffer);
+            block.size = blockSize;
+            return block;
         }
 
-        dassert(snappy::IsValidCompressedBuffer(_buffer.get(), blockSize));
+        dassert(snappy::IsValidCompressedBuffer(buffer.get(), blockSize));
 
         size_t uncompressedSize;
         massert(17061,
                 "couldn't get uncompressed length",
-                snappy::GetUncompressedLength(_buffer.get(), blockSize, &uncompressedSize));
+                snappy::GetUncompressedLength(buffer.get(), blockSize, &uncompressedSize));
 
-        std::unique_ptr<char[]> decompressionBuffer(new char[uncompressedSize]);
+        block.data.reset(new char[uncompressedSize]);
+        block.size = uncompressedSize;
         massert(17062,
                 "decompression failed",
-                snappy::RawUncompress(_buffer.get(), blockSize, decompressionBuffer.get()));
-
-        // hold on to decompressed data and throw out compressed data at block exit
-        _buffer.swap(decompressionBuffer);
-        _reader.reset(new BufReader(_buffer.get(), uncompressedSize));
+                snappy::RawUncompress(buffer.get(), blockSize, block.data.get()));
+        return block;
     }
 
-    // sets _done to true on EOF - asserts on any other error
-    void read(void* out, size_t size) {
+    // returns false on EOF - asserts on any other error
+    bool read(void* out, size_t size) {
         _file.read(reinterpret_cast<char*>(out), size);
         if (!_file.good()) {
             if (_file.eof()) {
-                _done = true;
-                return;
+                return false;
             }
 
             msgasserted(16817,
@@ -261,18 +329,28 @@ private:
                                       << myErrnoWithDescription());
         }
         verify(_file.gcount() == static_cast<std::streamsize>(size));
+        return true;
     }
 
     const Settings _settings;
     bool _done;
+    const bool _readAhead;
     std::unique_ptr<char[]> _buffer;
     std::unique_ptr<BufReader> _reader;
     std::string _fileName;
     std::shared_ptr<FileDeleter> _fileDeleter;  // Must outlive _file
     std::ifstream _file;
+    stdx::future<Block> _nextBlock;  // Must be destroyed first, since it waits for a pending read
 };
 
-/** Merge-sorts results from 0 or more FileIterators */
+/**
+ * Merge-sorts results from 0 or more FileIterators.
+ *
+ * The inputs are merged with a tree of losers: each internal node of a complete binary tree over
+ * the inputs remembers the loser of the comparison played there, so replacing the winner only
+ * replays the comparisons on its path to the root. This takes log2(k) comparisons per result for k
+ * inputs, about half of what sifting a binary heap needs.
+ */
 template <typename Key, typename Value, typename Comparator>
 class MergeIterator : public SortIteratorInterface<Key, Value> {
 public:
@@ -282,37 +360,44 @@ public:
 
     MergeIterator(const std::vector<std::shared_ptr<Input>>& iters,
                   const SortOptions& opts,
-                  const Comparator& comp)
+                  const Comparator& comp,
+                  std::shared_ptr<SorterStats> stats = nullptr)
         : _opts(opts),
           _remaining(opts.limit ? opts.limit : std::numeric_limits<unsigned long long>::max()),
           _first(true),
-          _greater(comp) {
+          _comp(comp),
+          _stats(std::move(stats)) {
         for (size_t i = 0; i < iters.size(); i++) {
             if (iters[i]->more()) {
-                _heap.push_back(std::make_shared<Stream>(i, iters[i]->next(), iters[i]));
+                _streams.push_back(std::make_shared<Stream>(i, iters[i]->next(), iters[i]));
             }
         }
 
-        if (_heap.empty()) {
+        if (_streams.empty()) {
             _remaining = 0;
             return;
         }
 
-        std::make_heap(_heap.begin(), _heap.end(), _greater);
-        std::pop_heap(_heap.begin(), _heap.end(), _greater);
-        _current = _heap.back();
-        _heap.pop_back();
+        _liveStreams = _streams.size();
+        _tree.resize(_streams.size());
+        _tree[0] = initTree(1);
+    }
+
+    ~MergeIterator() {
+        publishStats();
     }
 
     bool more() {
-        if (_remaining > 0 && (_first || !_heap.empty() || _current->more()))
+        if (_remaining > 0 && (_first || _liveStreams > 1 || winner()->more()))
             return true;
 
         // We are done so clean up resources.
         // Can't do this in next() due to lifetime guarantees of unowned Data.
-        _heap.clear();
-        _current.reset();
+        _streams.clear();
+        _tree.clear();
+        _liveStreams = 0;
         _remaining = 0;
+        publishStats();
 
         return false;
     }
@@ -320,26 +405,25 @@ public:
     Data next() {
         verify(_remaining);
 
+        const bool timed = _stats && _mergedResults++ % kTimedResultInterval == 0;
+        const TickSource::Tick start = timed ? _tickSource->getTicks() : 0;
+
         _remaining--;
 
         if (_first) {
             _first = false;
-            return _current->current();
+        } else {
+            advanceWinner();
         }
 
-        if (!_current->advance()) {
-            verify(!_heap.empty());
-
-            std::pop_heap(_heap.begin(), _heap.end(), _greater);
-            _current = _heap.back();
-            _heap.pop_back();
-        } else if (!_heap.empty() && _greater(_current, _heap.front())) {
-            std::pop_heap(_heap.begin(), _heap.end(), _greater);
-            std::swap(_current, _heap.back());
-            std::push_heap(_heap.begin(), _heap.end(), _greater);
+        const Data& current = winner()->current();
+        if (_stats) {
+            _mergedBytes += current.first.memUsageForSorter() + current.second.memUsageForSorter();
         }
-
-        return _current->current();
+        if (timed) {
+            _timedTicks += _tickSource->getTicks() - start;
+        }
+        return current;
     }
 
 
@@ -356,44 +440,115 @@ private:
             return _rest->more();
         }
         bool advance() {
-            if (!_rest->more())
+            if (!_rest->more()) {
+                exhausted = true;
                 return false;
+            }
 
             _current = _rest->next();
             return true;
         }
 
         const size_t fileNum;
+        bool exhausted = false;
 
     private:
         Data _current;
         std::shared_ptr<Input> _rest;
     };
 
-    class STLComparator {  // uses greater rather than less-than to maintain a MinHeap
-    public:
-        explicit STLComparator(const Comparator& comp) : _comp(comp) {}
-        bool operator()(unowned_ptr<const Stream> lhs, unowned_ptr<const Stream> rhs) const {
-            // first compare data
-            dassertCompIsSane(_comp, lhs->current(), rhs->current());
-            int ret = _comp(lhs->current(), rhs->current());
-            if (ret)
-                return ret > 0;
+    const std::shared_ptr<Stream>& winner() const {
+        return _streams[_tree[0]];
+    }
 
-            // then compare fileNums to ensure stability
-            return lhs->fileNum > rhs->fileNum;
+    /**
+     * Adds the bytes merged so far, and the estimated time spent in next() producing them, to the
+     * shared stats. Updating atomics for every result would cost more than merging it, so this is
+     * only done once the merge is exhausted or abandoned.
+     */
+    void publishStats() {
+        if (!_mergedResults) {
+            return;
         }
+        const long long timedResults =
+            (_mergedResults + kTimedResultInterval - 1) / kTimedResultInterval;
+        const auto mergeTicks = static_cast<TickSource::Tick>(
+            static_cast<double>(_timedTicks) * _mergedResults / timedResults);
+        _stats->merge.bytes.fetchAndAdd(_mergedBytes);
+        _stats->merge.micros.fetchAndAdd(_tickSource->ticksTo<Microseconds>(mergeTicks).count());
+        _mergedBytes = 0;
+        _mergedResults = 0;
+        _timedTicks = 0;
+    }
 
-    private:
-        const Comparator _comp;
-    };
+    /**
+     * Returns whether the stream at 'lhs' should be returned before the stream at 'rhs'. Exhausted
+     * streams lose to all others, and ties go to the earlier input to keep the merge stable.
+     */
+    bool beats(size_t lhs, size_t rhs) const {
+        const Stream& left = *_streams[lhs];
+        const Stream& right = *_streams[rhs];
+        if (left.exhausted || right.exhausted)
+            return !left.exhausted;
+
+        dassertCompIsSane(_comp, left.current(), right.current());
+        int ret = _comp(left.current(), right.current());
+        if (ret)
+            return ret < 0;
+
+        return left.fileNum < right.fileNum;
+    }
+
+    /**
+     * Plays the matches in the subtree rooted at 'node', recording the loser of each one, and
+     * returns the index of the stream which wins the subtree. Stream i is the leaf at position
+     * _streams.size() + i.
+     */
+    size_t initTree(size_t node) {
+        if (node >= _streams.size())
+            return node - _streams.size();
+
+        size_t left = initTree(2 * node);
+        size_t right = initTree(2 * node + 1);
+        if (beats(right, left))
+            std::swap(left, right);
+        _tree[node] = right;
+        return left;
+    }
+
+    void advanceWinner() {
+        size_t winner = _tree[0];
+        if (!_streams[winner]->advance()) {
+            verify(_liveStreams > 1);
+            _liveStreams--;
+        }
+
+        for (size_t node = (winner + _streams.size()) / 2; node > 0; node /= 2) {
+            if (beats(_tree[node], winner))
+                std::swap(_tree[node], winner);
+        }
+        _tree[0] = winner;
+    }
 
     SortOptions _opts;
     unsigned long long _remaining;
     bool _first;
-    std::shared_ptr<Stream> _current;
-    std::vector<std::shared_ptr<Stream>> _heap;  // MinHeap
-    STLComparator _greater;                      // named so calls make sense
+    const Comparator _comp;
+    std::shared_ptr<SorterStats> _stats;
+    std::vector<std::shared_ptr<Stream>> _streams;
+    std::vector<size_t> _tree;  // _tree[0] is the winner, other nodes hold losers.
+    size_t _liveStreams = 0;    // Streams which have not been exhausted.
+
+    // Reading the clock around every call to next() would cost about as much as the merge itself,
+    // so only one call in this many is timed and the merge time is extrapolated from those.
+    static constexpr long long kTimedResultInterval = 64;
+
+    // Not yet published to '_stats'. Only time spent inside next() is counted, never the caller's
+    // own work between calls.
+    TickSource* const _tickSource = SystemTickSource::get();
+    long long _mergedBytes = 0;
+    long long _mergedResults = 0;
+    TickSource::Tick _timedTicks = 0;
 };
 
 template <typename Key, typename Value, typename Comparator>
@@ -424,12 +579,15 @@ public:
 
     Iterator* done() {
         if (_iters.empty()) {
+            Timer timer;
             sort();
+            this->_stats->runGeneration.bytes.fetchAndAdd(_memUsed);
+            this->_stats->runGeneration.micros.fetchAndAdd(timer.micros());
             return new InMemIterator<Key, Value>(_data);
         }
 
         spill();
-        return Iterator::merge(_iters, _opts, _comp);
+        return new MergeIterator<Key, Value, Comparator>(_iters, _opts, _comp, this->_stats);
     }
 
     // TEMP these are here for compatibility. Will be replaced with a general stats API
@@ -441,6 +599,8 @@ public:
     }
 
 private:
+    typedef typename std::deque<Data>::iterator DataIterator;
+
     class STLComparator {
     public:
         explicit STLComparator(const Comparator& comp) : _comp(comp) {}
@@ -453,13 +613,62 @@ private:
         const Comparator& _comp;
     };
 
+    // Sorting is only split across threads once each thread has at least this much data.
+    static constexpr size_t kMinItemsPerThread = 1024;
+
+    size_t numSortThreads() const {
+        const size_t maxThreads = _data.size() / kMinItemsPerThread;
+        return std::max(std::min(_opts.numThreads, maxThreads), size_t(1));
+    }
+
     void sort() {
         STLComparator less(_comp);
-        std::stable_sort(_data.begin(), _data.end(), less);
+        const size_t numThreads = numSortThreads();
+        if (numThreads == 1) {
+            std::stable_sort(_data.begin(), _data.end(), less);
+            return;
+        }
 
-        // Does 2x more compares than stable_sort
-        // TODO test on windows
-        // std::sort(_data.begin(), _data.end(), comp);
+        // Sort chunks concurrently, then merge neighbouring chunks until one remains. Both steps
+        // are stable, so the result is the same as sorting the whole range at once.
+        std::vector<DataIterator> bounds{_data.begin()};
+        for (auto&& chunkEnd : forEachChunkConcurrently(
+                 _data.begin(), _data.end(), numThreads, [&](DataIterator begin, DataIterator end) {
+                     std::stable_sort(begin, end, less);
+                     return end;
+                 })) {
+            bounds.push_back(chunkEnd);
+        }
+
+        while (bounds.size() > 2) {
+            std::vector<DataIterator> merged{bounds.front()};
+            for (size_t i = 2; i < bounds.size(); i += 2) {
+                std::inplace_merge(bounds[i - 2], bounds[i - 1], bounds[i], less);
+                merged.push_back(bounds[i]);
+            }
+            if (bounds.size() % 2 == 0) {
+                merged.push_back(bounds.back());
+            }
+            bounds.swap(merged);
+        }
+    }
+
+    /**
+     * Sorts [begin, end) and writes it to a new spill file, returning an iterator over the file.
+     */
+    std::shared_ptr<Iterator> writeRun(DataIterator begin, DataIterator end) const {
+        STLComparator less(_comp);
+        std::stable_sort(begin, end, less);
+
+        SortedFileWriter<Key, Value> writer(_opts, _settings);
+        for (; begin != end; ++begin) {
+            writer.addAlreadySorted(begin->first, begin->second);
+        }
+
+        std::shared_ptr<Iterator> run(writer.done());
+        this->_stats->spilledRuns.fetchAndAdd(1);
+        this->_stats->spilledBytes.fetchAndAdd(writer.bytesWritten());
+        return run;
     }
 
     void spill() {
@@ -480,15 +689,24 @@ private:
                           << " Pass allowDiskUse:true to opt in.");
         }
 
-        sort();
-
-        SortedFileWriter<Key, Value> writer(_opts, _settings);
-        for (; !_data.empty(); _data.pop_front()) {
-            writer.addAlreadySorted(_data.front().first, _data.front().second);
+        Timer timer;
+        const size_t numThreads = numSortThreads();
+        if (numThreads == 1) {
+            _iters.push_back(writeRun(_data.begin(), _data.end()));
+        } else {
+            // Each thread sorts and writes its own run. The runs are merged in the order of their
+            // chunks, which keeps the sort stable.
+            auto writeChunk = [this](DataIterator begin, DataIterator end) {
+                return writeRun(begin, end);
+            };
+            auto runs =
+                forEachChunkConcurrently(_data.begin(), _data.end(), numThreads, writeChunk);
+            _iters.insert(_iters.end(), runs.begin(), runs.end());
         }
+        _data.clear();
 
-        _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
-
+        this->_stats->runGeneration.bytes.fetchAndAdd(_memUsed);
+        this->_stats->runGeneration.micros.fetchAndAdd(timer.micros());
         _memUsed = 0;
     }
 
@@ -629,7 +847,7 @@ public:
         }
 
         spill();
-        return Iterator::merge(_iters, _opts, _comp);
+        return new MergeIterator<Key, Value, Comparator>(_iters, _opts, _comp, this->_stats);
     }
 
     // TEMP these are here for compatibility. Will be replaced with a general stats API
@@ -762,6 +980,7 @@ private:
         // We should check readOnly before getting here.
         invariant(!storageGlobalParams.readOnly);
 
+        Timer timer;
         sort();
         updateCutoff();
 
@@ -775,6 +994,10 @@ private:
 
         _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
 
+        this->_stats->spilledRuns.fetchAndAdd(1);
+        this->_stats->spilledBytes.fetchAndAdd(writer.bytesWritten());
+        this->_stats->runGeneration.bytes.fetchAndAdd(_memUsed);
+        this->_stats->runGeneration.micros.fetchAndAdd(timer.micros());
         _memUsed = 0;
     }
 
@@ -808,7 +1031,7 @@ inline unsigned nextFileNumber() {
 
 template <typename Key, typename Value>
 SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts, const Settings& settings)
-    : _settings(settings) {
+    : _settings(settings), _readAhead(opts.numThreads > 1), _compress(opts.compress) {
     namespace str = mongoutils::str;
 
     // This should be checked by consumers, but if we get here don't allow writes.
@@ -859,10 +1082,12 @@ void SortedFileWriter<Key, Value>::spill() {
         return;
 
     std::string compressed;
-    snappy::Compress(outBuffer, size, &compressed);
-    verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+    if (_compress) {
+        snappy::Compress(outBuffer, size, &compressed);
+        verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+    }
 
-    const bool shouldCompress = compressed.size() < size_t(_buffer.len() / 10 * 9);
+    const bool shouldCompress = _compress && compressed.size() < size_t(_buffer.len() / 10 * 9);
     if (shouldCompress) {
         size = compressed.size();
         outBuffer = const_cast<char*>(compressed.data());
@@ -886,11 +1111,15 @@ void SortedFileWriter<Key, Value>::spill() {
         size = resultLen;
     }
 
+    const uint32_t checksum = sorter::blockChecksum(outBuffer, size);
+
     // negative size means compressed
     size = shouldCompress ? -size : size;
     try {
         _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        _file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
         _file.write(outBuffer, std::abs(size));
+        _bytesWritten += sizeof(size) + sizeof(checksum) + std::abs(size);
 
     } catch (const std::exception&) {
         msgasserted(16821,
@@ -905,7 +1134,7 @@ template <typename Key, typename Value>
 SortIteratorInterface<Key, Value>* SortedFileWriter<Key, Value>::done() {
     spill();
     _file.close();
-    return new sorter::FileIterator<Key, Value>(_fileName, _settings, _fileDeleter);
+    return new sorter::FileIterator<Key, Value>(_fileName, _settings, _fileDeleter, _readAhead);
 }
 
 //
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <deque>
 #include <fstream>
 #include <memory>
@@ -36,7 +37,9 @@
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/util/builder.h"
+#include "mongo/platform/atomic_word.h"
 
 /**
  * This is the public API for the Sorter (both in-memory and external)
@@ -98,8 +101,17 @@ struct SortOptions {
     bool extSortAllowed;         /// If false, uassert if more mem needed than allowed.
     std::string tempDir;         /// Directory to directly place files in.
                                  /// Must be explicitly set if extSortAllowed is true.
-
-    SortOptions() : limit(0), maxMemoryUsageBytes(64 * 1024 * 1024), extSortAllowed(false) {}
+    size_t numThreads;           /// Threads used to sort runs concurrently and to read ahead in
+                                 /// spill files while merging. 1 does all work on the caller.
+    bool compress;               /// If true, spilled blocks are snappy compressed when that
+                                 /// saves space. Blocks are checksummed either way.
+
+    SortOptions()
+        : limit(0),
+          maxMemoryUsageBytes(64 * 1024 * 1024),
+          extSortAllowed(false),
+          numThreads(1),
+          compress(true) {}
 
     /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
 
@@ -122,6 +134,53 @@ struct SortOptions {
         tempDir = newTempDir;
         return *this;
     }
+
+    SortOptions& NumThreads(size_t newNumThreads) {
+        numThreads = std::max(newNumThreads, size_t(1));
+        return *this;
+    }
+
+    SortOptions& Compress(bool newCompress = true) {
+        compress = newCompress;
+        return *this;
+    }
+};
+
+/**
+ * Throughput counters for the two phases of a sort: generating sorted runs, in memory or spilled to
+ * disk, and merging spilled runs back together. A Sorter shares these with the iterator returned
+ * by done(), so the merge is still counted after the Sorter itself has been destroyed.
+ */
+struct SorterStats {
+    struct Phase {
+        AtomicInt64 bytes;   // Approximate in-memory size of the data processed.
+        AtomicInt64 micros;  // Time spent processing it, summed over all threads.
+
+        void appendTo(StringData fieldName, BSONObjBuilder* builder) const {
+            const long long phaseBytes = bytes.load();
+            const long long phaseMicros = micros.load();
+            BSONObjBuilder phase(builder->subobjStart(fieldName));
+            phase.append("bytes", phaseBytes);
+            phase.append("millis", phaseMicros / 1000);
+            phase.append("bytesPerSec",
+                         phaseMicros ? static_cast<long long>(phaseBytes * 1000000.0 / phaseMicros)
+                                     : 0LL);
+        }
+    };
+
+    Phase runGeneration;
+    Phase merge;
+    AtomicInt64 spilledRuns;
+    AtomicInt64 spilledBytes;  // Size of the spill files.
+
+    BSONObj toBSON() const {
+        BSONObjBuilder builder;
+        builder.append("spilledRuns", spilledRuns.load());
+        builder.append("spilledBytes", spilledBytes.load());
+        runGeneration.appendTo("runGeneration", &builder);
+        merge.appendTo("merge", &builder);
+        return builder.obj();
+    }
 };
 
 /// This is the output from the sorting framework
@@ -179,8 +238,13 @@ public:
     virtual int numFiles() const = 0;
     virtual size_t memUsed() const = 0;
 
+    std::shared_ptr<const SorterStats> stats() const {
+        return _stats;
+    }
+
 protected:
     bool _usedDisk{false};  // Keeps track of whether the sorter used disk or not
+    std::shared_ptr<SorterStats> _stats = std::make_shared<SorterStats>();
     Sorter() {}             // can only be constructed as a base
 };
 
@@ -200,14 +264,22 @@ public:
     void addAlreadySorted(const Key&, const Value&);
     Iterator* done();  /// Can't add more data after calling done()
 
+    /// Number of bytes written to the file so far. Data is buffered until done() is called.
+    size_t bytesWritten() const {
+        return _bytesWritten;
+    }
+
 private:
     void spill();
 
     const Settings _settings;
+    const bool _readAhead;  // Whether the returned iterator reads blocks on another thread.
+    const bool _compress;   // Whether to try compressing each block before writing it.
     std::string _fileName;
     std::shared_ptr<sorter::FileDeleter> _fileDeleter;  // Must outlive _file
     std::ofstream _file;
     BufBuilder _buffer;
+    size_t _bytesWritten = 0;
 };
 }
 
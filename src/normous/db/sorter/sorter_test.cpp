@@ -31,6 +31,7 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem.hpp>
+#include <fstream>
 
 #include "mongo/base/data_type_endian.h"
 #include "mongo/base/init.h"
@@ -86,6 +87,7 @@ private:
 typedef pair<IntWrapper, IntWrapper> IWPair;
 typedef SortIteratorInterface<IntWrapper, IntWrapper> IWIterator;
 typedef Sorter<IntWrapper, IntWrapper> IWSorter;
+typedef sorter::InMemIterator<IntWrapper, IntWrapper> IWInMemIterator;
 
 enum Direction { ASC = 1, DESC = -1 };
 class IWComparator {
@@ -268,6 +270,54 @@ public:
     }
 };
 
+class SortedFileWriterWithoutCompressionTests : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("sortedFileWriterTests");
+        const SortOptions opts = SortOptions().TempDir(tempDir.path());
+
+        // Runs of equal pairs compress well, so the uncompressed file must be larger.
+        SortedFileWriter<IntWrapper, IntWrapper> compressed(opts);
+        SortedFileWriter<IntWrapper, IntWrapper> uncompressed(SortOptions(opts).Compress(false));
+        for (int i = 0; i < 100 * 1000; i++) {
+            compressed.addAlreadySorted(i / 1000, 0);
+            uncompressed.addAlreadySorted(i / 1000, 0);
+        }
+
+        std::shared_ptr<IWIterator> compressedIt(compressed.done());
+        std::shared_ptr<IWIterator> uncompressedIt(uncompressed.done());
+        ASSERT_GREATER_THAN(uncompressed.bytesWritten(), compressed.bytesWritten());
+        ASSERT_ITERATORS_EQUIVALENT(uncompressedIt, compressedIt);
+    }
+};
+
+class FileIteratorDetectsCorruptionTests : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("sortedFileWriterTests");
+        for (bool compress : {false, true}) {
+            SortedFileWriter<IntWrapper, IntWrapper> writer(
+                SortOptions().TempDir(tempDir.path()).Compress(compress));
+            for (int i = 0; i < 1000; i++)
+                writer.addAlreadySorted(i, -i);
+            std::shared_ptr<IWIterator> it(writer.done());
+
+            // Flip a byte in the body of the first block, past its size and checksum header.
+            const std::string fileName =
+                boost::filesystem::directory_iterator(tempDir.path())->path().string();
+            std::fstream file(fileName, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekg(sizeof(int32_t) + sizeof(uint32_t) + 10);
+            const char byte = file.get();
+            file.seekp(sizeof(int32_t) + sizeof(uint32_t) + 10);
+            file.put(~byte);
+            file.close();
+
+            ASSERT_THROWS_CODE(it->more(), AssertionException, 50974);
+        }
+        ASSERT(boost::filesystem::is_empty(tempDir.path()));
+    }
+};
+
 
 class MergeIteratorTests {
 public:
@@ -322,6 +372,25 @@ public:
                 mergeIterators(iterators, ASC, SortOptions().Limit(10)),
                 make_shared<LimitIterator>(10, make_shared<IntIterator>(0, 20, 1)));
         }
+        {  // test that ties go to the earlier input, with a number of inputs not a power of 2
+            std::vector<std::shared_ptr<IWIterator>> inputs;
+            std::vector<IWPair> expected;
+            for (int input = 0; input < 7; input++) {
+                std::vector<IWPair> pairs;
+                for (int key = input % 2; key < 10; key += 1 + input % 2)
+                    pairs.push_back(IWPair(key, input));
+                inputs.push_back(std::make_shared<IWInMemIterator>(pairs));
+                expected.insert(expected.end(), pairs.begin(), pairs.end());
+            }
+            std::stable_sort(
+                expected.begin(), expected.end(), [](const IWPair& lhs, const IWPair& rhs) {
+                    return lhs.first < rhs.first;
+                });
+
+            std::shared_ptr<IWIterator> mergeIter(
+                IWIterator::merge(inputs, SortOptions(), IWComparator()));
+            ASSERT_ITERATORS_EQUIVALENT(mergeIter, make_shared<IWInMemIterator>(expected));
+        }
     }
 };
 
@@ -534,6 +603,61 @@ class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
     }
     enum { MEM_LIMIT = 32 * 1024 };
 };
+
+template <bool Random = true>
+class ParallelLotsOfDataLittleMemory : public LotsOfDataLittleMemory<Random> {
+    SortOptions adjustSortOptions(SortOptions opts) {
+        return LotsOfDataLittleMemory<Random>::adjustSortOptions(opts).NumThreads(4);
+    }
+};
+
+template <bool Random = true>
+class ParallelLotsOfDataInMemory : public LotsOfDataLittleMemory<Random> {
+    SortOptions adjustSortOptions(SortOptions opts) {
+        return opts.MaxMemoryUsageBytes(64 * 1024 * 1024).NumThreads(4);
+    }
+};
+
+/**
+ * Sorts many duplicate keys with several threads, checking that pairs with equal keys are returned
+ * in the order they were added whether or not the sort spills, and that the stats are filled in.
+ */
+class ParallelIsStable : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("sorterTests");
+        const SortOptions opts = SortOptions().TempDir(tempDir.path()).NumThreads(4);
+
+        std::vector<IWPair> expected;
+        for (int i = 0; i < NUM_ITEMS; i++)
+            expected.push_back(IWPair(i % 100, i));
+        std::stable_sort(
+            expected.begin(), expected.end(), [](const IWPair& lhs, const IWPair& rhs) {
+                return lhs.first < rhs.first;
+            });
+
+        for (bool spill : {false, true}) {
+            std::unique_ptr<IWSorter> sorter(IWSorter::make(
+                spill ? SortOptions(opts).MaxMemoryUsageBytes(64 * 1024).ExtSortAllowed() : opts,
+                IWComparator(ASC)));
+            for (int i = 0; i < NUM_ITEMS; i++)
+                sorter->add(i % 100, i);
+
+            ASSERT_EQUALS(sorter->usedDisk(), spill);
+            ASSERT_ITERATORS_EQUIVALENT(std::shared_ptr<IWIterator>(sorter->done()),
+                                        make_shared<IWInMemIterator>(expected));
+
+            const BSONObj stats = sorter->stats()->toBSON();
+            ASSERT_EQUALS(stats["spilledRuns"].numberLong() > 0, spill);
+            ASSERT_EQUALS(stats["merge"]["bytes"].numberLong() > 0, spill);
+            ASSERT_GREATER_THAN(stats["runGeneration"]["bytes"].numberLong(), 0);
+        }
+
+        ASSERT(boost::filesystem::is_empty(tempDir.path()));
+    }
+
+    enum Constants { NUM_ITEMS = 100 * 1000 };
+};
 }
 
 class SorterSuite : public mongo::unittest::Suite {
@@ -543,6 +667,8 @@ public:
     void setupTests() {
         add<InMemIterTests>();
         add<SortedFileWriterAndFileIteratorTests>();
+        add<SortedFileWriterWithoutCompressionTests>();
+        add<FileIteratorDetectsCorruptionTests>();
         add<MergeIteratorTests>();
         add<SorterTests::Basic>();
         add<SorterTests::Limit>();
@@ -555,6 +681,10 @@ public:
         add<SorterTests::LotsOfDataWithLimit<100, /*random=*/true>>();    // fits in mem
         add<SorterTests::LotsOfDataWithLimit<5000, /*random=*/false>>();  // spills
         add<SorterTests::LotsOfDataWithLimit<5000, /*random=*/true>>();   // spills
+        add<SorterTests::ParallelLotsOfDataLittleMemory</*random=*/false>>();
+        add<SorterTests::ParallelLotsOfDataLittleMemory</*random=*/true>>();
+        add<SorterTests::ParallelLotsOfDataInMemory</*random=*/true>>();
+        add<SorterTests::ParallelIsStable>();
     }
 };
 
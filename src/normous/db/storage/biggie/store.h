@@ -28,7 +28,7 @@
 
 #pragma once
 
-#include <array>
+#include <algorithm>
 #include <boost/optional.hpp>
 #include <cstring>
 #include <exception>
@@ -151,24 +151,19 @@ public:
 
                 // Check the children right of the node that the iterator was at already. This way,
                 // there will be no backtracking in the traversal.
-                for (auto iter = oldKey + 1 + node->children.begin(); iter != node->children.end();
-                     ++iter) {
-
-                    // If the node has a child, then the sub-tree must have a node with data that
-                    // has not yet been visited.
-                    if (*iter != nullptr) {
-
-                        // If the current node has data, return it and exit. If not, continue
-                        // following the nodes to find the next one with data. It is necessary to go
-                        // to the left-most node in this sub-tree.
-                        if ((*iter)->data != boost::none) {
-                            _current = iter->get();
-                            return;
-                        }
-                        _current = iter->get();
+                unsigned nextKey = node->children.nextKey(oldKey + 1);
+
+                // If the node has a child, then the sub-tree must have a node with data that has
+                // not yet been visited.
+                if (nextKey != Children::kNoKey) {
+
+                    // If the current node has data, return it and exit. If not, continue following
+                    // the nodes to find the next one with data. It is necessary to go to the
+                    // left-most node in this sub-tree.
+                    _current = node->children[nextKey].get();
+                    if (_current->data == boost::none)
                         _traverseLeftSubtree();
-                        return;
-                    }
+                    return;
                 }
             }
             return;
@@ -179,12 +174,7 @@ public:
             // '_current' is root. However, it cannot return the root, and hence at least 1
             // iteration of the while loop is required.
             do {
-                for (auto child : _current->children) {
-                    if (child != nullptr) {
-                        _current = child.get();
-                        break;
-                    }
-                }
+                _current = _current->children.first().get();
             } while (_current->data == boost::none);
         }
 
@@ -301,14 +291,13 @@ public:
 
                 // After moving up in the tree, continue searching for neighboring nodes to see if
                 // they have data, moving from right to left.
-                for (int i = oldKey - 1; i >= 0; i--) {
-                    if (node->children[i] != nullptr) {
-                        // If there is a sub-tree found, it must have data, therefore it's necessary
-                        // to traverse to the right most node.
-                        _current = node->children[i].get();
-                        _traverseRightSubtree();
-                        return;
-                    }
+                unsigned prevKey = node->children.prevKey(oldKey);
+                if (prevKey != Children::kNoKey) {
+                    // If there is a sub-tree found, it must have data, therefore it's necessary to
+                    // traverse to the right most node.
+                    _current = node->children[prevKey].get();
+                    _traverseRightSubtree();
+                    return;
                 }
 
                 // If there were no sub-trees that contained data, and the 'current' node has data,
@@ -323,15 +312,9 @@ public:
         void _traverseRightSubtree() {
             // This function traverses the given tree to the right most leaf of the subtree where
             // 'current' is the root.
-            do {
-                for (auto iter = _current->children.rbegin(); iter != _current->children.rend();
-                     ++iter) {
-                    if (*iter != nullptr) {
-                        _current = iter->get();
-                        break;
-                    }
-                }
-            } while (!_current->isLeaf());
+            while (!_current->isLeaf()) {
+                _current = _current->children.last().get();
+            }
         }
 
         // "_root" is a copy of the root of the tree over which this is iterating.
@@ -447,6 +430,11 @@ public:
             depth += node->trieKey.size();
         }
 
+        // The key may only be a prefix of other keys, in which case its node holds no data.
+        if (node->data == boost::none) {
+            return 0;
+        }
+
         size_t sizeOfRemovedNode = node->data->second.size();
         Node* deleted = context.back().first;
         context.pop_back();
@@ -460,7 +448,7 @@ public:
             if (isUniquelyOwned) {
                 // If this node is uniquely owned, simply set that child node to null and
                 // "cut" off that branch of our tree
-                last->children[firstChar] = nullptr;
+                last->children.set(firstChar, nullptr);
                 last->_numSubtreeElems -= 1;
                 last->_sizeSubtreeElems -= sizeOfRemovedNode;
                 _compressOnlyChild(last);
@@ -477,7 +465,7 @@ public:
                 std::shared_ptr<Node> child = std::make_shared<Node>(*last);
                 child->_numSubtreeElems = last->_numSubtreeElems - 1;
                 child->_sizeSubtreeElems = last->_sizeSubtreeElems - sizeOfRemovedNode;
-                child->children[firstChar] = nullptr;
+                child->children.set(firstChar, nullptr);
 
                 // 'last' may only have one child, in which case we need to evaluate
                 // whether or not this node is redundant.
@@ -494,7 +482,7 @@ public:
                     node = std::make_shared<Node>(*last);
                     node->_numSubtreeElems = last->_numSubtreeElems - 1;
                     node->_sizeSubtreeElems = last->_sizeSubtreeElems - sizeOfRemovedNode;
-                    node->children[firstChar] = child;
+                    node->children.set(firstChar, child);
                     child = node;
                 }
                 _root = node;
@@ -528,16 +516,11 @@ public:
         if (this->empty())
             return RadixStore::rend();
 
-        auto node = _root;
+        Node* node = _root.get();
         while (!node->isLeaf()) {
-            for (auto iter = node->children.rbegin(); iter != node->children.rend(); ++iter) {
-                if (*iter != nullptr) {
-                    node = *iter;
-                    break;
-                }
-            }
+            node = node->children.last().get();
         }
-        return RadixStore::const_reverse_iterator(_root, node.get());
+        return RadixStore::const_reverse_iterator(_root, node);
     }
 
     const_iterator end() const noexcept {
@@ -566,8 +549,8 @@ public:
         const char* charKey = key.data();
         // When we search a child array, always search to the right of 'idx' so that
         // when we go back up the tree we never search anything less than something
-        // we already examined.
-        uint8_t idx = '\0';
+        // we already examined. This is wider than a byte so that the search can start past 0xff.
+        unsigned idx = '\0';
         size_t depth = 0;
 
         // Traverse the path given the key to see if the node exists.
@@ -627,22 +610,15 @@ public:
             node = context.back();
             context.pop_back();
 
-            for (auto iter = idx + node->children.begin(); iter != node->children.end(); ++iter) {
-                if (*iter != nullptr) {
-                    // There exists a node with a key larger than the one given, traverse to
-                    // this node which will be the left-most node in this sub-tree.
-                    node = iter->get();
-                    while (node->data == boost::none) {
-                        for (auto iter = node->children.begin(); iter != node->children.end();
-                             ++iter) {
-                            if (*iter != nullptr) {
-                                node = iter->get();
-                                break;
-                            }
-                        }
-                    }
-                    return const_iterator(_root, node);
+            unsigned nextKey = node->children.nextKey(idx);
+            if (nextKey != Children::kNoKey) {
+                // There exists a node with a key larger than the one given, traverse to this node
+                // which will be the left-most node in this sub-tree.
+                node = node->children[nextKey].get();
+                while (node->data == boost::none) {
+                    node = node->children.first().get();
                 }
+                return const_iterator(_root, node);
             }
 
             if (node->trieKey.empty()) {
@@ -681,32 +657,255 @@ public:
         return _walkTree(_root.get(), 0);
     }
 
-private:
-    class Node {
-        friend class RadixStore;
+    /**
+     * Returns the number of bytes allocated for the nodes of this tree, not counting memory owned
+     * by the keys and values themselves. Nodes shared with other trees are counted in full.
+     */
+    size_type nodeBytes_for_test() const {
+        return _nodeBytes(_root.get());
+    }
 
+private:
+    /**
+     * The children of a node, indexed by the first byte of their trieKey. Most nodes have only a
+     * few children, so instead of always holding 256 pointers the representation grows with the
+     * number of children, as in an adaptive radix tree:
+     *
+     *  - up to 4 or 16 children: sorted arrays of keys and of the matching child pointers,
+     *  - up to 48 children: a 256 byte index from key to slot, and 48 slots,
+     *  - more than 48 children: 256 slots indexed directly by key.
+     *
+     * Nodes without children, i.e. most leaves, allocate nothing. Copies share the child nodes,
+     * just like a copied array of pointers would.
+     */
+    class Children {
     public:
-        Node() {
-            children.fill(nullptr);
+        // Returned by nextKey() and prevKey() when there is no such child.
+        static constexpr unsigned kNoKey = 256;
+
+        Children() = default;
+
+        Children(const Children& other) {
+            *this = other;
+        }
+
+        Children(Children&&) = default;
+
+        Children& operator=(const Children& other) {
+            if (this == &other)
+                return *this;
+
+            _reset(other._capacity);
+            _size = other._size;
+            std::copy(other._keys.get(), other._keys.get() + _keyBytes(_capacity), _keys.get());
+            std::copy(other._slots.get(), other._slots.get() + _capacity, _slots.get());
+            return *this;
+        }
+
+        Children& operator=(Children&&) = default;
+
+        size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        /**
+         * Returns the child for 'key', or a null pointer if there is none.
+         */
+        const std::shared_ptr<Node>& operator[](uint8_t key) const {
+            int slot = _find(key);
+            return slot < 0 ? _none() : _slots[slot];
         }
 
-        Node(std::vector<uint8_t> key) : trieKey(key) {
-            children.fill(nullptr);
-            _numSubtreeElems = 0;
-            _sizeSubtreeElems = 0;
+        /**
+         * Makes 'child' the child for 'key'. A null 'child' removes the child for 'key'.
+         */
+        void set(uint8_t key, std::shared_ptr<Node> child) {
+            int slot = _find(key);
+            if (slot >= 0 && child != nullptr) {
+                _slots[slot] = std::move(child);
+            } else if (slot >= 0) {
+                _remove(key, slot);
+                if (_size <= _shrinkThreshold(_capacity))
+                    _resize(_smaller(_capacity));
+            } else if (child != nullptr) {
+                if (_size == _capacity)
+                    _resize(_larger(_capacity));
+                _insert(key, std::move(child));
+            }
         }
 
-        bool isLeaf() {
-            for (auto child : children) {
-                if (child != nullptr)
-                    return false;
+        /**
+         * Returns the smallest key not less than 'from' that has a child, or kNoKey.
+         */
+        unsigned nextKey(unsigned from) const {
+            if (_capacity == 48 || _capacity == 256) {
+                for (unsigned key = from; key < 256; ++key) {
+                    if (_capacity == 48 ? _keys[key] != 0 : _slots[key] != nullptr)
+                        return key;
+                }
+                return kNoKey;
+            }
+
+            for (unsigned i = 0; i < _size; ++i) {
+                if (_keys[i] >= from)
+                    return _keys[i];
             }
-            return true;
+            return kNoKey;
+        }
+
+        /**
+         * Returns the largest key less than 'until' that has a child, or kNoKey.
+         */
+        unsigned prevKey(unsigned until) const {
+            if (_capacity == 48 || _capacity == 256) {
+                for (unsigned key = std::min(until, 256u); key-- > 0;) {
+                    if (_capacity == 48 ? _keys[key] != 0 : _slots[key] != nullptr)
+                        return key;
+                }
+                return kNoKey;
+            }
+
+            for (unsigned i = _size; i-- > 0;) {
+                if (_keys[i] < until)
+                    return _keys[i];
+            }
+            return kNoKey;
+        }
+
+        const std::shared_ptr<Node>& first() const {
+            return empty() ? _none() : (*this)[nextKey(0)];
+        }
+
+        const std::shared_ptr<Node>& last() const {
+            return empty() ? _none() : (*this)[prevKey(kNoKey)];
+        }
+
+        /**
+         * Returns the number of bytes allocated outside of this object.
+         */
+        size_t allocatedBytes() const {
+            return _keyBytes(_capacity) + _capacity * sizeof(std::shared_ptr<Node>);
+        }
+
+    private:
+        static const std::shared_ptr<Node>& _none() {
+            static const std::shared_ptr<Node> none;
+            return none;
+        }
+
+        // Number of bytes in '_keys': sorted keys for the small sizes, and a key to slot index
+        // for 48 children. Children are found directly by key when there are 256 slots.
+        static size_t _keyBytes(unsigned capacity) {
+            return capacity == 48 ? 256 : capacity == 256 ? 0 : capacity;
+        }
+
+        static unsigned _larger(unsigned capacity) {
+            return capacity == 0 ? 4 : capacity == 4 ? 16 : capacity == 16 ? 48 : 256;
+        }
+
+        static unsigned _smaller(unsigned capacity) {
+            return capacity == 256 ? 48 : capacity == 48 ? 16 : capacity == 16 ? 4 : 0;
+        }
+
+        // Shrinking below the next smaller capacity leaves some room, so that alternating inserts
+        // and removals around a boundary don't resize every time.
+        static unsigned _shrinkThreshold(unsigned capacity) {
+            return capacity == 256 ? 40 : capacity == 48 ? 12 : capacity == 16 ? 3 : 0;
+        }
+
+        void _reset(unsigned capacity) {
+            _capacity = capacity;
+            _size = 0;
+            _keys.reset(_keyBytes(capacity) ? new uint8_t[_keyBytes(capacity)]() : nullptr);
+            _slots.reset(capacity ? new std::shared_ptr<Node>[capacity] : nullptr);
+        }
+
+        // Returns the slot holding the child for 'key', or -1 if there is none.
+        int _find(uint8_t key) const {
+            if (_capacity == 256)
+                return _slots[key] != nullptr ? key : -1;
+            if (_capacity == 48)
+                return int(_keys[key]) - 1;
+
+            for (unsigned i = 0; i < _size && _keys[i] <= key; ++i) {
+                if (_keys[i] == key)
+                    return i;
+            }
+            return -1;
+        }
+
+        // Adds a child for 'key', which must not have one. There must be a free slot.
+        void _insert(uint8_t key, std::shared_ptr<Node> child) {
+            if (_capacity == 256) {
+                _slots[key] = std::move(child);
+            } else if (_capacity == 48) {
+                unsigned slot = 0;
+                while (_slots[slot] != nullptr)
+                    ++slot;
+                _slots[slot] = std::move(child);
+                _keys[key] = slot + 1;
+            } else {
+                unsigned pos = _size;
+                for (; pos > 0 && _keys[pos - 1] > key; --pos) {
+                    _keys[pos] = _keys[pos - 1];
+                    _slots[pos] = std::move(_slots[pos - 1]);
+                }
+                _keys[pos] = key;
+                _slots[pos] = std::move(child);
+            }
+            ++_size;
+        }
+
+        void _remove(uint8_t key, int slot) {
+            if (_capacity == 48)
+                _keys[key] = 0;
+
+            if (_capacity == 48 || _capacity == 256) {
+                _slots[slot] = nullptr;
+            } else {
+                for (unsigned i = slot; i + 1 < _size; ++i) {
+                    _keys[i] = _keys[i + 1];
+                    _slots[i] = std::move(_slots[i + 1]);
+                }
+                _slots[_size - 1] = nullptr;
+            }
+            --_size;
+        }
+
+        void _resize(unsigned capacity) {
+            Children resized;
+            resized._reset(capacity);
+            for (unsigned key = nextKey(0); key != kNoKey; key = nextKey(key + 1)) {
+                resized._insert(key, std::move(_slots[_find(key)]));
+            }
+            *this = std::move(resized);
+        }
+
+        uint16_t _capacity = 0;
+        uint16_t _size = 0;
+        std::unique_ptr<uint8_t[]> _keys;
+        std::unique_ptr<std::shared_ptr<Node>[]> _slots;
+    };
+
+    class Node {
+        friend class RadixStore;
+
+    public:
+        Node() = default;
+
+        Node(std::vector<uint8_t> key) : trieKey(key) {}
+
+        bool isLeaf() const {
+            return children.empty();
         }
 
         std::vector<uint8_t> trieKey;
         boost::optional<value_type> data;
-        std::array<std::shared_ptr<Node>, 256> children;
+        Children children;
 
     private:
         size_type _numSubtreeElems = 0;
@@ -738,14 +937,22 @@ private:
         }
         ret.push_back('\n');
 
-        for (auto child : node->children) {
-            if (child != nullptr) {
-                ret.append(_walkTree(child.get(), depth + 1));
-            }
+        for (unsigned key = node->children.nextKey(0); key != Children::kNoKey;
+             key = node->children.nextKey(key + 1)) {
+            ret.append(_walkTree(node->children[key].get(), depth + 1));
         }
         return ret;
     }
 
+    static size_type _nodeBytes(const Node* node) {
+        size_type bytes = sizeof(Node) + node->trieKey.capacity() + node->children.allocatedBytes();
+        for (unsigned key = node->children.nextKey(0); key != Children::kNoKey;
+             key = node->children.nextKey(key + 1)) {
+            bytes += _nodeBytes(node->children[key].get());
+        }
+        return bytes;
+    }
+
     Node* _findNode(const Key& key) const {
         unsigned int depth = 0;
         const char* charKey = key.data();
@@ -762,7 +969,7 @@ private:
         }
 
         uint8_t childFirstChar = static_cast<uint8_t>(charKey[depth]);
-        auto node = _root->children[childFirstChar];
+        Node* node = _root->children[childFirstChar].get();
 
         while (node != nullptr) {
 
@@ -770,13 +977,13 @@ private:
             if (mismatchIdx != node->trieKey.size()) {
                 return nullptr;
             } else if (mismatchIdx == key.size() - depth && node->data != boost::none) {
-                return node.get();
+                return node;
             }
 
             depth += node->trieKey.size();
 
             childFirstChar = static_cast<uint8_t>(charKey[depth]);
-            node = node->children[childFirstChar];
+            node = node->children[childFirstChar].get();
         }
 
         return nullptr;
@@ -841,7 +1048,7 @@ private:
                 node = std::make_shared<Node>(*old.get());
                 node->_numSubtreeElems = old->_numSubtreeElems;
                 node->_sizeSubtreeElems = old->_sizeSubtreeElems;
-                prev->children[old->trieKey.front()] = node;
+                prev->children.set(old->trieKey.front(), node);
             }
 
             // 'node' is uniquely owned at this point, so we are free to modify it.
@@ -874,7 +1081,7 @@ private:
 
                 // Change the current node's trieKey and make a child of the new node.
                 newKey = _makeKey(node->trieKey, mismatchIdx, node->trieKey.size() - mismatchIdx);
-                newNode->children[newKey.front()] = node;
+                newNode->children.set(newKey.front(), node);
                 node->trieKey = newKey;
 
                 return std::pair<const_iterator, bool>(it, true);
@@ -953,7 +1160,7 @@ private:
             newNode->_numSubtreeElems = node->children[key.front()]->_numSubtreeElems;
             newNode->_sizeSubtreeElems = node->children[key.front()]->_sizeSubtreeElems;
         }
-        node->children[key.front()] = newNode;
+        node->children.set(key.front(), newNode);
         return newNode;
     }
 
@@ -1009,15 +1216,10 @@ private:
         }
 
         // Determine if this node has only one child.
-        std::shared_ptr<Node> onlyChild = nullptr;
-        for (size_t i = 0; i < node->children.size(); ++i) {
-            if (node->children[i] != nullptr) {
-                if (onlyChild != nullptr) {
-                    return;
-                }
-                onlyChild = node->children[i];
-            }
+        if (node->children.size() != 1) {
+            return;
         }
+        std::shared_ptr<Node> onlyChild = node->children.first();
 
         // Append the child's key onto the parent.
         for (char item : onlyChild->trieKey) {
@@ -1067,7 +1269,7 @@ private:
         for (; idx < context.size(); idx++) {
             node = context[idx];
             newNode = std::make_shared<Node>(*node.get());
-            parent->children[node->trieKey.front()] = newNode;
+            parent->children.set(node->trieKey.front(), newNode);
             parent = newNode;
             context[idx] = newNode;
         }
@@ -1169,7 +1371,14 @@ private:
         int numDelta = 0;
         context.push_back(current);
 
-        for (unsigned int key = 0; key < 256; ++key) {
+        // Only keys with a child in at least one of the trees need to be compared.
+        auto nextKey = [&](unsigned from) {
+            return std::min({current->children.nextKey(from),
+                             base->children.nextKey(from),
+                             other->children.nextKey(from)});
+        };
+
+        for (unsigned key = nextKey(0); key != Children::kNoKey; key = nextKey(key + 1)) {
             std::shared_ptr<Node> node = current->children[key];
             std::shared_ptr<Node> baseNode = base->children[key];
             std::shared_ptr<Node> otherNode = other->children[key];
@@ -1184,7 +1393,7 @@ private:
                     numDelta += other->children[key]->_numSubtreeElems;
 
                     current = _makeBranchUnique(context);
-                    current->children[key] = other->children[key];
+                    current->children.set(key, other->children[key]);
                 } else if (baseNode != nullptr && otherNode != nullptr && baseNode == otherNode) {
                     // Don't do anything since it means that master + base have a branch
                     // that current does not, indicnating that current removed that branch.
@@ -1208,7 +1417,7 @@ private:
                         numDelta -= current->children[key]->_numSubtreeElems;
 
                         current = _makeBranchUnique(context);
-                        current->children[key] = nullptr;
+                        current->children.set(key, nullptr);
 
                     } else if (baseNode != nullptr && otherNode != nullptr && baseNode == node) {
                         // If other and current point to the same node, then master changed
@@ -1219,7 +1428,7 @@ private:
                             current->children[key]->_numSubtreeElems;
 
                         current = _makeBranchUnique(context);
-                        current->children[key] = other->children[key];
+                        current->children.set(key, other->children[key]);
                     }
                 } else {
                     // Current node is a unique pointer.
@@ -1268,19 +1477,14 @@ private:
     }
 
     Node* _begin(const std::shared_ptr<Node> root) const noexcept {
-        auto node = root;
+        Node* node = root.get();
         while (node->data == boost::none) {
             if (node->children.empty())
                 return nullptr;
 
-            for (auto child : node->children) {
-                if (child != nullptr) {
-                    node = child;
-                    break;
-                }
-            }
+            node = node->children.first().get();
         }
-        return node.get();
+        return node;
     }
 
     std::shared_ptr<Node> _root;
@@ -0,0 +1,153 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mongo/db/storage/biggie/store.h"
+#include "mongo/db/storage/key_string.h"
+
+namespace mongo {
+namespace biggie {
+namespace {
+
+const Ordering ALL_ASCENDING = Ordering::make(BSONObj());
+
+enum KeyType {
+    SEQUENTIAL_INT,  // Dense keys sharing long prefixes, like a RecordId or an _id index.
+    RANDOM_INT,      // Keys spread over the whole key space.
+    STRING,          // Keys like the ones used by store_test.cpp, encoded as KeyStrings.
+};
+
+std::vector<std::string> generateKeys(KeyType keyType, int numKeys) {
+    std::mt19937_64 gen(1234);
+    std::vector<std::string> keys;
+    for (int i = 0; i < numKeys; ++i) {
+        BSONObj obj;
+        switch (keyType) {
+            case SEQUENTIAL_INT:
+                obj = BSON("" << static_cast<long long>(i));
+                break;
+            case RANDOM_INT:
+                obj = BSON("" << static_cast<long long>(gen()));
+                break;
+            case STRING:
+                obj = BSON("" << ("key" + std::to_string(gen() % (10 * numKeys))));
+                break;
+        }
+        KeyString ks(KeyString::Version::V1, obj, ALL_ASCENDING);
+        keys.emplace_back(ks.getBuffer(), ks.getSize());
+    }
+    return keys;
+}
+
+StringStore makeStore(const std::vector<std::string>& keys) {
+    StringStore store;
+    for (const auto& key : keys) {
+        store.insert(StringStore::value_type(key, "value"));
+    }
+    return store;
+}
+
+// Reports the memory used by the nodes of a store holding the benchmark's keys. The overhead per
+// key is what adaptive node sizes bring down compared to a fixed 256-way array in every node.
+void reportFootprint(benchmark::State& state, const StringStore& store) {
+    state.counters["nodeBytesPerKey"] =
+        static_cast<double>(store.nodeBytes_for_test()) / std::max(store.size(), size_t(1));
+}
+
+void BM_RadixStoreInsert(benchmark::State& state, KeyType keyType) {
+    const std::vector<std::string> keys = generateKeys(keyType, state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(makeStore(keys));
+    }
+    reportFootprint(state, makeStore(keys));
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+void BM_RadixStoreFind(benchmark::State& state, KeyType keyType) {
+    const std::vector<std::string> keys = generateKeys(keyType, state.range(0));
+    const StringStore store = makeStore(keys);
+    for (auto _ : state) {
+        for (const auto& key : keys) {
+            benchmark::DoNotOptimize(store.find(key));
+        }
+    }
+    reportFootprint(state, store);
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+void BM_RadixStoreIterate(benchmark::State& state, KeyType keyType) {
+    const StringStore store = makeStore(generateKeys(keyType, state.range(0)));
+    for (auto _ : state) {
+        for (const auto& entry : store) {
+            benchmark::DoNotOptimize(entry);
+        }
+    }
+    reportFootprint(state, store);
+    state.SetItemsProcessed(state.iterations() * store.size());
+}
+
+// Modifies a copy of the store, as a transaction does with a snapshot, so that every node on the
+// path to the key is copied.
+void BM_RadixStoreCopyOnWrite(benchmark::State& state, KeyType keyType) {
+    const std::vector<std::string> keys = generateKeys(keyType, state.range(0));
+    const StringStore store = makeStore(keys);
+    size_t i = 0;
+    for (auto _ : state) {
+        StringStore copy(store);
+        copy.update(StringStore::value_type(keys[i++ % keys.size()], "other"));
+        benchmark::DoNotOptimize(copy);
+    }
+    reportFootprint(state, store);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_RadixStoreInsert, SequentialInt, SEQUENTIAL_INT)->Arg(1000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_RadixStoreInsert, RandomInt, RANDOM_INT)->Arg(1000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_RadixStoreInsert, String, STRING)->Arg(1000)->Arg(100000);
+
+BENCHMARK_CAPTURE(BM_RadixStoreFind, SequentialInt, SEQUENTIAL_INT)->Arg(1000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_RadixStoreFind, RandomInt, RANDOM_INT)->Arg(1000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_RadixStoreFind, String, STRING)->Arg(1000)->Arg(100000);
+
+BENCHMARK_CAPTURE(BM_RadixStoreIterate, SequentialInt, SEQUENTIAL_INT)->Arg(1000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_RadixStoreIterate, RandomInt, RANDOM_INT)->Arg(1000)->Arg(100000);
+BENCHMARK_CAPTURE(BM_RadixStoreIterate, String, STRING)->Arg(1000)->Arg(100000);
+
+BENCHMARK_CAPTURE(BM_RadixStoreCopyOnWrite, SequentialInt, SEQUENTIAL_INT)->Arg(100000);
+BENCHMARK_CAPTURE(BM_RadixStoreCopyOnWrite, RandomInt, RANDOM_INT)->Arg(100000);
+BENCHMARK_CAPTURE(BM_RadixStoreCopyOnWrite, String, STRING)->Arg(100000);
+
+}  // namespace
+}  // namespace biggie
+}  // namespace mongo
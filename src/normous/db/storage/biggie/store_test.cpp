@@ -32,6 +32,7 @@
 #include "mongo/platform/basic.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
+#include <algorithm>
 #include <iostream>
 
 namespace mongo {
@@ -1611,6 +1612,112 @@ TEST_F(RadixStoreTest, PathCompressionTest) {
               "\n food*"
               "\n  ie*\n");
 }
+
+TEST_F(RadixStoreTest, LowerBoundTestLargestByteCharacter) {
+    value_type value1 = std::make_pair("a", "1");
+    value_type value2 = std::make_pair(std::string("\xff\0", 2), "2");
+
+    thisStore.insert(value_type(value1));
+    thisStore.insert(value_type(value2));
+
+    // Every key in the tree is less than the search key, so the search must not wrap around to the
+    // smallest children of the root after examining the child for 0xff.
+    StringStore::const_iterator iter = thisStore.lower_bound(std::string("\xff\x01", 2));
+    ASSERT_TRUE(iter == thisStore.end());
+}
+
+TEST_F(RadixStoreTest, EraseKeyWithoutValueTest) {
+    value_type value1 = std::make_pair("food", "1");
+    value_type value2 = std::make_pair("foos", "2");
+
+    thisStore.insert(value_type(value1));
+    thisStore.insert(value_type(value2));
+
+    // "foo" has a node, as the shared prefix of both keys, but no value.
+    ASSERT_EQ(thisStore.erase("foo"), StringStore::size_type(0));
+    ASSERT_EQ(thisStore.size(), StringStore::size_type(2));
+    ASSERT_EQ(thisStore.dataSize(), StringStore::size_type(2));
+}
+
+TEST_F(RadixStoreTest, AdaptiveNodeGrowAndShrinkTest) {
+    // Insert children of a single node in a scrambled order, so that it passes through every node
+    // size, and check the order of the tree at each step.
+    std::vector<std::string> keys;
+    for (int i = 0; i < 256; ++i) {
+        keys.push_back(std::string("a") + static_cast<char>((i * 97) % 256));
+    }
+
+    std::vector<std::string> sorted;
+    for (const auto& key : keys) {
+        thisStore.insert(value_type(key, "1"));
+        sorted.insert(std::lower_bound(sorted.begin(), sorted.end(), key), key);
+
+        ASSERT_EQ(thisStore.size(), sorted.size());
+        ASSERT_TRUE(std::equal(sorted.begin(),
+                               sorted.end(),
+                               thisStore.begin(),
+                               [](const std::string& key, const value_type& value) {
+                                   return key == value.first;
+                               }));
+        ASSERT_TRUE(std::equal(sorted.rbegin(),
+                               sorted.rend(),
+                               thisStore.rbegin(),
+                               [](const std::string& key, const value_type& value) {
+                                   return key == value.first;
+                               }));
+    }
+
+    for (const auto& key : keys) {
+        ASSERT_TRUE(thisStore.find(key) != thisStore.end());
+        ASSERT_EQ(thisStore.lower_bound(key)->first, key);
+    }
+
+    // Erase them again in a different order, so that the node shrinks back down.
+    for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
+        ASSERT_EQ(thisStore.erase(*it), StringStore::size_type(1));
+        sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), *it));
+
+        ASSERT_EQ(thisStore.size(), sorted.size());
+        ASSERT_TRUE(std::equal(sorted.begin(),
+                               sorted.end(),
+                               thisStore.begin(),
+                               [](const std::string& key, const value_type& value) {
+                                   return key == value.first;
+                               }));
+    }
+    ASSERT_TRUE(thisStore.empty());
+}
+
+TEST_F(RadixStoreTest, AdaptiveNodeCopyOnWriteTest) {
+    for (char c = 'a'; c < 'a' + 10; ++c) {
+        baseStore.insert(value_type(std::string("key") + c, "1"));
+    }
+
+    // Grow and then shrink the shared node in a copy. The original must not change.
+    thisStore = baseStore;
+    expected = baseStore;
+    for (int i = 0; i < 100; ++i) {
+        thisStore.insert(value_type("key" + std::to_string(i), "2"));
+    }
+    ASSERT_EQ(thisStore.size(), StringStore::size_type(110));
+    ASSERT_TRUE(baseStore == expected);
+
+    for (char c = 'a'; c < 'a' + 10; ++c) {
+        thisStore.erase(std::string("key") + c);
+    }
+    ASSERT_EQ(thisStore.size(), StringStore::size_type(100));
+    ASSERT_EQ(baseStore.size(), StringStore::size_type(10));
+    ASSERT_TRUE(baseStore == expected);
+}
+
+TEST_F(RadixStoreTest, SparseNodesFootprintTest) {
+    // With a fixed array of 256 child pointers per node, every node would take several kilobytes.
+    // Nodes that are sparse, like these, should only pay for the children they have.
+    for (int i = 0; i < 1000; ++i) {
+        thisStore.insert(value_type("key" + std::to_string(i * 7919), "1"));
+    }
+    ASSERT_LT(thisStore.nodeBytes_for_test() / thisStore.size(), StringStore::size_type(512));
+}
 }  // namespace
 }  // mongo namespace
 }  // biggie namespace
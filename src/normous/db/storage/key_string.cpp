@@ -234,11 +234,30 @@ void memcpy_flipBits(void* dst, const void* src, size_t bytes) {
     const char* input = static_cast<const char*>(src);
     char* output = static_cast<char*>(dst);
     const char* const end = input + bytes;
+
+    // Flip a word at a time while at least a word is left. The memcpys compile to unaligned loads
+    // and stores.
+    for (; end - input >= static_cast<ptrdiff_t>(sizeof(uint64_t));
+         input += sizeof(uint64_t), output += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, input, sizeof(word));
+        word = ~word;
+        memcpy(output, &word, sizeof(word));
+    }
+
     while (input != end) {
         *output++ = ~(*input++);
     }
 }
 
+void copyBytes(char* dst, const void* src, size_t bytes, bool invert) {
+    if (invert) {
+        memcpy_flipBits(dst, src, bytes);
+    } else {
+        memcpy(dst, src, bytes);
+    }
+}
+
 template <typename T>
 T readType(BufReader* reader, bool inverted) {
     MONGO_STATIC_ASSERT(std::is_integral<T>::value);
@@ -588,7 +607,6 @@ void KeyString::_appendDoubleWithoutTypeBits(const double num,
             const size_t fractionalBytes = countLeadingZeros64(integerPart << 1) / 8;
             const auto ctype = isNegative ? CType::kNumericNegative8ByteInt + fractionalBytes
                                           : CType::kNumericPositive8ByteInt - fractionalBytes;
-            _append(static_cast<uint8_t>(ctype), invert);
 
             // Multiplying the double by 256 to the power X is logically equivalent to shifting the
             // fraction left by X bytes.
@@ -603,7 +621,10 @@ void KeyString::_appendDoubleWithoutTypeBits(const double num,
             invariant((encoding & 0x3ULL) == 0);
             encoding |= dcm;
             encoding = endian::nativeToBig(encoding);
-            _append(encoding, isNegative ? !invert : invert);
+
+            char* const dst = _buffer.skip(1 + sizeof(encoding));
+            dst[0] = invert ? ~static_cast<uint8_t>(ctype) : static_cast<uint8_t>(ctype);
+            copyBytes(dst + 1, &encoding, sizeof(encoding), isNegative ? !invert : invert);
         }
     } else {
         _appendLargeDouble(num, dcm, invert);
@@ -860,13 +881,17 @@ void KeyString::_appendBsonValue(const BSONElement& elem, bool invert, const Str
 void KeyString::_appendStringLike(StringData str, bool invert) {
     while (true) {
         size_t firstNul = strnlen(str.rawData(), str.size());
-        // No NULs in string.
-        _appendBytes(str.rawData(), firstNul, invert);
-        if (firstNul == str.size() || firstNul == std::string::npos) {
-            _append(int8_t(0), invert);
+        if (firstNul == str.size()) {
+            // No NULs in the rest of the string, which is the common case. Append it along with the
+            // terminating NUL in one go.
+            char* const dst = _buffer.skip(firstNul + 1);
+            copyBytes(dst, str.rawData(), firstNul, invert);
+            dst[firstNul] = invert ? ~char(0) : char(0);
             break;
         }
 
+        _appendBytes(str.rawData(), firstNul, invert);
+
         // replace "\x00" with "\x00\xFF"
         _appendBytes("\x00\xFF", 2, invert);
         str = str.substr(firstNul + 1);  // skip over the NUL byte
@@ -1051,13 +1076,14 @@ void KeyString::_appendPreshiftedIntegerPortion(uint64_t value, bool isNegative,
     value = endian::nativeToBig(value);
     const void* firstUsedByte = reinterpret_cast<const char*>((&value) + 1) - bytesNeeded;
 
-    if (isNegative) {
-        _append(uint8_t(CType::kNumericNegative1ByteInt - (bytesNeeded - 1)), invert);
-        _appendBytes(firstUsedByte, bytesNeeded, !invert);
-    } else {
-        _append(uint8_t(CType::kNumericPositive1ByteInt + (bytesNeeded - 1)), invert);
-        _appendBytes(firstUsedByte, bytesNeeded, invert);
-    }
+    const uint8_t ctype = isNegative ? uint8_t(CType::kNumericNegative1ByteInt - (bytesNeeded - 1))
+                                     : uint8_t(CType::kNumericPositive1ByteInt + (bytesNeeded - 1));
+
+    // Every integer and integral double ends up here, so grow the buffer once for both the ctype
+    // and the value.
+    char* const dst = _buffer.skip(1 + bytesNeeded);
+    dst[0] = invert ? ~ctype : ctype;
+    copyBytes(dst + 1, firstUsedByte, bytesNeeded, isNegative ? !invert : invert);
 }
 
 template <typename T>
@@ -1066,13 +1092,7 @@ void KeyString::_append(const T& thing, bool invert) {
 }
 
 void KeyString::_appendBytes(const void* source, size_t bytes, bool invert) {
-    char* const base = _buffer.skip(bytes);
-
-    if (invert) {
-        memcpy_flipBits(base, source, bytes);
-    } else {
-        memcpy(base, source, bytes);
-    }
+    copyBytes(_buffer.skip(bytes), source, bytes, invert);
 }
 
 
@@ -34,6 +34,8 @@
 #include <random>
 #include <vector>
 
+#include "mongo/db/query/collation/collation_index_key.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
 #include "mongo/db/storage/key_string.h"
 #include "mongo/platform/decimal128.h"
 #include "mongo/util/bufreader.h"
@@ -48,6 +50,7 @@ const int kStrLenMultiplier = 100;
 const int kArrLenMultiplier = 40;
 
 const Ordering ALL_ASCENDING = Ordering::make(BSONObj());
+const Ordering ALL_DESCENDING = Ordering::make(BSON("a" << -1 << "b" << -1 << "c" << -1));
 
 struct BsonsAndKeyStrings {
     int bsonSize = 0;
@@ -62,11 +65,26 @@ struct BsonsAndKeyStrings {
 enum BsonValueType {
     INT,
     DOUBLE,
+    INTEGRAL_DOUBLE,
     STRING,
+    COLLATED_STRING,
     ARRAY,
     DECIMAL,
+    COMPOUND,
+    NESTED,
+    MIXED_NUMERIC,
 };
 
+std::string generateString(std::mt19937& gen) {
+    std::exponential_distribution<double> expDist(1.0);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::string str(expDist(gen) * kStrLenMultiplier / 4, '\0');
+    for (auto& c : str) {
+        c = letter(gen);
+    }
+    return str;
+}
+
 BSONObj generateBson(BsonValueType bsonValueType) {
     std::mt19937 gen(seedGen());
     std::exponential_distribution<double> expReal(1e-3);
@@ -77,8 +95,20 @@ BSONObj generateBson(BsonValueType bsonValueType) {
             return BSON("" << static_cast<int>(expReal(gen)));
         case DOUBLE:
             return BSON("" << expReal(gen));
+        case INTEGRAL_DOUBLE:
+            // Numbers that came in through JSON or the shell are doubles even if integral.
+            return BSON("" << static_cast<double>(static_cast<long long>(expReal(gen))));
         case STRING:
             return BSON("" << std::string(expDist(gen) * kStrLenMultiplier, 'x'));
+        case COLLATED_STRING: {
+            // Indexes with a collation store comparison keys in place of strings.
+            static const CollatorInterfaceMock collator(
+                CollatorInterfaceMock::MockType::kToLowerString);
+            BSONObjBuilder bob;
+            CollationIndexKey::collationAwareIndexKeyAppend(
+                BSON("" << generateString(gen)).firstElement(), &collator, &bob);
+            return bob.obj();
+        }
         case ARRAY: {
             const int arrLen = expDist(gen) * kArrLenMultiplier;
             BSONArrayBuilder bab;
@@ -92,18 +122,38 @@ BSONObj generateBson(BsonValueType bsonValueType) {
                                          Decimal128::kRoundTo34Digits,
                                          Decimal128::kRoundTiesToAway)
                                   .quantize(Decimal128("0.01", Decimal128::kRoundTiesToAway)));
+        case COMPOUND:
+            // A typical secondary index on several fields.
+            return BSON("" << static_cast<int>(expReal(gen)) << "" << generateString(gen) << ""
+                           << expReal(gen));
+        case NESTED:
+            return BSON("" << BSON("a" << BSON("b" << static_cast<int>(expReal(gen)) << "c"
+                                                   << generateString(gen))
+                                       << "d"
+                                       << BSON_ARRAY(expReal(gen) << BSON("e" << true))));
+        case MIXED_NUMERIC: {
+            // Every element needs type bits to be told apart from the other numeric types.
+            BSONArrayBuilder bab;
+            for (int i = 0; i < 8; i++) {
+                bab.append(static_cast<long long>(expReal(gen)));
+                bab.append(-0.0);
+                bab.append(Decimal128(static_cast<int>(expReal(gen))));
+            }
+            return BSON("" << bab.arr());
+        }
     }
     MONGO_UNREACHABLE;
 }
 
 static BsonsAndKeyStrings generateBsonsAndKeyStrings(BsonValueType bsonValueType,
-                                                     KeyString::Version version) {
+                                                     KeyString::Version version,
+                                                     Ordering ordering = ALL_ASCENDING) {
     BsonsAndKeyStrings result;
     result.bsonSize = 0;
     result.keystringSize = 0;
     for (int i = 0; i < kSampleSize; i++) {
         BSONObj bson = generateBson(bsonValueType);
-        KeyString ks(version, bson, ALL_ASCENDING);
+        KeyString ks(version, bson, ordering);
         result.bsonSize += bson.objsize();
         result.keystringSize += ks.getSize();
         result.bsons[i] = bson;
@@ -114,19 +164,21 @@ static BsonsAndKeyStrings generateBsonsAndKeyStrings(BsonValueType bsonValueType
 
         result.typebits[i] = SharedBuffer::allocate(ks.getTypeBits().getSize());
         memcpy(result.typebits[i].get(), ks.getTypeBits().getBuffer(), ks.getTypeBits().getSize());
-        result.typebitsLens[i] = ks.getSize();
+        result.typebitsLens[i] = ks.getTypeBits().getSize();
     }
     return result;
 }
 
 void BM_BSONToKeyString(benchmark::State& state,
                         const KeyString::Version version,
-                        BsonValueType bsonType) {
-    const BsonsAndKeyStrings bsonsAndKeyStrings = generateBsonsAndKeyStrings(bsonType, version);
+                        BsonValueType bsonType,
+                        Ordering ordering = ALL_ASCENDING) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings =
+        generateBsonsAndKeyStrings(bsonType, version, ordering);
     for (auto _ : state) {
         benchmark::ClobberMemory();
         for (auto bson : bsonsAndKeyStrings.bsons) {
-            benchmark::DoNotOptimize(KeyString(version, bson, ALL_ASCENDING));
+            benchmark::DoNotOptimize(KeyString(version, bson, ordering));
         }
     }
     state.SetBytesProcessed(state.iterations() * bsonsAndKeyStrings.bsonSize);
@@ -135,8 +187,10 @@ void BM_BSONToKeyString(benchmark::State& state,
 
 void BM_KeyStringToBSON(benchmark::State& state,
                         const KeyString::Version version,
-                        BsonValueType bsonType) {
-    const BsonsAndKeyStrings bsonsAndKeyStrings = generateBsonsAndKeyStrings(bsonType, version);
+                        BsonValueType bsonType,
+                        Ordering ordering = ALL_ASCENDING) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings =
+        generateBsonsAndKeyStrings(bsonType, version, ordering);
     for (auto _ : state) {
         benchmark::ClobberMemory();
         for (size_t i = 0; i < kSampleSize; i++) {
@@ -144,7 +198,7 @@ void BM_KeyStringToBSON(benchmark::State& state,
             benchmark::DoNotOptimize(
                 KeyString::toBson(bsonsAndKeyStrings.keystrings[i].get(),
                                   bsonsAndKeyStrings.keystringLens[i],
-                                  ALL_ASCENDING,
+                                  ordering,
                                   KeyString::TypeBits::fromBuffer(version, &buf)));
         }
     }
@@ -161,6 +215,16 @@ BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_String, KeyString::Version::V0, STRING)
 BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_String, KeyString::Version::V1, STRING);
 BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_Array, KeyString::Version::V0, ARRAY);
 BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Array, KeyString::Version::V1, ARRAY);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_IntegralDouble, KeyString::Version::V1, INTEGRAL_DOUBLE);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_CollatedString, KeyString::Version::V1, COLLATED_STRING);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_Compound, KeyString::Version::V0, COMPOUND);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Compound, KeyString::Version::V1, COMPOUND);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Nested, KeyString::Version::V1, NESTED);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_MixedNumeric, KeyString::Version::V1, MIXED_NUMERIC);
+BENCHMARK_CAPTURE(
+    BM_BSONToKeyString, V1_Descending_String, KeyString::Version::V1, STRING, ALL_DESCENDING);
+BENCHMARK_CAPTURE(
+    BM_BSONToKeyString, V1_Descending_Compound, KeyString::Version::V1, COMPOUND, ALL_DESCENDING);
 
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Int, KeyString::Version::V0, INT);
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Int, KeyString::Version::V1, INT);
@@ -171,5 +235,15 @@ BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_String, KeyString::Version::V0, STRING)
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_String, KeyString::Version::V1, STRING);
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Array, KeyString::Version::V0, ARRAY);
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Array, KeyString::Version::V1, ARRAY);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_IntegralDouble, KeyString::Version::V1, INTEGRAL_DOUBLE);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_CollatedString, KeyString::Version::V1, COLLATED_STRING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Compound, KeyString::Version::V0, COMPOUND);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Compound, KeyString::Version::V1, COMPOUND);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Nested, KeyString::Version::V1, NESTED);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_MixedNumeric, KeyString::Version::V1, MIXED_NUMERIC);
+BENCHMARK_CAPTURE(
+    BM_KeyStringToBSON, V1_Descending_String, KeyString::Version::V1, STRING, ALL_DESCENDING);
+BENCHMARK_CAPTURE(
+    BM_KeyStringToBSON, V1_Descending_Compound, KeyString::Version::V1, COMPOUND, ALL_DESCENDING);
 }  // namespace
 }  // namespace mongo
@@ -1353,6 +1353,29 @@ TEST_F(KeyStringTest, VeryLargeString) {
     ROUNDTRIP(version, obj);
 }
 
+TEST_F(KeyStringTest, StringsWithNulsAtEveryPosition) {
+    // Strings are copied a word at a time, so cover NULs on both sides of word boundaries, in both
+    // orders.
+    std::vector<BSONObj> objs;
+    for (size_t len = 0; len < 20; ++len) {
+        objs.push_back(BSON("" << std::string(len, 'a')));
+        for (size_t nulPos = 0; nulPos < len; ++nulPos) {
+            std::string str(len, 'a');
+            str[nulPos] = '\0';
+            objs.push_back(BSON("" << str));
+        }
+    }
+
+    for (const auto& obj : objs) {
+        ROUNDTRIP(version, obj);
+    }
+    for (const auto& x : objs) {
+        for (const auto& y : objs) {
+            COMPARES_SAME(version, x, y);
+        }
+    }
+}
+
 TEST_F(KeyStringTest, ToBsonSafeShouldNotTerminate) {
     KeyString::TypeBits typeBits(KeyString::Version::V1);
 
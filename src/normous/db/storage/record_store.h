@@ -202,6 +202,17 @@ public:
      */
     virtual boost::optional<Record> seekExact(const RecordId& id) = 0;
 
+    /**
+     * Positions the cursor so that the following call to next() returns the first record at or
+     * after 'id' in the direction of the scan, whether or not a record with that id exists.
+     *
+     * Returns false if this cursor does not support such seeks or could not be positioned, in
+     * which case its position is unspecified.
+     */
+    virtual bool seekAtOrAfter(const RecordId& id) {
+        return false;
+    }
+
     /**
      * Prepares for state changes in underlying data without necessarily saving the current
      * state.
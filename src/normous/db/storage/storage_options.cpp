@@ -44,6 +44,7 @@ void StorageGlobalParams::reset() {
     engine = "wiredTiger";
     engineSetByUser = false;
     dbpath = kDefaultDbPath;
+    spillDirectory.clear();
     upgrade = false;
     repair = false;
 
@@ -57,6 +58,10 @@ void StorageGlobalParams::reset() {
     groupCollections = false;
 }
 
+std::string StorageGlobalParams::getSpillDirectory() const {
+    return spillDirectory.empty() ? dbpath + "/_tmp" : spillDirectory;
+}
+
 StorageGlobalParams storageGlobalParams;
 
 /**
@@ -82,6 +87,13 @@ namespace {
 ExportedServerParameter<bool, ServerParameterType::kStartupAndRuntime> NoTableScanSetting(
     ServerParameterSet::getGlobal(), "notablescan", &storageGlobalParams.noTableScan);
 
+/**
+ * Specify the directory temporary spill files are written to, for example by external sorts and
+ * $group. Placing it on a separate volume keeps spills from competing with the data files for I/O.
+ */
+ExportedServerParameter<std::string, ServerParameterType::kStartupOnly> SpillDirectorySetting(
+    ServerParameterSet::getGlobal(), "spillDirectory", &storageGlobalParams.spillDirectory);
+
 /**
  * Specify the interval in seconds between fsync operations where mongod flushes its
  * working memory to disk. By default, mongod flushes memory to disk every 60 seconds.
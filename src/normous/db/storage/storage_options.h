@@ -64,6 +64,14 @@ struct StorageGlobalParams {
     // The directory where the mongod instance stores its data.
     std::string dbpath;
 
+    // spillDirectory server parameter
+    // The directory external sorts and other operations place temporary spill files in. If empty,
+    // they go under the "_tmp" directory of dbpath. See getSpillDirectory().
+    std::string spillDirectory;
+
+    // Returns spillDirectory if set, and otherwise the "_tmp" directory under dbpath.
+    std::string getSpillDirectory() const;
+
     // --upgrade
     // Upgrades the on-disk data format of the files specified by the --dbpath to the
     // latest version, if needed.
@@ -1933,6 +1933,20 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordI
     return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
 }
 
+bool WiredTigerRecordStoreCursorBase::seekAtOrAfter(const RecordId& id) {
+    // Act as if the record just before 'id' in the direction of the scan had been returned, and
+    // let restore() land on the closest record from there. A null '_lastReturnedId' makes
+    // restore() start over from the beginning.
+    if (_forward ? id <= RecordId::min() : id >= RecordId::max()) {
+        _lastReturnedId = RecordId();
+    } else {
+        _lastReturnedId = RecordId(_forward ? id.repr() - 1 : id.repr() + 1);
+    }
+    _eof = false;
+
+    save();
+    return restore();
+}
 
 void WiredTigerRecordStoreCursorBase::save() {
     try {
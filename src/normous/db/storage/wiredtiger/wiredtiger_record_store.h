@@ -431,6 +431,8 @@ public:
 
     boost::optional<Record> seekExact(const RecordId& id);
 
+    bool seekAtOrAfter(const RecordId& id);
+
     void save();
 
     void saveUnpositioned();
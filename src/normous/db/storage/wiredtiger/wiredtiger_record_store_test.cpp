@@ -32,6 +32,7 @@
 #include <sstream>
 #include <string>
 #include <time.h>
+#include <vector>
 
 #include "mongo/base/checked_cast.h"
 #include "mongo/base/init.h"
@@ -402,6 +403,60 @@ TEST(WiredTigerRecordStoreTest, CappedCursorYieldFirst) {
     ASSERT(!cursor->next());
 }
 
+TEST(WiredTigerRecordStoreTest, SeekAtOrAfter) {
+    const auto harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+
+    std::vector<RecordId> ids;
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        for (int i = 0; i < 5; i++) {
+            StatusWith<RecordId> res = rs->insertRecord(opCtx.get(), "a", 2, Timestamp());
+            ASSERT_OK(res.getStatus());
+            ids.push_back(res.getValue());
+        }
+        uow.commit();
+    }
+
+    // Leave a hole at ids[2].
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        rs->deleteRecord(opCtx.get(), ids[2]);
+        uow.commit();
+    }
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+
+    // Seeking to an existing record returns it next.
+    auto cursor = rs->getCursor(opCtx.get());
+    ASSERT_TRUE(cursor->seekAtOrAfter(ids[1]));
+    auto record = cursor->next();
+    ASSERT(record);
+    ASSERT_EQ(ids[1], record->id);
+
+    // Seeking to a deleted record lands on the one after it, also across a yield.
+    ASSERT_TRUE(cursor->seekAtOrAfter(ids[2]));
+    cursor->save();
+    opCtx->recoveryUnit()->abandonSnapshot();
+    ASSERT_TRUE(cursor->restore());
+    record = cursor->next();
+    ASSERT(record);
+    ASSERT_EQ(ids[3], record->id);
+
+    // Reverse cursors land on the closest record before a missing one.
+    auto reverseCursor = rs->getCursor(opCtx.get(), false);
+    ASSERT_TRUE(reverseCursor->seekAtOrAfter(ids[2]));
+    record = reverseCursor->next();
+    ASSERT(record);
+    ASSERT_EQ(ids[1], record->id);
+
+    // Seeking past the last record reaches EOF.
+    ASSERT_TRUE(cursor->seekAtOrAfter(RecordId(ids[4].repr() + 1)));
+    ASSERT(!cursor->next());
+}
+
 BSONObj makeBSONObjWithSize(const Timestamp& opTime, int size, char fill = 'x') {
     BSONObj objTemplate = BSON("ts" << opTime << "str"
                                     << "");
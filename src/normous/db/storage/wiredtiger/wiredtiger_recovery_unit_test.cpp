@@ -37,6 +37,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/clock_source_mock.h"
@@ -578,5 +579,49 @@ TEST_F(WiredTigerRecoveryUnitTestFixture, ReadOnceCursorsAreNotCached) {
 
     ASSERT(ru->getReadOnce());
 }
+
+BSONObj getSessionCacheStats(const WiredTigerSessionCache& cache) {
+    BSONObjBuilder builder;
+    cache.appendStats(&builder);
+    return builder.obj()["sessionCache"].Obj().getOwned();
+}
+
+TEST_F(WiredTigerRecoveryUnitTestFixture, SessionCacheSharesSessionsBetweenThreads) {
+    WiredTigerSessionCache cache(harnessHelper->getEngine()->getConnection(), 4);
+
+    WiredTigerSession* released = cache.getSession().get();
+
+    // Whichever partition the other thread is assigned, it finds the session cached by this one
+    // rather than opening a new one.
+    WiredTigerSession* reused = nullptr;
+    stdx::thread thread([&] { reused = cache.getSession().get(); });
+    thread.join();
+    ASSERT_EQ(released, reused);
+
+    BSONObj stats = getSessionCacheStats(cache);
+    ASSERT_EQ(4, stats["partitions"].numberLong());
+    ASSERT_EQ(1, stats["sessionsCreated"].numberLong());
+    ASSERT_EQ(1, stats["cachedSessions"].numberLong());
+    ASSERT_EQ(2, stats["checkoutLatency"]["ops"].numberLong());
+}
+
+TEST_F(WiredTigerRecoveryUnitTestFixture, SessionCacheCloseAllDiscardsSessionsOfOldEpoch) {
+    WiredTigerSessionCache cache(harnessHelper->getEngine()->getConnection(), 4);
+
+    UniqueWiredTigerSession held = cache.getSession();
+    cache.getSession().reset();
+    ASSERT_EQ(1, getSessionCacheStats(cache)["cachedSessions"].numberLong());
+
+    // Both the cached session and the one checked out before closeAll() are closed, rather than
+    // returned to any partition.
+    cache.closeAll();
+    held.reset();
+    ASSERT_EQ(0, getSessionCacheStats(cache)["cachedSessions"].numberLong());
+
+    cache.getSession().reset();
+    BSONObj stats = getSessionCacheStats(cache);
+    ASSERT_EQ(3, stats["sessionsCreated"].numberLong());
+    ASSERT_EQ(1, stats["cachedSessions"].numberLong());
+}
 }  // namespace
 }  // namespace mongo
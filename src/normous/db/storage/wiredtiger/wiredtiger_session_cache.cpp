@@ -36,6 +36,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 
 #include "mongo/base/error_codes.h"
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/global_settings.h"
 #include "mongo/db/repl/repl_settings.h"
@@ -43,10 +44,14 @@
 #include "mongo/db/storage/journal_listener.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/platform/bits.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/system_tick_source.h"
+#include "mongo/util/tick_source.h"
 
 namespace mongo {
 
@@ -86,6 +91,17 @@ ExportedServerParameter<std::int32_t, ServerParameterType::kStartupAndRuntime>
                                      "wiredTigerCursorCacheSize",
                                      &kWiredTigerCursorCacheSize);
 
+// The number of partitions the session cache is split into. The default of 0 uses one partition
+// per available core.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerSessionCachePartitions, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 1024) {
+            return Status(ErrorCodes::BadValue,
+                          "wiredTigerSessionCachePartitions must be between 0 and 1024");
+        }
+        return Status::OK();
+    });
+
 WiredTigerSession::WiredTigerSession(WT_CONNECTION* conn, uint64_t epoch, uint64_t cursorEpoch)
     : _epoch(epoch), _cursorEpoch(cursorEpoch), _session(NULL), _cursorGen(0), _cursorsOut(0) {
     invariantWTOK(conn->open_session(conn, NULL, "isolation=snapshot", &_session));
@@ -224,11 +240,37 @@ uint64_t WiredTigerSession::genTableId() {
 
 // -----------------------
 
-WiredTigerSessionCache::WiredTigerSessionCache(WiredTigerKVEngine* engine)
-    : _engine(engine), _conn(engine->getConnection()), _shuttingDown(0) {}
+namespace {
+// Threads are assigned session cache partitions round-robin, the first time they use a cache.
+AtomicUInt32 nextThreadPartition;
+thread_local int64_t threadPartition = -1;
+
+size_t getNumSessionCachePartitions(size_t requested) {
+    if (requested == 0) {
+        requested = wiredTigerSessionCachePartitions;
+    }
+    if (requested == 0) {
+        requested = ProcessInfo::getNumAvailableCores();
+    }
+    return std::max(requested, size_t(1));
+}
+}  // namespace
 
-WiredTigerSessionCache::WiredTigerSessionCache(WT_CONNECTION* conn)
-    : _engine(NULL), _conn(conn), _shuttingDown(0) {}
+WiredTigerSessionCache::WiredTigerSessionCache(WiredTigerKVEngine* engine)
+    : _engine(engine),
+      _conn(engine->getConnection()),
+      _shuttingDown(0),
+      _numPartitions(getNumSessionCachePartitions(0)),
+      _partitions(stdx::make_unique<Partition[]>(_numPartitions)),
+      _tickSource(SystemTickSource::get()) {}
+
+WiredTigerSessionCache::WiredTigerSessionCache(WT_CONNECTION* conn, size_t numPartitions)
+    : _engine(NULL),
+      _conn(conn),
+      _shuttingDown(0),
+      _numPartitions(getNumSessionCachePartitions(numPartitions)),
+      _partitions(stdx::make_unique<Partition[]>(_numPartitions)),
+      _tickSource(SystemTickSource::get()) {}
 
 WiredTigerSessionCache::~WiredTigerSessionCache() {
     shuttingDown();
@@ -348,9 +390,13 @@ void WiredTigerSessionCache::notifyPreparedUnitOfWorkHasCommittedOrAborted() {
 
 
 void WiredTigerSessionCache::closeAllCursors(const std::string& uri) {
-    stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-    for (SessionCache::iterator i = _sessions.begin(); i != _sessions.end(); i++) {
-        (*i)->closeAllCursors(uri);
+    for (size_t p = 0; p < _numPartitions; p++) {
+        Partition& partition = _partitions[p];
+        stdx::lock_guard<stdx::mutex> lock(partition.lock);
+        for (SessionCache::iterator i = partition.sessions.begin(); i != partition.sessions.end();
+             i++) {
+            (*i)->closeAllCursors(uri);
+        }
     }
 }
 
@@ -358,24 +404,37 @@ void WiredTigerSessionCache::closeCursorsForQueuedDrops() {
     // Increment the cursor epoch so that all cursors from this epoch are closed.
     _cursorEpoch.fetchAndAdd(1);
 
-    stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-    for (SessionCache::iterator i = _sessions.begin(); i != _sessions.end(); i++) {
-        (*i)->closeCursorsForQueuedDrops(_engine);
+    for (size_t p = 0; p < _numPartitions; p++) {
+        Partition& partition = _partitions[p];
+        stdx::lock_guard<stdx::mutex> lock(partition.lock);
+        for (SessionCache::iterator i = partition.sessions.begin(); i != partition.sessions.end();
+             i++) {
+            (*i)->closeCursorsForQueuedDrops(_engine);
+        }
     }
 }
 
 void WiredTigerSessionCache::closeAll() {
-    // Increment the epoch as we are now closing all sessions with this epoch.
-    SessionCache swap;
+    std::vector<SessionCache> swap(_numPartitions);
 
-    {
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        _epoch.fetchAndAdd(1);
-        _sessions.swap(swap);
+    // Increment the epoch as we are now closing all sessions with this epoch. All the partitions
+    // are locked, in order, while doing so, so that no session of the old epoch can be returned to
+    // a partition that has already been emptied.
+    for (size_t p = 0; p < _numPartitions; p++) {
+        _partitions[p].lock.lock();
+    }
+    _epoch.fetchAndAdd(1);
+    for (size_t p = 0; p < _numPartitions; p++) {
+        Partition& partition = _partitions[p];
+        partition.sessions.swap(swap[p]);
+        partition.numSessions.store(0);
+        partition.lock.unlock();
     }
 
-    for (SessionCache::iterator i = swap.begin(); i != swap.end(); i++) {
-        delete (*i);
+    for (auto&& sessions : swap) {
+        for (SessionCache::iterator i = sessions.begin(); i != sessions.end(); i++) {
+            delete (*i);
+        }
     }
 }
 
@@ -388,20 +447,107 @@ UniqueWiredTigerSession WiredTigerSessionCache::getSession() {
     // operations should be allowed to start.
     invariant(!(_shuttingDown.loadRelaxed() & kShuttingDownMask));
 
-    {
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        if (!_sessions.empty()) {
-            // Get the most recently used session so that if we discard sessions, we're
-            // discarding older ones
-            WiredTigerSession* cachedSession = _sessions.back();
-            _sessions.pop_back();
-            return UniqueWiredTigerSession(cachedSession);
+    const TickSource::Tick start = _tickSource->getTicks();
+    Partition& home = _getPartitionForThisThread();
+
+    WiredTigerSession* session = _takeCachedSession(home);
+    if (!session) {
+        // Outside of the cache partition lock, but on release will be put back on the cache
+        session = new WiredTigerSession(_conn, this, _epoch.load(), _cursorEpoch.load());
+        home.sessionsCreated.fetchAndAdd(1);
+    }
+
+    const auto elapsed = _tickSource->ticksTo<Nanoseconds>(_tickSource->getTicks() - start);
+    _recordCheckout(home, durationCount<Nanoseconds>(elapsed));
+    return UniqueWiredTigerSession(session);
+}
+
+WiredTigerSessionCache::Partition& WiredTigerSessionCache::_getPartitionForThisThread() {
+    if (threadPartition < 0) {
+        threadPartition = nextThreadPartition.fetchAndAdd(1);
+    }
+    return _partitions[threadPartition % _numPartitions];
+}
+
+WiredTigerSession* WiredTigerSessionCache::_takeCachedSession(Partition& home) {
+    const size_t homeIndex = &home - _partitions.get();
+    for (size_t i = 0; i < _numPartitions; i++) {
+        Partition& partition = _partitions[(homeIndex + i) % _numPartitions];
+        if (partition.numSessions.loadRelaxed() == 0) {
+            continue;
         }
+
+        stdx::lock_guard<stdx::mutex> lock(partition.lock);
+        if (partition.sessions.empty()) {
+            continue;
+        }
+
+        // Get the most recently used session so that if we discard sessions, we're
+        // discarding older ones
+        WiredTigerSession* cachedSession = partition.sessions.back();
+        partition.sessions.pop_back();
+        partition.numSessions.store(partition.sessions.size());
+        if (i != 0) {
+            home.sessionsStolen.fetchAndAdd(1);
+        }
+        return cachedSession;
     }
+    return nullptr;
+}
 
-    // Outside of the cache partition lock, but on release will be put back on the cache
-    return UniqueWiredTigerSession(
-        new WiredTigerSession(_conn, this, _epoch.load(), _cursorEpoch.load()));
+void WiredTigerSessionCache::_recordCheckout(Partition& home, uint64_t nanos) {
+    int bucket = 0;
+    if (nanos >= (1ULL << kFirstLatencyBucketLog2)) {
+        const int log2 = 63 - countLeadingZeros64(nanos);
+        bucket = std::min(log2 - kFirstLatencyBucketLog2 + 1, kNumLatencyBuckets - 1);
+    }
+    home.checkoutLatencyBuckets[bucket].fetchAndAdd(1);
+    home.checkoutNanos.fetchAndAdd(nanos);
+}
+
+void WiredTigerSessionCache::appendStats(BSONObjBuilder* builder) const {
+    long long cachedSessions = 0;
+    long long sessionsCreated = 0;
+    long long sessionsStolen = 0;
+    long long checkoutNanos = 0;
+    long long checkouts = 0;
+    long long buckets[kNumLatencyBuckets] = {};
+    for (size_t p = 0; p < _numPartitions; p++) {
+        const Partition& partition = _partitions[p];
+        cachedSessions += partition.numSessions.loadRelaxed();
+        sessionsCreated += partition.sessionsCreated.loadRelaxed();
+        sessionsStolen += partition.sessionsStolen.loadRelaxed();
+        checkoutNanos += partition.checkoutNanos.loadRelaxed();
+        for (int i = 0; i < kNumLatencyBuckets; i++) {
+            const long long count = partition.checkoutLatencyBuckets[i].loadRelaxed();
+            buckets[i] += count;
+            checkouts += count;
+        }
+    }
+
+    BSONObjBuilder bob(builder->subobjStart("sessionCache"));
+    bob.append("partitions", static_cast<long long>(_numPartitions));
+    bob.append("cachedSessions", cachedSessions);
+    bob.append("sessionsCreated", sessionsCreated);
+    bob.append("sessionsStolen", sessionsStolen);
+    {
+        BSONObjBuilder latencyBuilder(bob.subobjStart("checkoutLatency"));
+        BSONArrayBuilder histogramBuilder(latencyBuilder.subarrayStart("histogram"));
+        for (int i = 0; i < kNumLatencyBuckets; i++) {
+            if (buckets[i] == 0)
+                continue;
+            const long long lowerBound = i == 0 ? 0 : 1LL << (kFirstLatencyBucketLog2 + i - 1);
+            BSONObjBuilder entryBuilder(histogramBuilder.subobjStart());
+            entryBuilder.append("nanos", lowerBound);
+            entryBuilder.append("count", buckets[i]);
+            entryBuilder.doneFast();
+        }
+        histogramBuilder.doneFast();
+        latencyBuilder.append("latency", checkoutNanos);
+        latencyBuilder.append("ops", checkouts);
+        latencyBuilder.doneFast();
+    }
+    bob.doneFast();
 }
 
 void WiredTigerSessionCache::releaseSession(WiredTigerSession* session) {
@@ -453,10 +599,12 @@ void WiredTigerSessionCache::releaseSession(WiredTigerSession* session) {
     session->dropQueuedIdentsAtSessionEndAllowed(true);
 
     if (session->_getEpoch() == currentEpoch) {  // check outside of lock to reduce contention
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
+        Partition& partition = _getPartitionForThisThread();
+        stdx::lock_guard<stdx::mutex> lock(partition.lock);
         if (session->_getEpoch() == _epoch.load()) {  // recheck inside the lock for correctness
             returnedToCache = true;
-            _sessions.push_back(session);
+            partition.sessions.push_back(session);
+            partition.numSessions.store(partition.sessions.size());
         }
     } else
         invariant(session->_getEpoch() < currentEpoch);
@@ -32,7 +32,9 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <wiredtiger.h>
 
@@ -40,10 +42,13 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_snapshot_manager.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/stdx/new.h"
 #include "mongo/util/concurrency/spin_lock.h"
 
 namespace mongo {
 
+class BSONObjBuilder;
+class TickSource;
 class WiredTigerKVEngine;
 class WiredTigerSessionCache;
 
@@ -184,11 +189,20 @@ private:
 /**
  *  This cache implements a shared pool of WiredTiger sessions with the goal to amortize the
  *  cost of session creation and destruction over multiple uses.
+ *
+ *  The pool is split into partitions, each with its own lock. Every thread is assigned one of the
+ *  partitions, to which it returns its sessions and in which it first looks for a cached session.
+ *  Only when its partition is empty does a thread take a session from another partition, so
+ *  threads rarely contend with each other for the cache.
  */
 class WiredTigerSessionCache {
 public:
     WiredTigerSessionCache(WiredTigerKVEngine* engine);
-    WiredTigerSessionCache(WT_CONNECTION* conn);
+
+    /**
+     * If 'numPartitions' is 0, the number of partitions is chosen as for a storage engine's cache.
+     */
+    WiredTigerSessionCache(WT_CONNECTION* conn, size_t numPartitions = 0);
     ~WiredTigerSessionCache();
 
     /**
@@ -284,7 +298,52 @@ public:
         return _engine;
     }
 
+    /**
+     * Appends the number of sessions cached, created and taken from other threads' partitions,
+     * and a histogram of the time getSession() has taken, as a "sessionCache" subobject.
+     */
+    void appendStats(BSONObjBuilder* builder) const;
+
 private:
+    // Checkout latencies are counted in buckets of powers of two nanoseconds. The first bucket
+    // holds the checkouts which took less than 2^kFirstLatencyBucketLog2 nanoseconds, and the
+    // last bucket all those which took at least 2^(kFirstLatencyBucketLog2 + kNumLatencyBuckets
+    // - 2) nanoseconds.
+    static constexpr int kNumLatencyBuckets = 16;
+    static constexpr int kFirstLatencyBucketLog2 = 7;
+
+    typedef std::vector<WiredTigerSession*> SessionCache;
+
+    // This alignment is a best effort approach to ensure that each partition falls on a
+    // separate cache line in order to avoid false sharing.
+    struct alignas(stdx::hardware_destructive_interference_size) Partition {
+        stdx::mutex lock;
+        SessionCache sessions;  // Protected by 'lock'.
+
+        // The size of 'sessions', which may be read without the lock so that threads looking for a
+        // session to take can pass over empty partitions cheaply.
+        AtomicUInt64 numSessions;
+
+        // Statistics about the checkouts made by the threads assigned to this partition.
+        AtomicUInt64 sessionsCreated;
+        AtomicUInt64 sessionsStolen;
+        AtomicUInt64 checkoutNanos;
+        AtomicUInt64 checkoutLatencyBuckets[kNumLatencyBuckets];
+    };
+
+    /**
+     * Returns the partition of the calling thread.
+     */
+    Partition& _getPartitionForThisThread();
+
+    /**
+     * Removes and returns a cached session, looking in 'home' first and then in the other
+     * partitions. Returns nullptr if no session is cached.
+     */
+    WiredTigerSession* _takeCachedSession(Partition& home);
+
+    void _recordCheckout(Partition& home, uint64_t nanos);
+
     WiredTigerKVEngine* _engine;  // not owned, might be NULL
     WT_CONNECTION* _conn;         // not owned
     WiredTigerSnapshotManager _snapshotManager;
@@ -295,11 +354,13 @@ private:
     AtomicUInt32 _shuttingDown;
     static const uint32_t kShuttingDownMask = 1 << 31;
 
-    stdx::mutex _cacheLock;
-    typedef std::vector<WiredTigerSession*> SessionCache;
-    SessionCache _sessions;
+    size_t _numPartitions;
+    std::unique_ptr<Partition[]> _partitions;
+
+    TickSource* _tickSource;
 
-    // Bumped when all open sessions need to be closed
+    // Bumped when all open sessions need to be closed. Only bumped while holding the locks of all
+    // partitions.
     AtomicUInt64 _epoch;  // atomic so we can check it outside of the lock
 
     // Bumped when all open cursors need to be closed
@@ -74,7 +74,7 @@ public:
     DocumentSourceCursorTest()
         : client(_opCtx.get()),
           _ctx(new ExpressionContextForTest(_opCtx.get(), AggregationRequest(nss, {}))) {
-        _ctx->tempDir = storageGlobalParams.dbpath + "/_tmp";
+        _ctx->tempDir = storageGlobalParams.getSpillDirectory();
     }
 
     virtual ~DocumentSourceCursorTest() {
@@ -43,6 +43,19 @@
 #include "mongo/db/storage/storage_engine_init.h"
 #include "mongo/dbtests/dbtests.h"
 
+namespace mongo {
+
+// How we access the external setParameter knobs for pipelined key generation.
+extern AtomicBool internalIndexBuildPipelineKeyGeneration;
+
+extern AtomicInt32 internalIndexBuildPipelineBatchSize;
+
+extern AtomicInt32 internalIndexBuildPipelineMaxThreads;
+
+extern AtomicBool internalIndexBuildStreamInserts;
+
+}  // namespace mongo
+
 namespace IndexUpdateTests {
 
 namespace {
@@ -637,6 +650,200 @@ protected:
     }
 };
 
+/**
+ * Fixture for foreground builds of several indexes at once, which generate their keys on separate
+ * threads. Uses a small batch size so that the collection scan hands off many batches, and fewer
+ * threads than indexes so that some threads generate the keys for several indexes.
+ */
+class PipelinedIndexBuildBase : public IndexBuildBase {
+public:
+    PipelinedIndexBuildBase()
+        : _pipelineKeyGeneration(internalIndexBuildPipelineKeyGeneration.load()),
+          _pipelineBatchSize(internalIndexBuildPipelineBatchSize.load()),
+          _pipelineMaxThreads(internalIndexBuildPipelineMaxThreads.load()),
+          _streamInserts(internalIndexBuildStreamInserts.load()) {
+        internalIndexBuildPipelineKeyGeneration.store(true);
+        internalIndexBuildStreamInserts.store(true);
+        internalIndexBuildPipelineBatchSize.store(7);
+        internalIndexBuildPipelineMaxThreads.store(2);
+    }
+
+    ~PipelinedIndexBuildBase() {
+        internalIndexBuildPipelineKeyGeneration.store(_pipelineKeyGeneration);
+        internalIndexBuildPipelineBatchSize.store(_pipelineBatchSize);
+        internalIndexBuildPipelineMaxThreads.store(_pipelineMaxThreads);
+        internalIndexBuildStreamInserts.store(_streamInserts);
+    }
+
+protected:
+    void insertDocuments(const std::vector<BSONObj>& docs) {
+        WriteUnitOfWork wunit(&_opCtx);
+        for (auto&& doc : docs) {
+            OpDebug* const nullOpDebug = nullptr;
+            ASSERT_OK(collection()->insertDocument(
+                &_opCtx, InsertStatement(doc), nullOpDebug, true));
+        }
+        wunit.commit();
+    }
+
+    BSONObj makeSpec(const std::string& name,
+                     const BSONObj& key,
+                     const BSONObj& options = BSONObj()) {
+        BSONObjBuilder spec;
+        spec << "name" << name << "ns" << _ns << "key" << key << "v"
+             << static_cast<int>(kIndexVersion);
+        spec.appendElements(options);
+        return spec.obj();
+    }
+
+    int64_t numKeys(const std::string& name) {
+        auto indexCatalog = collection()->getIndexCatalog();
+        auto desc = indexCatalog->findIndexByName(&_opCtx, name);
+        ASSERT(desc);
+        int64_t keys;
+        ValidateResults results;
+        indexCatalog->getIndex(desc)->validate(&_opCtx, &keys, &results);
+        return keys;
+    }
+
+private:
+    const bool _pipelineKeyGeneration;
+    const int _pipelineBatchSize;
+    const int _pipelineMaxThreads;
+    const bool _streamInserts;
+};
+
+/** Every index built through the key generation pipeline gets the keys of every document. */
+class PipelinedIndexBuild : public PipelinedIndexBuildBase {
+public:
+    void run() {
+        const int nDocs = 100;
+        std::vector<BSONObj> docs;
+        for (int i = 0; i < nDocs; ++i) {
+            docs.push_back(BSON("_id" << i << "a" << i << "b" << BSON_ARRAY(i << i + nDocs) << "c"
+                                      << (i % 2 == 0 ? BSON("d" << i) : BSONObj())));
+        }
+        insertDocuments(docs);
+
+        auto indexerPtr = collection()->createMultiIndexBlock(&_opCtx);
+        MultiIndexBlock& indexer(*indexerPtr);
+
+        BSONObj partialSpec =
+            makeSpec("a_partial",
+                     BSON("a" << 1),
+                     BSON("partialFilterExpression" << BSON("a" << BSON("$lt" << 10))));
+        BSONObj sparseSpec = makeSpec("cd_sparse", BSON("c.d" << 1), BSON("sparse" << true));
+        std::vector<BSONObj> specs{makeSpec("a_1", BSON("a" << 1)),
+                                   makeSpec("b_1", BSON("b" << 1)),
+                                   makeSpec("a_1_b_1", BSON("a" << 1 << "b" << 1)),
+                                   partialSpec,
+                                   sparseSpec};
+        ASSERT_OK(indexer.init(specs).getStatus());
+        ASSERT_OK(indexer.insertAllDocumentsInCollection());
+
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            indexer.commit();
+            wunit.commit();
+        }
+
+        ASSERT_EQUALS(nDocs, numKeys("a_1"));
+        ASSERT_EQUALS(2 * nDocs, numKeys("b_1"));
+        ASSERT_EQUALS(2 * nDocs, numKeys("a_1_b_1"));
+        ASSERT_EQUALS(10, numKeys("a_partial"));
+        ASSERT_EQUALS(nDocs / 2, numKeys("cd_sparse"));
+    }
+};
+
+/** A key generation error on one index's thread fails the whole build. */
+class PipelinedIndexBuildKeyGenerationFails : public PipelinedIndexBuildBase {
+public:
+    void run() {
+        std::vector<BSONObj> docs;
+        for (int i = 0; i < 50; ++i) {
+            docs.push_back(BSON("_id" << i << "a" << i << "b" << i));
+        }
+        // Documents with two array fields can't be indexed by a compound index on both.
+        docs.push_back(BSON("_id" << 50 << "a" << BSON_ARRAY(1 << 2) << "b" << BSON_ARRAY(3 << 4)));
+        insertDocuments(docs);
+
+        auto indexerPtr = collection()->createMultiIndexBlock(&_opCtx);
+        MultiIndexBlock& indexer(*indexerPtr);
+
+        std::vector<BSONObj> specs{makeSpec("a_1", BSON("a" << 1)),
+                                   makeSpec("a_1_b_1", BSON("a" << 1 << "b" << 1))};
+        ASSERT_OK(indexer.init(specs).getStatus());
+        ASSERT_EQUALS(ErrorCodes::CannotIndexParallelArrays,
+                      indexer.insertAllDocumentsInCollection());
+    }
+};
+
+/**
+ * Documents inserted into the collection while the indexes are being built have their keys
+ * generated on the pipeline's threads, as during initial sync, and the keys are all there once
+ * doneInserting() returns.
+ */
+class StreamedIndexBuild : public PipelinedIndexBuildBase {
+public:
+    void run() {
+        auto indexerPtr = collection()->createMultiIndexBlock(&_opCtx);
+        MultiIndexBlock& indexer(*indexerPtr);
+        indexer.streamInserts();
+
+        std::vector<BSONObj> specs{makeSpec("a_1", BSON("a" << 1)),
+                                   makeSpec("b_1", BSON("b" << 1))};
+        ASSERT_OK(indexer.init(specs).getStatus());
+
+        const int nDocs = 100;
+        for (int i = 0; i < nDocs; ++i) {
+            WriteUnitOfWork wunit(&_opCtx);
+            ASSERT_OK(collection()->insertDocument(
+                &_opCtx, BSON("_id" << i << "a" << i << "b" << BSON_ARRAY(i << -i)), {&indexer}));
+            wunit.commit();
+        }
+        ASSERT_OK(indexer.doneInserting());
+
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            indexer.commit();
+            wunit.commit();
+        }
+
+        ASSERT_EQUALS(nDocs, numKeys("a_1"));
+        ASSERT_EQUALS(2 * nDocs - 1, numKeys("b_1"));
+    }
+};
+
+/** A key generation error for a streamed document fails the build by doneInserting() at latest. */
+class StreamedIndexBuildKeyGenerationFails : public PipelinedIndexBuildBase {
+public:
+    void run() {
+        auto indexerPtr = collection()->createMultiIndexBlock(&_opCtx);
+        MultiIndexBlock& indexer(*indexerPtr);
+        indexer.streamInserts();
+
+        std::vector<BSONObj> specs{makeSpec("a_1_b_1", BSON("a" << 1 << "b" << 1))};
+        ASSERT_OK(indexer.init(specs).getStatus());
+
+        // Documents with two array fields can't be indexed by a compound index on both.
+        Status status = Status::OK();
+        for (int i = 0; i < 20 && status.isOK(); ++i) {
+            BSONObj doc = i == 3
+                ? BSON("_id" << i << "a" << BSON_ARRAY(1 << 2) << "b" << BSON_ARRAY(3 << 4))
+                : BSON("_id" << i << "a" << i << "b" << i);
+            WriteUnitOfWork wunit(&_opCtx);
+            status = collection()->insertDocument(&_opCtx, doc, {&indexer});
+            if (status.isOK()) {
+                wunit.commit();
+            }
+        }
+        if (status.isOK()) {
+            status = indexer.doneInserting();
+        }
+        ASSERT_EQUALS(ErrorCodes::CannotIndexParallelArrays, status);
+    }
+};
+
 class IndexCatatalogFixIndexKey : public IndexBuildBase {
 public:
     void run() {
@@ -784,6 +991,11 @@ public:
         add<SameSpecDifferentTTL>();
         add<StorageEngineOptions>();
 
+        add<PipelinedIndexBuild>();
+        add<PipelinedIndexBuildKeyGenerationFails>();
+        add<StreamedIndexBuild>();
+        add<StreamedIndexBuildKeyGenerationFails>();
+
         add<IndexCatatalogFixIndexKey>();
 
         add<InsertSymbolInsideNestedObjectIntoIndexWithCollationFails>();
@@ -390,6 +390,52 @@ public:
     }
 };
 
+//
+// Scan a range of RecordIds whose start has been deleted, and expect the records from the one
+// after it up to, but not including, the end of the range.
+//
+
+class QueryStageCollscanRange : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        dbtests::WriteContextForTests ctx(&_opCtx, nss.ns());
+        Collection* coll = ctx.getCollection();
+
+        vector<RecordId> recordIds;
+        getRecordIds(coll, CollectionScanParams::FORWARD, &recordIds);
+
+        // Range scans are not supported by every storage engine.
+        if (!coll->getCursor(&_opCtx)->seekAtOrAfter(recordIds[10])) {
+            return;
+        }
+
+        remove(coll->docFor(&_opCtx, recordIds[10]).value());
+
+        CollectionScanParams params;
+        params.collection = coll;
+        params.direction = CollectionScanParams::FORWARD;
+        params.minRecord = recordIds[10];
+        params.maxRecord = recordIds[20];
+
+        WorkingSet ws;
+        unique_ptr<CollectionScan> scan(new CollectionScan(&_opCtx, params, &ws, NULL));
+
+        vector<RecordId> scanned;
+        while (!scan->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan->work(&id);
+            if (PlanStage::ADVANCED == state) {
+                scanned.push_back(ws.get(id)->recordId);
+            }
+        }
+
+        ASSERT_EQUALS(9U, scanned.size());
+        for (size_t i = 0; i < scanned.size(); ++i) {
+            ASSERT_EQUALS(recordIds[11 + i], scanned[i]);
+        }
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("QueryStageCollectionScan") {}
@@ -404,6 +450,7 @@ public:
         add<QueryStageCollscanObjectsInOrderBackward>();
         add<QueryStageCollscanDeleteUpcomingObject>();
         add<QueryStageCollscanDeleteUpcomingObjectBackward>();
+        add<QueryStageCollscanRange>();
     }
 };
 